@@ -128,6 +128,25 @@
 #define FALCOR_FORCEINLINE __attribute__((always_inline))
 #endif
 
+/**
+ * AVX2 code paths.
+ * FALCOR_HAS_AVX2_TARGET is set if AVX2 intrinsics can be compiled for the target architecture.
+ * Functions marked with FALCOR_TARGET_AVX2 are compiled for AVX2 independent of the build flags,
+ * and must only be called if isAVX2Supported() returns true. Code using the intrinsics must be in
+ * such functions, so that no shared inline code is compiled for AVX2.
+ */
+#if defined(_M_X64) || defined(__x86_64__)
+#define FALCOR_HAS_AVX2_TARGET 1
+#else
+#define FALCOR_HAS_AVX2_TARGET 0
+#endif
+
+#if FALCOR_MSVC
+#define FALCOR_TARGET_AVX2
+#elif FALCOR_CLANG | FALCOR_GCC
+#define FALCOR_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
 /**
  * Preprocessor stringification.
  */
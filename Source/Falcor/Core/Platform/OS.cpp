@@ -37,6 +37,10 @@
 #include <mutex>
 #include <regex>
 
+#if FALCOR_HAS_AVX2_TARGET && FALCOR_MSVC
+#include <intrin.h>
+#endif
+
 namespace Falcor
 {
 const std::filesystem::path& getExecutableDirectory()
@@ -442,4 +446,32 @@ std::string getStackTrace(size_t skip, size_t maxDepth)
     return result;
 }
 
+bool isAVX2Supported()
+{
+    static const bool supported = []()
+    {
+#if FALCOR_HAS_AVX2_TARGET && FALCOR_MSVC
+        // AVX2 requires OS support for saving the YMM registers (OSXSAVE and XCR0 bits 1 and 2).
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#elif FALCOR_HAS_AVX2_TARGET
+        // Also checks the OS support for the YMM registers.
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+#else
+        return false;
+#endif
+    }();
+    return supported;
+}
+
 } // namespace Falcor
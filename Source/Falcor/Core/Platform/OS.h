@@ -538,4 +538,10 @@ FALCOR_API void* getProcAddress(SharedLibraryHandle library, const std::string&
  */
 FALCOR_API std::string getStackTrace(size_t skip = 0, size_t maxDepth = 0);
 
+/**
+ * Check if the CPU and OS support AVX2, i.e. if functions marked with FALCOR_TARGET_AVX2 can be called.
+ * @return True if AVX2 is supported. Always false if FALCOR_HAS_AVX2_TARGET is not set.
+ */
+FALCOR_API bool isAVX2Supported();
+
 } // namespace Falcor
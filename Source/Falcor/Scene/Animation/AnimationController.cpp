@@ -27,8 +27,12 @@
  **************************************************************************/
 #include "AnimationController.h"
 #include "Core/API/RenderContext.h"
+#include "Utils/Threading.h"
+#include "Utils/Math/MatrixBatch.h"
 #include "Utils/Timing/Profiler.h"
 #include "Scene/Scene.h"
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 
 namespace Falcor
@@ -39,6 +43,9 @@ namespace Falcor
         const std::string kInverseTransposeWorldMatrices = "inverseTransposeWorldMatrices";
         const std::string kPrevWorldMatrices = "prevWorldMatrices";
         const std::string kPrevInverseTransposeWorldMatrices = "prevInverseTransposeWorldMatrices";
+
+        const size_t kWorldMatrixGrainSize = 256;   ///< Nodes of a level per parallel task.
+        const size_t kWorldMatrixBatchSize = 64;    ///< Nodes gathered per call to the batched matrix kernels.
     }
 
     AnimationController::AnimationController(ref<Device> pDevice, Scene* pScene, const StaticVertexVector& staticVertexData, const SkinningVertexVector& skinningVertexData, uint32_t prevVertexCount, const std::vector<ref<Animation>>& animations)
@@ -84,6 +91,7 @@ namespace Falcor
         }
 
         createSkinningPass(staticVertexData, skinningVertexData);
+        createNodeLevels();
 
         // Determine length of global animation loop.
         for (const auto& pAnimation : mAnimations)
@@ -182,6 +190,43 @@ namespace Falcor
         }
     }
 
+    void AnimationController::createNodeLevels()
+    {
+        const auto& sceneGraph = mpScene->mSceneGraph;
+        mLevelNodes.clear();
+        mLevelOffsets.clear();
+        mDeferredNodes.clear();
+        if (sceneGraph.empty()) return;
+
+        // Compute the depth of each node. A node whose parent has a larger ID reads the parent's
+        // matrix from the previous update (as the update in ID order always did), so it starts a new tree.
+        std::vector<uint32_t> depths(sceneGraph.size(), 0);
+        uint32_t maxDepth = 0;
+        for (size_t i = 0; i < sceneGraph.size(); i++)
+        {
+            const NodeID parent = sceneGraph[i].parent;
+            if (parent == NodeID::Invalid()) continue;
+            if (parent.get() > i)
+            {
+                mDeferredNodes.push_back((uint32_t)i);
+                continue;
+            }
+            depths[i] = depths[parent.get()] + 1;
+            maxDepth = std::max(maxDepth, depths[i]);
+        }
+        mDeferredParentMatrices.resize(mDeferredNodes.size());
+        mDeferredParentChanged.resize(mDeferredNodes.size());
+
+        // Sort the nodes by depth, keeping them in ID order within a level.
+        mLevelOffsets.assign(maxDepth + 2, 0);
+        for (uint32_t depth : depths) mLevelOffsets[depth + 1]++;
+        for (size_t level = 1; level < mLevelOffsets.size(); level++) mLevelOffsets[level] += mLevelOffsets[level - 1];
+
+        std::vector<size_t> next(mLevelOffsets.begin(), mLevelOffsets.end() - 1);
+        mLevelNodes.resize(sceneGraph.size());
+        for (size_t i = 0; i < sceneGraph.size(); i++) mLevelNodes[next[depths[i]]++] = (uint32_t)i;
+    }
+
     void AnimationController::initLocalMatrices()
     {
         for (size_t i = 0; i < mLocalMatrices.size(); i++)
@@ -299,31 +344,120 @@ namespace Falcor
 
     void AnimationController::updateWorldMatrices(bool updateAll)
     {
+        // Capture the parents of deferred nodes before this update changes them.
         const auto& sceneGraph = mpScene->mSceneGraph;
+        for (size_t k = 0; k < mDeferredNodes.size(); k++)
+        {
+            const uint32_t parentID = sceneGraph[mDeferredNodes[k]].parent.get();
+            mDeferredParentMatrices[k] = mGlobalMatrices[parentID];
+            mDeferredParentChanged[k] = mMatricesChanged[parentID];
+        }
 
-        for (size_t i = 0; i < mGlobalMatrices.size(); i++)
+        // The nodes of a level only depend on their parents in the previous levels,
+        // so the levels are processed in order and the nodes of each level in parallel.
+        for (size_t level = 0; level + 1 < mLevelOffsets.size(); level++)
         {
-            // Propagate matrix change flag to children.
-            if (sceneGraph[i].parent != NodeID::Invalid())
+            const size_t levelBegin = mLevelOffsets[level];
+            const size_t levelEnd = mLevelOffsets[level + 1];
+            const size_t chunkCount = (levelEnd - levelBegin + kWorldMatrixGrainSize - 1) / kWorldMatrixGrainSize;
+            Threading::parallelFor(
+                0,
+                chunkCount,
+                [&](size_t chunk)
+                {
+                    const size_t begin = levelBegin + chunk * kWorldMatrixGrainSize;
+                    updateWorldMatrices(begin, std::min(levelEnd, begin + kWorldMatrixGrainSize), updateAll);
+                },
+                1
+            );
+        }
+    }
+
+    void AnimationController::updateWorldMatrices(size_t levelBegin, size_t levelEnd, bool updateAll)
+    {
+        const auto& sceneGraph = mpScene->mSceneGraph;
+
+        uint32_t nodes[kWorldMatrixBatchSize];
+        uint32_t children[kWorldMatrixBatchSize];
+        float4x4 lhs[kWorldMatrixBatchSize];
+        float4x4 rhs[kWorldMatrixBatchSize];
+        float4x4 globals[kWorldMatrixBatchSize];
+
+        for (size_t batchBegin = levelBegin; batchBegin < levelEnd; batchBegin += kWorldMatrixBatchSize)
+        {
+            const size_t batchEnd = std::min(levelEnd, batchBegin + kWorldMatrixBatchSize);
+
+            // Gather the changed nodes of the batch.
+            size_t nodeCount = 0;
+            size_t childCount = 0;
+            for (size_t j = batchBegin; j < batchEnd; j++)
             {
-                mMatricesChanged[i] = mMatricesChanged[i] || mMatricesChanged[sceneGraph[i].parent.get()];
-            }
+                const uint32_t i = mLevelNodes[j];
+                const NodeID parent = sceneGraph[i].parent;
 
-            if (!mMatricesChanged[i] && !updateAll) continue;
+                // Propagate matrix change flag to children.
+                const float4x4* pParentMatrix = nullptr;
+                if (parent != NodeID::Invalid())
+                {
+                    uint8_t parentChanged;
+                    if (parent.get() < i)
+                    {
+                        pParentMatrix = &mGlobalMatrices[parent.get()];
+                        parentChanged = mMatricesChanged[parent.get()];
+                    }
+                    else
+                    {
+                        const size_t k = std::lower_bound(mDeferredNodes.begin(), mDeferredNodes.end(), i) - mDeferredNodes.begin();
+                        FALCOR_ASSERT(k < mDeferredNodes.size() && mDeferredNodes[k] == i);
+                        pParentMatrix = &mDeferredParentMatrices[k];
+                        parentChanged = mDeferredParentChanged[k];
+                    }
+                    mMatricesChanged[i] = mMatricesChanged[i] || parentChanged;
+                }
 
-            mGlobalMatrices[i] = mLocalMatrices[i];
+                if (!mMatricesChanged[i] && !updateAll) continue;
 
-            if (mpScene->mSceneGraph[i].parent != NodeID::Invalid())
+                if (pParentMatrix)
+                {
+                    lhs[childCount] = *pParentMatrix;
+                    rhs[childCount] = mLocalMatrices[i];
+                    children[childCount++] = (uint32_t)nodeCount;
+                }
+                else
+                {
+                    globals[nodeCount] = mLocalMatrices[i];
+                }
+                nodes[nodeCount++] = i;
+            }
+
+            mulBatch(lhs, rhs, lhs, childCount);
+            for (size_t c = 0; c < childCount; c++) globals[children[c]] = lhs[c];
+
+            // Write the global matrices. The inverse transpose and skinning matrices of a node are functions of its global matrix,
+            // so they are only recomputed if the global matrix is bitwise different from the previous one.
+            size_t changedCount = 0;
+            for (size_t k = 0; k < nodeCount; k++)
             {
-                mGlobalMatrices[i] = mul(mGlobalMatrices[sceneGraph[i].parent.get()], mGlobalMatrices[i]);
+                float4x4& global = mGlobalMatrices[nodes[k]];
+                if (!updateAll && std::memcmp(&global, &globals[k], sizeof(float4x4)) == 0) continue;
+                global = globals[k];
+                lhs[changedCount] = globals[k];
+                nodes[changedCount++] = nodes[k];
             }
 
-            mInvTransposeGlobalMatrices[i] = transpose(inverse(mGlobalMatrices[i]));
+            inverseTransposeBatch(lhs, rhs, changedCount);
+            for (size_t k = 0; k < changedCount; k++) mInvTransposeGlobalMatrices[nodes[k]] = rhs[k];
 
             if (mpSkinningPass)
             {
-                mSkinningMatrices[i] = mul(mGlobalMatrices[i], sceneGraph[i].localToBindSpace);
-                mInvTransposeSkinningMatrices[i] = transpose(inverse(mSkinningMatrices[i]));
+                for (size_t k = 0; k < changedCount; k++) rhs[k] = sceneGraph[nodes[k]].localToBindSpace;
+                mulBatch(lhs, rhs, lhs, changedCount);
+                inverseTransposeBatch(lhs, rhs, changedCount);
+                for (size_t k = 0; k < changedCount; k++)
+                {
+                    mSkinningMatrices[nodes[k]] = lhs[k];
+                    mInvTransposeSkinningMatrices[nodes[k]] = rhs[k];
+                }
             }
         }
     }
@@ -108,7 +108,7 @@ namespace Falcor
 
         /** Check if a matrix changed since last frame.
         */
-        bool isMatrixChanged(NodeID matrixID) const { return mMatricesChanged[matrixID.get()]; }
+        bool isMatrixChanged(NodeID matrixID) const { return mMatricesChanged[matrixID.get()] != 0; }
 
         /** Get the local matrices.
             These represent the current local transform for each scene graph node.
@@ -146,9 +146,11 @@ namespace Falcor
     private:
         friend class SceneBuilder;
 
+        void createNodeLevels();
         void initLocalMatrices();
         void updateLocalMatrices(double time);
         void updateWorldMatrices(bool updateAll = false);
+        void updateWorldMatrices(size_t levelBegin, size_t levelEnd, bool updateAll);
         void uploadWorldMatrices(bool uploadAll = false);
 
         void bindBuffers();
@@ -164,7 +166,12 @@ namespace Falcor
         std::vector<float4x4> mLocalMatrices;
         std::vector<float4x4> mGlobalMatrices;
         std::vector<float4x4> mInvTransposeGlobalMatrices;
-        std::vector<bool> mMatricesChanged;         ///< Flag per matrix, true if matrix changed since last frame.
+        std::vector<uint8_t> mMatricesChanged;      ///< Flag per matrix, 1 if matrix changed since last frame. Bytes, so a level can be updated in parallel.
+        std::vector<uint32_t> mLevelNodes;          ///< Node IDs ordered by depth in the scene graph, roots first.
+        std::vector<size_t> mLevelOffsets;          ///< Offset of each depth level in mLevelNodes, followed by the node count.
+        std::vector<uint32_t> mDeferredNodes;       ///< Sorted IDs of nodes whose parent has a larger ID. They use the parent's state from before the update.
+        std::vector<float4x4> mDeferredParentMatrices;  ///< Parent global matrix per deferred node, captured at the start of the update.
+        std::vector<uint8_t> mDeferredParentChanged;    ///< Parent change flag per deferred node, captured at the start of the update.
 
         bool mFirstUpdate = true;       ///< True if this is the first update.
         bool mEnabled = true;           ///< True if animations are enabled.
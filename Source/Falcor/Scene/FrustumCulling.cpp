@@ -27,9 +27,88 @@
  **************************************************************************/
 #include "FrustumCulling.h"
 #include "Utils/Math/FalcorMath.h"
+#include "Core/Platform/OS.h"
+#include <algorithm>
+#include <cstring>
+
+#if FALCOR_HAS_AVX2_TARGET
+#include <immintrin.h>
+#endif
 
 namespace Falcor
 {
+#if FALCOR_HAS_AVX2_TARGET
+    namespace
+    {
+        /** Tests 8 boxes per iteration, starting at begin while a whole batch is left.
+            Uses the same operations as isInFrontOfPlane() so the results agree exactly with the scalar path.
+            \return Index of the first box that was not tested.
+        */
+        FALCOR_TARGET_AVX2 size_t isInFrustumAVX2(
+            const FrustumCulling::AABBArray& boxes,
+            size_t begin,
+            size_t end,
+            const float3 normals[],
+            const float distances[],
+            uint32_t planeMask,
+            uint8_t& lastPlane,
+            uint8_t* pVisible
+        )
+        {
+            const __m256 half = _mm256_set1_ps(0.5f);
+            size_t i = begin;
+            for (; i + 8 <= end; i += 8)
+            {
+                const __m256 minX = _mm256_loadu_ps(boxes.minX.data() + i);
+                const __m256 minY = _mm256_loadu_ps(boxes.minY.data() + i);
+                const __m256 minZ = _mm256_loadu_ps(boxes.minZ.data() + i);
+                const __m256 maxX = _mm256_loadu_ps(boxes.maxX.data() + i);
+                const __m256 maxY = _mm256_loadu_ps(boxes.maxY.data() + i);
+                const __m256 maxZ = _mm256_loadu_ps(boxes.maxZ.data() + i);
+
+                const __m256 cX = _mm256_mul_ps(_mm256_add_ps(minX, maxX), half);
+                const __m256 cY = _mm256_mul_ps(_mm256_add_ps(minY, maxY), half);
+                const __m256 cZ = _mm256_mul_ps(_mm256_add_ps(minZ, maxZ), half);
+                const __m256 eX = _mm256_sub_ps(maxX, cX);
+                const __m256 eY = _mm256_sub_ps(maxY, cY);
+                const __m256 eZ = _mm256_sub_ps(maxZ, cZ);
+
+                __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+                for (uint32_t k = 0; k < FrustumCulling::kPlaneCount; k++)
+                {
+                    const uint32_t p = k == 0 ? lastPlane : (k - 1 < lastPlane ? k - 1 : k);
+                    if ((planeMask & (1u << p)) == 0)
+                        continue;
+
+                    const float3 n = normals[p];
+                    const float3 absN = math::abs(n);
+                    __m256 r = _mm256_mul_ps(eX, _mm256_set1_ps(absN.x));
+                    r = _mm256_add_ps(r, _mm256_mul_ps(eY, _mm256_set1_ps(absN.y)));
+                    r = _mm256_add_ps(r, _mm256_mul_ps(eZ, _mm256_set1_ps(absN.z)));
+                    __m256 d = _mm256_mul_ps(cX, _mm256_set1_ps(n.x));
+                    d = _mm256_add_ps(d, _mm256_mul_ps(cY, _mm256_set1_ps(n.y)));
+                    d = _mm256_add_ps(d, _mm256_mul_ps(cZ, _mm256_set1_ps(n.z)));
+                    d = _mm256_sub_ps(d, _mm256_set1_ps(distances[p]));
+                    const __m256 negR = _mm256_sub_ps(_mm256_setzero_ps(), r);
+                    inside = _mm256_and_ps(inside, _mm256_cmp_ps(negR, d, _CMP_LE_OQ));
+
+                    // The whole batch is culled, remember the plane for the next batch
+                    if (_mm256_movemask_ps(inside) == 0)
+                    {
+                        lastPlane = uint8_t(p);
+                        break;
+                    }
+                }
+
+                const int mask = _mm256_movemask_ps(inside);
+                for (int k = 0; k < 8; k++)
+                    pVisible[i - begin + k] = uint8_t((mask >> k) & 1);
+            }
+            return i;
+        }
+    } // namespace
+#endif
+
     FrustumCulling::Plane::Plane(const float3 p1, const float3 N)
     {
         normal = math::normalize(N);
@@ -41,6 +120,34 @@ namespace Falcor
         return math::dot(normal, point) - distance;
     }
 
+    void FrustumCulling::AABBArray::resize(size_t count)
+    {
+        minX.resize(count);
+        minY.resize(count);
+        minZ.resize(count);
+        maxX.resize(count);
+        maxY.resize(count);
+        maxZ.resize(count);
+    }
+
+    void FrustumCulling::AABBArray::set(size_t index, const AABB& aabb)
+    {
+        minX[index] = aabb.minPoint.x;
+        minY[index] = aabb.minPoint.y;
+        minZ[index] = aabb.minPoint.z;
+        maxX[index] = aabb.maxPoint.x;
+        maxY[index] = aabb.maxPoint.y;
+        maxZ[index] = aabb.maxPoint.z;
+    }
+
+    AABB FrustumCulling::AABBArray::get(size_t index) const
+    {
+        AABB aabb;
+        aabb.minPoint = float3(minX[index], minY[index], minZ[index]);
+        aabb.maxPoint = float3(maxX[index], maxY[index], maxZ[index]);
+        return aabb;
+    }
+
     FrustumCulling::FrustumCulling(const ref<Camera>& camera)
     {
         updateFrustum(camera);
@@ -105,6 +212,7 @@ namespace Falcor
         frustum.left = {camPos, math::normalize(math::cross(camV, frontTimesFar + camU * halfHSide))};
 
         mFrustum = frustum;
+        mViewProj = math::mul(math::perspective(fovY, aspect, near, far), math::matrixFromLookAt(camPos, camPos + camW, camV));
     }
 
     void FrustumCulling::createFrustum(float3 camPos, float3 camU, float3 camV, float3 camW, float left, float right, float bottom, float top, float near, float far)
@@ -121,6 +229,7 @@ namespace Falcor
         frustum.left = {camPos + camU * left, camU};
 
         mFrustum = frustum;
+        mViewProj = math::mul(math::ortho(left, right, bottom, top, near, far), math::matrixFromLookAt(camPos, camPos + camW, camV));
     }
         
     bool FrustumCulling::isInFrontOfPlane(const Plane& plane, const AABB& aabb) const
@@ -150,6 +259,80 @@ namespace Falcor
 
         return inPlane;
     }
+
+    FrustumCulling::Intersection FrustumCulling::classify(const AABB& aabb) const
+    {
+        uint32_t planeMask = kAllPlanes;
+        uint8_t lastPlane = 0;
+        return classify(aabb, planeMask, lastPlane);
+    }
+
+    FrustumCulling::Intersection FrustumCulling::classify(const AABB& aabb, uint32_t& planeMask, uint8_t& lastPlane) const
+    {
+        const Plane* planes[] = {&mFrustum.near, &mFrustum.far, &mFrustum.top, &mFrustum.bottom, &mFrustum.left, &mFrustum.right};
+        float3 c = aabb.center();
+        float3 e = aabb.maxPoint - c;
+
+        for (uint32_t k = 0; k < kPlaneCount; k++)
+        {
+            // Test lastPlane first, then the others in order
+            const uint32_t i = k == 0 ? lastPlane : (k - 1 < lastPlane ? k - 1 : k);
+            if ((planeMask & (1u << i)) == 0)
+                continue;
+
+            // Same test as isInFrontOfPlane(), additionally checks if the box is fully in front of the plane
+            float r = math::dot(e, math::abs(planes[i]->normal));
+            float d = planes[i]->getSignedDistanceToPlane(c);
+            if (d < -r)
+            {
+                lastPlane = uint8_t(i);
+                return Intersection::Outside;
+            }
+            if (d >= r)
+                planeMask &= ~(1u << i);
+        }
+        return planeMask == 0 ? Intersection::Inside : Intersection::Intersecting;
+    }
+
+    void FrustumCulling::isInFrustum(const AABBArray& boxes, size_t begin, size_t end, uint8_t* pVisible) const
+    {
+        uint8_t lastPlane = 0;
+        isInFrustum(boxes, begin, end, kAllPlanes, lastPlane, pVisible);
+    }
+
+    void FrustumCulling::isInFrustum(
+        const AABBArray& boxes,
+        size_t begin,
+        size_t end,
+        uint32_t planeMask,
+        uint8_t& lastPlane,
+        uint8_t* pVisible
+    ) const
+    {
+        FALCOR_ASSERT(begin <= end && end <= boxes.size());
+        size_t i = begin;
+
+#if FALCOR_HAS_AVX2_TARGET
+        if (isAVX2Supported())
+        {
+            const Plane* planes[] = {&mFrustum.near, &mFrustum.far, &mFrustum.top, &mFrustum.bottom, &mFrustum.left, &mFrustum.right};
+            float3 normals[kPlaneCount];
+            float distances[kPlaneCount];
+            for (uint32_t p = 0; p < kPlaneCount; p++)
+            {
+                normals[p] = planes[p]->normal;
+                distances[p] = planes[p]->distance;
+            }
+            i = isInFrustumAVX2(boxes, begin, end, normals, distances, planeMask, lastPlane, pVisible);
+        }
+#endif
+
+        for (; i < end; i++)
+        {
+            uint32_t boxPlaneMask = planeMask;
+            pVisible[i - begin] = classify(boxes.get(i), boxPlaneMask, lastPlane) != Intersection::Outside ? 1 : 0;
+        }
+    }
         
     void FrustumCulling::createDrawBuffer(ref<Device> pDevice, ref<GpuFence> pSceneFence, RenderContext* pRenderContext, const std::vector<ref<Buffer>>& drawBuffer, const std::vector<bool>& isDynamic)
     {
@@ -157,9 +340,11 @@ namespace Falcor
         mDraw.clear();
         mStagingBuffer.clear();
         mDrawCount.clear();
+        mOccludedCount.clear();
         mValidDrawBuffer.clear();
 
         mpStagingFence = pSceneFence;
+        mIsDynamic = isDynamic;
 
         for (auto& waitVals : mFenceWaitValues)
             waitVals = 0;
@@ -169,6 +354,7 @@ namespace Falcor
         mDraw.resize(size);
         mStagingBuffer.resize(size);
         mDrawCount.resize(size);
+        mOccludedCount.resize(size);
         mValidDrawBuffer.resize(size);
 
         uint countDynamic = 0;
@@ -216,69 +402,77 @@ namespace Falcor
     void FrustumCulling::invalidateAllDrawBuffers() {
         for (uint i = 0; i < mValidDrawBuffer.size(); i++)
             mValidDrawBuffer[i] = false;
+
+        // The occluders are rasterized again with the next update
+        if (mpOcclusionCulling)
+            mpOcclusionCulling->invalidate();
     }
 
-    void FrustumCulling::updateDrawBuffer(RenderContext* pRenderContext, uint index, const std::vector<DrawIndexedArguments> drawArguments)
+    void FrustumCulling::setOcclusionCullingEnabled(bool enabled)
     {
-        FALCOR_ASSERT(mStagingBuffer[index].buffer);
-        FALCOR_ASSERT(mDraw[index]);
+        if (enabled == (mpOcclusionCulling != nullptr))
+            return;
 
-        uint buffSize = drawArguments.size();
-        mValidDrawBuffer[index] = true;
-        mDrawCount[index] = buffSize;
+        mpOcclusionCulling = enabled ? make_ref<OcclusionCulling>() : nullptr;
+        std::fill(mOccludedCount.begin(), mOccludedCount.end(), 0);
+        invalidateAllDrawBuffers();
+    }
 
-        if (buffSize <= 0)
+    void FrustumCulling::invalidateDynamicDrawBuffers(uint64_t geometryVersion)
+    {
+        if (geometryVersion == mGeometryVersion)
             return;
 
-        auto& stagingBuffer = mStagingBuffer[index].buffer;
-        const auto& maxElements = mStagingBuffer[index].maxElementsBytes / sizeof(DrawIndexedArguments);
-        const uint stagingOffset = maxElements * mStagingCount;
+        mGeometryVersion = geometryVersion;
+        for (uint i = 0; i < mValidDrawBuffer.size(); i++)
+        {
+            if (mIsDynamic[i])
+                mValidDrawBuffer[i] = false;
+        }
+    }
+
+    void* FrustumCulling::mapDrawBufferStaging(uint index)
+    {
+        FALCOR_ASSERT(mStagingBuffer[index].buffer);
 
         //Wait for the GPU to finish copying from kStagingFramesInFlight frames back
         mpStagingFence->syncCpu(mFenceWaitValues[mStagingCount]);
 
-        DrawIndexedArguments* drawArgs = (DrawIndexedArguments*)stagingBuffer->map(Buffer::MapType::Write);
-        for (uint i = 0; i < buffSize; i++)
-        {
-            drawArgs[stagingOffset + i] = drawArguments[i];
-        }
-
-        pRenderContext->copyBufferRegion(
-            mDraw[index].get(), 0, stagingBuffer.get(), sizeof(DrawIndexedArguments) * stagingOffset,
-            sizeof(DrawIndexedArguments) * buffSize
-        );
+        uint8_t* pData = (uint8_t*)mStagingBuffer[index].buffer->map(Buffer::MapType::Write);
+        return pData + size_t(mStagingBuffer[index].maxElementsBytes) * mStagingCount;
     }
 
-    void FrustumCulling::updateDrawBuffer(RenderContext* pRenderContext, uint index, const std::vector<DrawArguments> drawArguments)
+    void FrustumCulling::commitDrawBufferStaging(RenderContext* pRenderContext, uint index, uint count, size_t argumentSize)
     {
-        FALCOR_ASSERT(mStagingBuffer[index].buffer);
         FALCOR_ASSERT(mDraw[index]);
+        FALCOR_ASSERT(count * argumentSize <= mStagingBuffer[index].maxElementsBytes);
 
-        uint buffSize = drawArguments.size();
         mValidDrawBuffer[index] = true;
-        mDrawCount[index] = buffSize;
-        if (buffSize <= 0)
-            return;
-
-        auto& stagingBuffer = mStagingBuffer[index].buffer;
-        const auto& maxElements = mStagingBuffer[index].maxElementsBytes / sizeof(DrawIndexedArguments);
-        const uint stagingOffset = maxElements * mStagingCount;
+        mDrawCount[index] = count;
 
-        // Wait for the GPU to finish copying from kStagingFramesInFlight frames back
-        mpStagingFence->syncCpu(mFenceWaitValues[mStagingCount]);
-
-        DrawArguments* drawArgs = (DrawArguments*)stagingBuffer->map(Buffer::MapType::Write);
-        for (uint i = 0; i < buffSize; i++)
-        {
-            drawArgs[stagingOffset + i] = drawArguments[i];
-        }
+        if (count == 0)
+            return;
 
+        const uint64_t stagingOffset = uint64_t(mStagingBuffer[index].maxElementsBytes) * mStagingCount;
         pRenderContext->copyBufferRegion(
-            mDraw[index].get(), 0, stagingBuffer.get(), sizeof(DrawArguments) * stagingOffset,
-            sizeof(DrawArguments) * buffSize
+            mDraw[index].get(), 0, mStagingBuffer[index].buffer.get(), stagingOffset, argumentSize * count
         );
     }
 
+    void FrustumCulling::updateDrawBuffer(RenderContext* pRenderContext, uint index, const std::vector<DrawIndexedArguments>& drawArguments)
+    {
+        if (!drawArguments.empty())
+            std::memcpy(mapDrawBufferStaging(index), drawArguments.data(), drawArguments.size() * sizeof(DrawIndexedArguments));
+        commitDrawBufferStaging(pRenderContext, index, (uint)drawArguments.size(), sizeof(DrawIndexedArguments));
+    }
+
+    void FrustumCulling::updateDrawBuffer(RenderContext* pRenderContext, uint index, const std::vector<DrawArguments>& drawArguments)
+    {
+        if (!drawArguments.empty())
+            std::memcpy(mapDrawBufferStaging(index), drawArguments.data(), drawArguments.size() * sizeof(DrawArguments));
+        commitDrawBufferStaging(pRenderContext, index, (uint)drawArguments.size(), sizeof(DrawArguments));
+    }
+
     void FrustumCulling::startUpdate(const uint lastFrameSyncValue)
     {
         //Store signal value for next round
@@ -287,33 +481,19 @@ namespace Falcor
         mStagingCount = (mStagingCount + 1) % kStagingFramesInFlight;
     }
 
-    bool FrustumCulling::checkDynamicInstances(uint index, const std::vector<uint> passedInstanceIDs)
+    bool FrustumCulling::checkDynamicInstances(uint index, const uint* pPassedInstanceIDs, size_t count)
     {
         uint instanceIdx = mDynamicDrawArgsToInstanceID[index];
         auto& instanceList = mDynamicInstanceID[instanceIdx];
 
-        bool updateDraw = false;
-        if (instanceList.size() != passedInstanceIDs.size())
-            updateDraw = true;
-        else //Check if the instance ids are the same
-        {
-            for (uint i = 0; i < instanceList.size(); i++)
-            {
-                if (instanceList[i] != passedInstanceIDs[i])
-                {
-                    updateDraw = true;
-                    break;
-                } 
-            }
-        }
+        //Check if the instance ids are the same
+        bool updateDraw = instanceList.size() != count || !std::equal(instanceList.begin(), instanceList.end(), pPassedInstanceIDs);
 
         //Copy Lists if they are different
         if (updateDraw)
-        {
-            instanceList.resize(0);
-            for (auto& ids : passedInstanceIDs)
-                instanceList.push_back(ids);
-        }
+            instanceList.assign(pPassedInstanceIDs, pPassedInstanceIDs + count);
+        else
+            mValidDrawBuffer[index] = true;
 
         return updateDraw;
     }
@@ -29,12 +29,15 @@
 #include "Utils/Math/Vector.h"
 #include "Utils/Math/Matrix.h"
 #include "Utils/Math/AABB.h"
+#include "OcclusionCulling.h"
 #include "Camera/Camera.h"
 #include "Camera/CameraController.h"
 #include "Core/API/Buffer.h"
 #include "Core/API/IndirectCommands.h"
 #include "Core/API/Device.h"
 #include "Core/API/GpuFence.h"
+#include <cstdint>
+#include <vector>
 
 namespace Falcor
 {
@@ -45,6 +48,30 @@ namespace Falcor
     {
         FALCOR_OBJECT(FrustumCulling)
     public:
+        /** World-space AABBs in structure-of-arrays layout for the batched frustum test.
+        */
+        struct AABBArray
+        {
+            std::vector<float> minX, minY, minZ;
+            std::vector<float> maxX, maxY, maxZ;
+
+            void resize(size_t count);
+            void set(size_t index, const AABB& aabb);
+            AABB get(size_t index) const;
+            size_t size() const { return minX.size(); }
+        };
+
+        // Result of classifying a box against the frustum
+        enum class Intersection
+        {
+            Outside,      // Culled by at least one plane
+            Intersecting, // Crosses at least one plane
+            Inside,       // Fully in front of all planes
+        };
+
+        static constexpr uint32_t kPlaneCount = 6;
+        static constexpr uint32_t kAllPlanes = (1u << kPlaneCount) - 1;
+
         FrustumCulling() = default;
         //Constructor based on perspective camera
         FrustumCulling(const ref<Camera>& camera);
@@ -65,6 +92,37 @@ namespace Falcor
         // Frustum Culling Test. Assumes AABB is transformed to world coordinates
         bool isInFrustum(const AABB& aabb) const;
 
+        // Classifies an AABB in world coordinates. Boxes that are not Outside pass isInFrustum()
+        Intersection classify(const AABB& aabb) const;
+
+        // Classifies an AABB against the planes in planeMask, for hierarchical and temporally coherent culling.
+        // Planes the box is fully in front of are removed from planeMask, so boxes contained in it can skip them.
+        // lastPlane is tested first and is set to the rejecting plane if the box is outside
+        Intersection classify(const AABB& aabb, uint32_t& planeMask, uint8_t& lastPlane) const;
+
+        // Batched Frustum Culling Test of the boxes [begin, end). Writes 1 (visible) or 0 (culled) per box to pVisible[0 .. end - begin)
+        void isInFrustum(const AABBArray& boxes, size_t begin, size_t end, uint8_t* pVisible) const;
+
+        // Batched Frustum Culling Test against the planes in planeMask, starting with lastPlane.
+        // Stops testing a batch once all its boxes are culled and sets lastPlane to the plane that culled it
+        void isInFrustum(const AABBArray& boxes, size_t begin, size_t end, uint32_t planeMask, uint8_t& lastPlane, uint8_t* pVisible) const;
+
+        // View projection matrix of the frustum, with depth in [0, 1]
+        const float4x4& getViewProjMatrix() const { return mViewProj; }
+
+        // Enables the CPU occlusion test (see OcclusionCulling) for the draws culled with this frustum. Invalidates the draw buffers if it changed
+        void setOcclusionCullingEnabled(bool enabled);
+
+        // Occlusion culling state, nullptr if occlusion culling is disabled. Its occluders are filled in by the scene
+        OcclusionCulling* getOcclusionCulling() const { return mpOcclusionCulling.get(); }
+
+        // Number of instances of a draw buffer that passed the frustum test but were rejected by the occlusion test
+        uint getOccludedCount(uint index) const { return mOccludedCount[index]; }
+        void setOccludedCount(uint index, uint count) { mOccludedCount[index] = count; }
+
+        // Temporal state for hierarchical queries (see InstanceBVH::queryFrustum()). Holds the plane that last rejected each node
+        std::vector<uint8_t>& getRejectingPlanes() { return mRejectingPlanes; }
+
         virtual bool isUserAllowed(const MeshDesc& mesh) const
         {
             if (!mUserCallback) return true;
@@ -84,18 +142,29 @@ namespace Falcor
         );
 
         //Update of the draw buffer with (culled) vector of draw arguments. Overload for DrawIndexedArguments
-        void updateDrawBuffer(RenderContext* pRenderContext, uint index, const std::vector<DrawIndexedArguments> drawArguments);
+        void updateDrawBuffer(RenderContext* pRenderContext, uint index, const std::vector<DrawIndexedArguments>& drawArguments);
 
         // Update of the draw buffer with (culled) vector of draw arguments. Overload for DrawArguments
-        void updateDrawBuffer(RenderContext* pRenderContext, uint index, const std::vector<DrawArguments> drawArguments);
+        void updateDrawBuffer(RenderContext* pRenderContext, uint index, const std::vector<DrawArguments>& drawArguments);
+
+        // Returns the staging memory of this frame for a draw buffer, with room for all draws of the original buffer.
+        // The draw arguments can be written to it directly (also from multiple threads) and are copied with commitDrawBufferStaging()
+        void* mapDrawBufferStaging(uint index);
+
+        // Copies the first count draw arguments (of argumentSize bytes each) from the staging memory to the draw buffer
+        void commitDrawBufferStaging(RenderContext* pRenderContext, uint index, uint count, size_t argumentSize);
 
         // Call at the start of the draw call with the sync value from the scene for proper CPU/GPU sync
         void startUpdate(const uint lastFrameSyncValue);
 
         bool hasDynamic() const {return mHasDynamic; }
 
-        //Checks if the dynamic instances have changed
-        bool checkDynamicInstances(uint index, const std::vector<uint> passedInstanceIDs);
+        //Checks if the dynamic instances have changed. If not, the current draw buffer stays valid
+        bool checkDynamicInstances(uint index, const uint* pPassedInstanceIDs, size_t count);
+        bool checkDynamicInstances(uint index, const std::vector<uint>& passedInstanceIDs)
+        {
+            return checkDynamicInstances(index, passedInstanceIDs.data(), passedInstanceIDs.size());
+        }
 
         std::vector<ref<Buffer>>& getDrawBuffers() { return mDraw; }
         std::vector<uint>& getDrawCounts() { return mDrawCount; }
@@ -103,6 +172,10 @@ namespace Falcor
         bool isBufferValid(uint index) { return mValidDrawBuffer[index]; }
         void invalidateAllDrawBuffers();
 
+        // Invalidates the draw buffers with dynamic geometry if the geometry moved since the last call
+        void invalidateDynamicDrawBuffers(uint64_t geometryVersion);
+
+        // The callback is called concurrently from the culling threads and must be thread-safe
         void setUserCallback(std::function<bool(const MeshDesc&)> cb) { mUserCallback = cb; }
     private:
         static const uint kStagingFramesInFlight = 6u;
@@ -147,6 +220,8 @@ namespace Falcor
         bool isInFrontOfPlane(const Plane& plane, const AABB& aabb) const;
 
         Frustum mFrustum;
+        float4x4 mViewProj;
+        ref<OcclusionCulling> mpOcclusionCulling;
         ref<GpuFence> mpStagingFence;   //Copy of the scenes fence
 
         bool mDrawValid = false;
@@ -156,7 +231,11 @@ namespace Falcor
         std::vector<StagingInfo> mStagingBuffer; // Current Staging index for each buff
         std::vector<ref<Buffer>> mDraw;      //Draw buffer that can be reused if there was no change in frustum. One per mDrawArgs from scene
         std::vector<uint> mDrawCount;         //The number of elements in the draw buffer. One per mDrawArgs from scene
+        std::vector<uint> mOccludedCount;     //The number of instances rejected by the occlusion test. One per mDrawArgs from scene
         std::vector<bool> mValidDrawBuffer;
+        std::vector<bool> mIsDynamic;           //Draw buffer contains dynamic geometry. One per mDrawArgs from scene
+        uint64_t mGeometryVersion = 0;          //Geometry version the dynamic draw buffers were culled with
+        std::vector<uint8_t> mRejectingPlanes;  //Plane that last rejected each node of a hierarchical query
 
         std::vector<std::vector<uint>> mDynamicInstanceID;  //The dynamic instance id is stored to check if the culling buffer does not need to be copied again
         std::vector<uint> mDynamicDrawArgsToInstanceID;     //Mapping buffer to map between drawArgs and the above vector
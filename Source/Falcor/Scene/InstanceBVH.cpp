@@ -0,0 +1,278 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "InstanceBVH.h"
+#include "Core/Assert.h"
+#include <algorithm>
+#include <numeric>
+
+namespace Falcor
+{
+namespace
+{
+bool overlaps(const AABB& a, const AABB& b)
+{
+    return all(a.minPoint <= b.maxPoint) && all(b.minPoint <= a.maxPoint);
+}
+
+bool contains(const AABB& outer, const AABB& inner)
+{
+    return all(outer.minPoint <= inner.minPoint) && all(inner.maxPoint <= outer.maxPoint);
+}
+} // namespace
+
+void InstanceBVH::build(const std::vector<Item>& items)
+{
+    clear();
+    if (items.empty())
+        return;
+
+    const uint32_t itemCount = (uint32_t)items.size();
+    std::vector<uint32_t> order(itemCount);
+    std::iota(order.begin(), order.end(), 0u);
+
+    std::vector<float3> centroids(itemCount);
+    for (uint32_t i = 0; i < itemCount; i++)
+        centroids[i] = items[i].bounds.center();
+
+    // Split the nodes at the median of the longest centroid axis.
+    Node root;
+    root.end = itemCount;
+    mNodes.push_back(root);
+
+    std::vector<uint32_t> stack = {0};
+    while (!stack.empty())
+    {
+        const uint32_t nodeIndex = stack.back();
+        stack.pop_back();
+
+        const uint32_t begin = mNodes[nodeIndex].begin;
+        const uint32_t end = mNodes[nodeIndex].end;
+        if (end - begin <= kMaxLeafSize)
+            continue;
+
+        AABB centroidBounds;
+        for (uint32_t i = begin; i < end; i++)
+            centroidBounds.include(centroids[order[i]]);
+
+        const float3 extent = centroidBounds.extent();
+        const uint32_t axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        if (extent[axis] <= 0.f)
+            continue; // All centroids coincide, keep the node as a leaf.
+
+        const uint32_t mid = begin + (end - begin) / 2;
+        std::nth_element(
+            order.begin() + begin,
+            order.begin() + mid,
+            order.begin() + end,
+            [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; }
+        );
+
+        const uint32_t left = (uint32_t)mNodes.size();
+        mNodes[nodeIndex].left = left;
+
+        Node child;
+        child.parent = nodeIndex;
+        child.begin = begin;
+        child.end = mid;
+        mNodes.push_back(child);
+        child.begin = mid;
+        child.end = end;
+        mNodes.push_back(child);
+
+        stack.push_back(left + 1);
+        stack.push_back(left);
+    }
+
+    // Store the items in hierarchy order.
+    uint32_t maxID = 0;
+    for (const auto& item : items)
+        maxID = std::max(maxID, item.id);
+
+    mItemIDs.resize(itemCount);
+    mItemBounds.resize(itemCount);
+    mItemLeaves.resize(itemCount);
+    mItemPositions.assign(maxID + 1, kInvalidIndex);
+    for (uint32_t pos = 0; pos < itemCount; pos++)
+    {
+        const auto& item = items[order[pos]];
+        FALCOR_ASSERT(mItemPositions[item.id] == kInvalidIndex);
+        mItemIDs[pos] = item.id;
+        mItemBounds.set(pos, item.bounds);
+        mItemPositions[item.id] = pos;
+    }
+
+    for (uint32_t nodeIndex = 0; nodeIndex < mNodes.size(); nodeIndex++)
+    {
+        const auto& node = mNodes[nodeIndex];
+        if (node.isLeaf())
+            std::fill(mItemLeaves.begin() + node.begin, mItemLeaves.begin() + node.end, nodeIndex);
+    }
+
+    // Compute the node bounds bottom-up. Children always follow their parent.
+    mNodeDirty.assign(mNodes.size(), true);
+    mDirtyNodes.resize(mNodes.size());
+    std::iota(mDirtyNodes.begin(), mDirtyNodes.end(), 0u);
+    refit();
+}
+
+void InstanceBVH::clear()
+{
+    mNodes.clear();
+    mItemIDs.clear();
+    mItemBounds.resize(0);
+    mItemLeaves.clear();
+    mItemPositions.clear();
+    mDirtyNodes.clear();
+    mNodeDirty.clear();
+}
+
+void InstanceBVH::setItemBounds(uint32_t id, const AABB& bounds)
+{
+    FALCOR_ASSERT(id < mItemPositions.size() && mItemPositions[id] != kInvalidIndex);
+    const uint32_t pos = mItemPositions[id];
+    mItemBounds.set(pos, bounds);
+
+    // Mark the leaf and its ancestors. Stops at the first node that is already marked.
+    for (uint32_t nodeIndex = mItemLeaves[pos]; nodeIndex != kInvalidIndex && !mNodeDirty[nodeIndex];
+         nodeIndex = mNodes[nodeIndex].parent)
+    {
+        mNodeDirty[nodeIndex] = true;
+        mDirtyNodes.push_back(nodeIndex);
+    }
+}
+
+void InstanceBVH::refit()
+{
+    // Children have higher indices than their parent, so refit in descending order.
+    std::sort(mDirtyNodes.begin(), mDirtyNodes.end(), std::greater<uint32_t>());
+    for (uint32_t nodeIndex : mDirtyNodes)
+    {
+        auto& node = mNodes[nodeIndex];
+        AABB bounds;
+        if (node.isLeaf())
+        {
+            for (uint32_t pos = node.begin; pos < node.end; pos++)
+                bounds.include(mItemBounds.get(pos));
+        }
+        else
+        {
+            bounds.include(mNodes[node.left].bounds);
+            bounds.include(mNodes[node.left + 1].bounds);
+        }
+        node.bounds = bounds;
+        mNodeDirty[nodeIndex] = false;
+    }
+    mDirtyNodes.clear();
+}
+
+void InstanceBVH::appendItems(const Node& node, std::vector<uint32_t>& ids) const
+{
+    ids.insert(ids.end(), mItemIDs.begin() + node.begin, mItemIDs.begin() + node.end);
+}
+
+void InstanceBVH::queryFrustum(FrustumCulling& frustum, std::vector<uint32_t>& ids) const
+{
+    if (mNodes.empty())
+        return;
+
+    // Plane that rejected each node in the previous query with this frustum. Reset if the hierarchy changed.
+    auto& rejectingPlanes = frustum.getRejectingPlanes();
+    if (rejectingPlanes.size() != mNodes.size())
+        rejectingPlanes.assign(mNodes.size(), 0);
+
+    // Each entry holds a node and the planes its parent is not fully in front of.
+    std::vector<std::pair<uint32_t, uint32_t>> stack = {{0, FrustumCulling::kAllPlanes}};
+    std::vector<uint8_t> visible;
+    while (!stack.empty())
+    {
+        auto [nodeIndex, planeMask] = stack.back();
+        stack.pop_back();
+        const Node& node = mNodes[nodeIndex];
+
+        switch (frustum.classify(node.bounds, planeMask, rejectingPlanes[nodeIndex]))
+        {
+        case FrustumCulling::Intersection::Outside:
+            break;
+        case FrustumCulling::Intersection::Inside:
+            appendItems(node, ids);
+            break;
+        case FrustumCulling::Intersection::Intersecting:
+            if (node.isLeaf())
+            {
+                visible.resize(node.end - node.begin);
+                frustum.isInFrustum(mItemBounds, node.begin, node.end, planeMask, rejectingPlanes[nodeIndex], visible.data());
+                for (uint32_t pos = node.begin; pos < node.end; pos++)
+                {
+                    if (visible[pos - node.begin])
+                        ids.push_back(mItemIDs[pos]);
+                }
+            }
+            else
+            {
+                stack.push_back({node.left + 1, planeMask});
+                stack.push_back({node.left, planeMask});
+            }
+            break;
+        }
+    }
+}
+
+void InstanceBVH::queryAABB(const AABB& box, std::vector<uint32_t>& ids) const
+{
+    if (mNodes.empty())
+        return;
+
+    std::vector<uint32_t> stack = {0};
+    while (!stack.empty())
+    {
+        const Node& node = mNodes[stack.back()];
+        stack.pop_back();
+
+        if (!overlaps(node.bounds, box))
+            continue;
+
+        if (contains(box, node.bounds))
+        {
+            appendItems(node, ids);
+        }
+        else if (node.isLeaf())
+        {
+            for (uint32_t pos = node.begin; pos < node.end; pos++)
+            {
+                if (overlaps(mItemBounds.get(pos), box))
+                    ids.push_back(mItemIDs[pos]);
+            }
+        }
+        else
+        {
+            stack.push_back(node.left + 1);
+            stack.push_back(node.left);
+        }
+    }
+}
+} // namespace Falcor
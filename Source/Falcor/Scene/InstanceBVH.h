@@ -0,0 +1,122 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "FrustumCulling.h"
+#include "Core/Macros.h"
+#include "Utils/Math/AABB.h"
+#include <cstdint>
+#include <vector>
+
+namespace Falcor
+{
+    /** Bounding volume hierarchy over world-space instance bounds for CPU-side culling queries.
+
+        The hierarchy is built with median splits along the longest centroid axis and stores the item
+        bounds of each leaf contiguously in SoA layout, so leaves are tested with the batched frustum test.
+        When instances move, their bounds are updated with setItemBounds() and only the nodes above them
+        are refit. The hierarchy only needs to be rebuilt when the set of items changes.
+
+        Queries skip subtrees outside of the query volume and return subtrees fully inside of it without
+        testing their items, so the cost scales with the number of visible items. Frustum queries only test
+        the planes a node's parent is not fully in front of, and first test the plane that rejected the node
+        in the previous query with the same frustum.
+    */
+    class FALCOR_API InstanceBVH
+    {
+    public:
+        /// Item of the hierarchy.
+        struct Item
+        {
+            uint32_t id = 0; ///< User ID, e.g. the geometry instance ID. IDs index a lookup table and should be dense.
+            AABB bounds;     ///< World-space bounds.
+        };
+
+        /// Maximum number of items per leaf. Leaves may hold more items if their centroids coincide.
+        static constexpr uint32_t kMaxLeafSize = 16;
+
+        /** Build the hierarchy.
+            \param[in] items Items to insert. Replaces all previous items.
+        */
+        void build(const std::vector<Item>& items);
+
+        /// Remove all items.
+        void clear();
+
+        bool isEmpty() const { return mNodes.empty(); }
+        size_t getItemCount() const { return mItemIDs.size(); }
+        size_t getNodeCount() const { return mNodes.size(); }
+
+        /// Returns the bounds of all items.
+        AABB getBounds() const { return mNodes.empty() ? AABB() : mNodes[0].bounds; }
+
+        /** Update the bounds of an item. Call refit() afterwards to update the hierarchy.
+            \param[in] id ID of an item in the hierarchy.
+            \param[in] bounds New world-space bounds.
+        */
+        void setItemBounds(uint32_t id, const AABB& bounds);
+
+        /// Refit the nodes above the items changed with setItemBounds().
+        void refit();
+
+        /** Find the items that pass the frustum test.
+            \param[in] frustum Frustum to test against. Its temporal state is updated.
+            \param[out] ids IDs of the items that pass FrustumCulling::isInFrustum(), appended in hierarchy order.
+        */
+        void queryFrustum(FrustumCulling& frustum, std::vector<uint32_t>& ids) const;
+
+        /** Find the items that overlap a box.
+            \param[in] box World-space box.
+            \param[out] ids IDs of the items overlapping the box, appended in hierarchy order.
+        */
+        void queryAABB(const AABB& box, std::vector<uint32_t>& ids) const;
+
+    private:
+        static constexpr uint32_t kInvalidIndex = 0xffffffff;
+
+        struct Node
+        {
+            AABB bounds;
+            uint32_t begin = 0;               ///< First item (in hierarchy order) of the subtree.
+            uint32_t end = 0;                 ///< One past the last item of the subtree.
+            uint32_t left = kInvalidIndex;    ///< Index of the left child, the right child follows it. kInvalidIndex for leaves.
+            uint32_t parent = kInvalidIndex;  ///< Index of the parent node. kInvalidIndex for the root.
+
+            bool isLeaf() const { return left == kInvalidIndex; }
+        };
+
+        void appendItems(const Node& node, std::vector<uint32_t>& ids) const;
+
+        std::vector<Node> mNodes;                ///< Nodes. Children always follow their parent.
+        std::vector<uint32_t> mItemIDs;          ///< Item IDs in hierarchy order.
+        FrustumCulling::AABBArray mItemBounds;   ///< Item bounds in hierarchy order.
+        std::vector<uint32_t> mItemLeaves;       ///< Leaf node per item, in hierarchy order.
+        std::vector<uint32_t> mItemPositions;    ///< Position in hierarchy order per item ID. kInvalidIndex if not present.
+        std::vector<uint32_t> mDirtyNodes;       ///< Nodes to refit.
+        std::vector<bool> mNodeDirty;            ///< Flag per node, true if the node is in mDirtyNodes.
+    };
+}
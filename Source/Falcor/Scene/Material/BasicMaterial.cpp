@@ -578,6 +578,27 @@ namespace Falcor
         return (*this) == (*other);
     }
 
+    uint64_t BasicMaterial::getHash() const
+    {
+        // Hashes the data compared in operator==, except for the samplers.
+        ContentHash hash;
+        hash.add(getBaseHash());
+        hash.add(mData.flags);
+        hash.add(mData.displacementScale);
+        hash.add(mData.displacementOffset);
+        hash.add(mData.baseColor);
+        hash.add(mData.specular);
+        hash.add(mData.emissive);
+        hash.add(mData.emissiveFactor);
+        hash.add(mData.diffuseTransmission);
+        hash.add(mData.specularTransmission);
+        hash.add(mData.transmission);
+        hash.add(mData.volumeAbsorption);
+        hash.add(mData.volumeAnisotropy);
+        hash.add(mData.volumeScattering);
+        return hash.get();
+    }
+
     bool BasicMaterial::operator==(const BasicMaterial& other) const
     {
         if (!isBaseEqual(other)) return false;
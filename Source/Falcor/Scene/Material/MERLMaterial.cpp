@@ -145,6 +145,14 @@ namespace Falcor
         return true;
     }
 
+    uint64_t MERLMaterial::getHash() const
+    {
+        ContentHash hash;
+        hash.add(getBaseHash());
+        hash.add(mPath);
+        return hash.get();
+    }
+
     Program::ShaderModuleList MERLMaterial::getShaderModules() const
     {
         return { Program::ShaderModule(kShaderFile) };
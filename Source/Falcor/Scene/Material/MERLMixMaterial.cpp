@@ -235,6 +235,20 @@ namespace Falcor
         return true;
     }
 
+    uint64_t MERLMixMaterial::getHash() const
+    {
+        // Hashes the data compared in isEqual(), except for the sampler.
+        ContentHash hash;
+        hash.add(getBaseHash());
+        hash.add(mBRDFs.size());
+        for (const auto& brdf : mBRDFs)
+        {
+            hash.add(brdf.name);
+            hash.add(brdf.path);
+        }
+        return hash.get();
+    }
+
     Program::ShaderModuleList MERLMixMaterial::getShaderModules() const
     {
         return { Program::ShaderModule(kShaderFile) };
@@ -318,6 +318,45 @@ namespace Falcor
         return true;
     }
 
+    uint64_t Material::getBaseHash() const
+    {
+        // Hashes the same data that isBaseEqual() compares.
+        ContentHash hash;
+        hash.add(mHeader.packedData);
+        hash.add(mTextureTransform.getTranslation());
+        hash.add(mTextureTransform.getScaling());
+        const quatf& rotation = mTextureTransform.getRotation();
+        hash.add(float4(rotation.x, rotation.y, rotation.z, rotation.w));
+
+        for (size_t i = 0; i < mTextureSlotInfo.size(); i++)
+        {
+            auto slot = (TextureSlot)i;
+            hash.add(hasTextureSlot(slot));
+            if (hasTextureSlot(slot))
+            {
+                hash.add(mTextureSlotInfo[i].name);
+                hash.add(mTextureSlotInfo[i].mask);
+                hash.add(mTextureSlotInfo[i].srgb);
+                hash.add(mTextureSlotData[i].pTexture);
+            }
+        }
+
+        return hash.get();
+    }
+
+    void Material::ContentHash::add(const ref<Texture>& pTexture)
+    {
+        add(pTexture != nullptr);
+        if (pTexture)
+        {
+            add(pTexture->getSourcePath());
+            add(pTexture->getFormat());
+            add(pTexture->getWidth());
+            add(pTexture->getHeight());
+            add(pTexture->getDepth());
+        }
+    }
+
     NormalMapType Material::detectNormalMapType(const ref<Texture>& pNormalMap)
     {
         NormalMapType type = NormalMapType::None;
@@ -40,10 +40,12 @@
 #include "Scene/Transform.h"
 #include "MaterialTypeRegistry.h"
 #include <array>
+#include <cstring>
 #include <filesystem>
 #include <functional>
 #include <memory>
 #include <string>
+#include <type_traits>
 
 namespace Falcor
 {
@@ -155,6 +157,13 @@ namespace Falcor
         */
         virtual bool isEqual(const ref<Material>& pOther) const = 0;
 
+        /** Get a hash of the material content.
+            Materials that compare equal with isEqual() have the same hash. The hash does not depend on
+            object addresses, so it is stable across runs for the same content.
+            \return Hash of all material properties *except* the name.
+        */
+        virtual uint64_t getHash() const = 0;
+
         /** Set the double-sided flag. This flag doesn't affect the cull state, just the shading.
         */
         virtual void setDoubleSided(bool doubleSided);
@@ -338,6 +347,64 @@ namespace Falcor
         void updateTextureHandle(MaterialSystem* pOwner, const TextureSlot slot, TextureHandle& handle);
         void updateDefaultTextureSamplerID(MaterialSystem* pOwner, const ref<Sampler>& pSampler);
         bool isBaseEqual(const Material& other) const;
+        uint64_t getBaseHash() const;
+
+        /** Helper for computing content hashes that are consistent with equality comparisons.
+            Floating-point values are hashed by value, so that +0 and -0 hash the same.
+        */
+        class ContentHash
+        {
+        public:
+            template<typename T>
+            void add(const T& value)
+            {
+                if constexpr (std::is_same_v<T, float> || std::is_same_v<T, float16_t>)
+                {
+                    float f = (float)value;
+                    uint32_t bits = 0;
+                    if (f != 0.f) std::memcpy(&bits, &f, sizeof(bits));
+                    addBits(bits);
+                }
+                else
+                {
+                    static_assert(std::is_integral_v<T> || std::is_enum_v<T>, "Unsupported type");
+                    addBits((uint64_t)value);
+                }
+            }
+
+            template<typename T, int N>
+            void add(const math::vector<T, N>& v)
+            {
+                for (int i = 0; i < N; i++) add(v[i]);
+            }
+
+            void add(const std::string& str)
+            {
+                // FNV-1a over the characters.
+                uint64_t h = 0xcbf29ce484222325ull;
+                for (char c : str) h = (h ^ (uint8_t)c) * 0x100000001b3ull;
+                addBits(h);
+                addBits(str.size());
+            }
+
+            /// Paths compare by elements, so they are hashed in normal form with generic separators.
+            void add(const std::filesystem::path& path) { add(path.lexically_normal().generic_string()); }
+
+            /// Textures are compared by identity. They are hashed by their source path and properties instead of their address.
+            void add(const ref<Texture>& pTexture);
+
+            uint64_t get() const { return mHash; }
+
+        private:
+            void addBits(uint64_t v)
+            {
+                mHash ^= v + 0x9e3779b97f4a7c15ull + (mHash << 6) + (mHash >> 2);
+                mHash *= 0xff51afd7ed558ccdull;
+                mHash ^= mHash >> 33;
+            }
+
+            uint64_t mHash = 0;
+        };
 
         static NormalMapType detectNormalMapType(const ref<Texture>& pNormalMap);
 
@@ -30,7 +30,9 @@
 #include "Core/API/Device.h"
 #include "Utils/Logger.h"
 #include "Utils/StringUtils.h"
+#include "Utils/Threading.h"
 #include "MaterialTypeRegistry.h"
+#include <algorithm>
 #include <numeric>
 
 namespace Falcor
@@ -302,27 +304,67 @@ namespace Falcor
 
     size_t MaterialSystem::removeDuplicateMaterials(std::vector<MaterialID>& idMap)
     {
-        std::vector<ref<Material>> uniqueMaterials;
-        idMap.resize(mMaterials.size());
+        const size_t materialCount = mMaterials.size();
+        idMap.resize(materialCount);
+
+        // Sort materials by content hash. Equal materials have equal hashes, so duplicates are only searched for
+        // within runs of equal hashes. Materials with the same hash stay in ID order.
+        std::vector<uint64_t> hashes(materialCount);
+        Threading::parallelFor(0, materialCount, [&](size_t i) { hashes[i] = mMaterials[i]->getHash(); });
+
+        std::vector<uint32_t> order(materialCount);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return hashes[a] != hashes[b] ? hashes[a] < hashes[b] : a < b; });
+
+        std::vector<size_t> runs;
+        for (size_t i = 0; i < materialCount; i++)
+        {
+            if (i == 0 || hashes[order[i]] != hashes[order[i - 1]]) runs.push_back(i);
+        }
+        runs.push_back(materialCount);
 
-        // Find unique set of materials.
-        for (MaterialID id{ 0 }; id.get() < mMaterials.size(); ++id)
+        // Find the first equal material of each material within its run.
+        std::vector<uint32_t> firstEqual(materialCount);
+        Threading::parallelFor(
+            0, runs.size() - 1,
+            [&](size_t run)
+            {
+                std::vector<uint32_t> uniqueIDs;
+                for (size_t i = runs[run]; i < runs[run + 1]; i++)
+                {
+                    const uint32_t id = order[i];
+                    auto it = std::find_if(uniqueIDs.begin(), uniqueIDs.end(), [&](uint32_t uniqueID) { return mMaterials[uniqueID]->isEqual(mMaterials[id]); });
+                    if (it == uniqueIDs.end())
+                    {
+                        uniqueIDs.push_back(id);
+                        firstEqual[id] = id;
+                    }
+                    else
+                    {
+                        firstEqual[id] = *it;
+                    }
+                }
+            }
+        );
+
+        // Assign new IDs in the original order.
+        std::vector<ref<Material>> uniqueMaterials;
+        for (MaterialID id{ 0 }; id.get() < materialCount; ++id)
         {
-            const auto& pMaterial = mMaterials[id.get()];
-            auto it = std::find_if(uniqueMaterials.begin(), uniqueMaterials.end(), [&pMaterial](const auto& m) { return m->isEqual(pMaterial); });
-            if (it == uniqueMaterials.end())
+            const uint32_t original = firstEqual[id.get()];
+            if (original == id.get())
             {
                 idMap[id.get()] = MaterialID{ uniqueMaterials.size() };
-                uniqueMaterials.push_back(pMaterial);
+                uniqueMaterials.push_back(mMaterials[id.get()]);
             }
             else
             {
-                logInfo("Removing duplicate material '{}' (duplicate of '{}').", pMaterial->getName(), (*it)->getName());
-                idMap[id.get()] = MaterialID{ (size_t)std::distance(uniqueMaterials.begin(), it) };
+                logInfo("Removing duplicate material '{}' (duplicate of '{}').", mMaterials[id.get()]->getName(), mMaterials[original]->getName());
+                idMap[id.get()] = idMap[original];
             }
         }
 
-        size_t removed = mMaterials.size() - uniqueMaterials.size();
+        size_t removed = materialCount - uniqueMaterials.size();
         if (removed > 0)
         {
             mMaterials = uniqueMaterials;
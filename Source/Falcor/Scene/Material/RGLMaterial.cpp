@@ -133,6 +133,14 @@ namespace Falcor
         return true;
     }
 
+    uint64_t RGLMaterial::getHash() const
+    {
+        ContentHash hash;
+        hash.add(getBaseHash());
+        hash.add(mFilePath);
+        return hash.get();
+    }
+
     Program::ShaderModuleList RGLMaterial::getShaderModules() const
     {
         return { Program::ShaderModule(kShaderFile) };
@@ -50,6 +50,7 @@ namespace Falcor
         bool renderUI(Gui::Widgets& widget) override;
         Material::UpdateFlags update(MaterialSystem* pOwner) override;
         bool isEqual(const ref<Material>& pOther) const override;
+        uint64_t getHash() const override;
         MaterialDataBlob getDataBlob() const override { return prepareDataBlob(mData); }
         Program::ShaderModuleList getShaderModules() const override;
         Program::TypeConformanceList getTypeConformances() const override;
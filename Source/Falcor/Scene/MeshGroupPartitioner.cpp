@@ -0,0 +1,274 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "MeshGroupPartitioner.h"
+#include "Core/Assert.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+
+namespace Falcor
+{
+namespace
+{
+// Number of bins for evaluating cuts. Ranges with fewer items evaluate every cut.
+const uint32_t kBinCount = 32;
+
+// Cost model constants. A ray entering a group pays for the instance and then for each level of the BLAS.
+// Rays through the overlap of two groups traverse both, which is penalized in addition to the SAH cost.
+const float kGroupCost = 1.f;
+const float kNodeCost = 1.f;
+const float kOverlapCost = 1.f;
+
+float groupCost(uint64_t triangleCount)
+{
+    return kGroupCost + kNodeCost * std::log2(float(triangleCount) + 1.f);
+}
+
+float area(const AABB& bb)
+{
+    return bb.valid() ? bb.area() : 0.f;
+}
+
+float overlapArea(const AABB& a, const AABB& b)
+{
+    return area(a & b);
+}
+
+/// Spreads the lower 10 bits of v so that there are two zero bits between each bit.
+uint32_t expandBits(uint32_t v)
+{
+    v &= 0x3ff;
+    v = (v * 0x00010001u) & 0xff0000ffu;
+    v = (v * 0x00000101u) & 0x0f00f00fu;
+    v = (v * 0x00000011u) & 0xc30c30c3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+    return v;
+}
+
+/// Returns the 30-bit Morton code of a point in the unit cube.
+uint32_t mortonCode(const float3& p)
+{
+    auto quantize = [](float x) { return (uint32_t)std::clamp(x * 1024.f, 0.f, 1023.f); };
+    return (expandBits(quantize(p.x)) << 2) | (expandBits(quantize(p.y)) << 1) | expandBits(quantize(p.z));
+}
+
+class SAHPartitioner
+{
+public:
+    SAHPartitioner(const std::vector<MeshGroupPartitioner::Item>& items, uint64_t maxTrianglesPerGroup)
+        : mItems(items), mMaxTriangles(std::max<uint64_t>(maxTrianglesPerGroup, 1))
+    {}
+
+    std::vector<MeshGroupPartitioner::Group> run()
+    {
+        if (mItems.empty())
+            return {};
+
+        // Sort the items along a Morton curve through the centroids of their bounds.
+        AABB centroidBounds;
+        for (const auto& item : mItems)
+        {
+            if (item.bounds.valid())
+                centroidBounds.include(item.bounds.center());
+        }
+
+        const float3 origin = centroidBounds.valid() ? centroidBounds.minPoint : float3(0.f);
+        const float3 extent = centroidBounds.valid() ? centroidBounds.extent() : float3(0.f);
+        const float3 scale(
+            extent.x > 0.f ? 1.f / extent.x : 0.f, extent.y > 0.f ? 1.f / extent.y : 0.f, extent.z > 0.f ? 1.f / extent.z : 0.f
+        );
+
+        std::vector<uint64_t> keys(mItems.size());
+        uint64_t triangleCount = 0;
+        for (size_t i = 0; i < mItems.size(); i++)
+        {
+            const auto& bounds = mItems[i].bounds;
+            const uint32_t code = bounds.valid() ? mortonCode((bounds.center() - origin) * scale) : 0;
+            keys[i] = (uint64_t(code) << 32) | i;
+            triangleCount += mItems[i].triangleCount;
+        }
+        std::sort(keys.begin(), keys.end());
+
+        mOrder.resize(mItems.size());
+        for (size_t i = 0; i < keys.size(); i++)
+            mOrder[i] = (uint32_t)keys[i];
+
+        split(0, (uint32_t)mOrder.size(), triangleCount);
+        return std::move(mGroups);
+    }
+
+private:
+    uint64_t groupsNeeded(uint64_t triangleCount, uint32_t itemCount) const
+    {
+        return itemCount == 1 ? 1 : (triangleCount + mMaxTriangles - 1) / mMaxTriangles;
+    }
+
+    void split(uint32_t begin, uint32_t end, uint64_t triangleCount)
+    {
+        FALCOR_ASSERT(begin < end);
+        const uint32_t itemCount = end - begin;
+        if (triangleCount <= mMaxTriangles || itemCount == 1)
+        {
+            mGroups.emplace_back(mOrder.begin() + begin, mOrder.begin() + end);
+            return;
+        }
+
+        // Assign the items to bins by the midpoint of their triangle range, so that bins hold similar amounts
+        // of geometry. Bin indices are increasing along the Morton order, so each bin is a contiguous range.
+        // With two or more items, the first and last item always end up in different bins.
+        const uint32_t binCount = std::min(kBinCount, itemCount);
+        std::array<AABB, kBinCount> binBounds;
+        std::array<uint64_t, kBinCount> binTriangles = {};
+        std::array<uint32_t, kBinCount> binEnd = {};
+
+        uint64_t prefix = 0;
+        for (uint32_t i = begin; i < end; i++)
+        {
+            const auto& item = mItems[mOrder[i]];
+            const double midpoint = prefix + 0.5 * item.triangleCount;
+            const uint32_t bin = std::min(binCount - 1, (uint32_t)(midpoint * binCount / triangleCount));
+            binBounds[bin].include(item.bounds);
+            binTriangles[bin] += item.triangleCount;
+            binEnd[bin] = i + 1;
+            prefix += item.triangleCount;
+        }
+
+        // Sweep from the right to get the bounds of all cuts.
+        std::array<AABB, kBinCount> rightBounds;
+        std::array<uint64_t, kBinCount> rightTriangles = {};
+        for (uint32_t bin = binCount - 1; bin > 0; bin--)
+        {
+            rightBounds[bin] = binBounds[bin];
+            rightTriangles[bin] = binTriangles[bin];
+            if (bin + 1 < binCount)
+            {
+                rightBounds[bin].include(rightBounds[bin + 1]);
+                rightTriangles[bin] += rightTriangles[bin + 1];
+            }
+        }
+
+        // Sweep from the left and pick the cut that needs the fewest groups, then the one with the lowest cost.
+        AABB leftBounds;
+        uint64_t leftTriangles = 0;
+        uint32_t cut = begin;
+        uint32_t bestCut = 0;
+        uint64_t bestGroups = 0;
+        float bestCost = 0.f;
+
+        for (uint32_t bin = 0; bin + 1 < binCount; bin++)
+        {
+            leftBounds.include(binBounds[bin]);
+            leftTriangles += binTriangles[bin];
+            if (binEnd[bin] != 0)
+                cut = binEnd[bin];
+
+            // Skip cuts that leave one side empty, and empty bins that repeat the previous cut.
+            if (cut == begin || cut == end || binEnd[bin] == 0)
+                continue;
+
+            const uint64_t groups = groupsNeeded(leftTriangles, cut - begin) + groupsNeeded(rightTriangles[bin + 1], end - cut);
+            const float leftCost = groupCost(leftTriangles);
+            const float rightCost = groupCost(rightTriangles[bin + 1]);
+            const float cost = area(leftBounds) * leftCost + area(rightBounds[bin + 1]) * rightCost +
+                               kOverlapCost * overlapArea(leftBounds, rightBounds[bin + 1]) * std::min(leftCost, rightCost);
+
+            if (bestCut == 0 || groups < bestGroups || (groups == bestGroups && cost < bestCost))
+            {
+                bestCut = cut;
+                bestGroups = groups;
+                bestCost = cost;
+            }
+        }
+        FALCOR_ASSERT(bestCut > begin && bestCut < end);
+
+        uint64_t bestLeftTriangles = 0;
+        for (uint32_t i = begin; i < bestCut; i++)
+            bestLeftTriangles += mItems[mOrder[i]].triangleCount;
+
+        split(begin, bestCut, bestLeftTriangles);
+        split(bestCut, end, triangleCount - bestLeftTriangles);
+    }
+
+    const std::vector<MeshGroupPartitioner::Item>& mItems;
+    const uint64_t mMaxTriangles;
+    std::vector<uint32_t> mOrder;
+    std::vector<MeshGroupPartitioner::Group> mGroups;
+};
+} // namespace
+
+std::vector<MeshGroupPartitioner::Group> MeshGroupPartitioner::partitionSAH(const std::vector<Item>& items, uint64_t maxTrianglesPerGroup)
+{
+    return SAHPartitioner(items, maxTrianglesPerGroup).run();
+}
+
+MeshGroupPartitioner::CostReport MeshGroupPartitioner::evaluate(const std::vector<Item>& items, const std::vector<Group>& groups)
+{
+    CostReport report;
+    report.groupCount = (uint32_t)groups.size();
+
+    std::vector<AABB> groupBounds(groups.size());
+    std::vector<uint64_t> groupTriangles(groups.size(), 0);
+    AABB bounds;
+
+    for (size_t g = 0; g < groups.size(); g++)
+    {
+        for (uint32_t index : groups[g])
+        {
+            FALCOR_ASSERT(index < items.size());
+            groupBounds[g].include(items[index].bounds);
+            groupTriangles[g] += items[index].triangleCount;
+        }
+        bounds.include(groupBounds[g]);
+        report.maxTriangleCount = std::max(report.maxTriangleCount, groupTriangles[g]);
+    }
+
+    // The probability of a ray hitting the bounds of all groups to also hit a group is given by the ratio of their surface areas.
+    const float totalArea = area(bounds);
+    for (size_t g = 0; g < groups.size(); g++)
+    {
+        const float probability = totalArea > 0.f ? area(groupBounds[g]) / totalArea : 1.f;
+        report.traversalCost += probability * groupCost(groupTriangles[g]);
+    }
+
+    for (size_t i = 0; i < groups.size(); i++)
+    {
+        for (size_t j = i + 1; j < groups.size(); j++)
+        {
+            const AABB overlap = groupBounds[i] & groupBounds[j];
+            if (overlap.valid())
+                report.overlapVolume += overlap.volume();
+        }
+    }
+
+    const float totalVolume = bounds.valid() ? bounds.volume() : 0.f;
+    report.overlapRatio = totalVolume > 0.f ? report.overlapVolume / totalVolume : 0.f;
+
+    return report;
+}
+} // namespace Falcor
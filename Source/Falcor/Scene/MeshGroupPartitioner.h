@@ -0,0 +1,81 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include "Utils/Math/AABB.h"
+#include <cstdint>
+#include <vector>
+
+namespace Falcor
+{
+    /** Partitions meshes into groups (BLASes) with a limited number of triangles.
+
+        partitionSAH() sorts the meshes along a Morton curve through their centroids and recursively cuts the
+        sorted list with a binned surface area heuristic (SAH). The cost of a cut includes the surface area of
+        the overlap between the two sides. Cuts that need the fewest groups to satisfy the triangle limit are
+        always preferred. Meshes are not split, so a single mesh may exceed the limit.
+
+        evaluate() computes a CPU cost model of a partition, so that different strategies can be compared
+        without building acceleration structures on the GPU.
+    */
+    class FALCOR_API MeshGroupPartitioner
+    {
+    public:
+        /// Mesh to partition.
+        struct Item
+        {
+            AABB bounds;
+            uint64_t triangleCount = 0;
+        };
+
+        using Group = std::vector<uint32_t>; ///< Indices of the items in a group.
+
+        /// Cost model of a partition.
+        struct CostReport
+        {
+            uint32_t groupCount = 0;
+            uint64_t maxTriangleCount = 0; ///< Triangle count of the largest group.
+            float traversalCost = 0.f;     ///< Expected traversal cost of a ray hitting the bounds of all groups (SAH).
+            float overlapVolume = 0.f;     ///< Sum of the intersection volumes of all pairs of groups.
+            float overlapRatio = 0.f;      ///< Overlap volume relative to the volume of the bounds of all groups.
+        };
+
+        /** Partition the items using Morton order and binned SAH.
+            \param[in] items Items to partition.
+            \param[in] maxTrianglesPerGroup Target maximum number of triangles per group.
+            \return List of groups. Items within a group are in Morton order.
+        */
+        static std::vector<Group> partitionSAH(const std::vector<Item>& items, uint64_t maxTrianglesPerGroup);
+
+        /** Evaluate the cost model of a partition.
+            \param[in] items Items referenced by the groups.
+            \param[in] groups List of groups.
+        */
+        static CostReport evaluate(const std::vector<Item>& items, const std::vector<Group>& groups);
+    };
+}
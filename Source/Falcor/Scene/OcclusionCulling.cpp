@@ -0,0 +1,384 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "OcclusionCulling.h"
+#include "Core/Assert.h"
+#include "Utils/Math/Common.h"
+#include "Utils/Threading.h"
+#include "Core/Platform/OS.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if FALCOR_HAS_AVX2_TARGET
+#include <immintrin.h>
+#endif
+
+namespace Falcor
+{
+namespace
+{
+// Depth of pixels without occluders. Not infinity, so boxes behind the far plane are still only occluded by occluders
+const float kClearDepth = std::numeric_limits<float>::max();
+
+// Triangles with a smaller area in pixels are skipped
+const double kMinTriangleArea = 1e-6;
+
+float3 toScreen(const float4& clip, uint32_t width, uint32_t height)
+{
+    const float invW = 1.f / clip.w;
+    return float3((clip.x * invW * 0.5f + 0.5f) * width, (clip.y * invW * 0.5f + 0.5f) * height, clip.z * invW);
+}
+
+#if FALCOR_HAS_AVX2_TARGET
+/// Rasterizes a triangle row, 8 pixels per iteration. Same pixels and operations as the scalar path in rasterizeTriangleRow().
+FALCOR_TARGET_AVX2 void rasterizeRowAVX2(
+    const float edgeA[3],
+    float rowEdge0,
+    float rowEdge1,
+    float rowEdge2,
+    float depthA,
+    float rowDepth,
+    float minDepth,
+    float maxDepth,
+    int32_t minX,
+    int32_t maxX,
+    float* pRow
+)
+{
+    // Spans start at a multiple of 8 pixels, which is safe as the width is a multiple of the tile size.
+    const __m256 laneOffsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 a0 = _mm256_set1_ps(edgeA[0]), a1 = _mm256_set1_ps(edgeA[1]), a2 = _mm256_set1_ps(edgeA[2]);
+    const __m256 r0 = _mm256_set1_ps(rowEdge0), r1 = _mm256_set1_ps(rowEdge1), r2 = _mm256_set1_ps(rowEdge2);
+    const __m256 dA = _mm256_set1_ps(depthA), dRow = _mm256_set1_ps(rowDepth);
+    const __m256 dMin = _mm256_set1_ps(minDepth), dMax = _mm256_set1_ps(maxDepth);
+
+    for (int32_t x = minX & ~7; x <= maxX; x += 8)
+    {
+        const __m256 px = _mm256_add_ps(_mm256_set1_ps(float(x)), laneOffsets);
+        const __m256 e0 = _mm256_add_ps(_mm256_mul_ps(a0, px), r0);
+        const __m256 e1 = _mm256_add_ps(_mm256_mul_ps(a1, px), r1);
+        const __m256 e2 = _mm256_add_ps(_mm256_mul_ps(a2, px), r2);
+        const __m256 inside = _mm256_and_ps(
+            _mm256_and_ps(_mm256_cmp_ps(e0, zero, _CMP_GE_OQ), _mm256_cmp_ps(e1, zero, _CMP_GE_OQ)), _mm256_cmp_ps(e2, zero, _CMP_GE_OQ)
+        );
+        if (_mm256_movemask_ps(inside) == 0)
+            continue;
+
+        __m256 depth = _mm256_add_ps(_mm256_mul_ps(dA, px), dRow);
+        depth = _mm256_min_ps(_mm256_max_ps(depth, dMin), dMax);
+        const __m256 old = _mm256_loadu_ps(pRow + x);
+        _mm256_storeu_ps(pRow + x, _mm256_blendv_ps(old, _mm256_min_ps(depth, old), inside));
+    }
+}
+#endif
+} // namespace
+
+OcclusionCulling::OcclusionCulling(uint32_t width, uint32_t height)
+{
+    FALCOR_ASSERT(width > 0 && height > 0);
+    mTilesX = div_round_up(width, kTileSize);
+    mTilesY = div_round_up(height, kTileSize);
+    mWidth = mTilesX * kTileSize;
+    mHeight = mTilesY * kTileSize;
+
+    mDepth.assign(size_t(mWidth) * mHeight, kClearDepth);
+    mTileDepth.assign(size_t(mTilesX) * mTilesY, kClearDepth);
+    mBandTriangles.resize(mTilesY);
+}
+
+void OcclusionCulling::begin(const float4x4& viewProj, uint64_t occluderVersion)
+{
+    mViewProj = viewProj;
+    mOccluderVersion = occluderVersion;
+    mValid = false;
+    mStats = {};
+    mOccluders.clear();
+}
+
+void OcclusionCulling::addOccluder(
+    const float3* pPositions,
+    uint32_t vertexCount,
+    const uint32_t* pIndices,
+    uint32_t triangleCount,
+    const float4x4& transform
+)
+{
+    if (vertexCount == 0 || triangleCount == 0)
+        return;
+
+    Occluder occluder;
+    occluder.pPositions = pPositions;
+    occluder.pIndices = pIndices;
+    occluder.vertexCount = vertexCount;
+    occluder.triangleCount = triangleCount;
+    if (!mOccluders.empty())
+    {
+        occluder.firstVertex = mOccluders.back().firstVertex + mOccluders.back().vertexCount;
+        occluder.firstTriangle = mOccluders.back().firstTriangle + mOccluders.back().triangleCount;
+    }
+    occluder.objectToClip = mul(mViewProj, transform);
+    mOccluders.push_back(occluder);
+
+    mStats.occluderCount++;
+    mStats.triangleCount += triangleCount;
+}
+
+void OcclusionCulling::rasterize()
+{
+    const uint32_t vertexCount = mOccluders.empty() ? 0 : mOccluders.back().firstVertex + mOccluders.back().vertexCount;
+    const uint32_t triangleCount = mStats.triangleCount;
+    mClipPositions.resize(vertexCount);
+    mTriangles.resize(triangleCount);
+    mTriangleValid.resize(triangleCount);
+
+    // Transform the vertices and set up the triangles per occluder
+    Threading::parallelFor(
+        0,
+        mOccluders.size(),
+        [&](size_t i)
+        {
+            const Occluder& occluder = mOccluders[i];
+            float4* pClip = mClipPositions.data() + occluder.firstVertex;
+            for (uint32_t v = 0; v < occluder.vertexCount; v++)
+                pClip[v] = mul(occluder.objectToClip, float4(occluder.pPositions[v], 1.f));
+
+            for (uint32_t t = 0; t < occluder.triangleCount; t++)
+            {
+                const uint32_t* pTriangle = occluder.pIndices + 3 * t;
+                FALCOR_ASSERT(pTriangle[0] < occluder.vertexCount && pTriangle[1] < occluder.vertexCount && pTriangle[2] < occluder.vertexCount);
+                const uint32_t index = occluder.firstTriangle + t;
+                mTriangleValid[index] = setupTriangle(pClip[pTriangle[0]], pClip[pTriangle[1]], pClip[pTriangle[2]], mTriangles[index]) ? 1 : 0;
+            }
+        },
+        1
+    );
+
+    // Bin the triangles into rows of tiles, so that each band is rasterized by a single thread
+    for (auto& triangles : mBandTriangles)
+        triangles.clear();
+
+    uint32_t rasterizedCount = 0;
+    for (uint32_t i = 0; i < triangleCount; i++)
+    {
+        if (!mTriangleValid[i])
+            continue;
+
+        const Triangle& tri = mTriangles[i];
+        for (int32_t band = tri.minY / (int32_t)kTileSize; band <= tri.maxY / (int32_t)kTileSize; band++)
+            mBandTriangles[band].push_back(i);
+        rasterizedCount++;
+    }
+    mStats.rasterizedTriangleCount = rasterizedCount;
+
+    Threading::parallelFor(0, mTilesY, [&](size_t band) { rasterizeBand((uint32_t)band); }, 1);
+
+    mValid = true;
+}
+
+bool OcclusionCulling::isOccluded(const AABB& aabb) const
+{
+    if (!mValid || !aabb.valid())
+        return false;
+
+    float2 minPos(std::numeric_limits<float>::max());
+    float2 maxPos(std::numeric_limits<float>::lowest());
+    float minDepth = std::numeric_limits<float>::max();
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        const float3 corner(
+            (i & 1) ? aabb.maxPoint.x : aabb.minPoint.x, (i & 2) ? aabb.maxPoint.y : aabb.minPoint.y, (i & 4) ? aabb.maxPoint.z : aabb.minPoint.z
+        );
+        const float4 clip = mul(mViewProj, float4(corner, 1.f));
+
+        // Boxes crossing the near plane may cover the whole view
+        if (clip.z < 0.f || clip.w <= 0.f)
+            return false;
+
+        const float3 screen = toScreen(clip, mWidth, mHeight);
+        minPos = math::min(minPos, float2(screen.x, screen.y));
+        maxPos = math::max(maxPos, float2(screen.x, screen.y));
+        minDepth = std::min(minDepth, screen.z);
+    }
+
+    // Boxes outside of the screen are left to the frustum test
+    if (maxPos.x < 0.f || maxPos.y < 0.f || minPos.x >= (float)mWidth || minPos.y >= (float)mHeight)
+        return false;
+
+    // All pixels the screen rectangle of the box touches
+    const int32_t x0 = (int32_t)std::max(std::floor(minPos.x), 0.f);
+    const int32_t y0 = (int32_t)std::max(std::floor(minPos.y), 0.f);
+    const int32_t x1 = (int32_t)std::min(std::floor(maxPos.x), float(mWidth - 1));
+    const int32_t y1 = (int32_t)std::min(std::floor(maxPos.y), float(mHeight - 1));
+
+    for (int32_t ty = y0 / (int32_t)kTileSize; ty <= y1 / (int32_t)kTileSize; ty++)
+    {
+        for (int32_t tx = x0 / (int32_t)kTileSize; tx <= x1 / (int32_t)kTileSize; tx++)
+        {
+            // The whole tile is in front of the box
+            if (minDepth > mTileDepth[ty * mTilesX + tx])
+                continue;
+
+            // Otherwise test the pixels of the tile the box overlaps
+            const int32_t px0 = std::max(x0, tx * (int32_t)kTileSize);
+            const int32_t px1 = std::min(x1, tx * (int32_t)kTileSize + (int32_t)kTileSize - 1);
+            const int32_t py0 = std::max(y0, ty * (int32_t)kTileSize);
+            const int32_t py1 = std::min(y1, ty * (int32_t)kTileSize + (int32_t)kTileSize - 1);
+            for (int32_t y = py0; y <= py1; y++)
+            {
+                const float* pRow = mDepth.data() + size_t(y) * mWidth;
+                for (int32_t x = px0; x <= px1; x++)
+                {
+                    if (minDepth <= pRow[x])
+                        return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+bool OcclusionCulling::setupTriangle(const float4& c0, const float4& c1, const float4& c2, Triangle& tri) const
+{
+    // Triangles crossing the near plane are skipped instead of clipped, they are rare among coarse occluders
+    if (c0.z < 0.f || c1.z < 0.f || c2.z < 0.f || c0.w <= 0.f || c1.w <= 0.f || c2.w <= 0.f)
+        return false;
+
+    float3 v[3] = {toScreen(c0, mWidth, mHeight), toScreen(c1, mWidth, mHeight), toScreen(c2, mWidth, mHeight)};
+
+    // Both windings occlude. Set up in double precision, vertices close to the near plane project far off screen
+    double area = (double(v[1].x) - v[0].x) * (double(v[2].y) - v[0].y) - (double(v[2].x) - v[0].x) * (double(v[1].y) - v[0].y);
+    if (!(std::abs(area) > kMinTriangleArea))
+        return false;
+    if (area < 0.0)
+    {
+        std::swap(v[1], v[2]);
+        area = -area;
+    }
+
+    // Pixels whose centers are inside the bounding rectangle
+    const float minX = std::max(std::ceil(std::min({v[0].x, v[1].x, v[2].x}) - 0.5f), 0.f);
+    const float maxX = std::min(std::floor(std::max({v[0].x, v[1].x, v[2].x}) - 0.5f), float(mWidth - 1));
+    const float minY = std::max(std::ceil(std::min({v[0].y, v[1].y, v[2].y}) - 0.5f), 0.f);
+    const float maxY = std::min(std::floor(std::max({v[0].y, v[1].y, v[2].y}) - 0.5f), float(mHeight - 1));
+    if (!(minX <= maxX && minY <= maxY))
+        return false;
+
+    tri.minX = (int32_t)minX;
+    tri.maxX = (int32_t)maxX;
+    tri.minY = (int32_t)minY;
+    tri.maxY = (int32_t)maxY;
+
+    // Edge k goes from vertex k to vertex k + 1 and is positive inside. Normalized, it is the barycentric of the opposite vertex
+    double edgeA[3], edgeB[3], edgeC[3];
+    for (uint32_t k = 0; k < 3; k++)
+    {
+        const float3& a = v[k];
+        const float3& b = v[(k + 1) % 3];
+        edgeA[k] = double(a.y) - b.y;
+        edgeB[k] = double(b.x) - a.x;
+        edgeC[k] = double(a.x) * b.y - double(a.y) * b.x;
+        tri.edgeA[k] = (float)edgeA[k];
+        tri.edgeB[k] = (float)edgeB[k];
+        tri.edgeC[k] = (float)edgeC[k];
+    }
+
+    const double z0 = v[0].z / area, z1 = v[1].z / area, z2 = v[2].z / area;
+    tri.depthA = (float)(z0 * edgeA[1] + z1 * edgeA[2] + z2 * edgeA[0]);
+    tri.depthB = (float)(z0 * edgeB[1] + z1 * edgeB[2] + z2 * edgeB[0]);
+    tri.depthC = (float)(z0 * edgeC[1] + z1 * edgeC[2] + z2 * edgeC[0]);
+
+    // Interpolated depth is clamped to the vertex depths, so rounding never moves an occluder closer than it is
+    tri.minDepth = std::min({v[0].z, v[1].z, v[2].z});
+    tri.maxDepth = std::max({v[0].z, v[1].z, v[2].z});
+
+    return true;
+}
+
+void OcclusionCulling::rasterizeBand(uint32_t band)
+{
+    float* pBand = mDepth.data() + size_t(band) * kTileSize * mWidth;
+    std::fill(pBand, pBand + size_t(kTileSize) * mWidth, kClearDepth);
+
+    const int32_t bandMinY = band * kTileSize;
+    const int32_t bandMaxY = bandMinY + kTileSize - 1;
+    for (uint32_t index : mBandTriangles[band])
+    {
+        const Triangle& tri = mTriangles[index];
+        const int32_t y1 = std::min(tri.maxY, bandMaxY);
+        for (int32_t y = std::max(tri.minY, bandMinY); y <= y1; y++)
+            rasterizeTriangleRow(tri, y, mDepth.data() + size_t(y) * mWidth);
+    }
+
+    // Reduce to the farthest depth per tile
+    for (uint32_t tx = 0; tx < mTilesX; tx++)
+    {
+        float maxDepth = 0.f;
+        for (uint32_t y = 0; y < kTileSize; y++)
+        {
+            const float* pTileRow = pBand + size_t(y) * mWidth + tx * kTileSize;
+            for (uint32_t x = 0; x < kTileSize; x++)
+                maxDepth = std::max(maxDepth, pTileRow[x]);
+        }
+        mTileDepth[band * mTilesX + tx] = maxDepth;
+    }
+}
+
+void OcclusionCulling::rasterizeTriangleRow(const Triangle& tri, int32_t y, float* pRow) const
+{
+    const float py = float(y) + 0.5f;
+    const float rowEdge0 = tri.edgeB[0] * py + tri.edgeC[0];
+    const float rowEdge1 = tri.edgeB[1] * py + tri.edgeC[1];
+    const float rowEdge2 = tri.edgeB[2] * py + tri.edgeC[2];
+    const float rowDepth = tri.depthB * py + tri.depthC;
+
+#if FALCOR_HAS_AVX2_TARGET
+    if (isAVX2Supported())
+    {
+        rasterizeRowAVX2(tri.edgeA, rowEdge0, rowEdge1, rowEdge2, tri.depthA, rowDepth, tri.minDepth, tri.maxDepth, tri.minX, tri.maxX, pRow);
+        return;
+    }
+#endif
+
+    // Same pixels as the AVX2 path
+    for (int32_t x = tri.minX & ~7; x <= (tri.maxX | 7); x++)
+    {
+        const float px = float(x) + 0.5f;
+        const float e0 = tri.edgeA[0] * px + rowEdge0;
+        const float e1 = tri.edgeA[1] * px + rowEdge1;
+        const float e2 = tri.edgeA[2] * px + rowEdge2;
+        if (!(e0 >= 0.f && e1 >= 0.f && e2 >= 0.f))
+            continue;
+
+        float depth = tri.depthA * px + rowDepth;
+        depth = std::min(std::max(depth, tri.minDepth), tri.maxDepth);
+        pRow[x] = std::min(depth, pRow[x]);
+    }
+}
+} // namespace Falcor
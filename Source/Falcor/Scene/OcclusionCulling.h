@@ -0,0 +1,159 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include "Core/Object.h"
+#include "Utils/Math/Vector.h"
+#include "Utils/Math/Matrix.h"
+#include "Utils/Math/AABB.h"
+#include <cstdint>
+#include <vector>
+
+namespace Falcor
+{
+    /** Coarse CPU occlusion culling for raster passes.
+
+        Opaque occluder triangles are rasterized on the worker threads into a low resolution depth buffer,
+        which is reduced to the farthest depth per tile (Hi-Z). Boxes are then tested against the tiles they
+        overlap and, for tiles that are only partially occluded, against the pixels they overlap.
+        Depth is the post-projection depth z/w (0 at the near plane), so perspective and orthographic
+        projections are handled the same way.
+
+        Occluder coverage is sampled at pixel centers, boxes are tested conservatively with their screen-space
+        bounding rectangle and nearest depth. Triangles crossing the near plane are not rasterized and boxes
+        crossing it are never occluded.
+
+        Usage: begin(), addOccluder() per occluder, rasterize(). isOccluded() may then be called concurrently.
+    */
+    class FALCOR_API OcclusionCulling : public Object
+    {
+        FALCOR_OBJECT(OcclusionCulling)
+    public:
+        struct Stats
+        {
+            uint32_t occluderCount = 0;             ///< Occluders added since begin().
+            uint32_t triangleCount = 0;             ///< Triangles of the occluders.
+            uint32_t rasterizedTriangleCount = 0;   ///< Triangles in front of the near plane that overlap at least one pixel center.
+        };
+
+        /// Tile size in pixels of the Hi-Z buffer. The buffer dimensions are rounded up to a multiple of it.
+        static constexpr uint32_t kTileSize = 8;
+        static constexpr uint32_t kDefaultWidth = 256;
+        static constexpr uint32_t kDefaultHeight = 128;
+        static constexpr uint32_t kDefaultTriangleBudget = 65536;
+
+        OcclusionCulling(uint32_t width = kDefaultWidth, uint32_t height = kDefaultHeight);
+
+        /** Clear the depth buffer and start collecting occluders.
+            \param[in] viewProj View projection matrix with depth in [0, 1].
+            \param[in] occluderVersion Version of the occluder set, see getOccluderVersion().
+        */
+        void begin(const float4x4& viewProj, uint64_t occluderVersion = 0);
+
+        /** Add an occluder mesh. The data is referenced until rasterize() returns.
+            \param[in] pPositions Object-space vertex positions.
+            \param[in] vertexCount Number of vertices.
+            \param[in] pIndices Triangle list indices into pPositions.
+            \param[in] triangleCount Number of triangles.
+            \param[in] transform Object to world transform.
+        */
+        void addOccluder(const float3* pPositions, uint32_t vertexCount, const uint32_t* pIndices, uint32_t triangleCount, const float4x4& transform);
+
+        /// Rasterize the occluders and build the Hi-Z tiles. Marks the buffer valid.
+        void rasterize();
+
+        /** Test a box against the occluders.
+            \param[in] aabb World-space box.
+            \return True if the box is fully behind the rasterized occluders.
+        */
+        bool isOccluded(const AABB& aabb) const;
+
+        /// Returns true after rasterize() until the next begin() or invalidate().
+        bool isValid() const { return mValid; }
+        void invalidate() { mValid = false; }
+
+        /// Version of the occluder set passed to begin(), used by the caller to detect moved occluders.
+        uint64_t getOccluderVersion() const { return mOccluderVersion; }
+
+        /// Maximum number of occluder triangles the caller should add per frame.
+        uint32_t getTriangleBudget() const { return mTriangleBudget; }
+        void setTriangleBudget(uint32_t budget) { mTriangleBudget = budget; }
+
+        const Stats& getStats() const { return mStats; }
+        const float4x4& getViewProjMatrix() const { return mViewProj; }
+        uint32_t getWidth() const { return mWidth; }
+        uint32_t getHeight() const { return mHeight; }
+
+        /// Returns the depth per pixel, row by row starting at the bottom of the screen. Pixels without occluders hold the largest float.
+        const std::vector<float>& getDepthBuffer() const { return mDepth; }
+
+    private:
+        struct Occluder
+        {
+            const float3* pPositions = nullptr;
+            const uint32_t* pIndices = nullptr;
+            uint32_t vertexCount = 0;
+            uint32_t triangleCount = 0;
+            uint32_t firstVertex = 0;   ///< Offset into mClipPositions.
+            uint32_t firstTriangle = 0; ///< Offset into mTriangles.
+            float4x4 objectToClip;
+        };
+
+        /// Triangle set up for rasterization. Edge functions and depth are planes e(x, y) = a * x + b * y + c in pixel coordinates.
+        struct Triangle
+        {
+            float edgeA[3], edgeB[3], edgeC[3];
+            float depthA, depthB, depthC;
+            float minDepth, maxDepth;
+            int32_t minX, maxX, minY, maxY; ///< Inclusive pixel bounds. Empty if minX > maxX.
+        };
+
+        bool setupTriangle(const float4& c0, const float4& c1, const float4& c2, Triangle& tri) const;
+        void rasterizeBand(uint32_t band);
+        void rasterizeTriangleRow(const Triangle& tri, int32_t y, float* pRow) const;
+
+        uint32_t mWidth = 0;
+        uint32_t mHeight = 0;
+        uint32_t mTilesX = 0;
+        uint32_t mTilesY = 0;
+        uint32_t mTriangleBudget = kDefaultTriangleBudget;
+
+        float4x4 mViewProj;
+        uint64_t mOccluderVersion = 0;
+        bool mValid = false;
+        Stats mStats;
+
+        std::vector<Occluder> mOccluders;
+        std::vector<float4> mClipPositions;                 ///< Clip-space positions of all occluder vertices.
+        std::vector<Triangle> mTriangles;                   ///< Set up triangles of all occluders.
+        std::vector<uint8_t> mTriangleValid;                ///< 1 if the triangle is rasterized.
+        std::vector<std::vector<uint32_t>> mBandTriangles;  ///< Triangles overlapping each row of tiles.
+        std::vector<float> mDepth;                          ///< Nearest occluder depth per pixel.
+        std::vector<float> mTileDepth;                      ///< Farthest depth of mDepth per tile.
+    };
+}
@@ -39,6 +39,7 @@
 #include "Core/API/RenderContext.h"
 #include "Core/API/IndirectCommands.h"
 #include "Utils/StringUtils.h"
+#include "Utils/Threading.h"
 #include "Utils/ObjectIDPython.h"
 #include "Utils/Math/Common.h"
 #include "Utils/Math/MathHelpers.h"
@@ -47,6 +48,7 @@
 #include "Utils/UI/InputTypes.h"
 #include "Utils/Scripting/ScriptWriter.h"
 
+#include <atomic>
 #include <fstream>
 #include <numeric>
 #include <sstream>
@@ -63,6 +65,14 @@ namespace
 // The target is max 0.5GB intermediate memory per BLAS group. Note that this is not a strict limit.
 const size_t kMaxBLASBuildMemory = 1ull << 29;
 
+// Number of instances culled per task by the parallel frustum culling.
+const size_t kCullingChunkSize = 4096;
+const uint32_t kInvalidDrawIndex = 0xffffffff;
+
+// Occluders for the CPU occlusion test. Larger meshes are too expensive to rasterize on the CPU without simplification.
+const uint32_t kMaxOccluderMeshTriangles = 4096;
+const uint32_t kMaxOccluderTriangles = 1u << 20;
+
 const std::string kParameterBlockName = "gScene";
 const std::string kGeometryInstanceBufferName = "geometryInstances";
 const std::string kMeshBufferName = "meshes";
@@ -194,6 +204,8 @@ Scene::Scene(ref<Device> pDevice, SceneData&& sceneData) : mpDevice(pDevice)
 
     mParticleSystems = std::move(sceneData.particleSystems);
 
+    mpDeferredData = std::move(sceneData.pDeferredData);
+
     // Setup additional resources.
     mFrontClockwiseRS[RasterizerState::CullMode::None] =
         RasterizerState::create(RasterizerState::Desc().setFrontCounterCW(false).setCullMode(RasterizerState::CullMode::None));
@@ -219,6 +231,7 @@ Scene::Scene(ref<Device> pDevice, SceneData&& sceneData) : mpDevice(pDevice)
     createMeshVao(sceneData.meshDrawCount, sceneData.meshIndexData, sceneData.meshStaticData, sceneData.meshSkinningData);
     createCurveVao(mCurveIndexData, mCurveStaticData);
     createMeshUVTiles(mMeshDesc, sceneData.meshIndexData, sceneData.meshStaticData);
+    createOccluderMeshes(sceneData.meshIndexData, sceneData.meshStaticData);
 
     // Create animation controller.
     mpAnimationController = std::make_unique<AnimationController>(
@@ -500,6 +513,263 @@ void Scene::rasterizeFrustumCulling(
     );
 }
 
+const InstanceBVH& Scene::getInstanceBVH()
+{
+    updateInstanceBVH();
+    return mInstanceBVH;
+}
+
+void Scene::updateInstanceBVH()
+{
+    if (mInstanceBVHValid)
+        return;
+
+    mInstanceBVHInstanceIDs.clear();
+    mAlwaysVisibleInstanceIDs.clear();
+    mInstanceDrawIndices.assign(mGeometryInstanceData.size(), kInvalidDrawIndex);
+    mInstanceDrawOrder.assign(mGeometryInstanceData.size(), 0);
+
+    for (uint32_t drawIndex = 0; drawIndex < mDrawArgs.size(); drawIndex++)
+    {
+        // Particles are never culled
+        if (mDrawArgs[drawIndex].particleOrientationMode != ParticleOrientationMode::None)
+            continue;
+
+        const auto& instanceIDs = mDrawArgsInstanceIDs[drawIndex];
+        for (uint32_t j = 0; j < instanceIDs.size(); j++)
+        {
+            const uint32_t instanceID = instanceIDs[j];
+            mInstanceDrawIndices[instanceID] = drawIndex;
+            mInstanceDrawOrder[instanceID] = j;
+
+            // TODO: Add a better/functioning precalculated BB for skinned meshes
+            if (mMeshDesc[mGeometryInstanceData[instanceID].geometryID].isSkinned())
+                mAlwaysVisibleInstanceIDs.push_back(instanceID);
+            else
+                mInstanceBVHInstanceIDs.push_back(instanceID);
+        }
+    }
+
+    const auto& globalMatrices = mpAnimationController->getGlobalMatrices();
+    std::vector<InstanceBVH::Item> items(mInstanceBVHInstanceIDs.size());
+    Threading::parallelFor(
+        0,
+        items.size(),
+        [&](size_t i)
+        {
+            const uint32_t instanceID = mInstanceBVHInstanceIDs[i];
+            const auto& instance = mGeometryInstanceData[instanceID];
+            items[i].id = instanceID;
+            items[i].bounds = mMeshBBs[instance.geometryID].transform(globalMatrices[instance.globalMatrixID]);
+        },
+        kCullingChunkSize
+    );
+    mInstanceBVH.build(items);
+
+    mInstanceBVHValid = true;
+}
+
+void Scene::refitInstanceBVH()
+{
+    // A hierarchy that was not built yet is built from the current transforms on first use
+    if (!mInstanceBVHValid)
+        return;
+
+    const auto& globalMatrices = mpAnimationController->getGlobalMatrices();
+    bool occludersMoved = false;
+    for (uint32_t instanceID : mInstanceBVHInstanceIDs)
+    {
+        const auto& instance = mGeometryInstanceData[instanceID];
+        if (mpAnimationController->isMatrixChanged(NodeID{instance.globalMatrixID}))
+        {
+            mInstanceBVH.setItemBounds(instanceID, mMeshBBs[instance.geometryID].transform(globalMatrices[instance.globalMatrixID]));
+            occludersMoved |= mOccluderMeshes[instance.geometryID].triangleCount > 0;
+        }
+    }
+    mInstanceBVH.refit();
+
+    // Occlusion culled draws of static geometry are only culled again if an occluder moved
+    if (occludersMoved)
+        mOccluderVersion++;
+}
+
+void Scene::rasterizeOccluders(FrustumCulling& culling, OcclusionCulling& occlusion)
+{
+    const float4x4& viewProj = culling.getViewProjMatrix();
+    const auto& globalMatrices = mpAnimationController->getGlobalMatrices();
+
+    // Rank the opaque occluders that passed the frustum test by their approximate size on screen:
+    // squared radius over squared clip w, which is the view depth or 1 for orthographic projections.
+    std::vector<std::pair<float, uint32_t>> candidates;
+    for (uint32_t instanceID : mCulledInstanceIDs)
+    {
+        const auto& instance = mGeometryInstanceData[instanceID];
+        if (mOccluderMeshes[instance.geometryID].triangleCount == 0)
+            continue;
+        if (!getMaterial(MaterialID::fromSlang(mMeshDesc[instance.geometryID].materialID))->isOpaque())
+            continue;
+
+        const AABB bounds = mMeshBBs[instance.geometryID].transform(globalMatrices[instance.globalMatrixID]);
+        const float w = mul(viewProj, float4(bounds.center(), 1.f)).w;
+        const float3 halfExtent = bounds.extent() * 0.5f;
+        candidates.emplace_back(dot(halfExtent, halfExtent) / std::max(w * w, 1e-6f), instanceID);
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    occlusion.begin(viewProj, mOccluderVersion);
+    uint32_t triangleCount = 0;
+    for (const auto& [size, instanceID] : candidates)
+    {
+        const auto& instance = mGeometryInstanceData[instanceID];
+        const OccluderMesh& mesh = mOccluderMeshes[instance.geometryID];
+        if (triangleCount + mesh.triangleCount > occlusion.getTriangleBudget())
+            continue;
+
+        occlusion.addOccluder(
+            mOccluderPositions.data() + mesh.firstVertex, mesh.vertexCount, mOccluderIndices.data() + mesh.firstIndex, mesh.triangleCount,
+            globalMatrices[instance.globalMatrixID]
+        );
+        triangleCount += mesh.triangleCount;
+    }
+    occlusion.rasterize();
+}
+
+void Scene::cullInstances(FrustumCulling& culling)
+{
+    mCulledInstanceIDs.clear();
+    mInstanceBVH.queryFrustum(culling, mCulledInstanceIDs);
+    mCulledInstanceIDs.insert(mCulledInstanceIDs.end(), mAlwaysVisibleInstanceIDs.begin(), mAlwaysVisibleInstanceIDs.end());
+
+    // Group the visible instances by draw
+    mCulledDrawOffsets.assign(mDrawArgs.size() + 1, 0);
+    for (uint32_t instanceID : mCulledInstanceIDs)
+        mCulledDrawOffsets[mInstanceDrawIndices[instanceID] + 1]++;
+    for (size_t i = 1; i < mCulledDrawOffsets.size(); i++)
+        mCulledDrawOffsets[i] += mCulledDrawOffsets[i - 1];
+
+    // The scratch buffers are sized for all instances and draws, so they are only reallocated when those counts change
+    FALCOR_ASSERT(mCulledInstanceIDs.size() <= mGeometryInstanceData.size());
+    if (mCulledGroupedIDs.size() != mGeometryInstanceData.size())
+        mCulledGroupedIDs.resize(mGeometryInstanceData.size());
+    if (mCulledWriteOffsets.size() != mDrawArgs.size())
+        mCulledWriteOffsets.resize(mDrawArgs.size());
+    std::copy(mCulledDrawOffsets.begin(), mCulledDrawOffsets.end() - 1, mCulledWriteOffsets.begin());
+    for (uint32_t instanceID : mCulledInstanceIDs)
+        mCulledGroupedIDs[mCulledWriteOffsets[mInstanceDrawIndices[instanceID]]++] = instanceID;
+    std::copy(mCulledGroupedIDs.begin(), mCulledGroupedIDs.begin() + mCulledInstanceIDs.size(), mCulledInstanceIDs.begin());
+
+    // Restore the draw order, so that the draw arguments do not depend on the hierarchy layout
+    Threading::parallelFor(
+        0,
+        mDrawArgs.size(),
+        [&](size_t drawIndex)
+        {
+            std::sort(
+                mCulledInstanceIDs.begin() + mCulledDrawOffsets[drawIndex],
+                mCulledInstanceIDs.begin() + mCulledDrawOffsets[drawIndex + 1],
+                [&](uint32_t a, uint32_t b) { return mInstanceDrawOrder[a] < mInstanceDrawOrder[b]; }
+            );
+        },
+        1
+    );
+}
+
+template<typename DrawArgsType, typename WriteFunc>
+void Scene::cullDrawInstances(RenderContext* pRenderContext, FrustumCulling& culling, uint drawIndex, WriteFunc&& writeDrawArg)
+{
+    // Instances of the draw that passed the frustum test, see cullInstances()
+    const uint32_t* instanceIDs = mCulledInstanceIDs.data() + mCulledDrawOffsets[drawIndex];
+    const size_t instanceCount = mCulledDrawOffsets[drawIndex + 1] - mCulledDrawOffsets[drawIndex];
+    const size_t chunkCount = div_round_up(instanceCount, kCullingChunkSize);
+
+    mCullingVisibility.resize(instanceCount);
+    mCullingChunkOffsets.resize(chunkCount);
+
+    const OcclusionCulling* pOcclusion = culling.getOcclusionCulling();
+    const auto& globalMatrices = mpAnimationController->getGlobalMatrices();
+    std::atomic<uint32_t> occludedCount{0};
+
+    // Apply the user and occlusion tests chunk by chunk and count the visible instances per chunk
+    Threading::parallelFor(
+        0,
+        chunkCount,
+        [&](size_t chunk)
+        {
+            const size_t begin = chunk * kCullingChunkSize;
+            const size_t end = std::min(begin + kCullingChunkSize, instanceCount);
+
+            uint32_t visibleCount = 0;
+            uint32_t chunkOccludedCount = 0;
+            for (size_t j = begin; j < end; j++)
+            {
+                const auto& instance = mGeometryInstanceData[instanceIDs[j]];
+                const auto& mesh = mMeshDesc[instance.geometryID];
+                bool visible = culling.isUserAllowed(mesh);
+
+                // Skinned meshes have no reliable bounds and are never occluded
+                if (visible && pOcclusion && !mesh.isSkinned() &&
+                    pOcclusion->isOccluded(mMeshBBs[instance.geometryID].transform(globalMatrices[instance.globalMatrixID])))
+                {
+                    visible = false;
+                    chunkOccludedCount++;
+                }
+
+                mCullingVisibility[j] = visible ? 1 : 0;
+                visibleCount += visible ? 1 : 0;
+            }
+            mCullingChunkOffsets[chunk] = visibleCount;
+            occludedCount += chunkOccludedCount;
+        },
+        1
+    );
+    culling.setOccludedCount(drawIndex, occludedCount);
+
+    // Turn the counts into output offsets, so that each chunk writes its visible instances in order
+    uint32_t visibleCount = 0;
+    for (auto& offset : mCullingChunkOffsets)
+    {
+        const uint32_t count = offset;
+        offset = visibleCount;
+        visibleCount += count;
+    }
+
+    auto forEachVisible = [&](auto&& func)
+    {
+        Threading::parallelFor(
+            0,
+            chunkCount,
+            [&](size_t chunk)
+            {
+                const size_t begin = chunk * kCullingChunkSize;
+                const size_t end = std::min(begin + kCullingChunkSize, instanceCount);
+                uint32_t outIndex = mCullingChunkOffsets[chunk];
+                for (size_t j = begin; j < end; j++)
+                {
+                    if (mCullingVisibility[j])
+                        func(outIndex++, instanceIDs[j]);
+                }
+            },
+            1
+        );
+    };
+
+    // For dynamic draws only update the draw buffer if the visible instances changed
+    if (mDrawArgs[drawIndex].isDynamic)
+    {
+        mCullingInstanceIDs.resize(visibleCount);
+        forEachVisible([&](uint32_t index, uint instanceID) { mCullingInstanceIDs[index] = instanceID; });
+        if (!culling.checkDynamicInstances(drawIndex, mCullingInstanceIDs.data(), visibleCount))
+            return;
+    }
+
+    if (visibleCount > 0)
+    {
+        DrawArgsType* pDrawArgs = static_cast<DrawArgsType*>(culling.mapDrawBufferStaging(drawIndex));
+        forEachVisible([&](uint32_t index, uint instanceID) { writeDrawArg(pDrawArgs[index], instanceID); });
+    }
+    culling.commitDrawBufferStaging(pRenderContext, drawIndex, visibleCount, sizeof(DrawArgsType));
+}
+
 void Scene::rasterizeFrustumCulling(
     RenderContext* pRenderContext,
     GraphicsState* pState,
@@ -519,8 +789,6 @@ void Scene::rasterizeFrustumCulling(
     auto pCurrentRS = pState->getRasterizerState();
     bool isIndexed = hasIndexBuffer();
 
-    bool updateDynamicGeomFrustum = true;
-
     // If there was no called culling, use the camera one
     if (!pFrustumCulling)
     {
@@ -535,26 +803,20 @@ void Scene::rasterizeFrustumCulling(
         }
 
         pFrustumCulling = mpCameraCulling;
+        pFrustumCulling->setOcclusionCullingEnabled(mCameraOcclusionCulling);
 
-        // Update the frustum only for the first rasterize pass
+        // Update the frustum only for the first rasterize pass.
+        // Only movement and frustum changes affect the planes, e.g. jitter or history changes keep all draw buffers.
         if (!mFrustumCullingUpdated || forceUpdate)
         {
             auto cameraChanges = camera->getChanges();
-            auto excluded = Camera::Changes::Jitter | Camera::Changes::History;
-            if (((cameraChanges & ~excluded) != Camera::Changes::None) || forceUpdate)
+            if (is_set(cameraChanges, Camera::Changes::Movement | Camera::Changes::Frustum) || forceUpdate)
             {
                 pFrustumCulling->updateFrustum(camera);
             }
-            updateDynamicGeomFrustum = true;
             mFrustumCullingUpdated = true;
         }
     }
-    else // Custom culling is used
-    {
-        // TODO add handling for custom frustum culling
-        // For now we assume that every custom culling is called once
-        updateDynamicGeomFrustum = true;
-    }
 
     // Initialize the draw buffers, with the mDrawArgs buffer as template
     if (mDrawArgs.size() != pFrustumCulling->getDrawBufferSize())
@@ -571,17 +833,34 @@ void Scene::rasterizeFrustumCulling(
     }
 
     // Create an custom draw argument buffer for this frame
-    const auto& globalMatrices = mpAnimationController->getGlobalMatrices();
     auto& pDrawBuffers = pFrustumCulling->getDrawBuffers();
     auto& pDrawBufferCounts = pFrustumCulling->getDrawCounts();
 
+    // Dynamic geometry only needs to be culled again if it moved
+    pFrustumCulling->invalidateDynamicDrawBuffers(mGeometryVersion);
+
+    // Moved occluders affect the occlusion of all draws
+    OcclusionCulling* pOcclusion = pFrustumCulling->getOcclusionCulling();
+    if (pOcclusion && pOcclusion->isValid() && pOcclusion->getOccluderVersion() != mOccluderVersion)
+        pFrustumCulling->invalidateAllDrawBuffers();
+
     // Check if any buffer needs an update
     bool needUpdate = false;
     for (uint i = 0; i < mDrawArgs.size(); i++)
         needUpdate |= !pFrustumCulling->isBufferValid(i);
 
-    if (needUpdate || (updateDynamicGeomFrustum && pFrustumCulling->hasDynamic()))
+    if (needUpdate)
+    {
         pFrustumCulling->startUpdate(mFenceSyncLastFrame);
+        updateInstanceBVH();
+        cullInstances(*pFrustumCulling);
+
+        if (pOcclusion && !pOcclusion->isValid())
+        {
+            FALCOR_PROFILE(pRenderContext, "rasterizeOccluders");
+            rasterizeOccluders(*pFrustumCulling, *pOcclusion);
+        }
+    }
 
     // Lamda for checking particles
     auto checkSkipParticle = [&](const DrawArgs& draw)
@@ -606,6 +885,7 @@ void Scene::rasterizeFrustumCulling(
         return skip;
     };
 
+    uint32_t occludedCount = 0;
     for (uint i = 0; i < mDrawArgs.size(); i++)
     {
         const auto& draw = mDrawArgs[i];
@@ -648,75 +928,42 @@ void Scene::rasterizeFrustumCulling(
             pDrawBufferCounts[i] = draw.count;
             pDrawBuffers[i] = draw.pBuffer;
         }
-        else if (isIndexed && (!bufferValid || draw.isDynamic))
+        else if (!bufferValid)
         {
-            std::vector<DrawIndexedArguments> drawArguments;
-            std::vector<uint> passedDrawInstances; // Draw instances used for dynamic geometry
-            for (auto& instanceID : mDrawArgsInstanceIDs[i])
+            if (isIndexed)
             {
-                const auto& instance = mGeometryInstanceData[instanceID];
-                const auto& worldMat = globalMatrices[instance.globalMatrixID];
-                const AABB& meshBB = mMeshBBs[instance.geometryID];
-                const auto& mesh = mMeshDesc[instance.geometryID];
-
-                // If the mesh passes the culling test, add to draw buffer
-                //  TODO: Add a better/functioning precalculated BB for skinned meshes
-                if (pFrustumCulling->isUserAllowed(mesh) &&
-                    (pFrustumCulling->isInFrustum(meshBB.transform(worldMat)) || mesh.isSkinned()))
-                {
-                    DrawIndexedArguments drawArg;
-                    drawArg.IndexCountPerInstance = mesh.indexCount;
-                    drawArg.InstanceCount = 1;
-                    drawArg.StartIndexLocation = mesh.ibOffset * (mesh.use16BitIndices() ? 2 : 1);
-                    drawArg.BaseVertexLocation = mesh.vbOffset;
-                    drawArg.StartInstanceLocation = instanceID;
-
-                    drawArguments.push_back(drawArg);
-                    passedDrawInstances.push_back(instanceID);
-                }
+                cullDrawInstances<DrawIndexedArguments>(
+                    pRenderContext, *pFrustumCulling, i,
+                    [&](DrawIndexedArguments& drawArg, uint instanceID)
+                    {
+                        const auto& mesh = mMeshDesc[mGeometryInstanceData[instanceID].geometryID];
+                        drawArg.IndexCountPerInstance = mesh.indexCount;
+                        drawArg.InstanceCount = 1;
+                        drawArg.StartIndexLocation = mesh.ibOffset * (mesh.use16BitIndices() ? 2 : 1);
+                        drawArg.BaseVertexLocation = mesh.vbOffset;
+                        drawArg.StartInstanceLocation = instanceID;
+                    }
+                );
             }
-            // For dynamic check if we need to update the draw buffer
-            bool updateDrawBuffer = true;
-            if (draw.isDynamic)
-                updateDrawBuffer = pFrustumCulling->checkDynamicInstances(i, passedDrawInstances);
-
-            if (updateDrawBuffer)
-                pFrustumCulling->updateDrawBuffer(pRenderContext, i, drawArguments);
-        }
-        else if ((!bufferValid || draw.isDynamic))
-        {
-            std::vector<DrawArguments> drawArguments;
-            std::vector<uint> passedDrawInstances; // Draw instances used for dynamic geometry
-            for (auto& instanceID : mDrawArgsInstanceIDs[i])
+            else
             {
-                const auto& instance = mGeometryInstanceData[instanceID];
-                const auto& worldMat = globalMatrices[instance.globalMatrixID];
-                const AABB& meshBB = mMeshBBs[instance.geometryID];
-                const auto& mesh = mMeshDesc[instance.geometryID];
-                // If the mesh passes the culling test, add to draw buffer
-                // TODO: Add a better/functioning precalculated BB for skinned meshes
-                if (pFrustumCulling->isUserAllowed(mesh) &&
-                    (pFrustumCulling->isInFrustum(meshBB.transform(worldMat)) || mesh.isSkinned()))
-                {
-                    DrawArguments drawArg;
-                    drawArg.VertexCountPerInstance = mesh.vertexCount;
-                    drawArg.InstanceCount = 1;
-                    drawArg.StartVertexLocation = mesh.vbOffset;
-                    drawArg.StartInstanceLocation = instanceID;
-
-                    drawArguments.push_back(drawArg);
-                    passedDrawInstances.push_back(instanceID);
-                }
+                cullDrawInstances<DrawArguments>(
+                    pRenderContext, *pFrustumCulling, i,
+                    [&](DrawArguments& drawArg, uint instanceID)
+                    {
+                        const auto& mesh = mMeshDesc[mGeometryInstanceData[instanceID].geometryID];
+                        drawArg.VertexCountPerInstance = mesh.vertexCount;
+                        drawArg.InstanceCount = 1;
+                        drawArg.StartVertexLocation = mesh.vbOffset;
+                        drawArg.StartInstanceLocation = instanceID;
+                    }
+                );
             }
-            // For dynamic check if we need to update the draw buffer
-            bool updateDrawBuffer = true;
-            if (draw.isDynamic)
-                updateDrawBuffer = pFrustumCulling->checkDynamicInstances(i, passedDrawInstances);
-
-            if (updateDrawBuffer)
-                pFrustumCulling->updateDrawBuffer(pRenderContext, i, drawArguments);
         }
 
+        if (pOcclusion && !isParticle)
+            occludedCount += pFrustumCulling->getOccludedCount(i);
+
         // Check if everything was culled
         if (pDrawBufferCounts[i] == 0)
             continue;
@@ -742,6 +989,12 @@ void Scene::rasterizeFrustumCulling(
         }
     }
 
+    if (pOcclusion)
+    {
+        FALCOR_PROFILE_COUNTER(pRenderContext, "occludedInstances", occludedCount);
+        FALCOR_PROFILE_COUNTER(pRenderContext, "occluderTriangles", pOcclusion->getStats().rasterizedTriangleCount);
+    }
+
     pState->setRasterizerState(pCurrentRS);
 }
 
@@ -1024,6 +1277,48 @@ void Scene::createMeshUVTiles(
     }
 }
 
+void Scene::createOccluderMeshes(const std::vector<uint32_t>& indexData, const std::vector<PackedStaticVertexData>& staticData)
+{
+    const uint8_t* indexData8 = reinterpret_cast<const uint8_t*>(indexData.data());
+
+    mOccluderMeshes.assign(mMeshDesc.size(), OccluderMesh());
+    mOccluderPositions.clear();
+    mOccluderIndices.clear();
+
+    uint32_t totalTriangleCount = 0;
+    for (size_t meshID = 0; meshID < mMeshDesc.size(); meshID++)
+    {
+        // Skinned and vertex animated meshes change shape every frame
+        const MeshDesc& desc = mMeshDesc[meshID];
+        const uint32_t triangleCount = desc.getTriangleCount();
+        if (desc.isDynamic() || triangleCount == 0 || triangleCount > kMaxOccluderMeshTriangles)
+            continue;
+        if (totalTriangleCount + triangleCount > kMaxOccluderTriangles)
+            continue;
+
+        OccluderMesh& mesh = mOccluderMeshes[meshID];
+        mesh.firstVertex = (uint32_t)mOccluderPositions.size();
+        mesh.vertexCount = desc.vertexCount;
+        mesh.firstIndex = (uint32_t)mOccluderIndices.size();
+        mesh.triangleCount = triangleCount;
+        totalTriangleCount += triangleCount;
+
+        FALCOR_ASSERT((size_t)desc.vbOffset + desc.vertexCount <= staticData.size());
+        for (uint32_t v = 0; v < desc.vertexCount; v++)
+            mOccluderPositions.push_back(staticData[(size_t)desc.vbOffset + v].position);
+
+        for (uint32_t i = 0; i < triangleCount * 3; i++)
+        {
+            if (!desc.useVertexIndices())
+                mOccluderIndices.push_back(i);
+            else if (desc.use16BitIndices())
+                mOccluderIndices.push_back(reinterpret_cast<const uint16_t*>(indexData8 + desc.ibOffset * 4)[i]);
+            else
+                mOccluderIndices.push_back(reinterpret_cast<const uint32_t*>(indexData8 + desc.ibOffset * 4)[i]);
+        }
+    }
+}
+
 void Scene::setSDFGridConfig()
 {
     if (mSDFGrids.empty())
@@ -2356,6 +2651,13 @@ Scene::UpdateFlags Scene::update(RenderContext* pRenderContext, double currentTi
 
     mUpdates = UpdateFlags::None;
 
+    // Apply data that finished loading in the background.
+    if (mpDeferredData && mpDeferredData->apply(*this, pRenderContext))
+    {
+        mpDeferredData.reset();
+        logInfo("Finished loading deferred scene data.");
+    }
+
     // Perform updates that may affect the scene defines.
     updateGeometryTypes();
     mUpdates |= updateMaterials(false);
@@ -2392,6 +2694,12 @@ Scene::UpdateFlags Scene::update(RenderContext* pRenderContext, double currentTi
             }
         }
 
+        if (is_set(mUpdates, UpdateFlags::GeometryMoved))
+        {
+            refitInstanceBVH();
+            mGeometryVersion++;
+        }
+
         // We might end up setting the flag even if curves haven't changed (if looping is disabled for example).
         if (mpAnimationController->hasAnimatedCurveCaches())
             mUpdates |= UpdateFlags::CurvesMoved;
@@ -2465,6 +2773,9 @@ Scene::UpdateFlags Scene::update(RenderContext* pRenderContext, double currentTi
 
 void Scene::renderUI(Gui::Widgets& widget)
 {
+    if (mpDeferredData)
+        widget.text(mpDeferredData->getStatus());
+
     if (mpAnimationController->hasAnimations())
     {
         bool isEnabled = mpAnimationController->isEnabled();
@@ -3257,6 +3568,8 @@ void Scene::createDrawList()
 
     mDrawArgs.clear();
     mDrawArgsInstanceIDs.clear();
+    mInstanceBVHValid = false;
+    mOccluderVersion++;
 
     // Correctly mark animated geometry
 
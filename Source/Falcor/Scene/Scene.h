@@ -30,6 +30,7 @@
 #include "SceneTypes.slang"
 #include "HitInfo.h"
 #include "FrustumCulling.h"
+#include "InstanceBVH.h"
 #include "Animation/Animation.h"
 #include "Animation/AnimationController.h"
 #include "Displacement/DisplacementUpdateTask.slang"
@@ -327,6 +328,26 @@ public:
         uint particleBufferOffset = 0;
     };
 
+    /** Scene data that is loaded after the scene was created.
+        The scene cache uses this to stream in material textures and the environment map.
+    */
+    class DeferredData
+    {
+    public:
+        virtual ~DeferredData() = default;
+
+        /** Apply the data that finished loading to the scene. Called on the main thread at the beginning of Scene::update().
+            \param[in] scene Scene to update.
+            \param[in] pRenderContext Render context.
+            \return Returns true when all data has been applied.
+        */
+        virtual bool apply(Scene& scene, RenderContext* pRenderContext) = 0;
+
+        /** Get a status message for the UI.
+         */
+        virtual std::string getStatus() const = 0;
+    };
+
     /** Full set of required data to create a scene object.
         This data is typically prepared by SceneBuilder before creating a Scene object.
     */
@@ -391,6 +412,8 @@ public:
         std::vector<CustomPrimitiveDesc> customPrimitiveDesc; ///< Custom primitive descriptors.
         std::vector<AABB> customPrimitiveAABBs; ///< List of AABBs for custom primitives in world space. Each custom primitive consists of
                                                 ///< one AABB.
+
+        std::unique_ptr<DeferredData> pDeferredData; ///< Data that is loaded after scene creation (optional).
     };
 
     /** Statistics.
@@ -964,6 +987,11 @@ public:
      */
     const ref<EnvMap>& getEnvMap() const { return mpEnvMap; }
 
+    /** Check if all scene data has been loaded.
+        Returns false while deferred data (e.g. material textures streamed from the scene cache) is still being loaded.
+    */
+    bool isFullyLoaded() const { return mpDeferredData == nullptr; }
+
     /** Set how the scene's TLASes are updated when raytracing.
         TLASes are REBUILT by default.
     */
@@ -1103,6 +1131,19 @@ public:
         ref<FrustumCulling> pFrustumCulling = nullptr
     );
 
+    /** Get the hierarchy over the world-space bounds of the rasterized mesh instances for CPU-side culling queries.
+        The items are geometry instance IDs. Skinned meshes and particles are not included.
+        The hierarchy is built on first use and refit when instances move.
+    */
+    const InstanceBVH& getInstanceBVH();
+
+    /** Enable the CPU occlusion test for rasterizeFrustumCulling() with the camera frustum.
+        Instances fully behind the largest opaque static meshes on screen are not drawn, see OcclusionCulling.
+        Passes with their own FrustumCulling enable it with FrustumCulling::setOcclusionCullingEnabled().
+    */
+    void setCameraOcclusionCulling(bool enabled) { mCameraOcclusionCulling = enabled; }
+    bool isCameraOcclusionCullingEnabled() const { return mCameraOcclusionCulling; }
+
     /** Get the required raytracing maximum attribute size for this scene.
         Note: This depends on what types of geometry are used in the scene.
         \return Max attribute size in bytes.
@@ -1277,6 +1318,7 @@ private:
         const std::vector<uint32_t>& indexData,
         const std::vector<PackedStaticVertexData>& staticData
     );
+    void createOccluderMeshes(const std::vector<uint32_t>& indexData, const std::vector<PackedStaticVertexData>& staticData);
 
     void updateSceneDefines();
     DefineList getSceneSDFGridDefines() const;
@@ -1320,6 +1362,12 @@ private:
     /** Create the draw list for rasterization.
      */
     void createDrawList();
+    void updateInstanceBVH();
+    void refitInstanceBVH();
+    void cullInstances(FrustumCulling& culling);
+    void rasterizeOccluders(FrustumCulling& culling, OcclusionCulling& occlusion);
+    template<typename DrawArgsType, typename WriteFunc>
+    void cullDrawInstances(RenderContext* pRenderContext, FrustumCulling& culling, uint drawIndex, WriteFunc&& writeDrawArg);
 
     /** Initialize geometry descs for each BLAS.
      */
@@ -1427,6 +1475,34 @@ private:
     ref<FrustumCulling> mpCameraCulling = nullptr;       ///< Culling for the camera
     uint mFrustumCullingSelectedCamera = 0;              ///< Selected Camera for Frustum Culling
     bool mFrustumCullingUpdated = false;                 ///< Records if culling was updated this frame
+    uint64_t mGeometryVersion = 0;                       ///< Incremented when geometry instances move. Dynamic draws are culled again on change.
+    InstanceBVH mInstanceBVH;                                  ///< Hierarchy over the world-space bounds of the culled mesh instances.
+    bool mInstanceBVHValid = false;                            ///< False if mInstanceBVH needs to be rebuilt.
+    std::vector<uint32_t> mInstanceBVHInstanceIDs;             ///< Geometry instances in mInstanceBVH.
+    std::vector<uint32_t> mAlwaysVisibleInstanceIDs;           ///< Geometry instances that are never frustum culled (skinned meshes).
+    std::vector<uint32_t> mInstanceDrawIndices;                ///< Draw index per geometry instance. Invalid for instances that are not culled.
+    std::vector<uint32_t> mInstanceDrawOrder;                  ///< Position of each geometry instance in mDrawArgsInstanceIDs of its draw.
+    std::vector<uint32_t> mCulledInstanceIDs;                  ///< Instances that passed the last frustum query, grouped by draw in draw order.
+    std::vector<uint32_t> mCulledDrawOffsets;                  ///< Start of each draw in mCulledInstanceIDs, followed by the total count.
+    std::vector<uint32_t> mCulledGroupedIDs;                   ///< Scratch for grouping mCulledInstanceIDs by draw. One entry per geometry instance.
+    std::vector<uint32_t> mCulledWriteOffsets;                 ///< Scratch write position of each draw while grouping.
+    std::vector<uint8_t> mCullingVisibility;                   ///< Per-instance culling result of the current draw. Reused between draws.
+    std::vector<uint32_t> mCullingChunkOffsets;                ///< Visible instances per culling chunk, turned into output offsets.
+    std::vector<uint> mCullingInstanceIDs;                     ///< Visible instance IDs of the current dynamic draw.
+
+    // Occlusion Culling
+    struct OccluderMesh
+    {
+        uint32_t firstVertex = 0;   ///< Offset into mOccluderPositions.
+        uint32_t vertexCount = 0;
+        uint32_t firstIndex = 0;    ///< Offset into mOccluderIndices.
+        uint32_t triangleCount = 0; ///< Zero if the mesh is not an occluder.
+    };
+    std::vector<OccluderMesh> mOccluderMeshes;                 ///< Occluder geometry per mesh.
+    std::vector<float3> mOccluderPositions;                    ///< Object-space vertex positions of the occluder meshes.
+    std::vector<uint32_t> mOccluderIndices;                    ///< Triangle indices of the occluder meshes, relative to the mesh.
+    uint64_t mOccluderVersion = 0;                             ///< Incremented when occluders move or the draw list changes.
+    bool mCameraOcclusionCulling = false;                      ///< Enables occlusion culling for the camera culling.
 
     // GPU CPU per frame sync
     ref<GpuFence> mpFence;        ///< Fence for GPU/CPU sync. Will record the GPU Counter once per update
@@ -1520,6 +1596,7 @@ private:
                                                     ///< scene.
 
     UpdateCallback mUpdateCallback; ///< Scene update callback.
+    std::unique_ptr<DeferredData> mpDeferredData; ///< Data that is still being loaded, applied in update().
 
     // Scene block resources
     ref<Buffer> mpGeometryInstancesBuffer;
@@ -27,6 +27,8 @@
  **************************************************************************/
 #include "SceneBuilder.h"
 #include "SceneCache.h"
+#include "VertexCacheOptimizer.h"
+#include "VertexWelder.h"
 #include "Importer.h"
 #include "Curves/CurveConfig.h"
 #include "Material/StandardMaterial.h"
@@ -40,6 +42,8 @@
 #include <mikktspace.h>
 #include <filesystem>
 #include <cmath>
+#include <cstring>
+#include <numeric>
 
 namespace Falcor
 {
@@ -53,6 +57,14 @@ const size_t kMaxTrianglesPerBLAS = 1ull << 24;
 // We'll log a warning if the maximum quantization error exceeds this value.
 const float kMaxTexelError = 0.5f;
 
+// Use the hashed vertex welder for merging duplicate vertices (see VertexWelder).
+// Can be overridden with the 'SceneBuilder:hashedVertexWelding' option.
+const bool kHashedVertexWelding = false;
+
+// Strategy for splitting mesh groups that exceed the triangle limit, one of "simple", "median", "midpoint" or "sah".
+// Can be overridden with the 'SceneBuilder:meshGroupSplitMode' option.
+const char kMeshGroupSplitMode[] = "midpoint";
+
 int largestAxis(const float3& v)
 {
     if (v.x >= v.y && v.x >= v.z)
@@ -168,25 +180,19 @@ void validateVertex(const SceneBuilder::Mesh::Vertex& v, size_t& invalidCount, s
         zeroCount++;
 }
 
-bool compareVertices(const SceneBuilder::Mesh::Vertex& lhs, const SceneBuilder::Mesh::Vertex& rhs, float threshold = 1e-6f)
+// Non-cryptographic hash of a block of memory.
+uint64_t hashBytes(const void* pData, size_t size, uint64_t seed)
 {
-    if (any(lhs.position != rhs.position))
-        return false; // Position need to be exact to avoid cracks
-    if (lhs.tangent.w != rhs.tangent.w)
-        return false;
-    if (lhs.curveRadius != rhs.curveRadius)
-        return false;
-    if (any(lhs.boneIDs != rhs.boneIDs))
-        return false;
-    if (any(abs(lhs.normal - rhs.normal) > float3(threshold)))
-        return false;
-    if (any(abs(lhs.tangent.xyz() - rhs.tangent.xyz()) > float3(threshold)))
-        return false;
-    if (any(abs(lhs.texCrd - rhs.texCrd) > float2(threshold)))
-        return false;
-    if (any(abs(lhs.boneWeights - rhs.boneWeights) > float4(threshold)))
-        return false;
-    return true;
+    const uint8_t* pBytes = reinterpret_cast<const uint8_t*>(pData);
+    uint64_t hash = seed ^ (size * 0x9e3779b97f4a7c15ull);
+    for (size_t i = 0; i < size; i += 8)
+    {
+        uint64_t word = 0;
+        std::memcpy(&word, pBytes + i, std::min<size_t>(8, size - i));
+        hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+        hash ^= hash >> 32;
+    }
+    return hash;
 }
 
 std::vector<uint32_t> compact16BitIndices(const std::vector<uint32_t>& indices)
@@ -206,7 +212,8 @@ std::vector<uint32_t> compact16BitIndices(const std::vector<uint32_t>& indices)
 
 SceneCache::Key computeSceneCacheKey(const std::filesystem::path& path, SceneBuilder::Flags buildFlags)
 {
-    SceneBuilder::Flags cacheFlags = buildFlags & (~(SceneBuilder::Flags::UseCache | SceneBuilder::Flags::RebuildCache));
+    SceneBuilder::Flags cacheFlags =
+        buildFlags & (~(SceneBuilder::Flags::UseCache | SceneBuilder::Flags::RebuildCache | SceneBuilder::Flags::DeferCacheLoading));
     SHA1 sha1;
     auto pathStr = path.string();
     sha1.update(pathStr.data(), pathStr.size());
@@ -232,6 +239,7 @@ SceneBuilder::SceneBuilder(ref<Device> pDevice, const std::filesystem::path& pat
     }
 
     // Compute scene cache key based on absolute scene path and build flags.
+    // The content of the scene and its dependencies is validated using the manifest stored with the cache.
     mSceneCacheKey = computeSceneCacheKey(fullPath, flags);
 
     // Determine if scene cache should be written after import.
@@ -244,7 +252,7 @@ SceneBuilder::SceneBuilder(ref<Device> pDevice, const std::filesystem::path& pat
     {
         try
         {
-            mpScene = Scene::create(pDevice, SceneCache::readCache(pDevice, mSceneCacheKey));
+            mpScene = Scene::create(pDevice, SceneCache::readCache(pDevice, mSceneCacheKey, is_set(flags, Flags::DeferCacheLoading)));
             return;
         }
         catch (const std::exception& e)
@@ -269,7 +277,20 @@ SceneBuilder::SceneBuilder(
     importFromMemory(buffer, byteSize, extension);
 }
 
-SceneBuilder::~SceneBuilder() {}
+SceneBuilder::~SceneBuilder()
+{
+    // Mesh processing tasks reference the builder.
+    for (const auto& pending : mPendingMeshes)
+    {
+        try
+        {
+            pending.task.finish();
+        }
+        catch (const std::exception&)
+        {
+        }
+    }
+}
 
 void SceneBuilder::import(const std::filesystem::path& path, const pybind11::dict& dict)
 {
@@ -281,6 +302,7 @@ void SceneBuilder::import(const std::filesystem::path& path, const pybind11::dic
     }
 
     mSceneData.path = fullPath;
+    addDependency(fullPath);
     if (auto importer = Importer::create(getExtensionFromPath(fullPath)))
     {
         importer->importScene(fullPath, *this, dict);
@@ -328,6 +350,8 @@ ref<Scene> SceneBuilder::getScene()
         addMeshInstance(nodeID, meshID);
     }
 
+    waitForMeshProcessing();
+
     // Post-process the scene data.
     TimeReport timeReport;
 
@@ -338,6 +362,7 @@ ref<Scene> SceneBuilder::getScene()
     prepareSceneGraph();
     prepareMeshes();
     removeUnusedMeshes();
+    instanceIdenticalMeshes();
     flattenStaticMeshInstances();
     pretransformStaticMeshes();
     unifyTriangleWinding();
@@ -346,6 +371,7 @@ ref<Scene> SceneBuilder::getScene()
     createMeshGroups();
     optimizeGeometry();
     sortMeshes();
+    optimizeVertexCache();
     createGlobalBuffers();
     createCurveGlobalBuffers();
     collectVolumeGrids();
@@ -379,7 +405,7 @@ ref<Scene> SceneBuilder::getScene()
     // Write scene cache if requested.
     if (mWriteSceneCache)
     {
-        SceneCache::writeCache(mSceneData, mSceneCacheKey);
+        SceneCache::writeCache(mSceneData, mSceneCacheKey, mDependencies);
         timeReport.measure("Writing cache");
     }
 
@@ -414,23 +440,36 @@ MeshID SceneBuilder::addTriangleMesh(const ref<TriangleMesh>& pTriangleMesh, con
     mesh.faceCount = (uint32_t)(indices.size() / 3);
     mesh.vertexCount = (uint32_t)vertices.size();
     mesh.indexCount = (uint32_t)indices.size();
-    mesh.pIndices = indices.data();
     mesh.topology = Vao::Topology::TriangleList;
     mesh.isFrontFaceCW = pTriangleMesh->getFrontFaceCW();
     mesh.pMaterial = pMaterial;
 
-    std::vector<float3> positions(vertices.size());
-    std::vector<float3> normals(vertices.size());
-    std::vector<float2> texCoords(vertices.size());
+    // The mesh data is copied and owned by the processing task, so the triangle mesh may be modified after this call.
+    struct Attributes
+    {
+        std::vector<uint32_t> indices;
+        std::vector<float3> positions;
+        std::vector<float3> normals;
+        std::vector<float2> texCoords;
+    };
+    auto pAttributes = std::make_shared<Attributes>();
+    pAttributes->indices = indices;
+    auto& positions = pAttributes->positions;
+    auto& normals = pAttributes->normals;
+    auto& texCoords = pAttributes->texCoords;
+    positions.resize(vertices.size());
+    normals.resize(vertices.size());
+    texCoords.resize(vertices.size());
     std::transform(vertices.begin(), vertices.end(), positions.begin(), [](const auto& v) { return v.position; });
     std::transform(vertices.begin(), vertices.end(), normals.begin(), [](const auto& v) { return v.normal; });
     std::transform(vertices.begin(), vertices.end(), texCoords.begin(), [](const auto& v) { return v.texCoord; });
 
+    mesh.pIndices = pAttributes->indices.data();
     mesh.positions = {positions.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex};
     mesh.normals = {normals.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex};
     mesh.texCrds = {texCoords.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex};
 
-    return addMesh(mesh);
+    return addMeshAsync(mesh, pAttributes);
 }
 
 SceneBuilder::ProcessedMesh SceneBuilder::processMesh(const Mesh& mesh_, MeshAttributeIndices* pAttributeIndices) const
@@ -527,16 +566,9 @@ SceneBuilder::ProcessedMesh SceneBuilder::processMesh(const Mesh& mesh_, MeshAtt
     }
 
     // Build new vertex/index buffers by merging identical vertices.
-    // The search is based on the topology defined by the original index buffer.
-    //
-    // A linked-list of vertices is built for each original vertex index.
-    // We iterate over all vertices and first check if a vertex is identical to any of the other vertices
-    // using the same original vertex index. If not, a new vertex is inserted and added to the list.
-    // The 'heads' array point to the first vertex in each list, and each vertex has an associated next-pointer.
-    // This ensures that adding to the linked lists do not require any dynamic memory allocation.
-    //
-    const uint32_t invalidIndex = 0xffffffff;
-    std::vector<std::pair<Mesh::Vertex, uint32_t>> vertices;
+    // The search is based on the topology defined by the original index buffer,
+    // i.e. only vertices using the same original vertex index are merged (see VertexWelder).
+    std::vector<Mesh::Vertex> vertices;
     std::vector<uint32_t> indices(mesh.indexCount);
 
     if (pAttributeIndices)
@@ -546,9 +578,8 @@ SceneBuilder::ProcessedMesh SceneBuilder::processMesh(const Mesh& mesh_, MeshAtt
 
     if (mesh.mergeDuplicateVertices)
     {
-        vertices.reserve(mesh.vertexCount);
-
-        std::vector<uint32_t> heads(mesh.vertexCount, invalidIndex);
+        const bool useHashedWelding = mSettings.getOption("SceneBuilder:hashedVertexWelding", kHashedVertexWelding);
+        VertexWelder welder(useHashedWelding ? VertexWelder::Mode::Hashed : VertexWelder::Mode::Linear, mesh.vertexCount);
 
         for (uint32_t face = 0; face < mesh.faceCount; face++)
         {
@@ -556,46 +587,27 @@ SceneBuilder::ProcessedMesh SceneBuilder::processMesh(const Mesh& mesh_, MeshAtt
             {
                 const Mesh::Vertex v = mesh.getVertex(face, vert);
                 const uint32_t origIndex = mesh.pIndices[face * 3 + vert];
+                FALCOR_ASSERT(origIndex < mesh.vertexCount);
 
-                // Iterate over vertex list to check if it already exists.
-                FALCOR_ASSERT(origIndex < heads.size());
-                uint32_t index = heads[origIndex];
-                bool found = false;
-
-                while (index != invalidIndex)
-                {
-                    if (compareVertices(v, vertices[index].first))
-                    {
-                        found = true;
-                        break;
-                    }
-                    index = vertices[index].second;
-                }
+                // Insert new vertex if there is no identical vertex yet.
+                auto [index, inserted] = welder.insert(v, origIndex);
 
-                // Insert new vertex if we couldn't find it.
-                if (!found)
+                if (inserted && pAttributeIndices)
                 {
-                    FALCOR_ASSERT(vertices.size() < std::numeric_limits<uint32_t>::max());
-                    index = (uint32_t)vertices.size();
-                    vertices.push_back({v, heads[origIndex]});
-
-                    if (pAttributeIndices)
-                    {
-                        pAttributeIndices->push_back(mesh.getAttributeIndices(face, vert));
-                        FALCOR_ASSERT(vertices.size() == pAttributeIndices->size());
-                    }
-
-                    heads[origIndex] = index;
+                    pAttributeIndices->push_back(mesh.getAttributeIndices(face, vert));
+                    FALCOR_ASSERT(welder.getVertexCount() == pAttributeIndices->size());
                 }
 
                 // Store new vertex index.
                 indices[face * 3 + vert] = index;
             }
         }
+
+        vertices = welder.takeVertices();
     }
     else
     {
-        vertices = {mesh.vertexCount, std::make_pair(Mesh::Vertex{}, invalidIndex)};
+        vertices.resize(mesh.vertexCount);
 
         for (uint32_t face = 0; face < mesh.faceCount; face++)
         {
@@ -605,7 +617,7 @@ SceneBuilder::ProcessedMesh SceneBuilder::processMesh(const Mesh& mesh_, MeshAtt
                 const uint32_t index = mesh.getAttributeIndex(mesh.positions, face, vert);
 
                 FALCOR_ASSERT(index < vertices.size());
-                vertices[index].first = v;
+                vertices[index] = v;
 
                 if (pAttributeIndices)
                 {
@@ -634,7 +646,7 @@ SceneBuilder::ProcessedMesh SceneBuilder::processMesh(const Mesh& mesh_, MeshAtt
     size_t zeroCount = 0;
     for (const auto& v : vertices)
     {
-        validateVertex(v.first, invalidCount, zeroCount);
+        validateVertex(v, invalidCount, zeroCount);
     }
     if (invalidCount > 0)
         logWarning("The mesh '{}' has inf/nan vertex attributes at {} vertices. Please fix the asset.", mesh.name, invalidCount);
@@ -666,7 +678,7 @@ SceneBuilder::ProcessedMesh SceneBuilder::processMesh(const Mesh& mesh_, MeshAtt
     {
         uint32_t index = isIndexed ? i : indices[i];
         FALCOR_ASSERT(index < vertices.size());
-        const Mesh::Vertex& v = vertices[index].first;
+        const Mesh::Vertex& v = vertices[index];
 
         {
             StaticVertexData s;
@@ -711,14 +723,76 @@ void SceneBuilder::generateTangents(Mesh& mesh, std::vector<float4>& tangents) c
 
 MeshID SceneBuilder::addProcessedMesh(const ProcessedMesh& mesh)
 {
-    const bool isIndexed = !is_set(mFlags, Flags::NonIndexedVertices);
+    MeshSpec spec;
+    spec.materialId = addMaterial(mesh.pMaterial);
+    setMeshData(spec, ProcessedMesh(mesh));
 
+    mMeshes.push_back(spec);
+
+    if (mMeshes.size() > std::numeric_limits<uint32_t>::max())
+    {
+        throw RuntimeError("Trying to build a scene that exceeds supported number of meshes");
+    }
+
+    return MeshID(mMeshes.size() - 1);
+}
+
+MeshID SceneBuilder::addMeshAsync(const Mesh& mesh, std::shared_ptr<const void> pOwner)
+{
+    // Add the material and a placeholder mesh now to retain the order of materials and meshes.
     MeshSpec spec;
+    spec.materialId = addMaterial(mesh.pMaterial);
+    mMeshes.push_back(spec);
+
+    if (mMeshes.size() > std::numeric_limits<uint32_t>::max())
+    {
+        throw RuntimeError("Trying to build a scene that exceeds supported number of meshes");
+    }
+
+    PendingMesh pending;
+    pending.meshID = MeshID(mMeshes.size() - 1);
+    pending.pMesh = std::make_shared<ProcessedMesh>();
+    pending.task = Threading::dispatchTask(
+        [this, mesh, pOwner = std::move(pOwner), pProcessedMesh = pending.pMesh]() mutable
+        {
+            *pProcessedMesh = processMesh(mesh);
+            pOwner.reset();
+        }
+    );
+    mPendingMeshes.push_back(std::move(pending));
+
+    return MeshID(mMeshes.size() - 1);
+}
+
+void SceneBuilder::waitForMeshProcessing()
+{
+    // Commit in the order the meshes were added. The placeholder meshes may already have instances.
+    auto pendingMeshes = std::move(mPendingMeshes);
+    mPendingMeshes.clear();
+    for (size_t i = 0; i < pendingMeshes.size(); ++i)
+    {
+        const auto& pending = pendingMeshes[i];
+        try
+        {
+            pending.task.finish();
+        }
+        catch (...)
+        {
+            // Don't leave tasks referencing the builder behind.
+            for (size_t j = i + 1; j < pendingMeshes.size(); ++j)
+                mPendingMeshes.push_back(std::move(pendingMeshes[j]));
+            throw;
+        }
+        setMeshData(mMeshes[pending.meshID.get()], std::move(*pending.pMesh));
+    }
+}
+
+void SceneBuilder::setMeshData(MeshSpec& spec, ProcessedMesh&& mesh) const
+{
+    const bool isIndexed = !is_set(mFlags, Flags::NonIndexedVertices);
 
-    // Add the mesh to the scene.
     spec.name = mesh.name;
     spec.topology = mesh.topology;
-    spec.materialId = addMaterial(mesh.pMaterial);
     spec.isFrontFaceCW = mesh.isFrontFaceCW;
     spec.skeletonNodeID = mesh.skeletonNodeId;
 
@@ -742,15 +816,6 @@ MeshID SceneBuilder::addProcessedMesh(const ProcessedMesh& mesh)
         spec.hasSkinningData = true;
         spec.prevVertexCount = spec.skinningVertexCount;
     }
-
-    mMeshes.push_back(spec);
-
-    if (mMeshes.size() > std::numeric_limits<uint32_t>::max())
-    {
-        throw RuntimeError("Trying to build a scene that exceeds supported number of meshes");
-    }
-
-    return MeshID(mMeshes.size() - 1);
 }
 
 void SceneBuilder::setCachedMeshes(std::vector<CachedMesh>&& cachedMeshes)
@@ -1062,6 +1127,17 @@ void SceneBuilder::loadMaterialTexture(const ref<Material>& pMaterial, Material:
         );
     }
     mpMaterialTextureLoader->loadTexture(pMaterial, slot, path);
+    addDependency(path);
+}
+
+void SceneBuilder::addDependency(const std::filesystem::path& path)
+{
+    // Paths that don't resolve to a file (e.g. UDIM patterns) are skipped, their resolved files are added by the loader.
+    std::filesystem::path fullPath;
+    if (path.empty() || !findFileInDataDirectories(path, fullPath) || !std::filesystem::is_regular_file(fullPath)) return;
+
+    std::lock_guard<std::mutex> lock(mDependencyMutex);
+    if (mDependencySet.insert(fullPath).second) mDependencies.push_back(fullPath);
 }
 
 void SceneBuilder::waitForMaterialTextureLoading()
@@ -1576,55 +1652,154 @@ void SceneBuilder::removeUnusedMeshes()
     if (unusedCount > 0)
     {
         logWarning("Scene has {} unused meshes that will be removed.", unusedCount);
+        removeMeshesWithoutInstances();
+    }
+}
 
-        const size_t meshCount = mMeshes.size();
-        MeshList meshes;
-        meshes.reserve(meshCount);
+void SceneBuilder::removeMeshesWithoutInstances()
+{
+    // This function removes all meshes that are not referenced by the scene graph
+    // and updates the mesh IDs in the scene graph and scene data.
+
+    const size_t meshCount = mMeshes.size();
+    std::vector<MeshID> meshIDMap(meshCount, MeshID::Invalid());
+    MeshList meshes;
+    meshes.reserve(meshCount);
 
-        for (MeshID meshID{0}; meshID.get() < (uint32_t)meshCount; ++meshID)
+    for (MeshID meshID{0}; meshID.get() < (uint32_t)meshCount; ++meshID)
+    {
+        auto& mesh = mMeshes[meshID.get()];
+        if (mesh.instances.empty())
+            continue; // Skip unused meshes
+
+        // Get new mesh ID.
+        const MeshID newMeshID(meshes.size());
+        meshIDMap[meshID.get()] = newMeshID;
+
+        // Update the mesh IDs in the scene graph nodes.
+        for (const auto& nodeID : mesh.instances)
         {
-            auto& mesh = mMeshes[meshID.get()];
-            if (mesh.instances.empty())
-                continue; // Skip unused meshes
+            FALCOR_ASSERT(nodeID.get() < mSceneGraph.size());
+            auto& node = mSceneGraph[nodeID.get()];
+            std::replace(node.meshes.begin(), node.meshes.end(), meshID, newMeshID);
+        }
 
-            // Get new mesh ID.
-            const MeshID newMeshID(meshes.size());
+        meshes.push_back(std::move(mesh));
+    }
 
-            // Update the mesh IDs in the scene graph nodes.
-            for (const auto& nodeID : mesh.instances)
-            {
-                FALCOR_ASSERT(nodeID.get() < mSceneGraph.size());
-                auto& node = mSceneGraph[nodeID.get()];
-                std::replace(node.meshes.begin(), node.meshes.end(), meshID, newMeshID);
-            }
+    // Update the mesh IDs of cached meshes and particle systems.
+    for (auto& cachedMesh : mSceneData.cachedMeshes)
+    {
+        FALCOR_ASSERT(meshIDMap[cachedMesh.meshID.get()] != MeshID::Invalid());
+        cachedMesh.meshID = meshIDMap[cachedMesh.meshID.get()];
+    }
+    for (auto& cache : mSceneData.cachedCurves)
+    {
+        if (cache.tessellationMode != CurveTessellationMode::LinearSweptSphere)
+        {
+            FALCOR_ASSERT(meshIDMap[cache.geometryID.get()] != MeshID::Invalid());
+            cache.geometryID = CurveOrMeshID{meshIDMap[cache.geometryID.get()]};
+        }
+    }
+    for (auto& ps : mSceneData.particleSystems)
+    {
+        for (auto& meshID : ps.meshIDs)
+            meshID = meshIDMap[meshID.get()];
+    }
 
-            // Update the mesh IDs of cached meshes.
-            for (auto& cachedMesh : mSceneData.cachedMeshes)
-            {
-                if (cachedMesh.meshID == meshID)
-                    cachedMesh.meshID = newMeshID;
-            }
-            for (auto& cache : mSceneData.cachedCurves)
-            {
-                if (cache.tessellationMode != CurveTessellationMode::LinearSweptSphere)
-                {
-                    if (cache.geometryID == CurveOrMeshID{meshID})
-                        cache.geometryID = CurveOrMeshID{newMeshID};
-                }
-            }
+    mMeshes = std::move(meshes);
+
+    // Validate scene graph.
+    for (const auto& node : mSceneGraph)
+    {
+        for (MeshID meshID : node.meshes)
+            FALCOR_ASSERT_LT(meshID.get(), mMeshes.size());
+    }
+}
+
+void SceneBuilder::instanceIdenticalMeshes()
+{
+    // This function replaces static meshes that have identical processed data with instances of a single mesh.
+    // Importers often emit a separate copy of a mesh for each scene graph node referencing it.
+    // Instancing them reduces the size of the global vertex/index buffers and of the BLASes.
+    // Skinned and vertex-animated (dynamic) meshes are skipped, as their vertices are updated per mesh. Particle systems are skipped too.
+    // The instanced meshes are marked as content instanced, so that flattenStaticMeshInstances() doesn't duplicate them again.
+
+    if (!is_set(mFlags, Flags::InstanceIdenticalMeshes))
+        return;
+
+    auto isInstanceable = [](const MeshSpec& mesh) { return !mesh.instances.empty() && !mesh.isDynamic() && !mesh.isParticle(); };
+
+    // Meshes are identical if all their properties except the name and instances match, and their data is bitwise identical.
+    auto isMeshDataEqual = [](const MeshSpec& lhs, const MeshSpec& rhs)
+    {
+        return lhs.topology == rhs.topology && lhs.materialId == rhs.materialId && lhs.isFrontFaceCW == rhs.isFrontFaceCW &&
+               lhs.use16BitIndices == rhs.use16BitIndices && lhs.indexCount == rhs.indexCount && lhs.vertexCount == rhs.vertexCount &&
+               lhs.staticVertexCount == rhs.staticVertexCount && lhs.isDisplaced == rhs.isDisplaced &&
+               lhs.isCastShadow == rhs.isCastShadow && lhs.isOpaque == rhs.isOpaque && lhs.indexData == rhs.indexData &&
+               lhs.staticData.size() == rhs.staticData.size() &&
+               std::memcmp(lhs.staticData.data(), rhs.staticData.data(), lhs.staticData.size() * sizeof(StaticVertexData)) == 0;
+    };
+
+    auto hashMeshData = [](const MeshSpec& mesh)
+    {
+        uint64_t hash = hashBytes(mesh.indexData.data(), mesh.indexData.size() * sizeof(uint32_t), mesh.materialId.get());
+        return hashBytes(mesh.staticData.data(), mesh.staticData.size() * sizeof(StaticVertexData), hash);
+    };
 
-            meshes.push_back(std::move(mesh));
+    // Hash the mesh data in parallel. Meshes are only compared if their hashes match.
+    std::vector<uint64_t> hashes(mMeshes.size(), 0);
+    Threading::parallelFor(
+        0, mMeshes.size(),
+        [&](size_t meshIndex)
+        {
+            const auto& mesh = mMeshes[meshIndex];
+            if (isInstanceable(mesh))
+                hashes[meshIndex] = hashMeshData(mesh);
         }
+    );
 
-        mMeshes = std::move(meshes);
+    std::unordered_map<uint64_t, std::vector<MeshID>> uniqueMeshes;
+    size_t instancedMeshCount = 0;
 
-        // Validate scene graph.
-        FALCOR_ASSERT(mMeshes.size() == meshCount - unusedCount);
-        for (const auto& node : mSceneGraph)
+    for (MeshID meshID{0}; meshID.get() < (uint32_t)mMeshes.size(); ++meshID)
+    {
+        auto& mesh = mMeshes[meshID.get()];
+        if (!isInstanceable(mesh))
+            continue;
+
+        auto& candidates = uniqueMeshes[hashes[meshID.get()]];
+        auto it = std::find_if(
+            candidates.begin(), candidates.end(), [&](MeshID otherID) { return isMeshDataEqual(mMeshes[otherID.get()], mesh); }
+        );
+        if (it == candidates.end())
         {
-            for (MeshID meshID : node.meshes)
-                FALCOR_ASSERT_LT(meshID.get(), mMeshes.size());
+            candidates.push_back(meshID);
+            continue;
         }
+
+        // Instances are identified by their node, so meshes sharing a node with the unique mesh are kept.
+        const MeshID uniqueID = *it;
+        auto& uniqueMesh = mMeshes[uniqueID.get()];
+        if (std::any_of(mesh.instances.begin(), mesh.instances.end(), [&](NodeID nodeID) { return uniqueMesh.instances.count(nodeID) > 0; }))
+            continue;
+
+        // Link the nodes of the mesh to the unique mesh.
+        for (NodeID nodeID : mesh.instances)
+        {
+            auto& node = mSceneGraph[nodeID.get()];
+            std::replace(node.meshes.begin(), node.meshes.end(), meshID, uniqueID);
+            uniqueMesh.instances.insert(nodeID);
+        }
+        uniqueMesh.isContentInstanced = true;
+        mesh.instances.clear();
+        instancedMeshCount++;
+    }
+
+    if (instancedMeshCount > 0)
+    {
+        removeMeshesWithoutInstances();
+        logInfo("Replaced {} meshes with instances of meshes with identical data.", instancedMeshCount);
     }
 }
 
@@ -1646,8 +1821,8 @@ void SceneBuilder::flattenStaticMeshInstances()
     {
         auto& mesh = mMeshes[meshID.get()];
 
-        // Skip non-instanced and dynamic meshes.
-        if (mesh.instances.size() == 1 || mesh.isDynamic())
+        // Skip non-instanced and dynamic meshes, and meshes instanced by instanceIdenticalMeshes().
+        if (mesh.instances.size() == 1 || mesh.isDynamic() || mesh.isContentInstanced)
         {
             continue;
         }
@@ -1995,19 +2170,23 @@ void SceneBuilder::unifyTriangleWinding()
 
 void SceneBuilder::calculateMeshBoundingBoxes()
 {
-    for (auto& mesh : mMeshes)
-    {
-        FALCOR_ASSERT(!mesh.staticData.empty());
-        FALCOR_ASSERT((size_t)mesh.vertexCount == mesh.staticData.size());
-
-        AABB meshBB;
-        for (auto& v : mesh.staticData)
+    Threading::parallelFor(
+        0, mMeshes.size(),
+        [&](size_t meshIndex)
         {
-            meshBB.include(v.position);
-        }
+            auto& mesh = mMeshes[meshIndex];
+            FALCOR_ASSERT(!mesh.staticData.empty());
+            FALCOR_ASSERT((size_t)mesh.vertexCount == mesh.staticData.size());
 
-        mesh.boundingBox = meshBB;
-    }
+            AABB meshBB;
+            for (auto& v : mesh.staticData)
+            {
+                meshBB.include(v.position);
+            }
+
+            mesh.boundingBox = meshBB;
+        }
+    );
 }
 
 void SceneBuilder::createMeshGroups()
@@ -2625,6 +2804,58 @@ SceneBuilder::MeshGroupList SceneBuilder::splitMeshGroupMidpointMeshes(MeshGroup
     return leftList;
 }
 
+SceneBuilder::MeshGroupList SceneBuilder::splitMeshGroupSAH(MeshGroup& meshGroup) const
+{
+    // This function partitions a mesh group into smaller groups by sorting the meshes along a Morton curve
+    // and cutting the sorted list using a binned SAH cost that penalizes overlap (see MeshGroupPartitioner).
+    // Individual meshes are not split, but the cost model keeps the overlap between groups low.
+
+    // Early out if splitting is not needed or possible.
+    size_t triangleCount = 0;
+    if (!needsSplit(meshGroup, triangleCount))
+        return MeshGroupList{std::move(meshGroup)};
+
+    std::vector<MeshGroupPartitioner::Item> items;
+    items.reserve(meshGroup.meshList.size());
+    for (auto meshID : meshGroup.meshList)
+    {
+        const auto& mesh = mMeshes[meshID.get()];
+        items.push_back({mesh.boundingBox, mesh.getTriangleCount()});
+    }
+
+    MeshGroupList groups;
+    for (const auto& partition : MeshGroupPartitioner::partitionSAH(items, kMaxTrianglesPerBLAS))
+    {
+        MeshGroup group = meshGroup;
+        group.meshList.clear();
+        for (uint32_t index : partition)
+            group.meshList.push_back(meshGroup.meshList[index]);
+        groups.push_back(std::move(group));
+    }
+
+    FALCOR_ASSERT(!groups.empty());
+    return groups;
+}
+
+MeshGroupPartitioner::CostReport SceneBuilder::evaluateMeshGroups(const MeshGroupList& meshGroups) const
+{
+    std::vector<MeshGroupPartitioner::Item> items;
+    std::vector<MeshGroupPartitioner::Group> groups;
+
+    for (const auto& meshGroup : meshGroups)
+    {
+        auto& group = groups.emplace_back();
+        for (auto meshID : meshGroup.meshList)
+        {
+            const auto& mesh = mMeshes[meshID.get()];
+            group.push_back((uint32_t)items.size());
+            items.push_back({mesh.boundingBox, mesh.getTriangleCount()});
+        }
+    }
+
+    return MeshGroupPartitioner::evaluate(items, groups);
+}
+
 void SceneBuilder::optimizeGeometry()
 {
     // This function optimizes the geometry for raytracing performance and memory usage.
@@ -2637,18 +2868,49 @@ void SceneBuilder::optimizeGeometry()
     //  - Split large mesh groups (BLASes) into multiple smaller ones.
     //  - Split large meshes into smaller to reduce spatial overlap between BLASes.
     //  - Sort meshes into BLASes based on spatial locality.
+    //
+    // The splitting strategy is selected with the 'SceneBuilder:meshGroupSplitMode' option. For each split group,
+    // the cost model of MeshGroupPartitioner is logged so that strategies can be compared without a GPU.
+
+    std::string splitMode = mSettings.getOption<std::string>("SceneBuilder:meshGroupSplitMode", kMeshGroupSplitMode);
+    if (splitMode != "simple" && splitMode != "median" && splitMode != "midpoint" && splitMode != "sah")
+    {
+        logWarning("Unknown mesh group split mode '{}'. Using '{}' instead.", splitMode, kMeshGroupSplitMode);
+        splitMode = kMeshGroupSplitMode;
+    }
 
     MeshGroupList optimizedGroups;
 
     for (auto& meshGroup : mMeshGroups)
     {
-        // auto groups = splitMeshGroupSimple(meshGroup);
-        // auto groups = splitMeshGroupMedian(meshGroup);
-        auto groups = splitMeshGroupMidpointMeshes(meshGroup);
+        // Evaluate the unsplit group first, as splitting consumes it.
+        MeshGroupPartitioner::CostReport unsplitCost;
+        if (meshGroup.meshList.size() > 1 && countTriangles(meshGroup) > kMaxTrianglesPerBLAS)
+            unsplitCost = evaluateMeshGroups({meshGroup});
+
+        MeshGroupList groups;
+        if (splitMode == "simple")
+            groups = splitMeshGroupSimple(meshGroup);
+        else if (splitMode == "median")
+            groups = splitMeshGroupMedian(meshGroup);
+        else if (splitMode == "sah")
+            groups = splitMeshGroupSAH(meshGroup);
+        else
+            groups = splitMeshGroupMidpointMeshes(meshGroup);
 
         if (groups.size() > 1)
+        {
             logWarning("SceneBuilder::optimizeGeometry() performance warning - Mesh group was split into {} groups.", groups.size());
 
+            const auto cost = evaluateMeshGroups(groups);
+            logInfo(
+                "Mesh group split mode '{}': traversal cost {:.3f} (unsplit {:.3f}), overlap volume {:.3g} ({:.1f}% of bounds), "
+                "largest group {} triangles.",
+                splitMode, cost.traversalCost, unsplitCost.traversalCost, cost.overlapVolume, cost.overlapRatio * 100.f,
+                cost.maxTriangleCount
+            );
+        }
+
         optimizedGroups.insert(optimizedGroups.end(), std::make_move_iterator(groups.begin()), std::make_move_iterator(groups.end()));
     }
 
@@ -2705,6 +2967,77 @@ void SceneBuilder::sortMeshes()
     }
 }
 
+void SceneBuilder::optimizeVertexCache()
+{
+    // This function reorders the triangles of each mesh for post-transform vertex cache efficiency and reduced overdraw,
+    // and renumbers the vertices in order of first use for vertex fetch locality.
+    // Vertex animations reference vertices by index, so vertices of animated meshes keep their order.
+
+    if (!is_set(mFlags, Flags::OptimizeVertexCache) || is_set(mFlags, Flags::NonIndexedVertices))
+        return;
+
+    std::vector<double> missesBefore(mMeshes.size(), 0.0);
+    std::vector<double> missesAfter(mMeshes.size(), 0.0);
+
+    Threading::parallelFor(
+        0, mMeshes.size(),
+        [&](size_t meshIndex)
+        {
+            auto& mesh = mMeshes[meshIndex];
+            if (mesh.indexCount == 0 || mesh.topology != Vao::Topology::TriangleList)
+                return;
+
+            const uint32_t vertexCount = (uint32_t)mesh.staticData.size();
+            std::vector<uint32_t> indices(mesh.indexCount);
+            for (uint32_t i = 0; i < mesh.indexCount; i++)
+                indices[i] = mesh.getIndex(i);
+
+            std::vector<float3> positions(vertexCount);
+            for (uint32_t i = 0; i < vertexCount; i++)
+                positions[i] = mesh.staticData[i].position;
+
+            const uint32_t triangleCount = mesh.getTriangleCount();
+            missesBefore[meshIndex] = VertexCacheOptimizer::computeACMR(indices, vertexCount) * triangleCount;
+
+            VertexCacheOptimizer::optimizeTriangleOrder(indices, vertexCount, positions.data());
+
+            if (!mesh.isAnimated)
+            {
+                auto remap = VertexCacheOptimizer::optimizeVertexOrder(indices, vertexCount);
+
+                std::vector<StaticVertexData> staticData(vertexCount);
+                for (uint32_t i = 0; i < vertexCount; i++)
+                    staticData[remap[i]] = mesh.staticData[i];
+                mesh.staticData = std::move(staticData);
+
+                // Skinning data references the local static vertices here.
+                for (auto& s : mesh.skinningData)
+                    s.staticIndex = remap[s.staticIndex];
+            }
+
+            missesAfter[meshIndex] = VertexCacheOptimizer::computeACMR(indices, vertexCount) * triangleCount;
+
+            if (mesh.use16BitIndices)
+                mesh.indexData = compact16BitIndices(indices);
+            else
+                mesh.indexData = std::move(indices);
+        }
+    );
+
+    uint64_t triangleCount = 0;
+    for (const auto& mesh : mMeshes)
+    {
+        if (mesh.indexCount > 0 && mesh.topology == Vao::Topology::TriangleList)
+            triangleCount += mesh.getTriangleCount();
+    }
+    if (triangleCount > 0)
+    {
+        double before = std::accumulate(missesBefore.begin(), missesBefore.end(), 0.0) / triangleCount;
+        double after = std::accumulate(missesAfter.begin(), missesAfter.end(), 0.0) / triangleCount;
+        logInfo("SceneBuilder::optimizeVertexCache() - ACMR {:.3f} before, {:.3f} after ({} triangles).", before, after, triangleCount);
+    }
+}
+
 void SceneBuilder::createGlobalBuffers()
 {
     FALCOR_ASSERT(mSceneData.meshIndexData.empty());
@@ -3278,8 +3611,11 @@ FALCOR_SCRIPT_BINDING(SceneBuilder)
     flags.value("DontUseDisplacement", SceneBuilder::Flags::DontUseDisplacement);
     flags.value("UseCompressedHitInfo", SceneBuilder::Flags::UseCompressedHitInfo);
     flags.value("TessellateCurvesIntoPolyTubes", SceneBuilder::Flags::TessellateCurvesIntoPolyTubes);
+    flags.value("OptimizeVertexCache", SceneBuilder::Flags::OptimizeVertexCache);
+    flags.value("InstanceIdenticalMeshes", SceneBuilder::Flags::InstanceIdenticalMeshes);
     flags.value("UseCache", SceneBuilder::Flags::UseCache);
     flags.value("RebuildCache", SceneBuilder::Flags::RebuildCache);
+    flags.value("DeferCacheLoading", SceneBuilder::Flags::DeferCacheLoading);
     ScriptBindings::addEnumBinaryOperators(flags);
 
     pybind11::class_<SceneBuilder> sceneBuilder(m, "SceneBuilder");
@@ -3297,6 +3633,7 @@ FALCOR_SCRIPT_BINDING(SceneBuilder)
     sceneBuilder.def_property("selectedCamera", &SceneBuilder::getSelectedCamera, &SceneBuilder::setSelectedCamera);
     sceneBuilder.def_property("cameraSpeed", &SceneBuilder::getCameraSpeed, &SceneBuilder::setCameraSpeed);
     sceneBuilder.def("importScene", &SceneBuilder::import, "path"_a, "dict"_a = pybind11::dict());
+    sceneBuilder.def("addDependency", &SceneBuilder::addDependency, "path"_a);
     sceneBuilder.def("addTriangleMesh", &SceneBuilder::addTriangleMesh, "triangleMesh"_a, "material"_a);
     sceneBuilder.def(
         "addParticleSystem", &SceneBuilder::addParticleSystem, "name"_a, "material"_a, "numParticles"_a,
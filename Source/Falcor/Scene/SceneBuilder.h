@@ -26,6 +26,7 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #pragma once
+#include "MeshGroupPartitioner.h"
 #include "Scene.h"
 #include "SceneCache.h"
 #include "SceneIDs.h"
@@ -41,11 +42,14 @@
 #include "Utils/Math/Vector.h"
 #include "Utils/Math/Matrix.h"
 #include "Utils/Settings.h"
+#include "Utils/Threading.h"
 
 #include <pybind11/pytypes.h>
 
 #include <filesystem>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -86,9 +90,15 @@ public:
         DontUseDisplacement = 0x4000,       ///< Don't use displacement mapping.
         UseCompressedHitInfo = 0x8000,      ///< Use compressed hit info (on scenes with triangle meshes only).
         TessellateCurvesIntoPolyTubes = 0x10000, ///< Tessellate curves into poly-tubes (the default is linear swept spheres).
+        OptimizeVertexCache = 0x20000, ///< Reorder triangles for post-transform vertex cache efficiency and reduced overdraw, and vertices
+                                       ///< for fetch locality. Vertices of meshes with vertex animations keep their order.
+        InstanceIdenticalMeshes = 0x40000, ///< Replace static meshes with identical data by instances of a single mesh. Skinned and animated
+                                           ///< meshes are not instanced. The instanced meshes are not flattened by 'FlattenStaticMeshInstances'.
 
         UseCache = 0x10000000,     ///< Enable scene caching. This caches the runtime scene representation on disk to reduce load time.
         RebuildCache = 0x20000000, ///< Rebuild scene cache.
+        DeferCacheLoading = 0x40000000, ///< When loading from the scene cache, load material textures and the environment map after the scene was created.
+                                        ///< All other data (geometry, grid volumes, animations, cached curves, ...) is loaded with the scene.
 
         Default = None
     };
@@ -392,6 +402,16 @@ public:
      */
     Flags getFlags() const { return mFlags; }
 
+    /** Record a file the scene depends on (scene file, included files, textures, ...).
+        The scene cache is only reused while none of the recorded files changed. This function is thread-safe.
+        \param[in] path File path. Relative paths are resolved using the data directories. Paths that don't exist are ignored.
+    */
+    void addDependency(const std::filesystem::path& path);
+
+    /** Get the files recorded with addDependency().
+     */
+    const std::vector<std::filesystem::path>& getDependencies() const { return mDependencies; }
+
     /** Set the render settings.
      */
     void setRenderSettings(const Scene::RenderSettings& renderSettings) { mSceneData.renderSettings = renderSettings; }
@@ -425,7 +445,24 @@ public:
     */
     MeshID addMesh(const Mesh& mesh);
 
+    /** Add a mesh that is processed on the thread pool.
+        The mesh ID is assigned immediately, so the order of meshes is the same as when using addMesh().
+        Processed meshes are committed by waitForMeshProcessing(), which is called by getScene().
+        Until then, the builder only holds a placeholder for the mesh with the material assigned. Instances can be added,
+        but the name, topology and vertex/index data are not available.
+        \param mesh The mesh to add. The data referenced by the mesh must stay valid until the mesh has been processed.
+        \param pOwner Optional object that is released after the mesh has been processed, e.g. the owner of the mesh data.
+        \return The ID of the mesh in the scene.
+    */
+    MeshID addMeshAsync(const Mesh& mesh, std::shared_ptr<const void> pOwner = nullptr);
+
+    /** Wait until all meshes added with addMeshAsync() are processed and commit them.
+        Throws an exception if processing a mesh failed.
+    */
+    void waitForMeshProcessing();
+
     /** Add a triangle mesh.
+        The mesh is processed on the thread pool (see addMeshAsync()).
         \param The triangle mesh to add.
         \param pMaterial The material to use for the mesh.
         \return The ID of the mesh in the scene.
@@ -738,6 +775,7 @@ private:
         bool isAnimated = false;                  ///< True if mesh has vertex animations.
         bool isCastShadow = true;                 ///< True if mesh should throw a shadow
         bool isOpaque = true;                     ///< True if the mesh is opaque
+        bool isContentInstanced = false;          ///< True if meshes with identical data were replaced by instances of this mesh.
         Scene::ParticleOrientationMode particleOrentation = Scene::ParticleOrientationMode::None; ///< Mode for particle orientation. None
                                                                                                   ///< means that this is no particle
         AABB boundingBox;                                                                         ///< Mesh bounding-box in object space.
@@ -803,11 +841,23 @@ private:
     SceneCache::Key mSceneCacheKey;
     bool mWriteSceneCache = false; ///< True if scene cache should be written after import.
 
+    std::vector<std::filesystem::path> mDependencies; ///< Files the scene depends on, stored in the scene cache manifest.
+    std::set<std::filesystem::path> mDependencySet;
+    std::mutex mDependencyMutex;
+
     SceneGraph mSceneGraph;
 
-    MeshList mMeshes;
+    MeshList mMeshes; ///< Meshes in mPendingMeshes only have the material assigned until waitForMeshProcessing().
     MeshGroupList mMeshGroups; ///< Groups of meshes. Each group represents all the geometries in a BLAS for ray tracing.
 
+    struct PendingMesh
+    {
+        MeshID meshID;
+        std::shared_ptr<ProcessedMesh> pMesh;
+        Threading::Task task;
+    };
+    std::vector<PendingMesh> mPendingMeshes; ///< Meshes added with addMeshAsync() that are not committed yet.
+
     CurveList mCurves;
 
     std::unique_ptr<MaterialTextureLoader> mpMaterialTextureLoader;
@@ -819,6 +869,7 @@ private:
     bool collapseNodes(NodeID parentNodeID, NodeID childNodeID);
     bool mergeNodes(NodeID dstNodeID, NodeID srcNodeID);
     void flipTriangleWinding(MeshSpec& mesh);
+    void setMeshData(MeshSpec& spec, ProcessedMesh&& mesh) const;
     void updateSDFGridID(SdfGridID oldID, SdfGridID newID);
 
     /** Split a mesh by the given axis-aligned splitting plane.
@@ -836,12 +887,16 @@ private:
     MeshGroupList splitMeshGroupSimple(MeshGroup& meshGroup) const;
     MeshGroupList splitMeshGroupMedian(MeshGroup& meshGroup) const;
     MeshGroupList splitMeshGroupMidpointMeshes(MeshGroup& meshGroup);
+    MeshGroupList splitMeshGroupSAH(MeshGroup& meshGroup) const;
+    MeshGroupPartitioner::CostReport evaluateMeshGroups(const MeshGroupList& meshGroups) const;
 
     // Post processing
     void prepareDisplacementMaps();
     void prepareSceneGraph();
     void prepareMeshes();
     void removeUnusedMeshes();
+    void removeMeshesWithoutInstances();
+    void instanceIdenticalMeshes();
     void flattenStaticMeshInstances();
     void optimizeSceneGraph();
     void pretransformStaticMeshes();
@@ -850,6 +905,7 @@ private:
     void createMeshGroups();
     void optimizeGeometry();
     void sortMeshes();
+    void optimizeVertexCache();
     void createGlobalBuffers();
     void createCurveGlobalBuffers();
     void optimizeMaterials();
@@ -30,11 +30,22 @@
 #include "Material/HairMaterial.h"
 #include "Material/ClothMaterial.h"
 #include "Material/MaterialTextureLoader.h"
+#include "Core/Platform/MemoryMappedFile.h"
+#include "Core/Platform/OS.h"
 #include "Utils/Logger.h"
+#include "Utils/Threading.h"
+#include "Utils/Image/Bitmap.h"
+#include "Utils/Image/ImageIO.h"
 
-#include <lz4_stream/lz4_stream.h>
+#include <lz4.h>
+#include <nlohmann/json.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <map>
+#include <memory>
+#include <optional>
 
 namespace Falcor
 {
@@ -43,37 +54,311 @@ namespace Falcor
         /** Specfies the current cache file version.
             This needs to be incremented every time the file format changes!
         */
-        const uint32_t kVersion = 25;
+        const uint32_t kVersion = 26;
 
         /** Scene cache directory (subdirectory in the application data directory).
         */
         const std::string kDirectory = "NVIDIA/Falcor/SceneCache";
 
+        /** Uncompressed size of a block. Blocks are compressed independently so they can be
+            compressed and decompressed in parallel.
+        */
         const size_t kBlockSize = 1 * 1024 * 1024;
 
+        /** Trivially copyable arrays of at least this size are stored in their own section,
+            which is decompressed directly into the destination array.
+        */
+        const size_t kMinSectionSize = 64 * 1024;
+
         const char* kMagic = "FalcorS$";
         struct Header
         {
             uint8_t magic[8]{};
             uint32_t version{};
+            uint32_t mainSection{}; ///< Section holding the serialized scene data.
+            uint64_t tocOffset{};   ///< File offset of the table of contents.
+            uint64_t tocSize{};     ///< Size of the table of contents in bytes.
 
             bool isValid() const
             {
                 return std::memcmp(magic, kMagic, sizeof(Header::magic)) == 0 && version == kVersion;
             }
         };
+
+        /** File layout (v26):
+            - Header
+            - Compressed blocks of all sections
+            - Table of contents: section count, then per section its uncompressed size, block count and BlockDescs.
+            A block with compressedSize == size is stored uncompressed.
+        */
+        struct BlockDesc
+        {
+            uint64_t offset = 0;         ///< File offset.
+            uint32_t compressedSize = 0;
+            uint32_t size = 0;           ///< Uncompressed size.
+        };
+        static_assert(sizeof(BlockDesc) == 16);
+
+        struct SectionDesc
+        {
+            uint64_t size = 0;
+            std::vector<BlockDesc> blocks;
+        };
+
+        /** Writes sections of independently compressed blocks to a cache file.
+        */
+        class CacheFileWriter
+        {
+        public:
+            CacheFileWriter(std::ostream& stream, uint64_t offset) : mStream(stream), mOffset(offset) {}
+
+            /** Compress and write a section.
+                \return Section index.
+            */
+            uint32_t addSection(const void* pData, size_t size)
+            {
+                const uint8_t* pSrc = reinterpret_cast<const uint8_t*>(pData);
+                const size_t blockCount = (size + kBlockSize - 1) / kBlockSize;
+                std::vector<std::vector<char>> compressed(blockCount);
+                Threading::parallelFor(0, blockCount, [&](size_t i)
+                {
+                    const size_t blockSize = std::min(kBlockSize, size - i * kBlockSize);
+                    auto& dst = compressed[i];
+                    dst.resize(LZ4_compressBound(int(blockSize)));
+                    int compressedSize = LZ4_compress_default(reinterpret_cast<const char*>(pSrc + i * kBlockSize), dst.data(), int(blockSize), int(dst.size()));
+                    // Keep incompressible blocks uncompressed.
+                    if (compressedSize <= 0 || size_t(compressedSize) >= blockSize) dst.clear();
+                    else dst.resize(compressedSize);
+                }, 1);
+
+                SectionDesc section;
+                section.size = size;
+                for (size_t i = 0; i < blockCount; ++i)
+                {
+                    BlockDesc block;
+                    block.offset = mOffset;
+                    block.size = uint32_t(std::min(kBlockSize, size - i * kBlockSize));
+                    if (compressed[i].empty())
+                    {
+                        block.compressedSize = block.size;
+                        mStream.write(reinterpret_cast<const char*>(pSrc + i * kBlockSize), block.size);
+                    }
+                    else
+                    {
+                        block.compressedSize = uint32_t(compressed[i].size());
+                        mStream.write(compressed[i].data(), block.compressedSize);
+                    }
+                    mOffset += block.compressedSize;
+                    section.blocks.push_back(block);
+                }
+                mSections.push_back(std::move(section));
+                return uint32_t(mSections.size() - 1);
+            }
+
+            /** Write the table of contents.
+                \param[out] header Receives the table location.
+            */
+            void writeToc(Header& header)
+            {
+                header.tocOffset = mOffset;
+                auto write = [&](const void* pData, size_t size) { mStream.write(reinterpret_cast<const char*>(pData), size); mOffset += size; };
+                uint32_t sectionCount = uint32_t(mSections.size());
+                write(&sectionCount, sizeof(sectionCount));
+                for (const auto& section : mSections)
+                {
+                    uint32_t blockCount = uint32_t(section.blocks.size());
+                    write(&section.size, sizeof(section.size));
+                    write(&blockCount, sizeof(blockCount));
+                    write(section.blocks.data(), blockCount * sizeof(BlockDesc));
+                }
+                header.tocSize = mOffset - header.tocOffset;
+            }
+
+        private:
+            std::ostream& mStream;
+            uint64_t mOffset;
+            std::vector<SectionDesc> mSections;
+        };
+
+        /** Reads sections of a memory-mapped cache file.
+        */
+        class CacheFileReader
+        {
+        public:
+            CacheFileReader(const std::filesystem::path& path) : mPath(path)
+            {
+                if (!mFile.open(path)) throw RuntimeError("Failed to open scene cache file '{}'.", path);
+
+                if (mFile.getSize() < sizeof(Header)) throw RuntimeError("Invalid header in scene cache file '{}'.", path);
+                std::memcpy(&mHeader, mFile.getData(), sizeof(Header));
+                if (!mHeader.isValid() || mHeader.tocOffset + mHeader.tocSize > mFile.getSize())
+                    throw RuntimeError("Invalid header in scene cache file '{}'.", path);
+
+                const uint8_t* pToc = getData() + mHeader.tocOffset;
+                const uint8_t* pTocEnd = pToc + mHeader.tocSize;
+                auto read = [&](void* pDst, size_t size)
+                {
+                    if (size > size_t(pTocEnd - pToc)) throw RuntimeError("Invalid table of contents in scene cache file '{}'.", mPath);
+                    std::memcpy(pDst, pToc, size);
+                    pToc += size;
+                };
+                uint32_t sectionCount = 0;
+                read(&sectionCount, sizeof(sectionCount));
+                mSections.resize(sectionCount);
+                for (auto& section : mSections)
+                {
+                    uint32_t blockCount = 0;
+                    read(&section.size, sizeof(section.size));
+                    read(&blockCount, sizeof(blockCount));
+                    section.blocks.resize(blockCount);
+                    read(section.blocks.data(), blockCount * sizeof(BlockDesc));
+                    for (const auto& block : section.blocks)
+                    {
+                        if (block.offset + block.compressedSize > mHeader.tocOffset || block.size > kBlockSize)
+                            throw RuntimeError("Invalid table of contents in scene cache file '{}'.", mPath);
+                    }
+                }
+                if (mHeader.mainSection >= mSections.size()) throw RuntimeError("Invalid header in scene cache file '{}'.", path);
+            }
+
+            const Header& getHeader() const { return mHeader; }
+
+            uint64_t getSectionSize(uint32_t index) const
+            {
+                if (index >= mSections.size()) throw RuntimeError("Invalid section index in scene cache file '{}'.", mPath);
+                return mSections[index].size;
+            }
+
+            /** Decompress a section in parallel into the destination, which must hold getSectionSize() bytes.
+            */
+            void readSection(uint32_t index, void* pDst, size_t size) const
+            {
+                if (getSectionSize(index) != size) throw RuntimeError("Unexpected section size in scene cache file '{}'.", mPath);
+
+                const auto& blocks = mSections[index].blocks;
+                uint8_t* pDstBytes = reinterpret_cast<uint8_t*>(pDst);
+                Threading::parallelFor(0, blocks.size(), [&](size_t i)
+                {
+                    const BlockDesc& block = blocks[i];
+                    const size_t dstOffset = i * kBlockSize;
+                    if (dstOffset + block.size > size) throw RuntimeError("Invalid block in scene cache file '{}'.", mPath);
+                    const char* pSrc = reinterpret_cast<const char*>(getData() + block.offset);
+                    char* pBlockDst = reinterpret_cast<char*>(pDstBytes + dstOffset);
+                    if (block.compressedSize == block.size)
+                    {
+                        std::memcpy(pBlockDst, pSrc, block.size);
+                    }
+                    else if (LZ4_decompress_safe(pSrc, pBlockDst, int(block.compressedSize), int(block.size)) != int(block.size))
+                    {
+                        throw RuntimeError("Corrupt block in scene cache file '{}'.", mPath);
+                    }
+                }, 1);
+            }
+
+        private:
+            const uint8_t* getData() const { return reinterpret_cast<const uint8_t*>(mFile.getData()); }
+
+            std::filesystem::path mPath;
+            MemoryMappedFile mFile;
+            Header mHeader;
+            std::vector<SectionDesc> mSections;
+        };
+
+        template<typename T>
+        constexpr bool isTriviallySerializable()
+        {
+            return std::is_trivial<T>::value && !std::is_same<T, bool>::value;
+        }
+
+        /** Entry of the dependency manifest.
+        */
+        struct Dependency
+        {
+            std::filesystem::path path;
+            uint64_t size = 0;
+            int64_t modificationTime = 0; ///< File time in ticks of the file clock.
+            std::string hash;             ///< SHA1 of the file content.
+        };
+
+        bool statDependency(const std::filesystem::path& path, uint64_t& size, int64_t& modificationTime)
+        {
+            std::error_code ec;
+            size = std::filesystem::file_size(path, ec);
+            if (ec) return false;
+            modificationTime = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+            return !ec;
+        }
+
+        std::string hashFile(const std::filesystem::path& path)
+        {
+            std::ifstream fs(path, std::ios_base::binary);
+            if (!fs) return {};
+            SHA1 sha1;
+            std::vector<char> buffer(kBlockSize);
+            while (fs)
+            {
+                fs.read(buffer.data(), buffer.size());
+                sha1.update(buffer.data(), size_t(fs.gcount()));
+            }
+            return SHA1::toString(sha1.finalize());
+        }
+
+        void writeManifest(const std::filesystem::path& manifestPath, const std::vector<Dependency>& dependencies)
+        {
+            nlohmann::json json = nlohmann::json::array();
+            for (const auto& dependency : dependencies)
+            {
+                json.push_back({
+                    { "path", dependency.path.string() },
+                    { "size", dependency.size },
+                    { "mtime", dependency.modificationTime },
+                    { "sha1", dependency.hash },
+                });
+            }
+            std::ofstream fs(manifestPath);
+            fs << json.dump(1);
+            if (fs.bad()) throw RuntimeError("Failed to write scene cache manifest '{}'.", manifestPath);
+        }
+
+        std::optional<std::vector<Dependency>> readManifest(const std::filesystem::path& manifestPath)
+        {
+            std::ifstream fs(manifestPath);
+            if (!fs) return {};
+            try
+            {
+                std::vector<Dependency> dependencies;
+                for (const auto& entry : nlohmann::json::parse(fs))
+                {
+                    Dependency dependency;
+                    dependency.path = entry.at("path").get<std::string>();
+                    dependency.size = entry.at("size").get<uint64_t>();
+                    dependency.modificationTime = entry.at("mtime").get<int64_t>();
+                    dependency.hash = entry.at("sha1").get<std::string>();
+                    dependencies.push_back(std::move(dependency));
+                }
+                return dependencies;
+            }
+            catch (const nlohmann::json::exception&)
+            {
+                return {};
+            }
+        }
     }
 
-    /** Wrapper around std::ostream to ease serialization of basic types.
+    /** Serializes basic types into an in-memory stream.
+        Large trivially copyable arrays are written to their own section of the cache file.
     */
     class SceneCache::OutputStream
     {
     public:
-        OutputStream(std::ostream& stream) : mStream(stream) {}
+        OutputStream(CacheFileWriter& writer) : mWriter(writer) {}
+
+        const std::vector<uint8_t>& getBuffer() const { return mBuffer; }
 
         void write(const void* data, size_t len)
         {
-            mStream.write(reinterpret_cast<const char*>(data), len);
+            const uint8_t* pData = reinterpret_cast<const uint8_t*>(data);
+            mBuffer.insert(mBuffer.end(), pData, pData + len);
         }
 
         template<typename T>
@@ -99,9 +384,10 @@ namespace Falcor
         {
             uint64_t len = vec.size();
             write(len);
-            if constexpr (std::is_trivial<T>::value && !std::is_same<T, bool>::value)
+            if constexpr (isTriviallySerializable<T>())
             {
-                write(vec.data(), len * sizeof(T));
+                if (len * sizeof(T) >= kMinSectionSize) write(mWriter.addSection(vec.data(), len * sizeof(T)));
+                else write(vec.data(), len * sizeof(T));
             }
             else
             {
@@ -118,19 +404,27 @@ namespace Falcor
         }
 
     private:
-        std::ostream& mStream;
+        CacheFileWriter& mWriter;
+        std::vector<uint8_t> mBuffer;
     };
 
-    /** Wrapper around std::istream to ease serialization of basic types.
+    /** Deserializes basic types from a decompressed section.
+        Arrays stored in their own section are decompressed directly into the destination.
     */
     class SceneCache::InputStream
     {
     public:
-        InputStream(std::istream& stream) : mStream(stream) {}
+        InputStream(const CacheFileReader& reader, uint32_t section) : mReader(reader)
+        {
+            mBuffer.resize(mReader.getSectionSize(section));
+            mReader.readSection(section, mBuffer.data(), mBuffer.size());
+        }
 
         void read(void* data, size_t len)
         {
-            mStream.read(reinterpret_cast<char*>(data), len);
+            if (len > mBuffer.size() - mPosition) throw RuntimeError("Unexpected end of scene cache data.");
+            std::memcpy(data, mBuffer.data() + mPosition, len);
+            mPosition += len;
         }
 
         template<typename T>
@@ -165,13 +459,25 @@ namespace Falcor
         void read(std::vector<T>& vec)
         {
             uint64_t len = read<uint64_t>();
-            vec.resize(len);
-            if constexpr (std::is_trivial<T>::value && !std::is_same<T, bool>::value)
+            if constexpr (isTriviallySerializable<T>())
             {
-                read(vec.data(), len * sizeof(T));
+                if (len * sizeof(T) >= kMinSectionSize)
+                {
+                    uint32_t section = read<uint32_t>();
+                    if (mReader.getSectionSize(section) != len * sizeof(T)) throw RuntimeError("Unexpected section size in scene cache data.");
+                    vec.resize(len);
+                    mReader.readSection(section, vec.data(), len * sizeof(T));
+                }
+                else
+                {
+                    if (len * sizeof(T) > mBuffer.size() - mPosition) throw RuntimeError("Unexpected end of scene cache data.");
+                    vec.resize(len);
+                    read(vec.data(), len * sizeof(T));
+                }
             }
             else
             {
+                vec.resize(len);
                 for (auto& item : vec) read(item);
             }
         }
@@ -189,7 +495,181 @@ namespace Falcor
         }
 
     private:
-        std::istream& mStream;
+        const CacheFileReader& mReader;
+        std::vector<uint8_t> mBuffer;
+        size_t mPosition = 0;
+    };
+
+    /** Loads material textures and the environment map after the scene was created.
+        Images are decoded on the thread pool. Textures are created on the main thread in apply(),
+        as texture uploads must not run concurrently with other GPU work. DDS files are loaded in apply().
+        Only textures and the environment map are deferred. Grid volumes, animations and cached curves are read with the scene.
+    */
+    class SceneCache::DeferredLoader : public Scene::DeferredData
+    {
+    public:
+        DeferredLoader(ref<Device> pDevice) : mpDevice(pDevice) {}
+
+        /** Check if a material texture can be deferred.
+            Displacement and emissive textures are loaded with the scene as they affect the geometry types and the light collection.
+            Paths that are not a single file (e.g. UDIM textures) are loaded by the texture manager.
+        */
+        static bool canDefer(Material::TextureSlot slot, const std::filesystem::path& path)
+        {
+            return slot != Material::TextureSlot::Displacement && slot != Material::TextureSlot::Emissive && std::filesystem::is_regular_file(path);
+        }
+
+        void loadTexture(const ref<Material>& pMaterial, Material::TextureSlot slot, const std::filesystem::path& path)
+        {
+            bool srgb = pMaterial->getTextureSlotInfo(slot).srgb;
+            auto& pImage = mImagesByKey[{ path, srgb }];
+            if (!pImage) pImage = requestImage(path, srgb);
+            mTextureAssignments.push_back({ pMaterial, slot, pImage });
+        }
+
+        void loadEnvMap(const std::filesystem::path& path, const EnvMapData& data, float3 rotation)
+        {
+            mEnvMap = { requestImage(path, false), data, rotation };
+        }
+
+        bool apply(Scene& scene, RenderContext* pRenderContext) override
+        {
+            // Create ready textures up to the upload budget, but at least one per frame.
+            uint64_t uploadedBytes = 0;
+            for (const auto& pImage : mPendingImages)
+            {
+                if (uploadedBytes >= kUploadBudget) break;
+                if (pImage->isCreated || !pImage->isReady) continue;
+                createTexture(*pImage);
+                if (pImage->pTexture) uploadedBytes += pImage->pTexture->getTextureSizeInBytes();
+            }
+            mPendingImages.erase(
+                std::remove_if(mPendingImages.begin(), mPendingImages.end(), [](const auto& pImage) { return pImage->isCreated; }),
+                mPendingImages.end()
+            );
+
+            // Assign created textures. This goes through the material's setTexture() like the synchronous load,
+            // so the material ends up in the same state.
+            auto it = std::remove_if(mTextureAssignments.begin(), mTextureAssignments.end(), [](const TextureAssignment& assignment)
+            {
+                if (!assignment.pImage->isCreated) return false;
+                if (assignment.pImage->pTexture) assignment.pMaterial->setTexture(assignment.slot, assignment.pImage->pTexture);
+                return true;
+            });
+            mTextureAssignments.erase(it, mTextureAssignments.end());
+
+            if (mEnvMap.pImage && mEnvMap.pImage->isCreated)
+            {
+                if (auto pTexture = mEnvMap.pImage->pTexture)
+                {
+                    auto pEnvMap = EnvMap::create(mpDevice, pTexture);
+                    pEnvMap->setRotation(mEnvMap.rotation);
+                    pEnvMap->setIntensity(mEnvMap.data.intensity);
+                    pEnvMap->setTint(mEnvMap.data.tint);
+                    scene.setEnvMap(pEnvMap);
+                }
+                mEnvMap.pImage.reset();
+            }
+
+            return mPendingImages.empty() && mTextureAssignments.empty() && !mEnvMap.pImage;
+        }
+
+        std::string getStatus() const override
+        {
+            return fmt::format("Loading scene: {} textures remaining", mPendingImages.size());
+        }
+
+    private:
+        /// Size of textures to create per frame.
+        static constexpr uint64_t kUploadBudget = 64 * 1024 * 1024;
+
+        struct Image
+        {
+            std::filesystem::path path;
+            bool srgb = false;
+            Bitmap::UniqueConstPtr pBitmap;
+            std::atomic<bool> isReady{false}; ///< Set by the loading task.
+            bool isCreated = false;
+            ref<Texture> pTexture;            ///< Created texture or nullptr if loading failed.
+        };
+
+        struct TextureAssignment
+        {
+            ref<Material> pMaterial;
+            Material::TextureSlot slot;
+            std::shared_ptr<Image> pImage;
+        };
+
+        struct EnvMapRequest
+        {
+            std::shared_ptr<Image> pImage;
+            EnvMapData data;
+            float3 rotation;
+        };
+
+        std::shared_ptr<Image> requestImage(const std::filesystem::path& path, bool srgb)
+        {
+            auto pImage = std::make_shared<Image>();
+            pImage->path = path;
+            pImage->srgb = srgb;
+            mPendingImages.push_back(pImage);
+
+            if (hasExtension(path, "dds"))
+            {
+                pImage->isReady = true;
+                return pImage;
+            }
+
+            // The task holds a reference to the image, so it may outlive the loader.
+            Threading::dispatchTask([pImage]()
+            {
+                try
+                {
+                    pImage->pBitmap = Bitmap::createFromFile(pImage->path, true);
+                }
+                catch (const std::exception& e)
+                {
+                    logWarning("Error loading '{}': {}", pImage->path, e.what());
+                }
+                pImage->isReady = true;
+            });
+            return pImage;
+        }
+
+        void createTexture(Image& image)
+        {
+            // Same as Texture::createFromFile() with mips, using the decoded bitmap.
+            if (hasExtension(image.path, "dds"))
+            {
+                try
+                {
+                    image.pTexture = ImageIO::loadTextureFromDDS(mpDevice, image.path, image.srgb);
+                }
+                catch (const std::exception& e)
+                {
+                    logWarning("Error loading '{}': {}", image.path, e.what());
+                }
+            }
+            else if (image.pBitmap)
+            {
+                ResourceFormat format = image.pBitmap->getFormat();
+                if (image.srgb) format = linearToSrgbFormat(format);
+                image.pTexture = Texture::create2D(
+                    mpDevice, image.pBitmap->getWidth(), image.pBitmap->getHeight(), format, 1, Texture::kMaxPossible, image.pBitmap->getData()
+                );
+                image.pBitmap.reset();
+            }
+
+            if (image.pTexture) image.pTexture->setSourcePath(image.path);
+            else logWarning("Failed to load deferred texture '{}'.", image.path);
+            image.isCreated = true;
+        }
+
+        ref<Device> mpDevice;
+        std::map<std::pair<std::filesystem::path, bool>, std::shared_ptr<Image>> mImagesByKey;
+        std::vector<std::shared_ptr<Image>> mPendingImages;
+        std::vector<TextureAssignment> mTextureAssignments;
+        EnvMapRequest mEnvMap;
     };
 
     bool SceneCache::hasValidCache(const Key& key)
@@ -201,13 +681,63 @@ namespace Falcor
         std::ifstream fs(cachePath.c_str(), std::ios_base::binary);
         if (fs.bad()) return false;
 
-        // Verify header.
+        // Verify header and that the file was completely written.
         Header header;
         fs.read(reinterpret_cast<char*>(&header), sizeof(header));
-        return !fs.eof() && header.isValid();
+        if (fs.eof() || !header.isValid()) return false;
+        std::error_code ec;
+        auto fileSize = std::filesystem::file_size(cachePath, ec);
+        if (ec || header.tocOffset + header.tocSize > fileSize) return false;
+
+        // Verify that none of the dependencies changed. Files with a different modification time are hashed
+        // and the manifest is updated if the content is unchanged, so touching a file only costs one hash.
+        auto manifestPath = getManifestPath(key);
+        auto dependencies = readManifest(manifestPath);
+        if (!dependencies) return false;
+
+        std::vector<uint8_t> valid(dependencies->size(), 1);
+        std::atomic<bool> touched{false};
+        Threading::parallelFor(0, dependencies->size(), [&](size_t i)
+        {
+            auto& dependency = (*dependencies)[i];
+            uint64_t size;
+            int64_t modificationTime;
+            if (!statDependency(dependency.path, size, modificationTime) || size != dependency.size) valid[i] = 0;
+            else if (modificationTime != dependency.modificationTime)
+            {
+                if (hashFile(dependency.path) != dependency.hash) valid[i] = 0;
+                else
+                {
+                    dependency.modificationTime = modificationTime;
+                    touched = true;
+                }
+            }
+        }, 1);
+
+        for (size_t i = 0; i < valid.size(); ++i)
+        {
+            if (!valid[i])
+            {
+                logInfo("Scene cache '{}' is outdated, '{}' has changed.", cachePath, (*dependencies)[i].path);
+                return false;
+            }
+        }
+
+        if (touched)
+        {
+            try
+            {
+                writeManifest(manifestPath, *dependencies);
+            }
+            catch (const RuntimeError& e)
+            {
+                logWarning("{}", e.what());
+            }
+        }
+        return true;
     }
 
-    void SceneCache::writeCache(const Scene::SceneData& sceneData, const Key& key)
+    void SceneCache::writeCache(const Scene::SceneData& sceneData, const Key& key, const std::vector<std::filesystem::path>& dependencies)
     {
         auto cachePath = getCachePath(key);
 
@@ -216,44 +746,64 @@ namespace Falcor
         // Create directories if not existing.
         std::filesystem::create_directories(cachePath.parent_path());
 
+        // Remove the old manifest first. A cache without manifest is invalid, so it is not used if writing fails.
+        auto manifestPath = getManifestPath(key);
+        std::error_code ec;
+        std::filesystem::remove(manifestPath, ec);
+
         // Open file.
         std::ofstream fs(cachePath.c_str(), std::ios_base::binary);
         if (fs.bad()) throw RuntimeError("Failed to create scene cache file '{}'.", cachePath);
 
-        // Write header (uncompressed).
+        // Reserve space for the header, which is written last. A partially written file has an invalid header.
         Header header;
-        std::memcpy(header.magic, kMagic, sizeof(Header::magic));
-        header.version = kVersion;
         fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
 
-        // Write cache (compressed).
-        lz4_stream::basic_ostream<kBlockSize> zs(fs);
-        OutputStream stream(zs);
+        // Write sections. Large arrays are written while serializing, the main section last.
+        CacheFileWriter writer(fs, sizeof(header));
+        OutputStream stream(writer);
         writeSceneData(stream, sceneData);
+        header.mainSection = writer.addSection(stream.getBuffer().data(), stream.getBuffer().size());
+        writer.writeToc(header);
+
+        std::memcpy(header.magic, kMagic, sizeof(Header::magic));
+        header.version = kVersion;
+        fs.seekp(0);
+        fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
         if (fs.bad()) throw RuntimeError("Failed to write scene cache file to '{}'.", cachePath);
+
+        // Write the dependency manifest.
+        std::vector<Dependency> manifest(dependencies.size());
+        std::vector<uint8_t> exists(dependencies.size(), 0);
+        Threading::parallelFor(0, dependencies.size(), [&](size_t i)
+        {
+            auto& dependency = manifest[i];
+            dependency.path = dependencies[i];
+            if (!statDependency(dependency.path, dependency.size, dependency.modificationTime)) return;
+            dependency.hash = hashFile(dependency.path);
+            exists[i] = !dependency.hash.empty();
+        }, 1);
+        for (size_t i = 0; i < dependencies.size(); ++i)
+        {
+            // Without a manifest the cache is never used.
+            if (!exists[i])
+            {
+                logWarning("Failed to read scene dependency '{}'. The scene cache will not be used.", dependencies[i]);
+                return;
+            }
+        }
+        writeManifest(manifestPath, manifest);
     }
 
-    Scene::SceneData SceneCache::readCache(ref<Device> pDevice, const Key& key)
+    Scene::SceneData SceneCache::readCache(ref<Device> pDevice, const Key& key, bool deferredLoading)
     {
         auto cachePath = getCachePath(key);
 
         logInfo("Loading scene cache from '{}'.", cachePath);
 
-        // Open file.
-        std::ifstream fs(cachePath.c_str(), std::ios_base::binary);
-        if (fs.bad()) throw RuntimeError("Failed to open scene cache file '{}'.", cachePath);
-
-        // Read header (uncompressed).
-        Header header;
-        fs.read(reinterpret_cast<char*>(&header), sizeof(header));
-        if (!header.isValid()) throw RuntimeError("Invalid header in scene cache file '{}'.", cachePath);
-
-        // Read cache (compressed).
-        lz4_stream::basic_istream<kBlockSize, kBlockSize> zs(fs);
-        InputStream stream(zs);
-        auto sceneData = readSceneData(stream, pDevice);
-        if (fs.bad()) throw RuntimeError("Failed to read scene cache file from '{}'.", cachePath);
-        return sceneData;
+        CacheFileReader reader(cachePath);
+        InputStream stream(reader, reader.getHeader().mainSection);
+        return readSceneData(stream, pDevice, deferredLoading);
     }
 
     std::filesystem::path SceneCache::getCachePath(const Key& key)
@@ -261,6 +811,13 @@ namespace Falcor
         return getAppDataDirectory() / kDirectory / SHA1::toString(key);
     }
 
+    std::filesystem::path SceneCache::getManifestPath(const Key& key)
+    {
+        auto path = getCachePath(key);
+        path += ".deps.json";
+        return path;
+    }
+
     // SceneData
 
     void SceneCache::writeSceneData(OutputStream& stream, const Scene::SceneData& sceneData)
@@ -376,10 +933,11 @@ namespace Falcor
         writeMarker(stream, "End");
     }
 
-    Scene::SceneData SceneCache::readSceneData(InputStream& stream, ref<Device> pDevice)
+    Scene::SceneData SceneCache::readSceneData(InputStream& stream, ref<Device> pDevice, bool deferredLoading)
     {
         Scene::SceneData sceneData;
         sceneData.pMaterials = std::make_unique<MaterialSystem>(pDevice);
+        auto pDeferredLoader = deferredLoading ? std::make_unique<DeferredLoader>(pDevice) : nullptr;
 
         readMarker(stream, "Path");
         stream.read(sceneData.path);
@@ -407,7 +965,7 @@ namespace Falcor
 
         readMarker(stream, "EnvMap");
         auto hasEnvMap = stream.read<bool>();
-        if (hasEnvMap) sceneData.pEnvMap = readEnvMap(stream, pDevice);
+        if (hasEnvMap) sceneData.pEnvMap = readEnvMap(stream, pDeferredLoader.get(), pDevice);
 
         // Material textures are loaded asynchronously to allow loading other data
         // in parallel while loading textures from files and uploading them to the GPU.
@@ -419,7 +977,7 @@ namespace Falcor
         auto pMaterialTextureLoader = std::make_unique<MaterialTextureLoader>(sceneData.pMaterials->getTextureManager(), true);
 
         readMarker(stream, "Materials");
-        readMaterials(stream, *sceneData.pMaterials, *pMaterialTextureLoader, pDevice);
+        readMaterials(stream, *sceneData.pMaterials, *pMaterialTextureLoader, pDeferredLoader.get(), pDevice);
 
         readMarker(stream, "SceneGraph");
         sceneData.sceneGraph.resize(stream.read<uint32_t>());
@@ -498,6 +1056,8 @@ namespace Falcor
 
         pMaterialTextureLoader.reset();
 
+        sceneData.pDeferredData = std::move(pDeferredLoader);
+
         return sceneData;
     }
 
@@ -704,19 +1264,19 @@ namespace Falcor
         writeSampler(stream, pMaterial->mpDisplacementMaxSampler);
     }
 
-    void SceneCache::readMaterials(InputStream& stream, MaterialSystem& materialSystem, MaterialTextureLoader& materialTextureLoader, ref<Device> pDevice)
+    void SceneCache::readMaterials(InputStream& stream, MaterialSystem& materialSystem, MaterialTextureLoader& materialTextureLoader, DeferredLoader* pDeferredLoader, ref<Device> pDevice)
     {
         uint32_t materialCount = 0;
         stream.read(materialCount);
 
         for (uint32_t i = 0; i < materialCount; i++)
         {
-            auto pMaterial = readMaterial(stream, materialTextureLoader, pDevice);
+            auto pMaterial = readMaterial(stream, materialTextureLoader, pDeferredLoader, pDevice);
             materialSystem.addMaterial(pMaterial);
         }
     }
 
-    ref<Material> SceneCache::readMaterial(InputStream& stream, MaterialTextureLoader& materialTextureLoader, ref<Device> pDevice)
+    ref<Material> SceneCache::readMaterial(InputStream& stream, MaterialTextureLoader& materialTextureLoader, DeferredLoader* pDeferredLoader, ref<Device> pDevice)
     {
         // Create derived material class of the right type.
         ref<Material> pMaterial;
@@ -752,7 +1312,8 @@ namespace Falcor
             if (hasTexture)
             {
                 auto path = stream.read<std::filesystem::path>();
-                materialTextureLoader.loadTexture(pMaterial, slot, path);
+                if (pDeferredLoader && DeferredLoader::canDefer(slot, path)) pDeferredLoader->loadTexture(pMaterial, slot, path);
+                else materialTextureLoader.loadTexture(pMaterial, slot, path);
             }
         };
 
@@ -879,9 +1440,16 @@ namespace Falcor
         stream.write(pEnvMap->mRotation);
     }
 
-    ref<EnvMap> SceneCache::readEnvMap(InputStream& stream, ref<Device> pDevice)
+    ref<EnvMap> SceneCache::readEnvMap(InputStream& stream, DeferredLoader* pDeferredLoader, ref<Device> pDevice)
     {
         auto path = stream.read<std::filesystem::path>();
+        if (pDeferredLoader)
+        {
+            auto data = stream.read<EnvMapData>();
+            auto rotation = stream.read<float3>();
+            pDeferredLoader->loadEnvMap(path, data, rotation);
+            return nullptr;
+        }
         auto pEnvMap = EnvMap::createFromFile(pDevice, path);
         if (!pEnvMap) throw RuntimeError("Failed to load environment map");
         stream.read(pEnvMap->mData);
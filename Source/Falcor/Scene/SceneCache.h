@@ -50,6 +50,13 @@ namespace Falcor
     /** Helper class for reading and writing scene cache files.
         The scene cache is used to heavily reduce load times of more complex assets.
         The cache stores a binary representation of `Scene::SceneData` which contains everything to re-create a `Scene`.
+        The file consists of sections of independently LZ4 compressed blocks and a table of contents. Large arrays
+        (mesh data, cached mesh keyframes) are stored in their own sections. When reading, the file is memory-mapped
+        and the blocks of a section are decompressed in parallel directly into the destination array.
+
+        Next to each cache file a JSON manifest lists the files the scene was built from together with their
+        size, modification time and SHA1 hash. A cache is only valid while all of these files are unchanged.
+        Files are only hashed if their modification time differs from the one in the manifest.
     */
     class FALCOR_API SceneCache
     {
@@ -57,6 +64,7 @@ namespace Falcor
         using Key = SHA1::MD;
 
         /** Check if there is a valid scene cache for a given cache key.
+            The cache is invalid if any of the files in its dependency manifest changed.
             \param[in] key Cache key.
             \return Returns true if a valid cache exists.
         */
@@ -65,24 +73,32 @@ namespace Falcor
         /** Write a scene cache.
             \param[in] sceneData Scene data.
             \param[in] key Cache key.
+            \param[in] dependencies Files the scene depends on (absolute paths).
         */
-        static void writeCache(const Scene::SceneData& sceneData, const Key& key);
+        static void writeCache(const Scene::SceneData& sceneData, const Key& key, const std::vector<std::filesystem::path>& dependencies = {});
 
         /** Read a scene cache.
+            With deferred loading, only material textures and the environment map are deferred. They are decoded on the
+            thread pool and applied by the scene once ready (see Scene::isFullyLoaded()). Displacement and emissive textures
+            affect the scene setup and are loaded with the scene. All other data, including grid volumes, animations and
+            cached curves, is loaded before this function returns, as the scene cannot add it after creation.
             \param[in] pDevice GPU device.
             \param[in] key Cache key.
+            \param[in] deferredLoading Load material textures and the environment map after the scene was created.
             \return Returns the loaded scene data.
         */
-        static Scene::SceneData readCache(ref<Device> pDevice, const Key& key);
+        static Scene::SceneData readCache(ref<Device> pDevice, const Key& key, bool deferredLoading = false);
 
     private:
         class OutputStream;
         class InputStream;
+        class DeferredLoader;
 
         static std::filesystem::path getCachePath(const Key& key);
+        static std::filesystem::path getManifestPath(const Key& key);
 
         static void writeSceneData(OutputStream& stream, const Scene::SceneData& sceneData);
-        static Scene::SceneData readSceneData(InputStream& stream, ref<Device> pDevice);
+        static Scene::SceneData readSceneData(InputStream& stream, ref<Device> pDevice, bool deferredLoading);
 
         static void writeMetadata(OutputStream& stream, const Scene::Metadata& metadata);
         static Scene::Metadata readMetadata(InputStream& stream);
@@ -96,8 +112,8 @@ namespace Falcor
         static void writeMaterials(OutputStream& stream, const MaterialSystem& materialSystem);
         static void writeMaterial(OutputStream& stream, const ref<Material>& pMaterial);
         static void writeBasicMaterial(OutputStream& stream, const ref<BasicMaterial>& pMaterial);
-        static void readMaterials(InputStream& stream, MaterialSystem& materialSystem, MaterialTextureLoader& materialTextureLoader, ref<Device> pDevice);
-        static ref<Material> readMaterial(InputStream& stream, MaterialTextureLoader& materialTextureLoader, ref<Device> pDevice);
+        static void readMaterials(InputStream& stream, MaterialSystem& materialSystem, MaterialTextureLoader& materialTextureLoader, DeferredLoader* pDeferredLoader, ref<Device> pDevice);
+        static ref<Material> readMaterial(InputStream& stream, MaterialTextureLoader& materialTextureLoader, DeferredLoader* pDeferredLoader, ref<Device> pDevice);
         static void readBasicMaterial(InputStream& stream, MaterialTextureLoader& materialTextureLoader, const ref<BasicMaterial>& pMaterial, ref<Device> pDevice);
 
         static void writeSampler(OutputStream& stream, const ref<Sampler>& pSampler);
@@ -110,7 +126,7 @@ namespace Falcor
         static ref<Grid> readGrid(InputStream& stream, ref<Device> pDevice);
 
         static void writeEnvMap(OutputStream& stream, const ref<EnvMap>& pEnvMap);
-        static ref<EnvMap> readEnvMap(InputStream& stream, ref<Device> pDevice);
+        static ref<EnvMap> readEnvMap(InputStream& stream, DeferredLoader* pDeferredLoader, ref<Device> pDevice);
 
         static void writeTransform(OutputStream& stream, const Transform& transform);
         static Transform readTransform(InputStream& stream);
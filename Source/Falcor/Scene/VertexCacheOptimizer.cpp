@@ -0,0 +1,310 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "VertexCacheOptimizer.h"
+#include "Core/Assert.h"
+#include <algorithm>
+
+namespace Falcor
+{
+namespace
+{
+const uint32_t kInvalidIndex = 0xffffffff;
+
+// Clusters are split for overdraw sorting as long as this doesn't increase their ACMR by more than this factor.
+const double kOverdrawThreshold = 1.05;
+
+/** Simulates a FIFO vertex cache using insertion timestamps.
+    A vertex is in the cache if fewer than 'cacheSize' vertices were inserted after it.
+*/
+class CacheSimulator
+{
+public:
+    CacheSimulator(uint32_t vertexCount, uint32_t cacheSize) : mTimestamps(vertexCount, 0), mCacheSize(cacheSize), mTime(cacheSize + 1) {}
+
+    /// Returns true and inserts the vertex if it is not in the cache.
+    bool access(uint32_t v)
+    {
+        if (mTime - mTimestamps[v] <= mCacheSize)
+            return false;
+        mTimestamps[v] = mTime++;
+        return true;
+    }
+
+    uint32_t accessTriangle(const uint32_t* pTriangle) { return (uint32_t)access(pTriangle[0]) + access(pTriangle[1]) + access(pTriangle[2]); }
+
+    /// Returns the number of insertions since the vertex was inserted.
+    uint32_t getAge(uint32_t v) const { return mTime - mTimestamps[v]; }
+
+    void clear() { mTime += mCacheSize + 1; }
+
+private:
+    std::vector<uint32_t> mTimestamps;
+    uint32_t mCacheSize;
+    uint32_t mTime;
+};
+
+/// Splits a triangle list into clusters and returns the first triangle of each cluster.
+std::vector<uint32_t> findClusters(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+{
+    const uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+    CacheSimulator cache(vertexCount, cacheSize);
+
+    // Hard boundaries are triangles where all vertices miss the cache, typically where Tipsify hit a dead end.
+    std::vector<uint32_t> hardBoundaries;
+    for (uint32_t t = 0; t < triangleCount; t++)
+    {
+        if (cache.accessTriangle(&indices[t * 3]) == 3 || t == 0)
+            hardBoundaries.push_back(t);
+    }
+    hardBoundaries.push_back(triangleCount);
+
+    // Split each cluster further as soon as the ACMR of the part is within the threshold of the ACMR of the whole cluster.
+    std::vector<uint32_t> clusters;
+    for (size_t i = 0; i + 1 < hardBoundaries.size(); i++)
+    {
+        const uint32_t begin = hardBoundaries[i];
+        const uint32_t end = hardBoundaries[i + 1];
+
+        cache.clear();
+        uint32_t clusterMisses = 0;
+        for (uint32_t t = begin; t < end; t++)
+            clusterMisses += cache.accessTriangle(&indices[t * 3]);
+        const double threshold = kOverdrawThreshold * clusterMisses / (end - begin);
+
+        cache.clear();
+        clusters.push_back(begin);
+        uint32_t misses = 0;
+        uint32_t triangles = 0;
+        for (uint32_t t = begin; t + 1 < end; t++)
+        {
+            misses += cache.accessTriangle(&indices[t * 3]);
+            triangles++;
+            if (misses <= threshold * triangles)
+            {
+                clusters.push_back(t + 1);
+                cache.clear();
+                misses = 0;
+                triangles = 0;
+            }
+        }
+    }
+    return clusters;
+}
+
+/// Sorts clusters of triangles so that clusters facing away from the mesh center are drawn first.
+void sortClusters(std::vector<uint32_t>& indices, const std::vector<uint32_t>& clusters, const float3* pPositions)
+{
+    const uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+    const size_t clusterCount = clusters.size();
+
+    // Area-weighted centroid and normal of each cluster.
+    std::vector<float3> centroids(clusterCount, float3(0.f));
+    std::vector<float3> normals(clusterCount, float3(0.f));
+    std::vector<float> areas(clusterCount, 0.f);
+    float3 meshCentroid(0.f);
+    float meshArea = 0.f;
+
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        const uint32_t end = c + 1 < clusterCount ? clusters[c + 1] : triangleCount;
+        for (uint32_t t = clusters[c]; t < end; t++)
+        {
+            const float3& p0 = pPositions[indices[t * 3 + 0]];
+            const float3& p1 = pPositions[indices[t * 3 + 1]];
+            const float3& p2 = pPositions[indices[t * 3 + 2]];
+            const float3 n = cross(p1 - p0, p2 - p0);
+            const float area = length(n);
+            centroids[c] += (p0 + p1 + p2) * (area / 3.f);
+            normals[c] += n;
+            areas[c] += area;
+        }
+        meshCentroid += centroids[c];
+        meshArea += areas[c];
+        if (areas[c] > 0.f)
+            centroids[c] /= areas[c];
+    }
+    if (meshArea > 0.f)
+        meshCentroid /= meshArea;
+
+    std::vector<float> sortKeys(clusterCount, 0.f);
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        const float normalLength = length(normals[c]);
+        if (normalLength > 0.f)
+            sortKeys[c] = dot(centroids[c] - meshCentroid, normals[c] / normalLength);
+    }
+
+    std::vector<uint32_t> order(clusterCount);
+    for (uint32_t c = 0; c < clusterCount; c++)
+        order[c] = c;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32_t> sorted;
+    sorted.reserve(indices.size());
+    for (uint32_t c : order)
+    {
+        const uint32_t end = c + 1 < clusterCount ? clusters[c + 1] : triangleCount;
+        sorted.insert(sorted.end(), indices.begin() + clusters[c] * 3, indices.begin() + end * 3);
+    }
+    indices = std::move(sorted);
+}
+} // namespace
+
+void VertexCacheOptimizer::optimizeTriangleOrder(std::vector<uint32_t>& indices, uint32_t vertexCount, const float3* pPositions, uint32_t cacheSize)
+{
+    FALCOR_ASSERT(indices.size() % 3 == 0);
+    const uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+    if (triangleCount == 0)
+        return;
+
+    // Build vertex-triangle adjacency. The live count is the number of unemitted triangles using a vertex.
+    std::vector<uint32_t> liveCount(vertexCount, 0);
+    for (uint32_t v : indices)
+    {
+        FALCOR_ASSERT(v < vertexCount);
+        liveCount[v]++;
+    }
+
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (uint32_t v = 0; v < vertexCount; v++)
+        offsets[v + 1] = offsets[v] + liveCount[v];
+
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (uint32_t i = 0; i < (uint32_t)indices.size(); i++)
+        adjacency[fill[indices[i]]++] = i / 3;
+
+    // Tipsify: emit all triangles around a fanning vertex, then continue with a vertex that is still in the cache.
+    CacheSimulator cache(vertexCount, cacheSize);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    uint32_t cursor = 0;
+
+    auto skipDeadEnd = [&]()
+    {
+        while (!deadEnd.empty())
+        {
+            uint32_t v = deadEnd.back();
+            deadEnd.pop_back();
+            if (liveCount[v] > 0)
+                return v;
+        }
+        for (; cursor < vertexCount; cursor++)
+        {
+            if (liveCount[cursor] > 0)
+                return cursor;
+        }
+        return kInvalidIndex;
+    };
+
+    uint32_t fanning = skipDeadEnd();
+    while (fanning != kInvalidIndex)
+    {
+        candidates.clear();
+        for (uint32_t a = offsets[fanning]; a < offsets[fanning + 1]; a++)
+        {
+            const uint32_t t = adjacency[a];
+            if (emitted[t])
+                continue;
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                const uint32_t v = indices[t * 3 + k];
+                output.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                liveCount[v]--;
+                cache.access(v);
+            }
+            emitted[t] = true;
+        }
+
+        // Prefer the oldest candidate whose remaining triangles can be emitted before it is evicted.
+        uint32_t next = kInvalidIndex;
+        int64_t bestPriority = -1;
+        for (uint32_t v : candidates)
+        {
+            if (liveCount[v] == 0)
+                continue;
+            int64_t priority = 0;
+            if (cache.getAge(v) + 2 * liveCount[v] <= cacheSize)
+                priority = cache.getAge(v);
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                next = v;
+            }
+        }
+        fanning = next != kInvalidIndex ? next : skipDeadEnd();
+    }
+
+    FALCOR_ASSERT(output.size() == indices.size());
+    indices = std::move(output);
+
+    if (pPositions && triangleCount > 1)
+    {
+        auto clusters = findClusters(indices, vertexCount, cacheSize);
+        if (clusters.size() > 1)
+            sortClusters(indices, clusters, pPositions);
+    }
+}
+
+std::vector<uint32_t> VertexCacheOptimizer::optimizeVertexOrder(std::vector<uint32_t>& indices, uint32_t vertexCount)
+{
+    std::vector<uint32_t> remap(vertexCount, kInvalidIndex);
+    uint32_t nextIndex = 0;
+    for (uint32_t& v : indices)
+    {
+        FALCOR_ASSERT(v < vertexCount);
+        if (remap[v] == kInvalidIndex)
+            remap[v] = nextIndex++;
+        v = remap[v];
+    }
+    for (uint32_t& newIndex : remap)
+    {
+        if (newIndex == kInvalidIndex)
+            newIndex = nextIndex++;
+    }
+    return remap;
+}
+
+double VertexCacheOptimizer::computeACMR(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return 0.0;
+
+    CacheSimulator cache(vertexCount, cacheSize);
+    size_t misses = 0;
+    for (size_t t = 0; t < triangleCount; t++)
+        misses += cache.accessTriangle(&indices[t * 3]);
+    return (double)misses / triangleCount;
+}
+} // namespace Falcor
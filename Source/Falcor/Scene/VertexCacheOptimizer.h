@@ -0,0 +1,77 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include "Utils/Math/Vector.h"
+#include <cstdint>
+#include <vector>
+
+namespace Falcor
+{
+    /** Reorders triangle lists for efficient rasterization.
+
+        optimizeTriangleOrder() reorders triangles for post-transform vertex cache efficiency using Tipsify
+        (Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007).
+        If vertex positions are given, the resulting clusters of triangles are then sorted so that outward
+        facing clusters are drawn first, which reduces overdraw from most view directions.
+
+        optimizeVertexOrder() renumbers vertices in the order they are first referenced, for vertex fetch locality.
+
+        All functions operate on triangle lists with 32-bit indices. The winding of each triangle is preserved.
+    */
+    class FALCOR_API VertexCacheOptimizer
+    {
+    public:
+        static constexpr uint32_t kDefaultCacheSize = 16;
+
+        /** Reorder triangles for vertex cache efficiency and reduced overdraw.
+            \param[in,out] indices Triangle list indices.
+            \param[in] vertexCount Number of vertices. All indices must be smaller.
+            \param[in] pPositions Vertex positions used for overdraw reduction, or nullptr to only optimize for the vertex cache.
+            \param[in] cacheSize Size of the FIFO vertex cache to optimize for.
+        */
+        static void optimizeTriangleOrder(
+            std::vector<uint32_t>& indices,
+            uint32_t vertexCount,
+            const float3* pPositions = nullptr,
+            uint32_t cacheSize = kDefaultCacheSize
+        );
+
+        /** Renumber vertices in order of first use. Unreferenced vertices are moved to the end.
+            \param[in,out] indices Triangle list indices. These are updated to the new vertex numbering.
+            \param[in] vertexCount Number of vertices.
+            \return Mapping from old to new vertex index. The caller is responsible for reordering the vertex data.
+        */
+        static std::vector<uint32_t> optimizeVertexOrder(std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+        /** Compute the average cache miss ratio (ACMR), i.e. the number of vertex shader invocations per triangle,
+            for a FIFO vertex cache of the given size.
+        */
+        static double computeACMR(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = kDefaultCacheSize);
+    };
+}
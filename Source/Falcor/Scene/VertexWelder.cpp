@@ -0,0 +1,324 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "VertexWelder.h"
+#include "Core/Assert.h"
+#include "Core/Platform/OS.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#if FALCOR_HAS_AVX2_TARGET
+#include <immintrin.h>
+#endif
+
+namespace Falcor
+{
+namespace
+{
+const uint32_t kInvalidIndex = 0xffffffff;
+
+// Key of the cell holding vertices with non-finite or very large approximate attributes.
+// These may match any vertex of their group, so they are checked by every lookup.
+const uint64_t kWildCell = 0x8000000000000000ull;
+
+// Vertices are only assigned to a grid cell if their cell coordinate is below this value.
+// This keeps the rounding error of the projection far below the cell size.
+const double kMaxCellCoord = 1e12;
+
+// Distinct weights of the approximate attributes in the projection onto the grid axis.
+const double kWeights[12] = {1.0, 1.083, 1.167, 1.25, 1.333, 1.417, 1.5, 1.583, 1.667, 1.75, 1.833, 1.917};
+
+uint64_t mix(uint64_t h)
+{
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    return h;
+}
+
+uint64_t hashCombine(uint64_t h, uint64_t v)
+{
+    return mix(h ^ (v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2)));
+}
+
+#if FALCOR_HAS_AVX2_TARGET
+const bool kUseAVX2 = isAVX2Supported();
+
+/// Same as the scalar path of VertexWelder::matches(), on the fields of two packed vertices.
+FALCOR_TARGET_AVX2 bool matchesAVX2(
+    const float* lhsExact,
+    const float* lhsApprox,
+    const uint32_t* lhsBoneIDs,
+    const float* rhsExact,
+    const float* rhsApprox,
+    const uint32_t* rhsBoneIDs,
+    float threshold
+)
+{
+    const __m256 exactMismatch = _mm256_cmp_ps(_mm256_load_ps(lhsExact), _mm256_load_ps(rhsExact), _CMP_NEQ_UQ);
+    const __m128i idsEqual = _mm_cmpeq_epi32(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(lhsBoneIDs)), _mm_load_si128(reinterpret_cast<const __m128i*>(rhsBoneIDs))
+    );
+
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 diff0 = _mm256_and_ps(_mm256_sub_ps(_mm256_load_ps(lhsApprox), _mm256_load_ps(rhsApprox)), absMask);
+    const __m128 diff1 = _mm_and_ps(_mm_sub_ps(_mm_load_ps(lhsApprox + 8), _mm_load_ps(rhsApprox + 8)), _mm256_castps256_ps128(absMask));
+    const __m256 approxMismatch0 = _mm256_cmp_ps(diff0, _mm256_set1_ps(threshold), _CMP_GT_OQ);
+    const __m128 approxMismatch1 = _mm_cmp_ps(diff1, _mm_set1_ps(threshold), _CMP_GT_OQ);
+
+    return _mm256_movemask_ps(_mm256_or_ps(exactMismatch, approxMismatch0)) == 0 && _mm_movemask_ps(approxMismatch1) == 0 &&
+           _mm_movemask_epi8(idsEqual) == 0xffff;
+}
+#endif
+} // namespace
+
+VertexWelder::VertexWelder(Mode mode, uint32_t originalVertexCount, float threshold) : mMode(mode), mThreshold(threshold)
+{
+    mVertices.reserve(originalVertexCount);
+    mPacked.reserve(originalVertexCount);
+
+    if (mMode == Mode::Linear)
+    {
+        mHeads.assign(originalVertexCount, kInvalidIndex);
+        mNext.reserve(originalVertexCount);
+    }
+    else
+    {
+        // Two vertices that match have each approximate attribute within the threshold,
+        // so their projections differ by at most threshold * sum(weights). With a cell size of twice that,
+        // matching vertices are at most one cell apart. A zero threshold requires equal projections.
+        // Negative or non-finite thresholds put all vertices in the wild cell.
+        double weightSum = 0.0;
+        for (double w : kWeights)
+            weightSum += w;
+        if (threshold == 0.f)
+            mCellScale = 1.0;
+        else if (threshold > 0.f && std::isfinite(threshold))
+            mCellScale = 1.0 / (2.0 * threshold * weightSum);
+
+        mOriginalIndices.reserve(originalVertexCount);
+        mCellNext.reserve(originalVertexCount);
+        mGroupNext.reserve(originalVertexCount);
+        mCellHeads.reserve(originalVertexCount);
+        mGroupHeads.reserve(originalVertexCount);
+    }
+}
+
+std::pair<uint32_t, bool> VertexWelder::insert(const Vertex& v, uint32_t originalIndex)
+{
+    const PackedVertex packed = pack(v);
+
+    if (mMode == Mode::Linear)
+    {
+        FALCOR_ASSERT(originalIndex < mHeads.size());
+        uint32_t index = findLinear(packed, originalIndex);
+        if (index != kInvalidIndex)
+            return {index, false};
+
+        FALCOR_ASSERT(mVertices.size() < std::numeric_limits<uint32_t>::max());
+        index = (uint32_t)mVertices.size();
+        mVertices.push_back(v);
+        mPacked.push_back(packed);
+        mNext.push_back(mHeads[originalIndex]);
+        mHeads[originalIndex] = index;
+        return {index, true};
+    }
+
+    uint64_t groupKey = 0;
+    uint64_t cellKey = 0;
+    bool isRegistered = false;
+    uint32_t index = findHashed(packed, originalIndex, groupKey, cellKey, isRegistered);
+    if (index != kInvalidIndex)
+        return {index, false};
+
+    FALCOR_ASSERT(mVertices.size() < std::numeric_limits<uint32_t>::max());
+    index = (uint32_t)mVertices.size();
+    mVertices.push_back(v);
+    mPacked.push_back(packed);
+    mOriginalIndices.push_back(originalIndex);
+
+    // Vertices with NaN in an exactly compared attribute never match, so they are not added to any list.
+    if (isRegistered)
+    {
+        auto [cellIt, newCell] = mCellHeads.try_emplace(cellKey, kInvalidIndex);
+        mCellNext.push_back(cellIt->second);
+        cellIt->second = index;
+
+        auto [groupIt, newGroup] = mGroupHeads.try_emplace(groupKey, kInvalidIndex);
+        mGroupNext.push_back(groupIt->second);
+        groupIt->second = index;
+    }
+    else
+    {
+        mCellNext.push_back(kInvalidIndex);
+        mGroupNext.push_back(kInvalidIndex);
+    }
+
+    return {index, true};
+}
+
+bool VertexWelder::compare(const Vertex& lhs, const Vertex& rhs, float threshold)
+{
+    return matches(pack(lhs), pack(rhs), threshold);
+}
+
+VertexWelder::PackedVertex VertexWelder::pack(const Vertex& v)
+{
+    PackedVertex p = {};
+    p.exact[0] = v.position.x;
+    p.exact[1] = v.position.y;
+    p.exact[2] = v.position.z;
+    p.exact[3] = v.tangent.w;
+    p.exact[4] = v.curveRadius;
+    for (int i = 0; i < 4; i++)
+        p.boneIDs[i] = v.boneIDs[i];
+    p.approx[0] = v.normal.x;
+    p.approx[1] = v.normal.y;
+    p.approx[2] = v.normal.z;
+    p.approx[3] = v.tangent.x;
+    p.approx[4] = v.tangent.y;
+    p.approx[5] = v.tangent.z;
+    p.approx[6] = v.texCrd.x;
+    p.approx[7] = v.texCrd.y;
+    for (int i = 0; i < 4; i++)
+        p.approx[8 + i] = v.boneWeights[i];
+    return p;
+}
+
+bool VertexWelder::matches(const PackedVertex& lhs, const PackedVertex& rhs, float threshold)
+{
+    // Position needs to be exact to avoid cracks. Exact attributes compare with !=, so NaN never matches.
+    // Approximate attributes mismatch if abs(lhs - rhs) > threshold, so a NaN difference matches.
+#if FALCOR_HAS_AVX2_TARGET
+    if (kUseAVX2)
+        return matchesAVX2(lhs.exact, lhs.approx, lhs.boneIDs, rhs.exact, rhs.approx, rhs.boneIDs, threshold);
+#endif
+
+    for (int i = 0; i < 8; i++)
+        if (lhs.exact[i] != rhs.exact[i])
+            return false;
+    for (int i = 0; i < 4; i++)
+        if (lhs.boneIDs[i] != rhs.boneIDs[i])
+            return false;
+    for (int i = 0; i < 12; i++)
+        if (std::abs(lhs.approx[i] - rhs.approx[i]) > threshold)
+            return false;
+    return true;
+}
+
+uint32_t VertexWelder::findLinear(const PackedVertex& packed, uint32_t originalIndex) const
+{
+    for (uint32_t index = mHeads[originalIndex]; index != kInvalidIndex; index = mNext[index])
+    {
+        if (matches(packed, mPacked[index], mThreshold))
+            return index;
+    }
+    return kInvalidIndex;
+}
+
+uint32_t VertexWelder::findInList(
+    const PackedVertex& packed,
+    uint32_t originalIndex,
+    uint32_t head,
+    const std::vector<uint32_t>& next,
+    uint32_t best
+) const
+{
+    // Lists are ordered from newest to oldest, so the first match is the newest in the list.
+    // Vertices older than the best match so far don't need to be checked.
+    for (uint32_t index = head; index != kInvalidIndex && (best == kInvalidIndex || index > best); index = next[index])
+    {
+        if (mOriginalIndices[index] == originalIndex && matches(packed, mPacked[index], mThreshold))
+            return index;
+    }
+    return best;
+}
+
+uint32_t VertexWelder::findHashed(
+    const PackedVertex& packed,
+    uint32_t originalIndex,
+    uint64_t& groupKey,
+    uint64_t& cellKey,
+    bool& isRegistered
+) const
+{
+    // Vertices that match have bit-identical exact attributes, except for the sign of zero.
+    groupKey = mix(originalIndex);
+    for (int i = 0; i < 5; i++)
+    {
+        float f = packed.exact[i];
+        if (std::isnan(f))
+        {
+            isRegistered = false;
+            return kInvalidIndex;
+        }
+        uint32_t bits = 0;
+        if (f != 0.f)
+            std::memcpy(&bits, &f, sizeof(bits));
+        groupKey = hashCombine(groupKey, bits);
+    }
+    for (int i = 0; i < 4; i++)
+        groupKey = hashCombine(groupKey, packed.boneIDs[i]);
+    isRegistered = true;
+
+    // Project the approximate attributes onto the grid axis.
+    double cellCoord = std::numeric_limits<double>::quiet_NaN();
+    if (mCellScale > 0.0)
+    {
+        double s = 0.0;
+        for (int i = 0; i < 12; i++)
+            s += kWeights[i] * packed.approx[i];
+        cellCoord = s * mCellScale;
+    }
+
+    auto findInCell = [&](uint64_t cell, uint32_t best)
+    {
+        auto it = mCellHeads.find(hashCombine(groupKey, cell));
+        return it != mCellHeads.end() ? findInList(packed, originalIndex, it->second, mCellNext, best) : best;
+    };
+
+    if (!(std::abs(cellCoord) < kMaxCellCoord))
+    {
+        // A wild vertex may match any vertex of its group.
+        cellKey = hashCombine(groupKey, kWildCell);
+        auto it = mGroupHeads.find(groupKey);
+        return it != mGroupHeads.end() ? findInList(packed, originalIndex, it->second, mGroupNext, kInvalidIndex) : kInvalidIndex;
+    }
+
+    const int64_t cell = (int64_t)std::floor(cellCoord);
+    cellKey = hashCombine(groupKey, (uint64_t)cell);
+
+    uint32_t best = kInvalidIndex;
+    best = findInCell((uint64_t)cell, best);
+    best = findInCell((uint64_t)(cell - 1), best);
+    best = findInCell((uint64_t)(cell + 1), best);
+    best = findInCell(kWildCell, best);
+    return best;
+}
+} // namespace Falcor
@@ -0,0 +1,117 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "SceneBuilder.h"
+#include "Core/Macros.h"
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Falcor
+{
+    /** Merges identical vertices of a mesh.
+
+        Vertices are inserted in order, each with the index it had in the original index buffer.
+        A vertex is merged with the most recently inserted vertex that has the same original index,
+        bit-identical position, tangent sign, curve radius and bone IDs, and normal, tangent,
+        texture coordinate and bone weights within 'threshold' of it.
+
+        Mode::Linear compares against all vertices previously inserted with the same original index.
+        Mode::Hashed only compares against vertices whose exact attributes hash the same and whose
+        approximate attributes project to a neighbouring cell of a quantization grid. This is faster
+        for meshes where many vertices are split at the same original index. Both modes produce
+        identical output.
+    */
+    class FALCOR_API VertexWelder
+    {
+    public:
+        using Vertex = SceneBuilder::Mesh::Vertex;
+
+        enum class Mode
+        {
+            Linear,
+            Hashed,
+        };
+
+        /** Create a vertex welder.
+            \param[in] mode Search mode.
+            \param[in] originalVertexCount Number of vertices in the original index buffer. All original indices must be smaller.
+            \param[in] threshold Max difference of the approximately compared attributes.
+        */
+        VertexWelder(Mode mode, uint32_t originalVertexCount, float threshold = 1e-6f);
+
+        /** Insert a vertex, or find an identical vertex that was inserted before.
+            \return Index of the vertex and true if the vertex was inserted.
+        */
+        std::pair<uint32_t, bool> insert(const Vertex& v, uint32_t originalIndex);
+
+        /// Returns true if the two vertices are identical within the threshold.
+        static bool compare(const Vertex& lhs, const Vertex& rhs, float threshold = 1e-6f);
+
+        Mode getMode() const { return mMode; }
+        uint32_t getVertexCount() const { return (uint32_t)mVertices.size(); }
+        const std::vector<Vertex>& getVertices() const { return mVertices; }
+
+        /// Moves the merged vertices out of the welder. The welder can't be used afterwards.
+        std::vector<Vertex> takeVertices() { return std::move(mVertices); }
+
+    private:
+        /// Vertex attributes laid out for comparing them with vector instructions.
+        struct alignas(32) PackedVertex
+        {
+            float exact[8];       ///< position.xyz, tangent.w, curveRadius, 0, 0, 0.
+            float approx[12];     ///< normal.xyz, tangent.xyz, texCrd.xy, boneWeights.xyzw.
+            uint32_t boneIDs[4];
+        };
+
+        static PackedVertex pack(const Vertex& v);
+        static bool matches(const PackedVertex& lhs, const PackedVertex& rhs, float threshold);
+
+        uint32_t findLinear(const PackedVertex& packed, uint32_t originalIndex) const;
+        uint32_t findHashed(const PackedVertex& packed, uint32_t originalIndex, uint64_t& groupKey, uint64_t& cellKey, bool& isRegistered) const;
+        uint32_t findInList(const PackedVertex& packed, uint32_t originalIndex, uint32_t head, const std::vector<uint32_t>& next, uint32_t best) const;
+
+        Mode mMode;
+        float mThreshold;
+        std::vector<Vertex> mVertices;
+        std::vector<PackedVertex> mPacked;
+
+        // Linear mode: list of vertices per original index.
+        std::vector<uint32_t> mHeads;
+        std::vector<uint32_t> mNext;
+
+        // Hashed mode: lists of vertices per grid cell and per exact attribute group.
+        double mCellScale = 0.0;    ///< Reciprocal of the cell size, or 0 if all vertices are searched by group.
+        std::vector<uint32_t> mOriginalIndices;
+        std::unordered_map<uint64_t, uint32_t> mCellHeads;
+        std::unordered_map<uint64_t, uint32_t> mGroupHeads;
+        std::vector<uint32_t> mCellNext;
+        std::vector<uint32_t> mGroupNext;
+    };
+}
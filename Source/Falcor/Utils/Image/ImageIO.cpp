@@ -37,6 +37,7 @@
 #include <nvtt/nvtt.h>
 
 #include <filesystem>
+#include <fstream>
 
 namespace Falcor
 {
@@ -689,6 +690,79 @@ void ImageIO::saveToDDS(const std::filesystem::path& path, const Bitmap& bitmap,
     }
 }
 
+void ImageIO::saveToDDS(
+    const std::filesystem::path& path,
+    ResourceFormat format,
+    Resource::Type type,
+    uint32_t width,
+    uint32_t height,
+    uint32_t depthOrArraySize,
+    const void* pData
+)
+{
+    if (!hasExtension(path, "dds"))
+    {
+        logWarning("Saving DDS image to '{}' which does not have 'dds' file extension.", path);
+    }
+
+    try
+    {
+        if (isCompressedFormat(format))
+        {
+            throw RuntimeError("Only uncompressed formats are supported.");
+        }
+        if (type != Resource::Type::Texture2D && type != Resource::Type::Texture3D)
+        {
+            throw RuntimeError("Invalid texture type. Only 2D and 3D are supported.");
+        }
+        if (width == 0 || height == 0 || depthOrArraySize == 0)
+        {
+            throw RuntimeError("Image dimensions must be non-zero.");
+        }
+
+        const bool isVolume = type == Resource::Type::Texture3D;
+        const uint32_t rowPitch = width * getFormatBytesPerBlock(format);
+
+        DDS_HEADER header = {};
+        header.size = sizeof(DDS_HEADER);
+        header.flags = DDS_HEADER_FLAGS_TEXTURE | DDS_HEADER_FLAGS_PITCH | (isVolume ? DDS_HEADER_FLAGS_VOLUME : 0);
+        header.height = height;
+        header.width = width;
+        header.pitchOrLinearSize = rowPitch;
+        header.depth = isVolume ? depthOrArraySize : 0;
+        header.mipMapCount = 1;
+        header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+        header.ddspf.flags = DDS_FOURCC;
+        header.ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+        header.caps = DDS_SURFACE_FLAGS_TEXTURE;
+        header.caps2 = isVolume ? DDS_FLAGS_VOLUME : 0;
+
+        DDS_HEADER_DXT10 dx10Header = {};
+        dx10Header.dxgiFormat = getDxgiFormat(format);
+        dx10Header.resourceDimension = isVolume ? DDS_DIMENSION_TEXTURE3D : DDS_DIMENSION_TEXTURE2D;
+        dx10Header.arraySize = isVolume ? 1 : depthOrArraySize;
+
+        std::ofstream file(path, std::ios::binary);
+        if (!file)
+        {
+            throw RuntimeError("Failed to open file for writing.");
+        }
+        const uint32_t magic = DDS_MAGIC;
+        file.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(&dx10Header), sizeof(dx10Header));
+        file.write(static_cast<const char*>(pData), std::streamsize(size_t(rowPitch) * height * depthOrArraySize));
+        if (!file)
+        {
+            throw RuntimeError("Failed to write image data.");
+        }
+    }
+    catch (const RuntimeError& e)
+    {
+        throw RuntimeError("Failed to save DDS image to '{}': {}", path, e.what());
+    }
+}
+
 void ImageIO::saveToDDS(
     CopyContext* pContext,
     const std::filesystem::path& path,
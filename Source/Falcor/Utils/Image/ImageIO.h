@@ -105,6 +105,28 @@ public:
         bool generateMips = false
     );
 
+    /**
+     * Saves uncompressed CPU image data with multiple array slices or volume layers to a DDS file.
+     * The file uses the DX10 header extension and contains a single mip level.
+     * Throws an exception if the path is invalid, the format is compressed or the image cannot be saved.
+     * @param[in] path Path to save to.
+     * @param[in] format Uncompressed format of the image data.
+     * @param[in] type Texture2D to store depthOrArraySize array slices, Texture3D to store a volume.
+     * @param[in] width Width in pixels.
+     * @param[in] height Height in pixels.
+     * @param[in] depthOrArraySize Number of array slices or volume layers.
+     * @param[in] pData Tightly packed image data, slice by slice.
+     */
+    static void saveToDDS(
+        const std::filesystem::path& path,
+        ResourceFormat format,
+        Resource::Type type,
+        uint32_t width,
+        uint32_t height,
+        uint32_t depthOrArraySize,
+        const void* pData
+    );
+
     /**
      * Saves a Texture to a DDS file. All mips and array images are saved.
      * Throws an exception if the path is invalid or the image cannot be saved.
@@ -0,0 +1,273 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "MatrixBatch.h"
+#include "Core/Platform/OS.h"
+#include <algorithm>
+#include <cstring>
+
+#if FALCOR_HAS_AVX2_TARGET
+#include <immintrin.h>
+#endif
+
+namespace Falcor
+{
+static_assert(sizeof(float4x4) == 16 * sizeof(float), "float4x4 must be 16 tightly packed floats");
+
+#if FALCOR_HAS_AVX2_TARGET
+namespace
+{
+/// Eight floats, one per matrix of a batch. The operators map 1:1 to the scalar operations.
+struct Lanes
+{
+    __m256 v;
+
+    Lanes() = default;
+    FALCOR_TARGET_AVX2 Lanes(__m256 v) : v(v) {}
+    FALCOR_TARGET_AVX2 Lanes(float f) : v(_mm256_set1_ps(f)) {}
+
+    friend FALCOR_TARGET_AVX2 Lanes operator+(Lanes a, Lanes b) { return _mm256_add_ps(a.v, b.v); }
+    friend FALCOR_TARGET_AVX2 Lanes operator-(Lanes a, Lanes b) { return _mm256_sub_ps(a.v, b.v); }
+    friend FALCOR_TARGET_AVX2 Lanes operator*(Lanes a, Lanes b) { return _mm256_mul_ps(a.v, b.v); }
+    friend FALCOR_TARGET_AVX2 Lanes operator/(Lanes a, Lanes b) { return _mm256_div_ps(a.v, b.v); }
+};
+
+/// Transposes the 8x8 block of floats in rows.
+FALCOR_TARGET_AVX2 void transpose8x8(__m256 rows[8])
+{
+    const __m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+    const __m256 t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+    const __m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+    const __m256 t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+    const __m256 t4 = _mm256_unpacklo_ps(rows[4], rows[5]);
+    const __m256 t5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+    const __m256 t6 = _mm256_unpacklo_ps(rows[6], rows[7]);
+    const __m256 t7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+    const __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+    rows[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+    rows[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+    rows[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+    rows[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+    rows[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+    rows[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+    rows[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+    rows[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+/// Loads count <= 8 consecutive matrices, transposed so that m[r][c] holds element (r, c) of all of them.
+/// Missing matrices are zero.
+FALCOR_TARGET_AVX2 void load8(const float4x4* pMatrices, size_t count, Lanes m[4][4])
+{
+    alignas(32) float padded[8 * 16];
+    const float* pData = reinterpret_cast<const float*>(pMatrices);
+    if (count < 8)
+    {
+        std::memset(padded, 0, sizeof(padded));
+        std::memcpy(padded, pData, count * sizeof(float4x4));
+        pData = padded;
+    }
+
+    for (int half = 0; half < 2; half++)
+    {
+        // Rows 2 * half and 2 * half + 1 of the 8 matrices.
+        __m256 rows[8];
+        for (int k = 0; k < 8; k++)
+            rows[k] = _mm256_loadu_ps(pData + k * 16 + half * 8);
+        transpose8x8(rows);
+        for (int e = 0; e < 8; e++)
+            m[half * 2 + e / 4][e % 4] = rows[e];
+    }
+}
+
+/// Stores the first count <= 8 matrices from the layout of load8().
+FALCOR_TARGET_AVX2 void store8(const Lanes m[4][4], size_t count, float4x4* pMatrices)
+{
+    alignas(32) float padded[8 * 16];
+    float* pData = count < 8 ? padded : reinterpret_cast<float*>(pMatrices);
+
+    for (int half = 0; half < 2; half++)
+    {
+        __m256 rows[8];
+        for (int e = 0; e < 8; e++)
+            rows[e] = m[half * 2 + e / 4][e % 4].v;
+        transpose8x8(rows);
+        for (int k = 0; k < 8; k++)
+            _mm256_storeu_ps(pData + k * 16 + half * 8, rows[k]);
+    }
+
+    if (count < 8) std::memcpy(pMatrices, padded, count * sizeof(float4x4));
+}
+
+/// Same as mul(): each element is dot(lhs.getRow(r), rhs.getCol(c)) summed from x to w.
+FALCOR_TARGET_AVX2 void mul8(const Lanes lhs[4][4], const Lanes rhs[4][4], Lanes result[4][4])
+{
+    for (int r = 0; r < 4; r++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            Lanes sum = lhs[r][0] * rhs[0][c];
+            sum = sum + lhs[r][1] * rhs[1][c];
+            sum = sum + lhs[r][2] * rhs[2][c];
+            sum = sum + lhs[r][3] * rhs[3][c];
+            result[r][c] = sum;
+        }
+    }
+}
+
+/// Element k of vec<row> = (m[row][1], m[row][0], m[row][0], m[row][0]) in inverse().
+FALCOR_TARGET_AVX2 Lanes vec(const Lanes m[4][4], int row, int k)
+{
+    return k == 0 ? m[row][1] : m[row][0];
+}
+
+/// Same as transpose(inverse()), see inverse() in MatrixMath.h for the derivation.
+FALCOR_TARGET_AVX2 void inverseTranspose8(const Lanes m[4][4], Lanes result[4][4])
+{
+    const Lanes c00 = m[2][2] * m[3][3] - m[2][3] * m[3][2];
+    const Lanes c02 = m[2][1] * m[3][3] - m[2][3] * m[3][1];
+    const Lanes c03 = m[2][1] * m[3][2] - m[2][2] * m[3][1];
+
+    const Lanes c04 = m[1][2] * m[3][3] - m[1][3] * m[3][2];
+    const Lanes c06 = m[1][1] * m[3][3] - m[1][3] * m[3][1];
+    const Lanes c07 = m[1][1] * m[3][2] - m[1][2] * m[3][1];
+
+    const Lanes c08 = m[1][2] * m[2][3] - m[1][3] * m[2][2];
+    const Lanes c10 = m[1][1] * m[2][3] - m[1][3] * m[2][1];
+    const Lanes c11 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+
+    const Lanes c12 = m[0][2] * m[3][3] - m[0][3] * m[3][2];
+    const Lanes c14 = m[0][1] * m[3][3] - m[0][3] * m[3][1];
+    const Lanes c15 = m[0][1] * m[3][2] - m[0][2] * m[3][1];
+
+    const Lanes c16 = m[0][2] * m[2][3] - m[0][3] * m[2][2];
+    const Lanes c18 = m[0][1] * m[2][3] - m[0][3] * m[2][1];
+    const Lanes c19 = m[0][1] * m[2][2] - m[0][2] * m[2][1];
+
+    const Lanes c20 = m[0][2] * m[1][3] - m[0][3] * m[1][2];
+    const Lanes c22 = m[0][1] * m[1][3] - m[0][3] * m[1][1];
+    const Lanes c23 = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+
+    const Lanes fac[6][4] = {
+        {c00, c00, c02, c03},
+        {c04, c04, c06, c07},
+        {c08, c08, c10, c11},
+        {c12, c12, c14, c15},
+        {c16, c16, c18, c19},
+        {c20, c20, c22, c23},
+    };
+
+    // Columns of the inverse before the division by the determinant, with signs applied.
+    Lanes inv[4][4];
+    for (int k = 0; k < 4; k++)
+    {
+        const float signA = (k & 1) ? -1.f : 1.f;
+        const float signB = -signA;
+        inv[0][k] = (vec(m, 1, k) * fac[0][k] - vec(m, 2, k) * fac[1][k] + vec(m, 3, k) * fac[2][k]) * signA;
+        inv[1][k] = (vec(m, 0, k) * fac[0][k] - vec(m, 2, k) * fac[3][k] + vec(m, 3, k) * fac[4][k]) * signB;
+        inv[2][k] = (vec(m, 0, k) * fac[1][k] - vec(m, 1, k) * fac[3][k] + vec(m, 3, k) * fac[5][k]) * signA;
+        inv[3][k] = (vec(m, 0, k) * fac[2][k] - vec(m, 1, k) * fac[4][k] + vec(m, 2, k) * fac[5][k]) * signB;
+    }
+
+    // Row 0 of the inverse holds element 0 of each column.
+    const Lanes dot0x = m[0][0] * inv[0][0];
+    const Lanes dot0y = m[1][0] * inv[1][0];
+    const Lanes dot0z = m[2][0] * inv[2][0];
+    const Lanes dot0w = m[3][0] * inv[3][0];
+    const Lanes dot1 = (dot0x + dot0y) + (dot0z + dot0w);
+    const Lanes oneOverDet = Lanes(1.f) / dot1;
+
+    // Column c of the inverse is row c of the transpose.
+    for (int r = 0; r < 4; r++)
+        for (int c = 0; c < 4; c++)
+            result[r][c] = inv[r][c] * oneOverDet;
+}
+
+FALCOR_TARGET_AVX2 void mulBatchAVX2(const float4x4* lhs, const float4x4* rhs, float4x4* result, size_t count)
+{
+    for (size_t i = 0; i < count; i += 8)
+    {
+        const size_t batchCount = std::min<size_t>(8, count - i);
+        Lanes a[4][4], b[4][4], c[4][4];
+        load8(lhs + i, batchCount, a);
+        load8(rhs + i, batchCount, b);
+        mul8(a, b, c);
+        store8(c, batchCount, result + i);
+    }
+}
+
+FALCOR_TARGET_AVX2 void inverseTransposeBatchAVX2(const float4x4* m, float4x4* result, size_t count)
+{
+    for (size_t i = 0; i < count; i += 8)
+    {
+        const size_t batchCount = std::min<size_t>(8, count - i);
+        Lanes a[4][4], b[4][4];
+        load8(m + i, batchCount, a);
+        inverseTranspose8(a, b);
+        store8(b, batchCount, result + i);
+    }
+}
+} // namespace
+#endif
+
+// The AVX2 kernels zero pad the last partial batch instead of using mul() and inverse(), so that none of the
+// shared inline math code is compiled for AVX2.
+
+void mulBatch(const float4x4* lhs, const float4x4* rhs, float4x4* result, size_t count)
+{
+#if FALCOR_HAS_AVX2_TARGET
+    if (isAVX2Supported())
+    {
+        mulBatchAVX2(lhs, rhs, result, count);
+        return;
+    }
+#endif
+
+    for (size_t i = 0; i < count; i++)
+        result[i] = mul(lhs[i], rhs[i]);
+}
+
+void inverseTransposeBatch(const float4x4* m, float4x4* result, size_t count)
+{
+#if FALCOR_HAS_AVX2_TARGET
+    if (isAVX2Supported())
+    {
+        inverseTransposeBatchAVX2(m, result, count);
+        return;
+    }
+#endif
+
+    for (size_t i = 0; i < count; i++)
+        result[i] = transpose(inverse(m[i]));
+}
+} // namespace Falcor
@@ -0,0 +1,48 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include "Utils/Math/Matrix.h"
+#include <cstddef>
+
+namespace Falcor
+{
+/**
+ * Batched 4x4 matrix kernels.
+ * On CPUs with AVX2 the kernels process 8 matrices per iteration. They perform the same floating-point operations
+ * in the same order as mul() and inverse(), so the results are bit-identical to calling those per matrix
+ * (except for the payload of NaN results). The AVX2 kernels are compiled without FMA, so this holds as long as
+ * the build does not enable FMA contraction for the scalar code.
+ */
+
+/// Computes result[i] = mul(lhs[i], rhs[i]) for all i in [0, count). result may alias lhs or rhs.
+FALCOR_API void mulBatch(const float4x4* lhs, const float4x4* rhs, float4x4* result, size_t count);
+
+/// Computes result[i] = transpose(inverse(m[i])) for all i in [0, count). result may alias m.
+FALCOR_API void inverseTransposeBatch(const float4x4* m, float4x4* result, size_t count);
+} // namespace Falcor
@@ -27,17 +27,178 @@
  **************************************************************************/
 #include "Threading.h"
 #include "Core/Assert.h"
+#include <atomic>
+#include <deque>
+#include <exception>
 
 namespace Falcor
 {
+struct Threading::Task::State
+{
+    std::function<void(void)> func;
+    std::atomic<bool> done{false};
+    std::exception_ptr exception;
+    std::vector<std::shared_ptr<State>> continuations;
+    std::mutex mutex;
+    std::condition_variable condition;
+};
+
 namespace
 {
+using TaskState = std::shared_ptr<Threading::Task::State>;
+
+struct WorkerQueue
+{
+    std::mutex mutex;
+    std::deque<TaskState> tasks;
+};
+
 struct ThreadingData
 {
     bool initialized = false;
     std::vector<std::thread> threads;
-    uint32_t current;
+    std::vector<std::unique_ptr<WorkerQueue>> queues; ///< One deque per worker.
+    WorkerQueue globalQueue;                          ///< Tasks dispatched from outside the pool.
+
+    std::atomic<size_t> queuedCount{0};  ///< Tasks waiting in any queue.
+    std::atomic<size_t> pendingCount{0}; ///< Tasks dispatched and not finished.
+    bool stop = false;
+    std::mutex sleepMutex;
+    std::condition_variable sleepCondition; ///< Signaled when tasks are queued or the pool stops.
+    std::condition_variable idleCondition;  ///< Signaled when the pending count drops to zero.
 } gData; // TODO: REMOVEGLOBAL
+
+/// Index of the worker owning the current thread, or -1 for threads outside the pool.
+thread_local int32_t tWorkerIndex = -1;
+
+void pushTask(TaskState pState)
+{
+    gData.pendingCount++;
+    WorkerQueue& queue = tWorkerIndex >= 0 ? *gData.queues[tWorkerIndex] : gData.globalQueue;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(pState));
+    }
+    {
+        // Increment under the sleep mutex so a worker going to sleep cannot miss the notification.
+        std::lock_guard<std::mutex> lock(gData.sleepMutex);
+        gData.queuedCount++;
+    }
+    gData.sleepCondition.notify_one();
+}
+
+void runTask(const TaskState& pState);
+
+/// Queues a task, or runs it on the calling thread if the pool is not started.
+void scheduleTask(TaskState pState)
+{
+    if (gData.initialized)
+    {
+        pushTask(std::move(pState));
+    }
+    else
+    {
+        gData.pendingCount++;
+        runTask(pState);
+    }
+}
+
+/// Pops from the back of the own deque, then from the shared queue, then steals from the front of other deques.
+TaskState popTask(int32_t workerIndex)
+{
+    if (gData.queuedCount == 0)
+        return nullptr;
+
+    auto tryPop = [](WorkerQueue& queue, bool back) -> TaskState
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            return nullptr;
+        TaskState pState;
+        if (back)
+        {
+            pState = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else
+        {
+            pState = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        gData.queuedCount--;
+        return pState;
+    };
+
+    if (workerIndex >= 0)
+    {
+        if (auto pState = tryPop(*gData.queues[workerIndex], true))
+            return pState;
+    }
+    if (auto pState = tryPop(gData.globalQueue, false))
+        return pState;
+
+    const size_t queueCount = gData.queues.size();
+    const size_t first = workerIndex >= 0 ? size_t(workerIndex) + 1 : 0;
+    for (size_t i = 0; i < queueCount; ++i)
+    {
+        const size_t victim = (first + i) % queueCount;
+        if (int32_t(victim) == workerIndex)
+            continue;
+        if (auto pState = tryPop(*gData.queues[victim], false))
+            return pState;
+    }
+    return nullptr;
+}
+
+void runTask(const TaskState& pState)
+{
+    try
+    {
+        pState->func();
+    }
+    catch (...)
+    {
+        pState->exception = std::current_exception();
+    }
+    pState->func = nullptr;
+
+    std::vector<TaskState> continuations;
+    {
+        std::lock_guard<std::mutex> lock(pState->mutex);
+        pState->done = true;
+        continuations.swap(pState->continuations);
+    }
+    pState->condition.notify_all();
+
+    // Queue the continuations before retiring this task, so Threading::finish() also waits for them.
+    for (auto& pContinuation : continuations)
+        scheduleTask(std::move(pContinuation));
+
+    if (--gData.pendingCount == 0)
+    {
+        std::lock_guard<std::mutex> lock(gData.sleepMutex);
+        gData.idleCondition.notify_all();
+    }
+}
+
+void workerLoop(int32_t workerIndex)
+{
+    tWorkerIndex = workerIndex;
+    while (true)
+    {
+        if (TaskState pState = popTask(workerIndex))
+        {
+            runTask(pState);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(gData.sleepMutex);
+        gData.sleepCondition.wait(lock, []() { return gData.stop || gData.queuedCount > 0; });
+        if (gData.stop && gData.queuedCount == 0)
+            break;
+    }
+    tWorkerIndex = -1;
+}
 } // namespace
 
 void Threading::start(uint32_t threadCount)
@@ -45,52 +206,169 @@ void Threading::start(uint32_t threadCount)
     if (gData.initialized)
         return;
 
-    gData.threads.resize(threadCount);
+    threadCount = std::max(threadCount, 1u);
+    gData.stop = false;
+    gData.queues.resize(threadCount);
+    for (auto& pQueue : gData.queues)
+        pQueue = std::make_unique<WorkerQueue>();
+    for (uint32_t i = 0; i < threadCount; ++i)
+        gData.threads.emplace_back(workerLoop, int32_t(i));
     gData.initialized = true;
 }
 
 void Threading::shutdown()
 {
+    if (!gData.initialized)
+        return;
+
+    finish();
+    {
+        std::lock_guard<std::mutex> lock(gData.sleepMutex);
+        gData.stop = true;
+    }
+    gData.sleepCondition.notify_all();
     for (auto& t : gData.threads)
     {
         if (t.joinable())
             t.join();
     }
 
+    gData.threads.clear();
+    gData.queues.clear();
     gData.initialized = false;
 }
 
-Threading::Task Threading::dispatchTask(const std::function<void(void)>& func)
+uint32_t Threading::getThreadCount()
 {
-    FALCOR_ASSERT(gData.initialized);
+    return uint32_t(gData.threads.size());
+}
 
-    std::thread& t = gData.threads[gData.current];
-    if (t.joinable())
-        t.join();
-    t = std::thread(func);
-    gData.current = (gData.current + 1) % gData.threads.size();
+Threading::Task Threading::dispatchTask(std::function<void(void)> func)
+{
+    auto pState = std::make_shared<Task::State>();
+    pState->func = std::move(func);
 
-    return Task();
+    scheduleTask(pState);
+    return Task(std::move(pState));
 }
 
 void Threading::finish()
 {
-    for (auto& t : gData.threads)
+    FALCOR_ASSERT(tWorkerIndex < 0);
+
+    std::unique_lock<std::mutex> lock(gData.sleepMutex);
+    gData.idleCondition.wait(lock, []() { return gData.pendingCount == 0; });
+}
+
+size_t Threading::getGrainSize(size_t count, size_t grainSize)
+{
+    if (grainSize > 0)
+        return grainSize;
+    const size_t chunkCount = size_t(std::max(getThreadCount(), 1u)) * 4;
+    return std::max<size_t>(1, (count + chunkCount - 1) / chunkCount);
+}
+
+void Threading::parallelForChunks(size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)>& func)
+{
+    if (begin >= end)
+        return;
+
+    grainSize = getGrainSize(end - begin, grainSize);
+    const size_t chunkCount = (end - begin + grainSize - 1) / grainSize;
+    if (chunkCount == 1 || !gData.initialized)
     {
-        if (t.joinable())
-            t.join();
+        for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+            func(begin + chunk * grainSize, std::min(end, begin + (chunk + 1) * grainSize));
+        return;
     }
+
+    // Helpers and the calling thread pull chunks from a shared counter, so the load balances itself.
+    std::atomic<size_t> nextChunk{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr exception;
+    std::mutex exceptionMutex;
+    auto runChunks = [&]()
+    {
+        for (size_t chunk = nextChunk++; chunk < chunkCount && !failed; chunk = nextChunk++)
+        {
+            try
+            {
+                func(begin + chunk * grainSize, std::min(end, begin + (chunk + 1) * grainSize));
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(exceptionMutex);
+                if (!exception)
+                    exception = std::current_exception();
+                failed = true;
+            }
+        }
+    };
+
+    const size_t helperCount = std::min(chunkCount, size_t(getThreadCount())) - 1;
+    std::vector<Task> helpers;
+    helpers.reserve(helperCount);
+    for (size_t i = 0; i < helperCount; ++i)
+        helpers.push_back(dispatchTask(runChunks));
+    runChunks();
+    for (auto& helper : helpers)
+        helper.finish();
+
+    if (exception)
+        std::rethrow_exception(exception);
 }
 
-Threading::Task::Task() {}
+bool Threading::Task::isRunning() const
+{
+    return mpState && !mpState->done;
+}
 
-bool Threading::Task::isRunning()
+void Threading::Task::finish() const
 {
-    FALCOR_UNIMPLEMENTED();
+    if (!mpState)
+        return;
+
+    if (tWorkerIndex >= 0)
+    {
+        // Execute other tasks while waiting, the awaited task may be queued behind them on this worker.
+        while (!mpState->done)
+        {
+            if (TaskState pState = popTask(tWorkerIndex))
+            {
+                runTask(pState);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mpState->mutex);
+            mpState->condition.wait_for(lock, std::chrono::microseconds(100), [this]() { return mpState->done.load(); });
+        }
+    }
+    else
+    {
+        std::unique_lock<std::mutex> lock(mpState->mutex);
+        mpState->condition.wait(lock, [this]() { return mpState->done.load(); });
+    }
+
+    if (mpState->exception)
+        std::rethrow_exception(mpState->exception);
 }
 
-void Threading::Task::finish()
+Threading::Task Threading::Task::then(std::function<void(void)> func) const
 {
-    FALCOR_UNIMPLEMENTED();
+    if (!mpState)
+        return dispatchTask(std::move(func));
+
+    auto pContinuation = std::make_shared<State>();
+    pContinuation->func = std::move(func);
+    {
+        std::lock_guard<std::mutex> lock(mpState->mutex);
+        if (!mpState->done)
+        {
+            mpState->continuations.push_back(pContinuation);
+            return Task(std::move(pContinuation));
+        }
+    }
+
+    scheduleTask(pContinuation);
+    return Task(std::move(pContinuation));
 }
 } // namespace Falcor
@@ -27,14 +27,29 @@
  **************************************************************************/
 #pragma once
 #include "Core/Macros.h"
+#include <algorithm>
 #include <condition_variable>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 #include <cstdint>
 
 namespace Falcor
 {
+/**
+ * Global work-stealing thread pool.
+ *
+ * The pool has a fixed number of worker threads, each with its own task deque. Workers push and pop
+ * tasks they spawn at the back of their own deque and steal from the front of the other deques when
+ * idle. Tasks dispatched from outside the pool go to a shared queue.
+ *
+ * Waiting on a task from a worker thread executes other tasks in the meantime, so tasks can dispatch
+ * and wait on nested work without deadlocking the pool.
+ *
+ * If the pool is not started, tasks execute immediately on the calling thread.
+ */
 class FALCOR_API Threading
 {
 public:
@@ -42,20 +57,36 @@ public:
 
     /**
      * Handle to a dispatched task
-     *
-     * TODO: Implementation
      */
-    class Task
+    class FALCOR_API Task
     {
     public:
+        /// Creates an empty handle, which is never running.
+        Task() = default;
+
+        /// Check if the handle refers to a task.
+        bool isValid() const { return mpState != nullptr; }
+
         ///  Check if task is still executing
-        bool isRunning();
+        bool isRunning() const;
+
+        /**
+         * Wait for task to finish executing.
+         * Rethrows the exception thrown by the task, if any.
+         */
+        void finish() const;
+
+        /**
+         * Dispatches a continuation that runs once this task has finished (or immediately if it already has).
+         * @return Handle to the continuation
+         */
+        Task then(std::function<void(void)> func) const;
 
-        /// Wait for task to finish executing
-        void finish();
+        struct State; ///< Internal task state.
 
     private:
-        Task();
+        Task(std::shared_ptr<State> pState) : mpState(std::move(pState)) {}
+        std::shared_ptr<State> mpState;
         friend class Threading;
     };
 
@@ -80,11 +111,67 @@ public:
      */
     static uint32_t getLogicalThreadCount() { return std::thread::hardware_concurrency(); }
 
+    /**
+     * Returns the number of worker threads in the pool (0 if not started).
+     */
+    static uint32_t getThreadCount();
+
     /**
      * Starts a task on an available thread.
      * @return Handle to the task
      */
-    static Task dispatchTask(const std::function<void(void)>& func);
+    static Task dispatchTask(std::function<void(void)> func);
+
+    /**
+     * Calls func(i) for every i in [begin, end) on the thread pool and the calling thread.
+     * Indices are processed in chunks of grainSize (0 selects a chunk size from the range and thread count).
+     * Returns when all iterations are done. The first exception thrown by an iteration is rethrown.
+     */
+    template<typename Func>
+    static void parallelFor(size_t begin, size_t end, Func&& func, size_t grainSize = 0)
+    {
+        parallelForChunks(
+            begin,
+            end,
+            grainSize,
+            [&func](size_t chunkBegin, size_t chunkEnd)
+            {
+                for (size_t i = chunkBegin; i < chunkEnd; ++i)
+                    func(i);
+            }
+        );
+    }
+
+    /**
+     * Parallel reduction over [begin, end).
+     * Every chunk is reduced with rangeFunc(chunkBegin, chunkEnd, identity) -> T and the chunk results are
+     * combined with reduceFunc(T, T) -> T in chunk order, so the result does not depend on the number of threads.
+     */
+    template<typename T, typename RangeFunc, typename ReduceFunc>
+    static T parallelReduce(size_t begin, size_t end, const T& identity, RangeFunc&& rangeFunc, ReduceFunc&& reduceFunc, size_t grainSize = 0)
+    {
+        if (begin >= end)
+            return identity;
+        grainSize = getGrainSize(end - begin, grainSize);
+        std::vector<T> partials((end - begin + grainSize - 1) / grainSize, identity);
+        parallelForChunks(
+            begin,
+            end,
+            grainSize,
+            [&](size_t chunkBegin, size_t chunkEnd) { partials[(chunkBegin - begin) / grainSize] = rangeFunc(chunkBegin, chunkEnd, identity); }
+        );
+        T result = identity;
+        for (auto& partial : partials)
+            result = reduceFunc(std::move(result), std::move(partial));
+        return result;
+    }
+
+private:
+    /// Default chunk size: about four chunks per thread.
+    static size_t getGrainSize(size_t count, size_t grainSize);
+
+    /// Calls func(chunkBegin, chunkEnd) for all chunks of [begin, end).
+    static void parallelForChunks(size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)>& func);
 };
 
 /**
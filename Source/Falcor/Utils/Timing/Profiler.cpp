@@ -369,6 +369,18 @@ Profiler::Event* Profiler::getEvent(const std::string& name)
     return event ? event : createEvent(name);
 }
 
+void Profiler::addCounter(const std::string& name, uint64_t value)
+{
+    if (!mEnabled || mPaused)
+        return;
+
+    // '/' is used as a "path delimiter", so it cannot be used in the counter name.
+    if (name.find('/') != std::string::npos)
+        return;
+
+    mCurrentFrameCounters[mCurrentEventName + "/" + name] += value;
+}
+
 void Profiler::endFrame(RenderContext* pRenderContext)
 {
     if (mPaused)
@@ -393,6 +405,8 @@ void Profiler::endFrame(RenderContext* pRenderContext)
         mpCapture->captureEvents(mCurrentFrameEvents);
 
     mLastFrameEvents = std::move(mCurrentFrameEvents);
+    mLastFrameCounters = std::move(mCurrentFrameCounters);
+    mCurrentFrameCounters.clear();
     ++mFrameIndex;
 }
 
@@ -464,6 +478,7 @@ FALCOR_SCRIPT_BINDING(Profiler)
     profiler.def_property("paused", &Profiler::isPaused, &Profiler::setPaused);
     profiler.def_property_readonly("is_capturing", &Profiler::isCapturing);
     profiler.def_property_readonly("events", [](const Profiler& profiler) { return toPython(profiler.getEvents()); });
+    profiler.def_property_readonly("counters", &Profiler::getCounters);
     profiler.def("start_capture", &Profiler::startCapture, "reserved_frames"_a = 1000);
     profiler.def("end_capture", endCapture);
 }
@@ -30,6 +30,7 @@
 #include "Core/Macros.h"
 #include "Core/API/GpuTimer.h"
 #include <filesystem>
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -234,6 +235,20 @@ public:
      */
     const std::vector<Event*>& getEvents() const { return mLastFrameEvents; }
 
+    /**
+     * Add to a per-frame counter (e.g. number of culled instances).
+     * The counter is keyed by the current event path, so it is reported under the event that sets it.
+     * Counters start at zero every frame.
+     * @param[in] name The counter name.
+     * @param[in] value The value to add for the current frame.
+     */
+    void addCounter(const std::string& name, uint64_t value);
+
+    /**
+     * Get the profiler counters (previous frame), keyed by full counter path.
+     */
+    const std::map<std::string, uint64_t>& getCounters() const { return mLastFrameCounters; }
+
     void breakStrongReferenceToDevice();
 
     /**
@@ -258,6 +273,8 @@ private:
     std::unordered_map<std::string, std::shared_ptr<Event>> mEvents; ///< Events by name.
     std::vector<Event*> mCurrentFrameEvents;                         ///< Events registered for current frame.
     std::vector<Event*> mLastFrameEvents;                            ///< Events from last frame.
+    std::map<std::string, uint64_t> mCurrentFrameCounters;           ///< Counters set in the current frame.
+    std::map<std::string, uint64_t> mLastFrameCounters;              ///< Counters from last frame.
     std::string mCurrentEventName;                                   ///< Current nested event name.
     uint32_t mCurrentLevel = 0;                                      ///< Current nesting level.
     uint32_t mFrameIndex = 0;                                        ///< Current frame index.
@@ -294,7 +311,9 @@ private:
     Falcor::ScopedProfilerEvent FALCOR_CONCAT_STRINGS(_profileEvent, __LINE__)(_pRenderContext, _name)
 #define FALCOR_PROFILE_CUSTOM(_pRenderContext, _name, _flags) \
     Falcor::ScopedProfilerEvent FALCOR_CONCAT_STRINGS(_profileEvent, __LINE__)(_pRenderContext, _name, _flags)
+#define FALCOR_PROFILE_COUNTER(_pRenderContext, _name, _value) (_pRenderContext)->getProfiler()->addCounter(_name, _value)
 #else
 #define FALCOR_PROFILE(_pRenderContext, _name)
 #define FALCOR_PROFILE_CUSTOM(_pRenderContext, _name, _flags)
+#define FALCOR_PROFILE_COUNTER(_pRenderContext, _name, _value)
 #endif
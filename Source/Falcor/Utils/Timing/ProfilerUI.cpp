@@ -235,6 +235,22 @@ void ProfilerUI::render()
         renderGraph(graphSize, mHighlightIndex, newHighlightIndex);
         mHighlightIndex = newHighlightIndex;
     }
+
+    renderCounters();
+}
+
+void ProfilerUI::renderCounters()
+{
+    const auto& counters = mpProfiler->getCounters();
+    if (counters.empty())
+        return;
+
+    ImGui::Columns(1);
+    ImGui::Dummy(ImVec2(0.f, kHeaderSpacing));
+    ImGui::TextUnformatted("Counters");
+    ImGui::Dummy(ImVec2(0.f, kHeaderSpacing));
+    for (const auto& [name, value] : counters)
+        ImGui::Text("%s: %llu", name.c_str(), (unsigned long long)value);
 }
 
 void ProfilerUI::renderOptions()
@@ -77,6 +77,11 @@ private:
      */
     void renderGraph(const ImVec2& size, size_t highlightIndex, size_t& newHighlightIndex);
 
+    /**
+     * Render the profiler counters of the previous frame.
+     */
+    void renderCounters();
+
     /**
      * Update the internal event data from the current profiler event data.
      */
@@ -545,6 +545,7 @@ namespace Mogwai
     {
         if (mOptions.useSceneCache) buildFlags |= SceneBuilder::Flags::UseCache;
         if (mOptions.rebuildSceneCache) buildFlags |= SceneBuilder::Flags::RebuildCache;
+        if (mOptions.deferSceneCacheLoading) buildFlags |= SceneBuilder::Flags::DeferCacheLoading;
 
         while (true)
         {
@@ -875,6 +876,7 @@ int main(int argc, char** argv)
     args::ValueFlag<uint32_t> heightFlag(parser, "pixels", "Initial window height.", {"height"});
     args::Flag useSceneCacheFlag(parser, "", "Use scene cache to improve scene load times.", {'c', "use-cache"});
     args::Flag rebuildSceneCacheFlag(parser, "", "Rebuild the scene cache.", {"rebuild-cache"});
+    args::Flag deferSceneCacheLoadingFlag(parser, "", "Stream in material textures and the environment map after loading from the scene cache.", {"defer-cache-loading"});
     args::Flag generateShaderDebugInfoFlag(parser, "", "Generate shader debug info.", {"debug-shaders"});
     args::Flag enableDebugLayerFlag(parser, "", "Enable debug layer (enabled by default in Debug build).", {"enable-debug-layer"});
     args::Flag preciseProgramFlag(parser, "", "Force all slang programs to run in precise mode", { "precise" });
@@ -980,6 +982,7 @@ int main(int argc, char** argv)
     if (silentFlag) options.silentMode = true;
     if (useSceneCacheFlag) options.useSceneCache = true;
     if (rebuildSceneCacheFlag) options.rebuildSceneCache = true;
+    if (deferSceneCacheLoadingFlag) options.deferSceneCacheLoading = true;
 
     try
     {
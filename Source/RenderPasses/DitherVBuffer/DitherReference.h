@@ -0,0 +1,981 @@
+#pragma once
+#include "Falcor.h"
+#include "PermutationTables.h"
+#include "Utils/NumericRange.h"
+#include <execution>
+#include <fstream>
+
+/** Headless CPU reference of the dither decisions in Dither.slangh.
+
+    Every function mirrors its shader counterpart of the same name, operating on the same inputs
+    (DitherInfo, the DitherConstants/AdaptiveDitherParams constants and the permutation/noise resources).
+    Shader intrinsics are replaced by explicit arguments: the object hash is computed by the caller via
+    getObjectHash(), and the ray differentials / hit distance are part of PixelInput.
+
+    Results match the GPU up to float precision of the transcendental functions (sin, exp2, log2, pow),
+    which only affects pixels whose threshold lies within a few ulps of alpha.
+
+    evaluateCoverage() evaluates a whole frame (one surface sample per pixel). The 8x8 pixel tiles are distributed
+    over all cores (thread parallelism, std::execution::par); within a tile the pixels are evaluated one by one
+    with scalar code, only the mode dispatch is hoisted out of the per-pixel loops.
+*/
+namespace Falcor::DitherReference
+{
+    /// Same values as DitherVBuffer::DitherMode and the DITHER_MODE_* defines.
+    enum class Mode : uint32_t
+    {
+        PerPixel2x2 = 0,
+        PerPixel3x3 = 1,
+        PerPixel4x4 = 2,
+        RussianRoulette = 4,
+        Periodic = 5,
+        HashGrid = 6,
+        FractalDithering = 7,
+        BlueNoise3D = 8,
+        DitherTemporalAA = 10,
+        SpatioTemporalBlueNoise = 11,
+        SurfaceSpatioTemporalBlueNoise = 12,
+        Adaptive = 13,
+        RIS = 14,
+        Disabled = 0xff,
+    };
+
+    /// Same values as DitherVBuffer::NoiseTopPattern and the NOISE_TOP_* defines.
+    enum class NoiseTop : uint32_t
+    {
+        Disabled,
+        StaticWhite,
+        DynamicWhite,
+        StaticBlue,
+        DynamicBlue,
+        StaticBayer,
+        DynamicBayer,
+        SurfaceWhite,
+    };
+
+    /// Same values as DitherVBuffer::ObjectHashType.
+    enum class ObjectHashType : uint32_t
+    {
+        Quads,
+        Geometry,
+    };
+
+    /// Same values as DitherVBuffer::CoverageCorrection and the COVERAGE_CORRECTION_* defines.
+    enum class CoverageCorrection : uint32_t
+    {
+        Disabled,
+        DLSS,
+        FSR,
+    };
+
+    /// Shader constants (DitherConstants, AdaptiveDitherParams, RisTemporalParams and the related defines).
+    struct Params
+    {
+        float gridScale = 0.5f;
+        bool rotatePattern = true;
+        ObjectHashType objectHashType = ObjectHashType::Geometry;
+        NoiseTop noiseTop = NoiseTop::StaticBlue;
+        bool ditherTAAPermutations = true;
+        bool enableHashGrids = true; ///< ENABLE_HASH_GRIDS.
+
+        CoverageCorrection coverageCorrection = CoverageCorrection::DLSS;
+        float correctionStrength = 1.0f;
+
+        float adaptiveDepthFar = 100.0f;
+        float adaptiveDepthWeight = 0.2f;
+        float adaptiveFreqWeight = 0.3f;
+        float adaptiveAlphaWeight = 0.5f;
+        float adaptiveFreqScale = 1.0f;
+        float adaptiveNoiseBlend = 0.1f;
+
+        float risRepeatPenalty = 0.15f;
+        float risNoveltyBoost = 1.35f;
+        bool risUseHistory = false;
+    };
+
+    /** Non-owning view of a single-channel float texture (width * height * depth values, x fastest).
+        Mirrors Texture2D/Texture2DArray/Texture3D loads and SampleLevel(lod 0).
+    */
+    struct TextureView
+    {
+        const float* data = nullptr;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t depth = 1;
+
+        bool isValid() const { return data != nullptr && width > 0 && height > 0 && depth > 0; }
+
+        float load(uint32_t x, uint32_t y, uint32_t z = 0) const
+        {
+            FALCOR_ASSERT(x < width && y < height && z < depth);
+            return data[x + size_t(width) * (y + size_t(height) * z)];
+        }
+
+        /// Load with wrap addressing. Equivalent to point sampling (gNoiseSampler) at texel corners.
+        float loadWrap(int x, int y, int z = 0) const { return load(wrap(x, width), wrap(y, height), wrap(z, depth)); }
+
+        /// Trilinear sampling with wrap/wrap/clamp addressing (gDitherSampler).
+        float sampleLinear(float u, float v, float w) const
+        {
+            float x = u * width - 0.5f, y = v * height - 0.5f, z = w * depth - 0.5f;
+            int x0 = int(std::floor(x)), y0 = int(std::floor(y)), z0 = int(std::floor(z));
+            float fx = x - x0, fy = y - y0, fz = z - z0;
+
+            auto texel = [&](int xi, int yi, int zi)
+            { return load(wrap(xi, width), wrap(yi, height), uint32_t(std::clamp(zi, 0, int(depth) - 1))); };
+            auto bilinear = [&](int zi)
+            {
+                float a = math::lerp(texel(x0, y0, zi), texel(x0 + 1, y0, zi), fx);
+                float b = math::lerp(texel(x0, y0 + 1, zi), texel(x0 + 1, y0 + 1, zi), fx);
+                return math::lerp(a, b, fy);
+            };
+            return depth > 1 ? math::lerp(bilinear(z0), bilinear(z0 + 1), fz) : bilinear(0);
+        }
+
+    private:
+        static uint32_t wrap(int i, uint32_t n) { return uint32_t(((i % int(n)) + int(n)) % int(n)); }
+    };
+
+    /// Shader resources. Unused textures may be left empty for modes that do not read them.
+    struct Resources
+    {
+        PermutationTables::View<uint32_t> permutations2x2;
+        PermutationTables::View<uint32_t> permutations3x3;
+        PermutationTables::View<Packed4x4Matrix> permutations4x4;
+
+        TextureView noise;             ///< gNoiseTex (hash grid).
+        TextureView blueNoise64;       ///< gBlueNoise64x64Tex.
+        TextureView blueNoise3D;       ///< gBlueNoise3DTex (16x16x16).
+        TextureView bayer64;           ///< gBayerNoise64Tex.
+        TextureView spatioTemporalBlueNoise; ///< gSpatioTemporalBlueNoiseTex (128x128x64).
+        TextureView fracDither;        ///< gDitherTex.
+        TextureView fracDitherRamp;    ///< gDitherRampTex.
+
+        /// Resources with the permutation tables used by DitherVBuffer and no textures.
+        static Resources fromPermutationTables(const PermutationTables& tables = PermutationTables::get())
+        {
+            Resources res;
+            res.permutations2x2 = tables.get2x2();
+            res.permutations3x3 = tables.get3x3();
+            res.permutations4x4 = tables.get4x4();
+            return res;
+        }
+    };
+
+    /// Owning single-channel texture, see loadTexture().
+    struct TextureData
+    {
+        std::vector<float> data;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t depth = 1; ///< Array size or volume depth.
+
+        TextureView getView() const { return TextureView{ data.data(), width, height, depth }; }
+    };
+
+    /** Load the first mip level of an uncompressed single-channel DDS file (as shipped in data/dither).
+        Supports R8_UNORM, R16_UNORM and R32_FLOAT 2D, 2D array and 3D textures. All slices are loaded,
+        unlike ImageIO::loadBitmapFromDDS() which only returns the first one.
+        Throws a RuntimeError if the file cannot be read or has an unsupported format.
+    */
+    inline TextureData loadTexture(const std::filesystem::path& path)
+    {
+        std::ifstream fs(path, std::ios_base::binary);
+        if (!fs) throw RuntimeError("Failed to open DDS file '{}'.", path);
+
+        // Plain DDS header (4 + 124 bytes) followed by the optional DX10 header (20 bytes).
+        uint32_t header[37] = {};
+        fs.read(reinterpret_cast<char*>(header), 128);
+        if (!fs || header[0] != 0x20534444) throw RuntimeError("'{}' is not a DDS file.", path);
+
+        const uint32_t kFourCCDX10 = 0x30315844;
+        const uint32_t height = header[3], width = header[4];
+        const uint32_t pfFlags = header[20], fourCC = header[21], bitCount = header[22];
+        uint32_t depth = (header[2] & 0x00800000) ? std::max(header[6], 1u) : 1u; // DDSD_DEPTH
+
+        enum class Format { Unknown, R8, R16, R32F } format = Format::Unknown;
+        if ((pfFlags & 0x4) && fourCC == kFourCCDX10)
+        {
+            fs.read(reinterpret_cast<char*>(header + 32), 20);
+            if (!fs) throw RuntimeError("'{}' has a truncated DX10 header.", path);
+            const uint32_t dxgiFormat = header[32];
+            if (dxgiFormat == 61) format = Format::R8;        // DXGI_FORMAT_R8_UNORM
+            else if (dxgiFormat == 56) format = Format::R16;  // DXGI_FORMAT_R16_UNORM
+            else if (dxgiFormat == 41) format = Format::R32F; // DXGI_FORMAT_R32_FLOAT
+            if (header[33] != 4) depth = std::max(header[35], 1u); // Array size unless TEXTURE3D.
+        }
+        else if ((pfFlags & 0x4) && fourCC == 114) format = Format::R32F;
+        else if ((pfFlags & 0x00020000) && bitCount == 8) format = Format::R8; // DDPF_LUMINANCE
+        else if ((pfFlags & 0x00020000) && bitCount == 16) format = Format::R16;
+
+        if (format == Format::Unknown) throw RuntimeError("'{}' is not a single-channel R8/R16/R32F texture.", path);
+        if (width == 0 || height == 0) throw RuntimeError("'{}' has invalid dimensions.", path);
+
+        TextureData tex;
+        tex.width = width;
+        tex.height = height;
+        tex.depth = depth;
+        const size_t texelCount = size_t(width) * height * depth;
+        tex.data.resize(texelCount);
+
+        const size_t texelSize = format == Format::R8 ? 1 : (format == Format::R16 ? 2 : 4);
+        const size_t sliceSize = size_t(width) * height * texelSize;
+        const uint32_t mipCount = std::max(header[7], 1u);
+        std::vector<uint8_t> raw(texelCount * texelSize);
+        if (mipCount > 1 && depth > 1 && header[33] != 4)
+        {
+            // Array slices are stored with their full mip chains, skip all but the first level.
+            size_t chainSize = 0;
+            for (uint32_t m = 0, w = width, h = height; m < mipCount; ++m, w = std::max(w / 2, 1u), h = std::max(h / 2, 1u))
+                chainSize += size_t(w) * h * texelSize;
+            for (uint32_t z = 0; z < depth; ++z)
+            {
+                fs.read(reinterpret_cast<char*>(raw.data() + z * sliceSize), sliceSize);
+                fs.seekg(chainSize - sliceSize, std::ios_base::cur);
+            }
+        }
+        else
+        {
+            fs.read(reinterpret_cast<char*>(raw.data()), raw.size());
+        }
+        if (!fs) throw RuntimeError("'{}' is truncated.", path);
+
+        for (size_t i = 0; i < texelCount; ++i)
+        {
+            switch (format)
+            {
+            case Format::R8:
+                tex.data[i] = raw[i] / 255.f;
+                break;
+            case Format::R16:
+                tex.data[i] = (raw[2 * i] | (raw[2 * i + 1] << 8)) / 65535.f;
+                break;
+            default:
+                std::memcpy(&tex.data[i], &raw[4 * i], 4);
+                break;
+            }
+        }
+        return tex;
+    }
+
+    /** Textures loaded from the data directories, using the same files as DitherVBuffer
+        (NoisePattern::Blue, SpatioTemporalBlueNoise and DitherPattern::Dither8x8 defaults).
+    */
+    struct TextureSet
+    {
+        TextureData noise;
+        TextureData blueNoise64;
+        TextureData blueNoise3D;
+        TextureData bayer64;
+        TextureData spatioTemporalBlueNoise;
+        TextureData fracDither;
+        TextureData fracDitherRamp;
+
+        /// Load all textures. Throws a RuntimeError if a file is not found in the data directories.
+        static TextureSet load(const std::string& noiseTexture = "dither/bluenoise1024.dds", const std::string& fracDitherTexture = "dither/Dither3D_8x8")
+        {
+            auto loadFromDataDirectory = [](const std::filesystem::path& path)
+            {
+                std::filesystem::path fullPath;
+                if (!findFileInDataDirectories(path, fullPath)) throw RuntimeError("Can't find dither texture '{}' in the data directories.", path);
+                return loadTexture(fullPath);
+            };
+
+            TextureSet set;
+            set.noise = loadFromDataDirectory(noiseTexture);
+            set.blueNoise64 = loadFromDataDirectory("dither/bluenoise64.dds");
+            set.blueNoise3D = loadFromDataDirectory("dither/bluenoise3d_16.dds");
+            set.bayer64 = loadFromDataDirectory("dither/bayer64.dds");
+            set.spatioTemporalBlueNoise = loadFromDataDirectory("dither/spatiotemporal_bluenoise.dds");
+            set.fracDither = loadFromDataDirectory(fracDitherTexture + ".dds");
+            set.fracDitherRamp = loadFromDataDirectory(fracDitherTexture + "_ramp.dds");
+            return set;
+        }
+
+        /// Bind the textures to the resources. The set must outlive the resources.
+        void bind(Resources& res) const
+        {
+            res.noise = noise.getView();
+            res.blueNoise64 = blueNoise64.getView();
+            res.blueNoise3D = blueNoise3D.getView();
+            res.bayer64 = bayer64.getView();
+            res.spatioTemporalBlueNoise = spatioTemporalBlueNoise.getView();
+            res.fracDither = fracDither.getView();
+            res.fracDitherRamp = fracDitherRamp.getView();
+        }
+    };
+
+    /// Common dither inputs (DitherInfo in Dither.slangh), plus the object hash that the shader computes from intrinsics.
+    struct DitherInfo
+    {
+        uint2 pixel = uint2(0);
+        uint32_t frameIndex = 0;
+        float3 posW = float3(0.f);
+        float alpha = 0.f;
+        float2 posUV = float2(0.f);
+        float maxDerivUV = 0.f;
+        float objectHash = 0.f;
+    };
+
+    // ------------------------------------------------------------------------
+    // Hashes and permutations
+    // ------------------------------------------------------------------------
+
+    inline float hash1D(float v)
+    {
+        return math::frac(1.0e4f * std::sin(17.0f * v) * (0.1f + std::abs(std::sin(v))));
+    }
+
+    inline float hash(float2 v)
+    {
+        return math::frac(1.0e4f * std::sin(17.0f * v.x + 0.1f * v.y) * (0.1f + std::abs(std::sin(13.0f * v.y + v.x))));
+    }
+
+    inline float hash3D(float3 v)
+    {
+        return hash(float2(hash(float2(v.x, v.y)), v.z));
+    }
+
+    inline float hash4D(float4 v)
+    {
+        return hash(float2(hash(float2(v.x, v.y)), hash(float2(v.z, v.w))));
+    }
+
+    /// getObjectHash() of DitherVBuffer.rt.slang with the intrinsics passed explicitly.
+    inline float getObjectHash(ObjectHashType type, uint32_t instanceID, uint32_t geometryIndex, uint32_t primitiveIndex, bool frontFace)
+    {
+        if (type == ObjectHashType::Quads) return hash3D(float3(float(instanceID), float(geometryIndex), float(primitiveIndex / 2u)));
+        return hash3D(float3(float(instanceID), float(geometryIndex), frontFace ? 1.f : 0.f));
+    }
+
+    inline std::array<uint32_t, 4> get2x2PermutationFromBuffer(const Resources& res, uint32_t id)
+    {
+        uint32_t packed = res.permutations2x2[id % res.permutations2x2.size()];
+        std::array<uint32_t, 4> result;
+        for (uint32_t i = 0; i < 4; ++i) result[i] = (packed >> (i * 4)) & 0xF;
+        return result;
+    }
+
+    /// Returns the 3x3 matrix in row-major order (m[y * 3 + x]).
+    inline std::array<uint32_t, 9> get3x3Permutation(const Resources& res, uint32_t id)
+    {
+        uint32_t packed = res.permutations3x3[id % res.permutations3x3.size()];
+        std::array<uint32_t, 9> m;
+        uint32_t sumValues = 0;
+        for (uint32_t i = 0; i < 8; ++i)
+        {
+            m[i] = (packed >> (i * 4)) & 0xF;
+            sumValues += m[i];
+        }
+        m[8] = 36 - sumValues;
+        return m;
+    }
+
+    /// Returns the 4x4 matrix in row-major order (m[y * 4 + x]).
+    inline std::array<uint32_t, 16> get4x4Permutation(const Resources& res, uint32_t id)
+    {
+        const Packed4x4Matrix& packed = res.permutations4x4[id % res.permutations4x4.size()];
+        std::array<uint32_t, 16> m;
+        for (uint32_t i = 0; i < 8; ++i)
+        {
+            m[i] = (packed.low >> (i * 4)) & 0xF;
+            m[i + 8] = (packed.high >> (i * 4)) & 0xF;
+        }
+        return m;
+    }
+
+    /// i-th permutation of [0, 5) in lexicographic order (same table as GetPermutation5).
+    inline std::array<uint32_t, 5> getPermutation5(uint32_t i)
+    {
+        i %= 120u;
+        std::array<uint32_t, 5> remaining = { 0, 1, 2, 3, 4 };
+        std::array<uint32_t, 5> result;
+        uint32_t count = 5, factorial = 24;
+        for (uint32_t k = 0; k < 5; ++k)
+        {
+            uint32_t index = i / factorial;
+            i %= factorial;
+            result[k] = remaining[index];
+            std::copy(remaining.begin() + index + 1, remaining.begin() + count, remaining.begin() + index);
+            --count;
+            if (count > 0) factorial /= count;
+        }
+        return result;
+    }
+
+    inline uint2 applyRotation(uint2 pixel, uint32_t offset, uint32_t width, uint32_t height)
+    {
+        uint32_t xoff = offset % width;
+        uint32_t yoff = offset / width;
+        if (yoff % 2u) xoff = width - xoff - 1; // serpentine raster
+        pixel.x += xoff;
+        pixel.y += yoff;
+        return pixel;
+    }
+
+    // ------------------------------------------------------------------------
+    // Thresholds
+    // ------------------------------------------------------------------------
+
+    /// clamp(t, 1e-6, 1) as evaluated by the shader: HLSL max() returns the non-NaN operand, std::clamp() would pass NaN through.
+    inline float clampThreshold(float t)
+    {
+        return std::min(std::max(1e-6f, t), 1.0f);
+    }
+
+    /// Final threshold interpolation shared by the hash grid variants ("Improved Alpha Testing Using Hashed Sampling").
+    inline float hashedAlphaThreshold(float2 alpha, float lerpFactor)
+    {
+        float x = (1.0f - lerpFactor) * alpha.x + lerpFactor * alpha.y;
+        float a = std::min(lerpFactor, 1.0f - lerpFactor);
+        float3 cases = float3(
+            x * x / (2 * a * (1.0f - a)),
+            (x - 0.5f * a) / (1.0f - a),
+            1.0f - ((1.0f - x) * (1.0f - x) / (2.0f * a * (1.0f - a)))
+        );
+        float threshold = (x < (1 - a)) ? ((x < a) ? cases.x : cases.y) : cases.z;
+        return clampThreshold(threshold);
+    }
+
+    inline float evalHashGrid2D(const Params& params, const Resources& res, const DitherInfo& d, float hashScale, bool rotate = false)
+    {
+        if (!params.enableHashGrids) return 0.5f;
+
+        float pixScale = 1.0f / (hashScale * d.maxDerivUV);
+        float2 pixScales = float2(std::exp2(std::floor(std::log2(pixScale))), std::exp2(std::ceil(std::log2(pixScale))));
+
+        float4 coords = float4(
+            std::floor(pixScales.x * d.posUV.x), std::floor(pixScales.x * d.posUV.y),
+            std::floor(pixScales.y * d.posUV.x), std::floor(pixScales.y * d.posUV.y)
+        );
+        if (rotate)
+        {
+            uint32_t width = 3;
+            uint32_t xoff = d.frameIndex % width;
+            uint32_t yoff = d.frameIndex / width;
+            if (yoff % 2u) xoff = width - xoff - 1; // serpentine raster
+            yoff = yoff % width;
+            coords.x += float(xoff);
+            coords.z += float(xoff);
+            coords.y += float(yoff);
+            coords.w += float(yoff);
+        }
+
+        // noise(uv) point samples gNoiseTex at uv / textureSize with wrap addressing, i.e. loads texel uv.
+        float2 alpha = float2(
+            1.0f - res.noise.loadWrap(int(coords.x), int(coords.y)),
+            1.0f - res.noise.loadWrap(int(coords.z), int(coords.w))
+        );
+        return hashedAlphaThreshold(alpha, math::frac(std::log2(pixScale)));
+    }
+
+    inline float getTopNoise(const Params& params, const Resources& res, const DitherInfo& d)
+    {
+        switch (params.noiseTop)
+        {
+        case NoiseTop::StaticWhite:
+            return hash3D(d.posW);
+        case NoiseTop::DynamicWhite:
+            return hash4D(float4(d.posW, float(d.frameIndex)));
+        case NoiseTop::StaticBlue:
+            return res.blueNoise64.load(d.pixel.x % 64u, d.pixel.y % 64u);
+        case NoiseTop::DynamicBlue:
+            return res.blueNoise3D.load(d.pixel.x % 16u, d.pixel.y % 16u, d.frameIndex % 16u);
+        case NoiseTop::StaticBayer:
+            return res.bayer64.load(d.pixel.x % 64u, d.pixel.y % 64u);
+        case NoiseTop::SurfaceWhite:
+            return evalHashGrid2D(params, res, d, params.gridScale);
+        case NoiseTop::Disabled:
+        default:
+            return 0.5f;
+        }
+    }
+
+    inline float getPixelDitherThreshold2x2(const Params& params, const Resources& res, const DitherInfo& d)
+    {
+        uint32_t randomOffset = uint32_t(d.objectHash * 7919);
+        std::array<uint32_t, 4> mask = get2x2PermutationFromBuffer(res, randomOffset);
+        uint2 p = d.pixel;
+        if (params.rotatePattern) p = applyRotation(p, d.frameIndex, 2, 2);
+        uint32_t v = mask[(p.x % 2u) + 2u * (p.y % 2u)];
+        return (v + getTopNoise(params, res, d)) / 4.0f;
+    }
+
+    inline float getPixelDitherThreshold3x3(const Params& params, const Resources& res, const DitherInfo& d)
+    {
+        uint32_t randomOffset = uint32_t(d.objectHash * 7919);
+        uint2 p = d.pixel;
+        if (params.rotatePattern) p = applyRotation(p, d.frameIndex, 3, 3);
+        std::array<uint32_t, 9> mask = get3x3Permutation(res, randomOffset);
+        uint32_t v = mask[(p.y % 3u) * 3 + (p.x % 3u)];
+        return (v + getTopNoise(params, res, d)) / 9.0f;
+    }
+
+    inline float getPixelDitherThreshold4x4(const Params& params, const Resources& res, const DitherInfo& d)
+    {
+        uint32_t randomOffset = uint32_t(d.objectHash * 7919);
+        uint2 p = d.pixel;
+        if (params.rotatePattern) p = applyRotation(p, d.frameIndex, 4, 4);
+        std::array<uint32_t, 16> mask = get4x4Permutation(res, randomOffset);
+        uint32_t v = mask[(p.y % 4u) * 4 + (p.x % 4u)];
+        return (v + getTopNoise(params, res, d)) / 16.0f;
+    }
+
+    inline float ditherTemporalAAThreshold(const Params& params, const Resources& res, const DitherInfo& d)
+    {
+        uint2 p = d.pixel + uint2(d.frameIndex);
+        uint32_t stratifyIndex = (p.x + p.y * 2u) % 5;
+        if (params.ditherTAAPermutations) stratifyIndex = getPermutation5(uint32_t(d.objectHash * 120))[stratifyIndex];
+
+        float t = (stratifyIndex + getTopNoise(params, res, d)) / 5.0f; // unbiased threshold
+        return clampThreshold(t);
+    }
+
+    inline float getSTBNThreshold(const Resources& res, const DitherInfo& d)
+    {
+        uint32_t randomOffset = uint32_t(d.objectHash * 128 * 128 * 64); // texture resolution 128x128x64
+        uint32_t x = (d.pixel.x + randomOffset % 128u) % 128u;
+        uint32_t y = (d.pixel.y + (randomOffset / 128u) % 128u) % 128u;
+        uint32_t z = (d.frameIndex + randomOffset / 16384u) % 64u;
+        return clampThreshold(res.spatioTemporalBlueNoise.load(x, y, z));
+    }
+
+    inline float getHashSTBNThreshold(const Params& params, const Resources& res, const DitherInfo& d)
+    {
+        if (!params.enableHashGrids) return 0.5f;
+
+        uint32_t randomOffset = uint32_t(d.objectHash * 64); // only for temporal slice
+        float pixScale = 1.0f / (params.gridScale * d.maxDerivUV);
+        float2 pixScales = float2(std::exp2(std::floor(std::log2(pixScale))), std::exp2(std::ceil(std::log2(pixScale))));
+
+        uint4 coords = uint4(
+            uint32_t(std::floor(pixScales.x * d.posUV.x)), uint32_t(std::floor(pixScales.x * d.posUV.y)),
+            uint32_t(std::floor(pixScales.y * d.posUV.x)), uint32_t(std::floor(pixScales.y * d.posUV.y))
+        );
+        coords = coords % 128u;
+        uint32_t z = (d.frameIndex + randomOffset / (128u * 128u)) % 64u;
+
+        float2 alpha = float2(
+            1.0f - res.spatioTemporalBlueNoise.load(coords.x, coords.y, z),
+            1.0f - res.spatioTemporalBlueNoise.load(coords.z, coords.w, z)
+        );
+        return hashedAlphaThreshold(alpha, 1.0f); // the shader overrides the lerp factor with 1
+    }
+
+    inline float getBlueNoise3DThreshold(const Resources& res, const DitherInfo& d)
+    {
+        uint32_t randomOffset = uint32_t(d.objectHash * 16 * 16 * 16);
+        uint32_t x = (d.pixel.x + randomOffset % 16u) % 16u;
+        uint32_t y = (d.pixel.y + (randomOffset / 16u) % 16u) % 16u;
+        uint32_t z = (d.frameIndex + randomOffset / 256u) % 16u;
+        return clampThreshold(res.blueNoise3D.load(x, y, z));
+    }
+
+    // ------------------------------------------------------------------------
+    // ADTF
+    // ------------------------------------------------------------------------
+
+    struct AdaptiveFactors
+    {
+        float depthFactor = 0.f;
+        float freqFactor = 0.f;
+        float alphaFactor = 0.f;
+        float adaptiveScore = 0.f;
+        uint32_t matrixSize = 0;
+    };
+
+    inline uint32_t selectAdaptiveMatrixSize(const Params& params, float rayT, float2 derivatives, float alpha, AdaptiveFactors& factors)
+    {
+        factors.alphaFactor = 1.0f - alpha;
+        factors.freqFactor = 1.0f - math::saturate(math::length(derivatives) * params.adaptiveFreqScale);
+        factors.depthFactor = math::saturate(rayT / params.adaptiveDepthFar);
+
+        factors.adaptiveScore = factors.alphaFactor * params.adaptiveAlphaWeight + factors.freqFactor * params.adaptiveFreqWeight +
+                                factors.depthFactor * params.adaptiveDepthWeight;
+        float totalWeight = params.adaptiveAlphaWeight + params.adaptiveFreqWeight + params.adaptiveDepthWeight;
+        if (totalWeight > 0.0f) factors.adaptiveScore /= totalWeight;
+
+        if (factors.adaptiveScore > 0.66f) factors.matrixSize = 4;
+        else if (factors.adaptiveScore > 0.33f) factors.matrixSize = 3;
+        else factors.matrixSize = 2;
+        return factors.matrixSize;
+    }
+
+    inline float getAdaptiveDitherThreshold(
+        const Params& params,
+        const Resources& res,
+        const DitherInfo& d,
+        float rayT,
+        float2 ddx,
+        AdaptiveFactors& factors
+    )
+    {
+        uint32_t matrixSize = selectAdaptiveMatrixSize(params, rayT, ddx, d.alpha, factors);
+        uint32_t temporalPhase = d.frameIndex % (matrixSize * matrixSize); // computeMotionAwarePhase
+        uint32_t randomOffset = uint32_t(d.objectHash * 7919);
+
+        uint2 p = d.pixel;
+        if (params.rotatePattern) p = applyRotation(p, temporalPhase, matrixSize, matrixSize);
+        p = p % matrixSize;
+
+        float baseThreshold;
+        if (matrixSize == 2) baseThreshold = (get2x2PermutationFromBuffer(res, randomOffset)[p.x + 2u * p.y] + 0.5f) / 4.0f;
+        else if (matrixSize == 3) baseThreshold = (get3x3Permutation(res, randomOffset)[p.y * 3 + p.x] + 0.5f) / 9.0f;
+        else baseThreshold = (get4x4Permutation(res, randomOffset)[p.y * 4 + p.x] + 0.5f) / 16.0f;
+
+        // Material modulation.
+        float materialMod = math::lerp(0.8f, 1.2f, d.alpha);
+        baseThreshold = std::pow(baseThreshold, 1.0f / std::clamp(materialMod, 0.5f, 2.0f));
+
+        // Adaptive noise blend.
+        float freqFactor = math::saturate(math::length(ddx) * params.adaptiveFreqScale);
+        float adaptiveNoiseBlend = math::lerp(params.adaptiveNoiseBlend * 1.5f, params.adaptiveNoiseBlend * 0.3f, freqFactor);
+
+        float finalThreshold = math::lerp(baseThreshold, getTopNoise(params, res, d), adaptiveNoiseBlend);
+        return clampThreshold(finalThreshold);
+    }
+
+    // ------------------------------------------------------------------------
+    // Boolean decisions
+    // ------------------------------------------------------------------------
+
+    inline bool winHashGrid2D(const Params& params, const Resources& res, const DitherInfo& d)
+    {
+        return d.alpha >= evalHashGrid2D(params, res, d, params.gridScale, params.rotatePattern);
+    }
+
+    inline bool winRoulette(const DitherInfo& d)
+    {
+        return hash4D(float4(d.posW, float(d.frameIndex))) <= d.alpha;
+    }
+
+    inline bool winBlueNoise3D(const Resources& res, const DitherInfo& d)
+    {
+        return d.alpha >= getBlueNoise3DThreshold(res, d);
+    }
+
+    inline bool winRotation(const DitherInfo& d, uint32_t instanceID, uint32_t geometryIndex)
+    {
+        static const int kDitherMatrix[4][4] = { { 0, 8, 2, 10 }, { 12, 4, 14, 6 }, { 3, 11, 1, 9 }, { 15, 7, 13, 5 } };
+        float rng = kDitherMatrix[d.pixel.x % 4u][d.pixel.y % 4u] / 16.0f;
+        rng += hash(float2(float(instanceID), float(geometryIndex)));
+        return math::frac(rng + d.frameIndex * d.alpha) < d.alpha;
+    }
+
+    inline bool winFractalDither(const Params& params, const Resources& res, DitherInfo d, float2 dx, float2 dy)
+    {
+        if (!params.enableHashGrids) return true;
+
+        const float scale = params.gridScale;
+        const float sizeVariability = 1.0f;
+        const bool invertPattern = true;
+
+        const TextureView& tex = res.fracDither;
+        const TextureView& ramp = res.fracDitherRamp;
+        float dotsPerSide = tex.width / 16.0f;
+        float dotsTotal = float(tex.depth);
+        float invZres = 1.0f / tex.depth;
+
+        // Lookup opacity to make dither output have correct output opacity at different input opacity values.
+        if (invertPattern) d.alpha = 1.0f - d.alpha;
+        float xRamp = float(ramp.width);
+        float lookup = math::lerp(0.5f, xRamp - 0.5f, d.alpha) / xRamp;
+        d.alpha = ramp.sampleLinear(lookup, 0.5f, 0.5f);
+
+        // Frequency from singular value decomposition of the UV Jacobian.
+        float Q = dx.x * dx.x + dx.y * dx.y + dy.x * dy.x + dy.y * dy.y;
+        float R = dx.x * dy.y - dx.y * dy.x;
+        float discriminant = std::sqrt(std::max(0.0f, Q * Q - 4 * R * R));
+        float2 freq = float2(std::sqrt((Q + discriminant) / 2), std::sqrt((Q - discriminant) / 2));
+
+        float spacing = freq.y;
+        spacing *= std::exp2(scale);
+        spacing *= dotsPerSide * 0.125f;
+        spacing *= std::pow(d.alpha * 2 + 0.001f, -(1 - sizeVariability));
+
+        float spacingLog = std::log2(spacing);
+        int patternScaleLevel = int(std::floor(spacingLog));
+        float f = spacingLog - patternScaleLevel;
+
+        float2 uv = d.posUV / std::exp2(float(patternScaleLevel));
+        float subLayer = math::lerp(0.25f * dotsTotal, dotsTotal, 1 - f);
+        subLayer = (subLayer - 0.5f) * invZres;
+
+        float pattern = tex.sampleLinear(uv.x, uv.y, 1.0f - subLayer);
+        return invertPattern ? pattern > d.alpha : pattern < d.alpha;
+    }
+
+    // ------------------------------------------------------------------------
+    // RIS
+    // ------------------------------------------------------------------------
+
+    inline bool risUpdateReservoir(float w, float& weightSum, uint32_t& candidateCount, uint32_t& selectedIndex, uint32_t candidateIndex, float rng)
+    {
+        candidateCount += 1u;
+        weightSum += w;
+        if (w <= 0.0f || weightSum <= 0.0f) return false;
+
+        float p = math::saturate(w / weightSum);
+        if (rng <= p)
+        {
+            selectedIndex = candidateIndex;
+            return true;
+        }
+        return false;
+    }
+
+    inline uint32_t makeRisSignature(uint32_t instanceID, uint32_t primitiveIndex)
+    {
+        uint32_t x = instanceID * 1664525u + 1013904223u;
+        uint32_t y = primitiveIndex * 22695477u + 1u;
+        return x ^ (y + 0x9e3779b9u + (x << 6) + (x >> 2));
+    }
+
+    // ------------------------------------------------------------------------
+    // Frame evaluation
+    // ------------------------------------------------------------------------
+
+    inline float applyCoverageCorrection(const Params& params, float alpha)
+    {
+        switch (params.coverageCorrection)
+        {
+        case CoverageCorrection::DLSS:
+        {
+            float dlssAlpha = math::saturate(0.0113f + 1.6560f * alpha - 0.8210f * alpha * alpha + 0.1560f * alpha * alpha * alpha);
+            return math::lerp(alpha, dlssAlpha, params.correctionStrength);
+        }
+        case CoverageCorrection::FSR:
+        {
+            float fsrAlpha = alpha;
+            if (alpha > 0.320314f)
+                fsrAlpha = math::saturate(-1.0204f + 6.0689f * alpha - 6.7421f * alpha * alpha + 2.6931f * alpha * alpha * alpha);
+            else if (alpha < 0.202436f)
+                fsrAlpha = math::saturate(1.3113f * alpha + 0.6793f * alpha * alpha - 10.9520f * alpha * alpha * alpha);
+            return math::lerp(alpha, fsrAlpha, params.correctionStrength);
+        }
+        default:
+            return alpha;
+        }
+    }
+
+    /// One transparent surface sample, i.e. the inputs of the any-hit shader for one pixel.
+    struct PixelInput
+    {
+        float alpha = 0.f;           ///< Material opacity (before coverage correction).
+        float3 posW = float3(0.f);
+        float2 texC = float2(0.f);
+        float2 texAspect = float2(1.f); ///< (1, texHeight / texWidth) of the material textures.
+        float2 ddx = float2(0.f);    ///< Texture coordinate derivatives.
+        float2 ddy = float2(0.f);
+        float rayT = 0.f;
+        uint32_t instanceID = 0;
+        uint32_t geometryIndex = 0;
+        uint32_t primitiveIndex = 0;
+        bool frontFace = true;
+    };
+
+    /// Build the DitherInfo for a pixel, as done in the any-hit shader. Alpha is coverage corrected.
+    inline DitherInfo makeDitherInfo(const Params& params, uint2 pixel, uint32_t frameIndex, const PixelInput& in)
+    {
+        DitherInfo d;
+        d.pixel = pixel;
+        d.frameIndex = frameIndex;
+        d.posW = in.posW;
+        d.alpha = applyCoverageCorrection(params, in.alpha);
+        d.posUV = in.texC * in.texAspect;
+        d.maxDerivUV = std::max(math::length(in.ddx * in.texAspect), math::length(in.ddy * in.texAspect));
+        d.objectHash = getObjectHash(params.objectHashType, in.instanceID, in.geometryIndex, in.primitiveIndex, in.frontFace);
+        return d;
+    }
+
+    /** Dither decision of the any-hit shader for one surface sample.
+        Returns true if the hit is kept (covered), false if it is ignored.
+        RIS selects among several layers instead, see selectRisCandidate(); a single layer is always kept.
+    */
+    inline bool isCovered(Mode mode, const Params& params, const Resources& res, uint2 pixel, uint32_t frameIndex, const PixelInput& in)
+    {
+        if (in.alpha <= 0.01f) return false;
+        if (in.alpha >= 1.0f) return true;
+
+        const DitherInfo d = makeDitherInfo(params, pixel, frameIndex, in);
+        switch (mode)
+        {
+        case Mode::PerPixel2x2:
+            return !(d.alpha < getPixelDitherThreshold2x2(params, res, d));
+        case Mode::PerPixel3x3:
+            return !(d.alpha < getPixelDitherThreshold3x3(params, res, d));
+        case Mode::PerPixel4x4:
+            return !(d.alpha < getPixelDitherThreshold4x4(params, res, d));
+        case Mode::DitherTemporalAA:
+            return !(d.alpha < ditherTemporalAAThreshold(params, res, d));
+        case Mode::RussianRoulette:
+            return winRoulette(d);
+        case Mode::Periodic:
+            return winRotation(d, in.instanceID, in.geometryIndex);
+        case Mode::HashGrid:
+            return winHashGrid2D(params, res, d);
+        case Mode::FractalDithering:
+            return winFractalDither(params, res, d, in.ddx * in.texAspect, in.ddy * in.texAspect);
+        case Mode::BlueNoise3D:
+            return winBlueNoise3D(res, d);
+        case Mode::SpatioTemporalBlueNoise:
+            return !(d.alpha < getSTBNThreshold(res, d));
+        case Mode::SurfaceSpatioTemporalBlueNoise:
+            return !(d.alpha < getHashSTBNThreshold(params, res, d));
+        case Mode::Adaptive:
+        {
+            AdaptiveFactors factors;
+            return !(d.alpha < getAdaptiveDitherThreshold(params, res, d, in.rayT, in.ddx, factors));
+        }
+        case Mode::RIS:
+        case Mode::Disabled:
+        default:
+            return true;
+        }
+    }
+
+    /** RIS selection over the transparent layers of one pixel (front to back), mirroring risAddCandidate()
+        and the final opaque/transparent choice in closestHit().
+        @param[in] historySignature Signature selected in the previous frame (only used if params.risUseHistory).
+        @return Index of the selected layer, or -1 if the opaque surface behind the layers is chosen.
+    */
+    inline int selectRisCandidate(
+        const Params& params,
+        uint2 pixel,
+        uint32_t frameIndex,
+        const PixelInput* pLayers,
+        size_t layerCount,
+        uint32_t historySignature = 0xffffffffu
+    )
+    {
+        float weightSum = 0.f;
+        float transmittance = 1.f;
+        uint32_t candidateCount = 0;
+        uint32_t selectedIndex = 0xffffffffu;
+        for (size_t i = 0; i < layerCount; ++i)
+        {
+            const PixelInput& in = pLayers[i];
+            if (in.alpha <= 0.01f || in.alpha >= 1.0f) continue;
+
+            float alpha = applyCoverageCorrection(params, in.alpha);
+            const uint32_t candidateIndex = candidateCount;
+            float w = std::max(0.0f, transmittance * alpha);
+            if (params.risUseHistory)
+            {
+                if (makeRisSignature(in.instanceID, in.primitiveIndex) == historySignature) w *= std::max(0.01f, params.risRepeatPenalty);
+                else w *= std::max(1.0f, params.risNoveltyBoost);
+            }
+            const float rng = hash4D(float4(in.posW.x, in.posW.y, in.posW.z, float(candidateIndex) + 1.0f));
+            if (risUpdateReservoir(w, weightSum, candidateCount, selectedIndex, candidateIndex, rng)) selectedIndex = uint32_t(i);
+            transmittance *= (1.0f - alpha);
+        }
+
+        const float totalW = weightSum + std::max(0.0f, transmittance);
+        bool chooseOpaque = true;
+        if (totalW > 0.0f)
+        {
+            const float rngFinal = hash4D(float4(float(pixel.x), float(pixel.y), float(frameIndex), 613.0f));
+            chooseOpaque = rngFinal <= math::saturate(std::max(0.0f, transmittance) / totalW);
+        }
+        return (!chooseOpaque && candidateCount > 0 && selectedIndex != 0xffffffffu) ? int(selectedIndex) : -1;
+    }
+
+    static constexpr uint32_t kTileSize = 8;
+
+    /** Evaluate the coverage mask of a full frame with one surface sample per pixel.
+        Tiles of kTileSize x kTileSize pixels are processed in parallel on multiple threads.
+        @param[in] frameDim Frame dimensions.
+        @param[in] pInputs frameDim.x * frameDim.y samples, row-major.
+        @param[out] pMask frameDim.x * frameDim.y values, 1 where the hit is kept and 0 where it is ignored.
+    */
+    inline void evaluateCoverage(
+        Mode mode,
+        const Params& params,
+        const Resources& res,
+        uint2 frameDim,
+        uint32_t frameIndex,
+        const PixelInput* pInputs,
+        uint8_t* pMask
+    )
+    {
+        const uint2 tileCount = (frameDim + kTileSize - 1u) / kTileSize;
+
+        // Threshold modes compute a row of thresholds first (scalar, one shader call per pixel) and then
+        // compare the whole row in a separate branch-free loop.
+        auto thresholdTile = [&](uint2 tileOrigin, auto thresholdFunc)
+        {
+            float thresholds[kTileSize];
+            float alphas[kTileSize];
+            uint8_t valid[kTileSize];
+            for (uint32_t y = tileOrigin.y; y < std::min(tileOrigin.y + kTileSize, frameDim.y); ++y)
+            {
+                const uint32_t width = std::min(kTileSize, frameDim.x - tileOrigin.x);
+                const size_t rowOffset = size_t(y) * frameDim.x + tileOrigin.x;
+                for (uint32_t i = 0; i < width; ++i)
+                {
+                    const PixelInput& in = pInputs[rowOffset + i];
+                    DitherInfo d = makeDitherInfo(params, uint2(tileOrigin.x + i, y), frameIndex, in);
+                    alphas[i] = d.alpha;
+                    valid[i] = in.alpha > 0.01f;
+                    // Opaque samples are always kept, transparent ones compare against the threshold.
+                    thresholds[i] = in.alpha >= 1.0f ? -1.0f : thresholdFunc(d, in);
+                }
+                for (uint32_t i = 0; i < width; ++i) pMask[rowOffset + i] = uint8_t(valid[i] & uint8_t(alphas[i] >= thresholds[i]));
+            }
+        };
+
+        auto genericTile = [&](uint2 tileOrigin)
+        {
+            for (uint32_t y = tileOrigin.y; y < std::min(tileOrigin.y + kTileSize, frameDim.y); ++y)
+            {
+                for (uint32_t x = tileOrigin.x; x < std::min(tileOrigin.x + kTileSize, frameDim.x); ++x)
+                {
+                    const size_t i = size_t(y) * frameDim.x + x;
+                    pMask[i] = isCovered(mode, params, res, uint2(x, y), frameIndex, pInputs[i]) ? 1 : 0;
+                }
+            }
+        };
+
+        NumericRange<uint32_t> tileRange(0, tileCount.x * tileCount.y);
+        std::for_each(
+            std::execution::par,
+            tileRange.begin(),
+            tileRange.end(),
+            [&](uint32_t tileIndex)
+            {
+                const uint2 tileOrigin = uint2(tileIndex % tileCount.x, tileIndex / tileCount.x) * kTileSize;
+                switch (mode)
+                {
+                case Mode::PerPixel2x2:
+                    thresholdTile(tileOrigin, [&](const DitherInfo& d, const PixelInput&) { return getPixelDitherThreshold2x2(params, res, d); });
+                    break;
+                case Mode::PerPixel3x3:
+                    thresholdTile(tileOrigin, [&](const DitherInfo& d, const PixelInput&) { return getPixelDitherThreshold3x3(params, res, d); });
+                    break;
+                case Mode::PerPixel4x4:
+                    thresholdTile(tileOrigin, [&](const DitherInfo& d, const PixelInput&) { return getPixelDitherThreshold4x4(params, res, d); });
+                    break;
+                case Mode::DitherTemporalAA:
+                    thresholdTile(tileOrigin, [&](const DitherInfo& d, const PixelInput&) { return ditherTemporalAAThreshold(params, res, d); });
+                    break;
+                case Mode::SpatioTemporalBlueNoise:
+                    thresholdTile(tileOrigin, [&](const DitherInfo& d, const PixelInput&) { return getSTBNThreshold(res, d); });
+                    break;
+                case Mode::Adaptive:
+                    thresholdTile(
+                        tileOrigin,
+                        [&](const DitherInfo& d, const PixelInput& in)
+                        {
+                            AdaptiveFactors factors;
+                            return getAdaptiveDitherThreshold(params, res, d, in.rayT, in.ddx, factors);
+                        }
+                    );
+                    break;
+                default:
+                    genericTile(tileOrigin);
+                    break;
+                }
+            }
+        );
+    }
+} // namespace Falcor::DitherReference
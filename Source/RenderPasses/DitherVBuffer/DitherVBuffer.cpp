@@ -26,7 +26,8 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "DitherVBuffer.h"
-#include "PermutationLookup.h"
+#include "PermutationTables.h"
+#include "DitherReference.h"
 #include "Scene/Lighting/LightSettings.h"
 #include "Scene/Lighting/ShadowSettings.h"
 
@@ -44,6 +45,46 @@ namespace
     const std::string kUseWhitelist = "useWhitelist";
     const std::string kWhitelist = "whitelist";
     const std::string kWhitelistBuffer = "whitelistBuffer"; // GPU Buffer for whitelist
+
+    // ADTF and RIS weights, see Source/Tools/DitherTuner for tuned presets.
+    const std::string kAdaptiveDepthFar = "adaptiveDepthFar";
+    const std::string kAdaptiveDepthWeight = "adaptiveDepthWeight";
+    const std::string kAdaptiveFreqWeight = "adaptiveFreqWeight";
+    const std::string kAdaptiveAlphaWeight = "adaptiveAlphaWeight";
+    const std::string kAdaptiveFreqScale = "adaptiveFreqScale";
+    const std::string kAdaptiveNoiseBlend = "adaptiveNoiseBlend";
+    const std::string kRisRepeatPenalty = "risRepeatPenalty";
+    const std::string kRisNoveltyBoost = "risNoveltyBoost";
+
+    // The CPU reference mirrors the shader defines, which are set from these enums.
+    // PerJitter and PerPixel2x2x2 are deprecated and have no reference implementation.
+    static_assert(uint32_t(DitherReference::Mode::PerPixel2x2) == uint32_t(DitherVBuffer::DitherMode::PerPixel2x2));
+    static_assert(uint32_t(DitherReference::Mode::PerPixel3x3) == uint32_t(DitherVBuffer::DitherMode::PerPixel3x3));
+    static_assert(uint32_t(DitherReference::Mode::PerPixel4x4) == uint32_t(DitherVBuffer::DitherMode::PerPixel4x4));
+    static_assert(uint32_t(DitherReference::Mode::RussianRoulette) == uint32_t(DitherVBuffer::DitherMode::RussianRoulette));
+    static_assert(uint32_t(DitherReference::Mode::Periodic) == uint32_t(DitherVBuffer::DitherMode::Periodic));
+    static_assert(uint32_t(DitherReference::Mode::HashGrid) == uint32_t(DitherVBuffer::DitherMode::HashGrid));
+    static_assert(uint32_t(DitherReference::Mode::FractalDithering) == uint32_t(DitherVBuffer::DitherMode::FractalDithering));
+    static_assert(uint32_t(DitherReference::Mode::BlueNoise3D) == uint32_t(DitherVBuffer::DitherMode::BlueNoise3D));
+    static_assert(uint32_t(DitherReference::Mode::DitherTemporalAA) == uint32_t(DitherVBuffer::DitherMode::DitherTemporalAA));
+    static_assert(uint32_t(DitherReference::Mode::SpatioTemporalBlueNoise) == uint32_t(DitherVBuffer::DitherMode::SpatioTemporalBlueNoise));
+    static_assert(uint32_t(DitherReference::Mode::SurfaceSpatioTemporalBlueNoise) == uint32_t(DitherVBuffer::DitherMode::SurfaceSpatioTemporalBlueNoise));
+    static_assert(uint32_t(DitherReference::Mode::Adaptive) == uint32_t(DitherVBuffer::DitherMode::Adaptive));
+    static_assert(uint32_t(DitherReference::Mode::RIS) == uint32_t(DitherVBuffer::DitherMode::RIS));
+    static_assert(uint32_t(DitherReference::Mode::Disabled) == uint32_t(DitherVBuffer::DitherMode::Disabled));
+    static_assert(uint32_t(DitherReference::NoiseTop::Disabled) == uint32_t(DitherVBuffer::NoiseTopPattern::Disabled));
+    static_assert(uint32_t(DitherReference::NoiseTop::StaticWhite) == uint32_t(DitherVBuffer::NoiseTopPattern::StaticWhite));
+    static_assert(uint32_t(DitherReference::NoiseTop::DynamicWhite) == uint32_t(DitherVBuffer::NoiseTopPattern::DynamicWhite));
+    static_assert(uint32_t(DitherReference::NoiseTop::StaticBlue) == uint32_t(DitherVBuffer::NoiseTopPattern::StaticBlue));
+    static_assert(uint32_t(DitherReference::NoiseTop::DynamicBlue) == uint32_t(DitherVBuffer::NoiseTopPattern::DynamicBlue));
+    static_assert(uint32_t(DitherReference::NoiseTop::StaticBayer) == uint32_t(DitherVBuffer::NoiseTopPattern::StaticBayer));
+    static_assert(uint32_t(DitherReference::NoiseTop::DynamicBayer) == uint32_t(DitherVBuffer::NoiseTopPattern::DynamicBayer));
+    static_assert(uint32_t(DitherReference::NoiseTop::SurfaceWhite) == uint32_t(DitherVBuffer::NoiseTopPattern::SurfaceWhite));
+    static_assert(uint32_t(DitherReference::ObjectHashType::Quads) == uint32_t(DitherVBuffer::ObjectHashType::Quads));
+    static_assert(uint32_t(DitherReference::ObjectHashType::Geometry) == uint32_t(DitherVBuffer::ObjectHashType::Geometry));
+    static_assert(uint32_t(DitherReference::CoverageCorrection::Disabled) == uint32_t(DitherVBuffer::CoverageCorrection::Disabled));
+    static_assert(uint32_t(DitherReference::CoverageCorrection::DLSS) == uint32_t(DitherVBuffer::CoverageCorrection::DLSS));
+    static_assert(uint32_t(DitherReference::CoverageCorrection::FSR) == uint32_t(DitherVBuffer::CoverageCorrection::FSR));
 }
 
 extern "C" FALCOR_API_EXPORT void registerPlugin(Falcor::PluginRegistry& registry)
@@ -56,8 +97,6 @@ DitherVBuffer::DitherVBuffer(ref<Device> pDevice, const Properties& props)
 {
     mpSampleGenerator = SampleGenerator::create(mpDevice, SAMPLE_GENERATOR_UNIFORM);
     mpSamplePattern = HaltonSamplePattern::create(16);
-    createNoisePattern();
-    setFractalDitherPattern(mFractalDitherPattern);
     Sampler::Desc sd;
     sd.setFilterMode(Sampler::Filter::Linear, Sampler::Filter::Linear, Sampler::Filter::Linear);
     sd.setAddressingMode(Sampler::AddressMode::Wrap, Sampler::AddressMode::Wrap, Sampler::AddressMode::Clamp);
@@ -66,11 +105,12 @@ DitherVBuffer::DitherVBuffer(ref<Device> pDevice, const Properties& props)
     sd.setAddressingMode(Sampler::AddressMode::Wrap, Sampler::AddressMode::Wrap, Sampler::AddressMode::Wrap);
     mpNoiseSampler = Sampler::create(mpDevice, sd);
 
-    // Generate permutation buffers for 2x2, 3x3, and 4x4 dither matrices
-    mpPermutations2x2Buffer = generatePermutations2x2(mpDevice);
-    mpPermutations3x3Buffer = generatePermutations3x3(mpDevice);
-    mpPermutations4x4Buffer = generatePermutations4x4(mpDevice);
-    mPermutations3x3Scores = getPermutationScores();
+    // Create permutation buffers for 2x2, 3x3, and 4x4 dither matrices from the precomputed tables
+    const auto& permutationTables = PermutationTables::get();
+    mpPermutations2x2Buffer = permutationTables.create2x2Buffer(mpDevice);
+    mpPermutations3x3Buffer = permutationTables.create3x3Buffer(mpDevice);
+    mpPermutations4x4Buffer = permutationTables.create4x4Buffer(mpDevice);
+    mPermutations3x3Scores = permutationTables.get3x3Scores();
     mPermutations3x3Score = mPermutations3x3Scores.empty() ? 0 : mPermutations3x3Scores[0];
     mPermutations3x3Dropdown.clear();
     for (const auto& score : mPermutations3x3Scores)
@@ -78,27 +118,23 @@ DitherVBuffer::DitherVBuffer(ref<Device> pDevice, const Properties& props)
         mPermutations3x3Dropdown.push_back(Gui::DropdownValue{ (uint)score, std::to_string(score) });
     }
 
-    mpBlueNoise3DTex = Texture::createFromFile(mpDevice, "dither/bluenoise3d_16.dds", false, false);
-    mpBlueNoise64Tex = Texture::createFromFile(mpDevice, "dither/bluenoise64.dds", false, false);
-    mpBayer64Tex = Texture::createFromFile(mpDevice, "dither/bayer64.dds", false, false);
-    mpSpatioTemporalBlueNoiseTex = Texture::createFromFile(mpDevice, "dither/spatiotemporal_bluenoise.dds", false, false);
-    mpSpatioTemporalBlueNoiseTex2 = Texture::createFromFile(mpDevice, "dither/spatiotemporal_bluenoise2.dds", false, false);
-
     // load properties
     for (const auto& [key, value] : props)
     {
         if (key == kUseWhitelist) mUseTransparencyWhitelist = value;
         else if (key == kWhitelist)
         {
-            std::stringstream ss;
             std::string svalue = value;
-            ss << svalue;
-            std::string entry;
-            while (std::getline(ss, entry, ','))
-            {
-                mTransparencyWhitelist.insert(entry);
-            }
+            mTransparencyWhitelist.setPatterns(TransparencyWhitelist::parse(svalue));
         }
+        else if (key == kAdaptiveDepthFar) mAdaptiveDepthFar = value;
+        else if (key == kAdaptiveDepthWeight) mAdaptiveDepthWeight = value;
+        else if (key == kAdaptiveFreqWeight) mAdaptiveFreqWeight = value;
+        else if (key == kAdaptiveAlphaWeight) mAdaptiveAlphaWeight = value;
+        else if (key == kAdaptiveFreqScale) mAdaptiveFreqScale = value;
+        else if (key == kAdaptiveNoiseBlend) mAdaptiveNoiseBlend = value;
+        else if (key == kRisRepeatPenalty) mRisRepeatPenalty = value;
+        else if (key == kRisNoveltyBoost) mRisNoveltyBoost = value;
     }
 }
 
@@ -107,9 +143,15 @@ Properties DitherVBuffer::getProperties() const
     Properties props;
     props[kUseWhitelist] = mUseTransparencyWhitelist;
     // convert whitelist into a comma separated string
-    std::stringstream ss;
-    for(const auto& entry : mTransparencyWhitelist) ss << entry << ",";
-    props[kWhitelist] = ss.str();
+    props[kWhitelist] = mTransparencyWhitelist.toString();
+    props[kAdaptiveDepthFar] = mAdaptiveDepthFar;
+    props[kAdaptiveDepthWeight] = mAdaptiveDepthWeight;
+    props[kAdaptiveFreqWeight] = mAdaptiveFreqWeight;
+    props[kAdaptiveAlphaWeight] = mAdaptiveAlphaWeight;
+    props[kAdaptiveFreqScale] = mAdaptiveFreqScale;
+    props[kAdaptiveNoiseBlend] = mAdaptiveNoiseBlend;
+    props[kRisRepeatPenalty] = mRisRepeatPenalty;
+    props[kRisNoveltyBoost] = mRisNoveltyBoost;
     return props;
 }
 
@@ -167,20 +209,15 @@ void DitherVBuffer::execute(RenderContext* pRenderContext, const RenderData& ren
     var["gMotion"] = pMotion;
     var["gOpacity"] = pOpacity;
     var["gColor"] = pColor;
-    var["gDitherTex"] = mpFracDitherTex;
-    var["gDitherRampTex"] = mpFracDitherRampTex;
+    updateNoiseTextures();
+    mNoiseTextures.bindShaderData(var);
     var["gDitherSampler"] = mpFracSampler;
-    var["gNoiseTex"] = mpNoiseTex;
     var["gNoiseSampler"] = mpNoiseSampler;
-    assert(mpTransparencyWhitelist);
-    var["gTransparencyWhitelist"] = mpTransparencyWhitelist;
+    assert(mTransparencyWhitelist.getBuffer());
+    var["gTransparencyWhitelist"] = mTransparencyWhitelist.getBuffer();
     var["gPermutations2x2"] = mpPermutations2x2Buffer;
     var["gPermutations3x3"] = mpPermutations3x3Buffer;
     var["gPermutations4x4"] = mpPermutations4x4Buffer;
-    var["gBlueNoise3DTex"] = mpBlueNoise3DTex;
-    var["gBlueNoise64x64Tex"] = mpBlueNoise64Tex;
-    var["gBayerNoise64Tex"] = mpBayer64Tex;
-    var["gSpatioTemporalBlueNoiseTex"] = mSTBNNoise == STBNNoise::Scalar ? mpSpatioTemporalBlueNoiseTex : mpSpatioTemporalBlueNoiseTex2;
     var["gRisHistoryIn"] = pRisHistoryIn;
     var["gRisHistoryOut"] = pRisHistoryOut;
 
@@ -190,7 +227,7 @@ void DitherVBuffer::execute(RenderContext* pRenderContext, const RenderData& ren
     var["PerFrame"]["gAlignMotionVectors"] = mAlignMotionVectors ? 1 : 0;
 
     var["DitherConstants"]["gGridScale"] = mGridScale;
-    var["DitherConstants"]["gNoiseScale"] = float2(1.0f / mpNoiseTex->getWidth(), 1.0f / mpNoiseTex->getHeight());
+    var["DitherConstants"]["gNoiseScale"] = mNoiseTextures.getNoiseScale();
     var["DitherConstants"]["gRotatePattern"] = mRotatePattern ? 1 : 0;
     var["DitherConstants"]["gObjectHashType"] = uint(mObjectHashType);
     var["DitherConstants"]["gNoiseTop"] = uint(mNoiseTopPattern);
@@ -264,8 +301,9 @@ void DitherVBuffer::execute(RenderContext* pRenderContext, const RenderData& ren
     // add whitelist to dict
     if (mUseTransparencyWhitelist)
     {
-        renderData.getDictionary()[kWhitelist] = mTransparencyWhitelist;
-        renderData.getDictionary()[kWhitelistBuffer] = mpTransparencyWhitelist;
+        // Resolved material names, so that passes with exact name lookups also see pattern matches.
+        renderData.getDictionary()[kWhitelist] = mTransparencyWhitelist.getMatchedNames();
+        renderData.getDictionary()[kWhitelistBuffer] = mTransparencyWhitelist.getBuffer();
     }
 }
 
@@ -279,10 +317,7 @@ void DitherVBuffer::renderUI(Gui::Widgets& widget)
     widget.dropdown("Dither", mDitherMode);
     if(mDitherMode == DitherMode::FractalDithering)
     {
-        if(widget.dropdown("Pattern", mFractalDitherPattern))
-        {
-            setFractalDitherPattern(mFractalDitherPattern);
-        }
+        widget.dropdown("Pattern", mFractalDitherPattern);
     }
 
     const bool is2DDither = mDitherMode == DitherMode::PerPixel2x2 ||
@@ -317,10 +352,7 @@ void DitherVBuffer::renderUI(Gui::Widgets& widget)
     }
     if (mDitherMode == DitherMode::HashGrid || useTopNoiseGrid)
     {
-        if (widget.dropdown("Noise Pattern", mNoisePattern))
-        {
-            createNoisePattern();
-        }
+        widget.dropdown("Noise Pattern", mNoisePattern);
     }
 
     if(mDitherMode == DitherMode::DitherTemporalAA)
@@ -376,10 +408,15 @@ void DitherVBuffer::renderUI(Gui::Widgets& widget)
     {
         if(g.dropdown("Score: ", mPermutations3x3Dropdown, mPermutations3x3Score))
         {
-            mpPermutations3x3Buffer = generatePermutations3x3(mpDevice, mPermutations3x3Score, mPermutations3x3Score);
+            mpPermutations3x3Buffer = PermutationTables::get().create3x3Buffer(mpDevice, mPermutations3x3Score, mPermutations3x3Score);
         }
     }
 
+    if (auto g = widget.group("Noise Textures"))
+    {
+        mNoiseTextures.renderUI(g);
+    }
+
     widget.dropdown("Correction", mCoverageCorrection);
     if (mCoverageCorrection != CoverageCorrection::Disabled)
     {
@@ -400,12 +437,18 @@ void DitherVBuffer::renderUI(Gui::Widgets& widget)
         if (mUseTransparencyWhitelist && mpScene)
         {
             auto g2 = widget.group("Whitelist");
-            std::string removeEntry;
+            std::string patterns = mTransparencyWhitelist.toString();
+            if (g2.textbox("Patterns", patterns))
+            {
+                mTransparencyWhitelist.setPatterns(TransparencyWhitelist::parse(patterns));
+                updateWhitelistBuffer();
+            }
+            g2.tooltip("Comma-separated material names, globs (*, ?, [a-z]) or regular expressions (re:<regex>).");
             // list all material names of the current scene
             for (uint mat = 0; mat < mpScene->getMaterialCount(); ++mat)
             {
                 std::string name = mpScene->getMaterial(MaterialID(mat))->getName();
-                bool isTransparent = mTransparencyWhitelist.find(name) != mTransparencyWhitelist.end();
+                bool isTransparent = mTransparencyWhitelist.isWhitelisted(mat);
                 if (g2.checkbox(name.c_str(), isTransparent))
                 {
                     if (isTransparent) mTransparencyWhitelist.insert(name);
@@ -437,26 +480,6 @@ void DitherVBuffer::setScene(RenderContext* pRenderContext, const ref<Scene>& pS
     mRisHistoryValid = false;
 }
 
-void DitherVBuffer::setFractalDitherPattern(DitherPattern pattern)
-{
-    mFractalDitherPattern = pattern;
-    std::string texname;
-    switch(pattern)
-    {
-    case DitherPattern::Dither2x2:
-        texname = "dither/Dither3D_2x2";
-        break;
-    case DitherPattern::Dither4x4:
-        texname = "dither/Dither3D_4x4";
-        break;
-    case DitherPattern::Dither8x8:
-        texname = "dither/Dither3D_8x8";
-        break;
-    }
-    mpFracDitherTex = Texture::createFromFile(mpDevice, texname + ".dds", false, false);
-    mpFracDitherRampTex = Texture::createFromFile(mpDevice, texname + "_ramp.dds", false, false);
-}
-
 void DitherVBuffer::setupProgram()
 {
     if (!mpScene) return;
@@ -491,38 +514,10 @@ void DitherVBuffer::setupProgram()
 
 bool DitherVBuffer::updateWhitelistBuffer()
 {
-    return updateWhitelist(mpDevice, mpScene, mTransparencyWhitelist, mpTransparencyWhitelist);
+    return mTransparencyWhitelist.update(mpDevice, mpScene);
 }
 
-void DitherVBuffer::createNoisePattern()
+void DitherVBuffer::updateNoiseTextures()
 {
-    std::string texname;
-    switch (mNoisePattern)
-    {
-    case NoisePattern::White:
-        texname = "dither/whitenoise1024.dds";
-        break;
-    case NoisePattern::Blue:
-        texname = "dither/bluenoise1024.dds";
-        break;
-    case NoisePattern::Bayer:
-        texname = "dither/bayer_matrix.dds";
-        break;
-    case NoisePattern::BlueBayer:
-        texname = "dither/blue_bayer.dds";
-        break;
-    case NoisePattern::Poisson:
-        texname = "dither/poisson1024.dds";
-        break;
-    case NoisePattern::Perlin:
-        texname = "dither/perlin1024.dds";
-        break;
-    case NoisePattern::Blue64:
-        texname = "dither/bluenoise64.dds";
-        break;
-    default:
-        assert(false);
-    }
-
-    mpNoiseTex = Texture::createFromFile(mpDevice, texname, false, false);
+    mNoiseTextures.update(mpDevice, getNoiseTexturePaths(mDitherMode, mNoiseTopPattern, mNoisePattern, mSTBNNoise, mFractalDitherPattern));
 }
@@ -31,6 +31,7 @@
 #include "Utils/SampleGenerators/HaltonSamplePattern.h"
 #include "Utils/SampleGenerators/StratifiedSamplePattern.h"
 #include "TransparencyWhitelist.h"
+#include "NoiseTextures.h"
 
 
 using namespace Falcor;
@@ -280,21 +281,24 @@ public:
         res = max(res, uint2(1));
         return res;
     }
+
+    // data paths of the noise textures that the shader samples with the given settings
+    static NoiseTextureSet::Paths getNoiseTexturePaths(DitherMode mode, NoiseTopPattern noiseTop, NoisePattern noisePattern, STBNNoise stbnNoise, DitherPattern fractalPattern);
+    static std::string getNoisePatternPath(NoisePattern pattern);
+    static std::string getFractalPatternPath(DitherPattern pattern);
 private:
-    
-    void setFractalDitherPattern(DitherPattern pattern);
 
     void setupProgram();
     // returns true if at least one material was whitelisted (or scene was invalid)
     bool updateWhitelistBuffer();
-    void createNoisePattern();
+    // loads the noise textures used by the current settings and releases the others
+    void updateNoiseTextures();
 
     ref<Scene> mpScene;
     
     ref<RtProgram> mpProgram;
     ref<RtProgramVars> mpVars;
     ref<SampleGenerator> mpSampleGenerator;
-    ref<Buffer> mpTransparencyWhitelist;
     ref<Buffer> mpPermutations2x2Buffer;
     ref<Buffer> mpPermutations3x3Buffer;
     ref<Buffer> mpPermutations4x4Buffer;
@@ -306,23 +310,16 @@ private:
     DitherMode mDitherMode = DitherMode::PerPixel3x3;
     bool mUseAlphaTextureLOD = false; // use lod for alpha lookups
     bool mUseTransparencyWhitelist = false;
-    whitelist_t mTransparencyWhitelist;
+    TransparencyWhitelist mTransparencyWhitelist;
     CoverageCorrection mCoverageCorrection = CoverageCorrection::DLSS;
     float mDLSSCorrectionStrength = 1.0;
     DitherPattern mFractalDitherPattern = DitherPattern::Dither8x8;
     float mGridScale = 0.5f;
     ObjectHashType mObjectHashType = ObjectHashType::Geometry;
 
-    ref<Texture> mpFracDitherTex;
-    ref<Texture> mpFracDitherRampTex;
     ref<Sampler> mpFracSampler;
-    ref<Texture> mpNoiseTex;
     ref<Sampler> mpNoiseSampler;
-    ref<Texture> mpBlueNoise3DTex;
-    ref<Texture> mpBlueNoise64Tex;
-    ref<Texture> mpBayer64Tex;
-    ref<Texture> mpSpatioTemporalBlueNoiseTex;
-    ref<Texture> mpSpatioTemporalBlueNoiseTex2;
+    NoiseTextureSet mNoiseTextures;
     ref<Texture> mpRisHistory[2];
     uint32_t mRisHistoryReadIndex = 0;
     bool mRisHistoryValid = false;
@@ -355,6 +352,84 @@ private:
 
 };
 
+inline NoiseTextureSet::Paths DitherVBuffer::getNoiseTexturePaths(DitherMode mode, NoiseTopPattern noiseTop, NoisePattern noisePattern, STBNNoise stbnNoise, DitherPattern fractalPattern)
+{
+    using Slot = NoiseTextureSet::Slot;
+    NoiseTextureSet::Paths paths;
+    auto set = [&](Slot slot, std::string path) { paths[size_t(slot)] = std::move(path); };
+
+    // modes that call getTopNoise() in Dither.slangh
+    const bool usesTopNoise = mode == DitherMode::PerPixel2x2 || mode == DitherMode::PerPixel3x3 || mode == DitherMode::PerPixel4x4 ||
+        mode == DitherMode::PerPixel2x2x2 || mode == DitherMode::DitherTemporalAA || mode == DitherMode::Adaptive;
+    if (usesTopNoise)
+    {
+        switch (noiseTop)
+        {
+        case NoiseTopPattern::StaticBlue:
+            set(Slot::BlueNoise64, "dither/bluenoise64.dds");
+            break;
+        case NoiseTopPattern::DynamicBlue:
+            set(Slot::BlueNoise3D, "dither/bluenoise3d_16.dds");
+            break;
+        case NoiseTopPattern::StaticBayer:
+            set(Slot::Bayer64, "dither/bayer64.dds");
+            break;
+        case NoiseTopPattern::SurfaceWhite:
+            set(Slot::Noise, getNoisePatternPath(noisePattern));
+            break;
+        default:
+            break;
+        }
+    }
+
+    switch (mode)
+    {
+    case DitherMode::HashGrid:
+        set(Slot::Noise, getNoisePatternPath(noisePattern));
+        break;
+    case DitherMode::BlueNoise3D:
+        set(Slot::BlueNoise3D, "dither/bluenoise3d_16.dds");
+        break;
+    case DitherMode::SpatioTemporalBlueNoise:
+    case DitherMode::SurfaceSpatioTemporalBlueNoise:
+        set(Slot::SpatioTemporal, stbnNoise == STBNNoise::Scalar ? "dither/spatiotemporal_bluenoise.dds" : "dither/spatiotemporal_bluenoise2.dds");
+        break;
+    case DitherMode::FractalDithering:
+        set(Slot::FracDither, getFractalPatternPath(fractalPattern) + ".dds");
+        set(Slot::FracDitherRamp, getFractalPatternPath(fractalPattern) + "_ramp.dds");
+        break;
+    default:
+        break;
+    }
+    return paths;
+}
+
+inline std::string DitherVBuffer::getNoisePatternPath(NoisePattern pattern)
+{
+    switch (pattern)
+    {
+    case NoisePattern::White: return "dither/whitenoise1024.dds";
+    case NoisePattern::Blue: return "dither/bluenoise1024.dds";
+    case NoisePattern::Bayer: return "dither/bayer_matrix.dds";
+    case NoisePattern::BlueBayer: return "dither/blue_bayer.dds";
+    case NoisePattern::Poisson: return "dither/poisson1024.dds";
+    case NoisePattern::Perlin: return "dither/perlin1024.dds";
+    case NoisePattern::Blue64: return "dither/bluenoise64.dds";
+    default: assert(false); return {};
+    }
+}
+
+inline std::string DitherVBuffer::getFractalPatternPath(DitherPattern pattern)
+{
+    switch (pattern)
+    {
+    case DitherPattern::Dither2x2: return "dither/Dither3D_2x2";
+    case DitherPattern::Dither4x4: return "dither/Dither3D_4x4";
+    case DitherPattern::Dither8x8: return "dither/Dither3D_8x8";
+    default: assert(false); return {};
+    }
+}
+
 FALCOR_ENUM_REGISTER(DitherVBuffer::DitherMode);
 FALCOR_ENUM_REGISTER(DitherVBuffer::CoverageCorrection);
 FALCOR_ENUM_REGISTER(DitherVBuffer::DitherPattern);
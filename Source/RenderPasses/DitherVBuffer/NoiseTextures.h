@@ -0,0 +1,188 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Falcor.h"
+#include "Utils/SharedCache.h"
+#include <array>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace Falcor
+{
+/** Dither noise textures, loaded on first use and shared between pass instances.
+
+    NoiseTextures::acquire() returns a shared handle to a texture from the data directory.
+    The process-wide cache only holds weak references, so a texture stays resident while at
+    least one pass holds a handle and is released with the last one.
+
+    NoiseTextureSet holds the handles of a single pass. It is updated with the paths the shader
+    samples in the active dither configuration (see DitherVBuffer::getNoiseTexturePaths()).
+*/
+class NoiseTextures
+{
+public:
+    struct Entry
+    {
+        std::string path;
+        ref<Texture> pTexture; ///< nullptr if the file could not be loaded.
+        uint64_t sizeInBytes = 0;
+    };
+
+    using Handle = std::shared_ptr<const Entry>;
+
+    struct Stats
+    {
+        uint32_t textureCount = 0;  ///< Textures currently held by at least one pass.
+        uint64_t residentBytes = 0; ///< GPU allocation size of those textures.
+    };
+
+    /// Returns the texture at the given data path, loading it if no pass holds it yet.
+    static Handle acquire(const ref<Device>& pDevice, const std::string& path)
+    {
+        return getCache().acquire(
+            { pDevice.get(), path },
+            [&]()
+            {
+                auto pEntry = std::make_shared<Entry>();
+                pEntry->path = path;
+                pEntry->pTexture = Texture::createFromFile(pDevice, path, false, false);
+                if (pEntry->pTexture) pEntry->sizeInBytes = pEntry->pTexture->getTextureSizeInBytes();
+                else logWarning("Failed to load dither noise texture '{}'.", path);
+                return pEntry;
+            }
+        );
+    }
+
+    /// Returns the resident textures over all devices.
+    static Stats getStats()
+    {
+        auto& cache = getCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        Stats stats;
+        for (const auto& [key, weak] : cache.cache)
+        {
+            if (auto pEntry = weak.lock())
+            {
+                stats.textureCount++;
+                stats.residentBytes += pEntry->sizeInBytes;
+            }
+        }
+        return stats;
+    }
+
+private:
+    using Key = std::pair<Device*, std::string>;
+
+    static SharedCache<const Entry, Key>& getCache()
+    {
+        static SharedCache<const Entry, Key> sCache;
+        return sCache;
+    }
+};
+
+class NoiseTextureSet
+{
+public:
+    enum class Slot : uint32_t
+    {
+        Noise,              ///< gNoiseTex: hash grid noise (HashGrid, surface noise on top)
+        BlueNoise64,        ///< gBlueNoise64x64Tex: static blue noise on top
+        BlueNoise3D,        ///< gBlueNoise3DTex: BlueNoise3D mode, dynamic blue noise on top
+        Bayer64,            ///< gBayerNoise64Tex: static bayer noise on top
+        SpatioTemporal,     ///< gSpatioTemporalBlueNoiseTex: STBN modes
+        FracDither,         ///< gDitherTex: fractal dithering
+        FracDitherRamp,     ///< gDitherRampTex: fractal dithering
+        Count
+    };
+
+    static constexpr size_t kSlotCount = size_t(Slot::Count);
+
+    /// Data path per slot. An empty path means the slot is not sampled.
+    using Paths = std::array<std::string, kSlotCount>;
+
+    /** Acquires the textures of all slots with a path and releases the others.
+        Cheap when the paths did not change, so it can be called every frame.
+    */
+    void update(const ref<Device>& pDevice, const Paths& paths)
+    {
+        for (size_t i = 0; i < kSlotCount; ++i)
+        {
+            auto& pHandle = mHandles[i];
+            if (paths[i].empty()) pHandle.reset();
+            else if (!pHandle || pHandle->path != paths[i]) pHandle = NoiseTextures::acquire(pDevice, paths[i]);
+        }
+    }
+
+    /// Returns the texture in the slot, or nullptr if the slot has no path.
+    const ref<Texture>& get(Slot slot) const
+    {
+        static const ref<Texture> kNull;
+        const auto& pHandle = mHandles[size_t(slot)];
+        return pHandle ? pHandle->pTexture : kNull;
+    }
+
+    /// Scale for normalized lookups into gNoiseTex.
+    float2 getNoiseScale() const
+    {
+        const auto& pNoise = get(Slot::Noise);
+        return pNoise ? float2(1.0f / pNoise->getWidth(), 1.0f / pNoise->getHeight()) : float2(0.0f);
+    }
+
+    void bindShaderData(const ShaderVar& var) const
+    {
+        var["gNoiseTex"] = get(Slot::Noise);
+        var["gBlueNoise64x64Tex"] = get(Slot::BlueNoise64);
+        var["gBlueNoise3DTex"] = get(Slot::BlueNoise3D);
+        var["gBayerNoise64Tex"] = get(Slot::Bayer64);
+        var["gDitherTex"] = get(Slot::FracDither);
+        var["gDitherRampTex"] = get(Slot::FracDitherRamp);
+        var["gSpatioTemporalBlueNoiseTex"] = get(Slot::SpatioTemporal);
+    }
+
+    /// Size of the textures held by this set (shared textures are counted by every holder).
+    uint64_t getSizeInBytes() const
+    {
+        uint64_t size = 0;
+        for (const auto& pHandle : mHandles)
+            if (pHandle) size += pHandle->sizeInBytes;
+        return size;
+    }
+
+    void renderUI(Gui::Widgets& widget) const
+    {
+        const auto stats = NoiseTextures::getStats();
+        std::string text = fmt::format("Noise textures: {:.1f} MB in this pass", getSizeInBytes() / (1024.0 * 1024.0));
+        text += fmt::format("\nResident (all passes): {} textures, {:.1f} MB", stats.textureCount, stats.residentBytes / (1024.0 * 1024.0));
+        widget.text(text);
+    }
+
+private:
+    std::array<NoiseTextures::Handle, kSlotCount> mHandles;
+};
+} // namespace Falcor
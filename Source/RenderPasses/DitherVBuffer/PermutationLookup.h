@@ -55,18 +55,9 @@ inline int scorePermutation(const std::array<int, T* T>& indices) {
     return sumInverseDist;
 }
 
+// Select the best permutations from a list of scored permutations (in enumeration order)
 template<int T>
-inline std::vector<std::array<int, T* T>> generateBestPermutations(size_t maxResults = size_t(-1)) {
-    std::array<int, T * T> indices;
-    std::iota(indices.begin(), indices.end(), 0);
-
-    std::vector<std::pair<int, std::array<int, T* T>>> scoredPermutations;
-
-    do {
-        int score = scorePermutation<T>(indices);
-        scoredPermutations.push_back({ score, indices });
-    } while (std::next_permutation(indices.begin(), indices.end()));
-
+inline std::vector<std::array<int, T* T>> selectBestPermutations(std::vector<std::pair<int, std::array<int, T* T>>> scoredPermutations, size_t maxResults = size_t(-1)) {
     // Sort permutations by best score (higher is better)
     std::sort(scoredPermutations.begin(), scoredPermutations.end(),
         [](const auto& a, const auto& b) { return a.first > b.first; });
@@ -136,6 +127,21 @@ inline std::vector<std::array<int, T* T>> generateBestPermutations(size_t maxRes
     return bestPermutations;
 }
 
+template<int T>
+inline std::vector<std::array<int, T* T>> generateBestPermutations(size_t maxResults = size_t(-1)) {
+    std::array<int, T * T> indices;
+    std::iota(indices.begin(), indices.end(), 0);
+
+    std::vector<std::pair<int, std::array<int, T* T>>> scoredPermutations;
+
+    do {
+        int score = scorePermutation<T>(indices);
+        scoredPermutations.push_back({ score, indices });
+    } while (std::next_permutation(indices.begin(), indices.end()));
+
+    return selectBestPermutations<T>(std::move(scoredPermutations), maxResults);
+}
+
 // Function to pack 4 values (0-3) into a single uint32_t using 4 bits per value
 inline uint32_t packPermutation2x2(const std::array<int, 4>& indices) {
     uint32_t packed = 0;
@@ -188,7 +194,7 @@ std::vector<std::array<int, T* T>> removeOverlapping(std::vector<std::array<int,
 }
 
 
-inline ref<Buffer> generatePermutations3x3(ref<Device> pDevice)
+inline Falcor::ref<Falcor::Buffer> generatePermutations3x3(Falcor::ref<Falcor::Device> pDevice)
 {
     // generate permutations, ranked from best to worst, exlcuding permutations with succesive values next to each other
     auto perms = generateBestPermutations<3>(288); // 
@@ -199,10 +205,10 @@ inline ref<Buffer> generatePermutations3x3(ref<Device> pDevice)
     std::vector<uint32_t> packed(perms.size());
     std::transform(perms.begin(), perms.end(), packed.begin(), packPermutation);
 
-    return Buffer::createStructured(pDevice, sizeof(packed[0]), packed.size(), ResourceBindFlags::ShaderResource, Buffer::CpuAccess::None, packed.data(), false);
+    return Falcor::Buffer::createStructured(pDevice, sizeof(packed[0]), packed.size(), Falcor::ResourceBindFlags::ShaderResource, Falcor::Buffer::CpuAccess::None, packed.data(), false);
 }
 
-inline ref<Buffer> generatePermutations3x3(ref<Device> pDevice, int minScore, int maxScore)
+inline Falcor::ref<Falcor::Buffer> generatePermutations3x3(Falcor::ref<Falcor::Device> pDevice, int minScore, int maxScore)
 {
     std::array<int, 3 * 3> indices;
     std::iota(indices.begin(), indices.end(), 0);
@@ -220,7 +226,7 @@ inline ref<Buffer> generatePermutations3x3(ref<Device> pDevice, int minScore, in
     std::vector<uint32_t> packed(perms.size());
     std::transform(perms.begin(), perms.end(), packed.begin(), packPermutation);
 
-    return Buffer::createStructured(pDevice, sizeof(packed[0]), packed.size(), ResourceBindFlags::ShaderResource, Buffer::CpuAccess::None, packed.data(), false);
+    return Falcor::Buffer::createStructured(pDevice, sizeof(packed[0]), packed.size(), Falcor::ResourceBindFlags::ShaderResource, Falcor::Buffer::CpuAccess::None, packed.data(), false);
 }
 
 template<int T = 3>
@@ -246,7 +252,7 @@ inline std::vector<int> getPermutationScores()
 // 2x2 Dither Matrix Generation
 // ============================================================================
 
-inline ref<Buffer> generatePermutations2x2(ref<Device> pDevice)
+inline Falcor::ref<Falcor::Buffer> generatePermutations2x2(Falcor::ref<Falcor::Device> pDevice)
 {
     // 2x2 has 4! = 24 permutations
     // Note: For 2x2, the "no successive elements" constraint is impossible to satisfy
@@ -265,7 +271,7 @@ inline ref<Buffer> generatePermutations2x2(ref<Device> pDevice)
     std::vector<uint32_t> packed(allPerms.size());
     std::transform(allPerms.begin(), allPerms.end(), packed.begin(), packPermutation2x2);
 
-    return Buffer::createStructured(pDevice, sizeof(packed[0]), packed.size(), ResourceBindFlags::ShaderResource, Buffer::CpuAccess::None, packed.data(), false);
+    return Falcor::Buffer::createStructured(pDevice, sizeof(packed[0]), packed.size(), Falcor::ResourceBindFlags::ShaderResource, Falcor::Buffer::CpuAccess::None, packed.data(), false);
 }
 
 // ============================================================================
@@ -291,101 +297,6 @@ inline Packed4x4Matrix packPermutation4x4(const std::array<int, 16>& indices) {
     return packed;
 }
 
-// Generate 4x4 permutations using random sampling (16! is too large for exhaustive search)
-// Uses simulated annealing to find good permutations
-inline std::vector<std::array<int, 16>> generateBestPermutations4x4(size_t maxResults, size_t iterations = 1000000) {
-    std::vector<std::pair<int, std::array<int, 16>>> bestPerms;
-    
-    // Start with Bayer matrix as initial guess
-    std::array<int, 16> current = {
-        0, 8, 2, 10,
-        12, 4, 14, 6,
-        3, 11, 1, 9,
-        15, 7, 13, 5
-    };
-    
-    int currentScore = scorePermutation<4>(current);
-    
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, 15);
-    std::uniform_real_distribution<> disReal(0.0, 1.0);
-    
-    double temperature = 100.0;
-    double coolingRate = 0.9999;
-    
-    for (size_t iter = 0; iter < iterations; ++iter) {
-        // Create neighbor by swapping two random positions
-        auto neighbor = current;
-        int i = dis(gen);
-        int j = dis(gen);
-        if (i != j) {
-            std::swap(neighbor[i], neighbor[j]);
-        }
-        
-        int neighborScore = scorePermutation<4>(neighbor);
-        
-        // Accept if better or with probability based on temperature
-        if (neighborScore > currentScore) {
-            current = neighbor;
-            currentScore = neighborScore;
-        } else if (neighborScore > 0 && disReal(gen) < std::exp((neighborScore - currentScore) / temperature)) {
-            current = neighbor;
-            currentScore = neighborScore;
-        }
-        
-        temperature *= coolingRate;
-        
-        // Store good permutations
-        if (currentScore > 0) {
-            bool found = false;
-            for (const auto& p : bestPerms) {
-                if (p.second == current) {
-                    found = true;
-                    break;
-                }
-            }
-            if (!found) {
-                bestPerms.push_back({currentScore, current});
-            }
-        }
-    }
-    
-    // Sort by score (higher is better)
-    std::sort(bestPerms.begin(), bestPerms.end(),
-        [](const auto& a, const auto& b) { return a.first > b.first; });
-    
-    // Return top results
-    std::vector<std::array<int, 16>> result;
-    for (size_t i = 0; i < std::min(maxResults, bestPerms.size()); ++i) {
-        if (bestPerms[i].first == 0) break;
-        result.push_back(bestPerms[i].second);
-    }
-    
-    return result;
-}
-
-inline ref<Buffer> generatePermutations4x4(ref<Device> pDevice, size_t maxResults = 256, size_t iterations = 1000000)
-{
-    auto perms = generateBestPermutations4x4(maxResults, iterations);
-    std::cout << "4x4 Permutations found: " << perms.size() << "\n";
-    
-    if (perms.empty()) {
-        // Fallback: use Bayer matrix if no good permutations found
-        perms.push_back({
-            0, 8, 2, 10,
-            12, 4, 14, 6,
-            3, 11, 1, 9,
-            15, 7, 13, 5
-        });
-    }
-
-    std::vector<Packed4x4Matrix> packed(perms.size());
-    std::transform(perms.begin(), perms.end(), packed.begin(), packPermutation4x4);
-
-    return Buffer::createStructured(pDevice, sizeof(packed[0]), packed.size(), ResourceBindFlags::ShaderResource, Buffer::CpuAccess::None, packed.data(), false);
-}
-
 // Get permutation scores for 2x2 and 4x4
 template<>
 inline std::vector<int> getPermutationScores<2>()
@@ -0,0 +1,276 @@
+#pragma once
+#include "PermutationLookup.h"
+#include "Core/Platform/OS.h"
+#if FALCOR_HAS_AVX2_TARGET
+#include <immintrin.h>
+#endif
+
+/** Fast scoring of dither permutations.
+
+    All functions return exactly the same values as scorePermutation<T>:
+    the sum of squared value differences over all right/bottom torus edges, or 0 if any edge
+    connects successive values (squared difference of 1).
+*/
+
+/** Incremental score of a single permutation.
+    Keeps the edge sum and the number of "successive" edges, so that the score after swapping
+    two cells can be evaluated in O(1) by only revisiting the (at most 8) edges touching them.
+*/
+template<int T>
+class IncrementalPermutationScore
+{
+public:
+    static constexpr int N = T * T;
+
+    IncrementalPermutationScore() = default;
+    explicit IncrementalPermutationScore(const std::array<int, N>& indices) { reset(indices); }
+
+    void reset(const std::array<int, N>& indices)
+    {
+        mIndices = indices;
+        mSum = 0;
+        mSuccessiveEdges = 0;
+        for (int c = 0; c < N; ++c)
+        {
+            for (int dir = 0; dir < 2; ++dir)
+            {
+                int cost = edgeCost(mIndices[c], mIndices[neighbor(c, dir)]);
+                mSum += cost;
+                mSuccessiveEdges += cost == 1 ? 1 : 0;
+            }
+        }
+    }
+
+    const std::array<int, N>& getIndices() const { return mIndices; }
+
+    int score() const { return mSuccessiveEdges > 0 ? 0 : mSum; }
+
+    /// Score after swapping the cells i and j, without modifying the state.
+    int scoreAfterSwap(int i, int j) const
+    {
+        // Any touched edge with cost 1 exists after the swap, so the score is 0 (same early-out as scorePermutation).
+        const int vi = mIndices[i], vj = mIndices[j];
+        int sum = mSum;
+        int successive = mSuccessiveEdges;
+        for (int k = 0; k < 4; ++k)
+        {
+            int n = kAdjacency.cells[i][k];
+            int oldValue = mIndices[n];
+            int newCost = edgeCost(vj, n == j ? vi : oldValue);
+            if (newCost == 1) return 0;
+            int oldCost = edgeCost(vi, oldValue);
+            sum += newCost - oldCost;
+            successive -= int(oldCost == 1);
+        }
+        for (int k = 0; k < 4; ++k)
+        {
+            int n = kAdjacency.cells[j][k];
+            int oldValue = mIndices[n];
+            int newCost = edgeCost(vi, n == i ? vj : oldValue);
+            if (newCost == 1) return 0;
+            int oldCost = edgeCost(vj, oldValue);
+            sum += newCost - oldCost;
+            successive -= int(oldCost == 1);
+        }
+        return successive > 0 ? 0 : sum;
+    }
+
+    /// Swap the cells i and j and update the score.
+    void applySwap(int i, int j)
+    {
+        evalSwap(i, j, mSum, mSuccessiveEdges);
+        std::swap(mIndices[i], mIndices[j]);
+    }
+
+private:
+    static int edgeCost(int a, int b) { return (a - b) * (a - b); }
+
+    /// Neighbor of cell c in direction dir (0 = right, 1 = bottom) on the torus.
+    static int neighbor(int c, int dir)
+    {
+        int x = c % T, y = c / T;
+        return dir == 0 ? (x + 1) % T + T * y : x + T * ((y + 1) % T);
+    }
+
+    /// Other endpoints of the 4 edges touching each cell (right, bottom, left, top).
+    /// For T = 2 left/right and top/bottom coincide, but they are still distinct edges.
+    struct Adjacency
+    {
+        int cells[N][4] = {};
+
+        constexpr Adjacency()
+        {
+            for (int c = 0; c < N; ++c)
+            {
+                int x = c % T, y = c / T;
+                cells[c][0] = (x + 1) % T + T * y;
+                cells[c][1] = x + T * ((y + 1) % T);
+                cells[c][2] = (x + T - 1) % T + T * y;
+                cells[c][3] = x + T * ((y + T - 1) % T);
+            }
+        }
+    };
+
+    static constexpr Adjacency kAdjacency{};
+
+    void evalSwap(int i, int j, int& sum, int& successive) const
+    {
+        sum = mSum;
+        successive = mSuccessiveEdges;
+
+        // Only edges touching i or j change. Neighbor values are read after the swap, so edges
+        // between i and j (and the case i == j) contribute a delta of zero without branching.
+        const int vi = mIndices[i], vj = mIndices[j];
+        for (int k = 0; k < 4; ++k)
+        {
+            int n = kAdjacency.cells[i][k];
+            int vn = n == j ? vi : mIndices[n];
+            int oldCost = edgeCost(vi, mIndices[n]);
+            int newCost = edgeCost(vj, vn);
+            sum += newCost - oldCost;
+            successive += int(newCost == 1) - int(oldCost == 1);
+        }
+        for (int k = 0; k < 4; ++k)
+        {
+            int n = kAdjacency.cells[j][k];
+            int vn = n == i ? vj : mIndices[n];
+            int oldCost = edgeCost(vj, mIndices[n]);
+            int newCost = edgeCost(vi, vn);
+            sum += newCost - oldCost;
+            successive += int(newCost == 1) - int(oldCost == 1);
+        }
+    }
+
+    std::array<int, N> mIndices{};
+    int mSum = 0;
+    int mSuccessiveEdges = 0;
+};
+
+/** Batch of candidate permutations in structure-of-arrays layout (one 16-bit lane per candidate).
+    With 16-bit lanes the maximum score of a 4x4 matrix (32 edges * 15^2) still fits, which allows
+    scoring 16 candidates per AVX2 instruction.
+*/
+template<int T>
+struct PermutationBatch
+{
+    static_assert(T >= 2 && T <= 4, "16-bit lanes only cover matrices up to 4x4");
+    static constexpr int N = T * T;
+    static constexpr size_t kWidth = 16;
+
+    alignas(32) int16_t cells[N][kWidth] = {};
+
+    void set(size_t lane, const std::array<int, N>& indices)
+    {
+        for (int c = 0; c < N; ++c) cells[c][lane] = int16_t(indices[c]);
+    }
+};
+
+#if FALCOR_HAS_AVX2_TARGET
+/// AVX2 path of scorePermutationBatch().
+template<int T>
+FALCOR_TARGET_AVX2 inline void scorePermutationBatchAVX2(const PermutationBatch<T>& batch, int* pScores)
+{
+    constexpr size_t kWidth = PermutationBatch<T>::kWidth;
+    const __m256i one = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    __m256i successive = _mm256_setzero_si256();
+    for (int y = 0; y < T; ++y)
+    {
+        for (int x = 0; x < T; ++x)
+        {
+            __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(batch.cells[x + T * y]));
+            __m256i r = _mm256_load_si256(reinterpret_cast<const __m256i*>(batch.cells[(x + 1) % T + T * y]));
+            __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(batch.cells[x + T * ((y + 1) % T)]));
+            __m256i dr = _mm256_sub_epi16(v, r);
+            __m256i db = _mm256_sub_epi16(v, b);
+            dr = _mm256_mullo_epi16(dr, dr);
+            db = _mm256_mullo_epi16(db, db);
+            successive = _mm256_or_si256(successive, _mm256_or_si256(_mm256_cmpeq_epi16(dr, one), _mm256_cmpeq_epi16(db, one)));
+            sum = _mm256_add_epi16(sum, _mm256_add_epi16(dr, db));
+        }
+    }
+    alignas(32) int16_t scores[kWidth];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(scores), _mm256_andnot_si256(successive, sum));
+    for (size_t lane = 0; lane < kWidth; ++lane) pScores[lane] = scores[lane];
+}
+#endif
+
+/// Score all kWidth candidates of a batch.
+template<int T>
+inline void scorePermutationBatch(const PermutationBatch<T>& batch, int* pScores)
+{
+#if FALCOR_HAS_AVX2_TARGET
+    if (Falcor::isAVX2Supported())
+    {
+        scorePermutationBatchAVX2<T>(batch, pScores);
+        return;
+    }
+#endif
+
+    constexpr size_t kWidth = PermutationBatch<T>::kWidth;
+    // Lane-parallel scalar fallback (auto-vectorizes well).
+    int16_t sum[kWidth] = {};
+    int16_t successive[kWidth] = {};
+    for (int y = 0; y < T; ++y)
+    {
+        for (int x = 0; x < T; ++x)
+        {
+            const int16_t* v = batch.cells[x + T * y];
+            const int16_t* r = batch.cells[(x + 1) % T + T * y];
+            const int16_t* b = batch.cells[x + T * ((y + 1) % T)];
+            for (size_t lane = 0; lane < kWidth; ++lane)
+            {
+                int16_t dr = int16_t((v[lane] - r[lane]) * (v[lane] - r[lane]));
+                int16_t db = int16_t((v[lane] - b[lane]) * (v[lane] - b[lane]));
+                successive[lane] |= int16_t(dr == 1) | int16_t(db == 1);
+                sum[lane] += dr + db;
+            }
+        }
+    }
+    for (size_t lane = 0; lane < kWidth; ++lane) pScores[lane] = successive[lane] ? 0 : sum[lane];
+}
+
+/// Score count permutations. Full batches go through scorePermutationBatch, the remainder is scored one by one.
+template<int T>
+inline void scorePermutations(const std::array<int, T * T>* pPerms, size_t count, int* pScores)
+{
+    constexpr size_t kWidth = PermutationBatch<T>::kWidth;
+    PermutationBatch<T> batch;
+    size_t i = 0;
+    for (; i + kWidth <= count; i += kWidth)
+    {
+        for (size_t lane = 0; lane < kWidth; ++lane) batch.set(lane, pPerms[i + lane]);
+        scorePermutationBatch<T>(batch, pScores + i);
+    }
+    for (; i < count; ++i) pScores[i] = scorePermutation<T>(pPerms[i]);
+}
+
+/** Enumerate all permutations of [0, T*T) in lexicographic order and call func(indices, score) for each.
+    Permutations are scored in batches of PermutationBatch<T>::kWidth.
+*/
+template<int T, typename Func>
+inline void forEachScoredPermutation(Func func)
+{
+    constexpr size_t kWidth = PermutationBatch<T>::kWidth;
+    std::array<std::array<int, T * T>, kWidth> perms;
+    PermutationBatch<T> batch;
+    int scores[kWidth];
+
+    std::array<int, T * T> indices;
+    std::iota(indices.begin(), indices.end(), 0);
+    size_t lane = 0;
+    bool more = true;
+    while (more)
+    {
+        perms[lane] = indices;
+        batch.set(lane, indices);
+        more = std::next_permutation(indices.begin(), indices.end());
+        if (++lane == kWidth || !more)
+        {
+            if (lane == kWidth) scorePermutationBatch<T>(batch, scores);
+            else for (size_t k = 0; k < lane; ++k) scores[k] = scorePermutation<T>(perms[k]);
+            for (size_t k = 0; k < lane; ++k) func(perms[k], scores[k]);
+            lane = 0;
+        }
+    }
+}
@@ -0,0 +1,284 @@
+#pragma once
+#include "Falcor.h"
+#include "PermutationLookup.h"
+#include "PermutationScoring.h"
+#include "Utils/Timing/CpuTimer.h"
+#include <atomic>
+#include <thread>
+
+/** Parallel, deterministic simulated-annealing search for 4x4 dither matrices.
+
+    Runs independent annealing chains on a pool of worker threads. Every accepted state with a
+    non-zero score is recorded in a lock-free hash set of packed 64-bit matrices, which replaces
+    the linear duplicate scan of the original single-chain search.
+
+    Each chain draws from its own generator seeded from (seed, chain index), and the final list is
+    sorted by (score, packed matrix). The result therefore only depends on the seed, the chain count
+    and the chain parameters, not on thread scheduling or on the number of worker threads.
+*/
+namespace PermutationSearch
+{
+    /// Small deterministic generator (SplitMix64). Unlike std distributions, results are identical across standard libraries.
+    struct SplitMix64
+    {
+        uint64_t state;
+
+        explicit SplitMix64(uint64_t seed) : state(seed) {}
+
+        uint64_t next()
+        {
+            uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31);
+        }
+
+        /// Uniform integer in [0, n).
+        uint32_t nextBelow(uint32_t n) { return uint32_t(((next() >> 32) * n) >> 32); }
+
+        /// Uniform double in [0, 1).
+        double nextDouble() { return double(next() >> 11) * (1.0 / 9007199254740992.0); }
+    };
+
+    /// Pack a 4x4 permutation into 64 bits (4 bits per value). Same bit layout as Packed4x4Matrix (low, high).
+    inline uint64_t pack4x4(const std::array<int, 16>& indices)
+    {
+        Packed4x4Matrix p = packPermutation4x4(indices);
+        return uint64_t(p.low) | (uint64_t(p.high) << 32);
+    }
+
+    inline std::array<int, 16> unpack4x4(uint64_t packed)
+    {
+        std::array<int, 16> indices;
+        for (size_t i = 0; i < 16; ++i) indices[i] = int((packed >> (i * 4)) & 0xF);
+        return indices;
+    }
+
+    /** Lock-free insert-only hash set of packed matrices (open addressing, linear probing).
+        The key 0 is reserved as empty slot, which is never a valid permutation of 0..15.
+    */
+    class PackedMatrixSet
+    {
+    public:
+        /// @param[in] maxElements Maximum number of elements to store. Inserts beyond that are dropped and flagged.
+        explicit PackedMatrixSet(size_t maxElements)
+        {
+            mMaxElements = std::max<size_t>(maxElements, 1);
+            mCapacity = 1024;
+            while (mCapacity < 2 * mMaxElements) mCapacity *= 2; // load factor <= 0.5
+            mpSlots = std::make_unique<std::atomic<uint64_t>[]>(mCapacity);
+            for (size_t i = 0; i < mCapacity; ++i) mpSlots[i].store(kEmpty, std::memory_order_relaxed);
+        }
+
+        /// Insert a key. Returns true if the key was not present before.
+        bool insert(uint64_t key)
+        {
+            FALCOR_ASSERT(key != kEmpty);
+            const size_t mask = mCapacity - 1;
+            for (size_t i = hash(key) & mask;; i = (i + 1) & mask)
+            {
+                uint64_t current = mpSlots[i].load(std::memory_order_relaxed);
+                if (current == key) return false;
+                if (current == kEmpty)
+                {
+                    if (mSize.fetch_add(1, std::memory_order_relaxed) >= mMaxElements)
+                    {
+                        mSize.fetch_sub(1, std::memory_order_relaxed);
+                        mOverflow.store(true, std::memory_order_relaxed);
+                        return false;
+                    }
+                    if (mpSlots[i].compare_exchange_strong(current, key, std::memory_order_relaxed)) return true;
+                    mSize.fetch_sub(1, std::memory_order_relaxed);
+                    if (current == key) return false;
+                    // Slot was taken by another key, continue probing.
+                }
+            }
+        }
+
+        size_t size() const { return mSize.load(std::memory_order_relaxed); }
+        bool hasOverflown() const { return mOverflow.load(std::memory_order_relaxed); }
+
+        /// Collect all keys. Must not run concurrently with insert().
+        std::vector<uint64_t> getKeys() const
+        {
+            std::vector<uint64_t> keys;
+            keys.reserve(size());
+            for (size_t i = 0; i < mCapacity; ++i)
+            {
+                uint64_t key = mpSlots[i].load(std::memory_order_relaxed);
+                if (key != kEmpty) keys.push_back(key);
+            }
+            return keys;
+        }
+
+    private:
+        static constexpr uint64_t kEmpty = 0;
+
+        static uint64_t hash(uint64_t key)
+        {
+            key ^= key >> 33;
+            key *= 0xff51afd7ed558ccdull;
+            key ^= key >> 33;
+            return key;
+        }
+
+        std::unique_ptr<std::atomic<uint64_t>[]> mpSlots;
+        size_t mCapacity = 0;
+        size_t mMaxElements = 0;
+        std::atomic<size_t> mSize{ 0 };
+        std::atomic<bool> mOverflow{ false };
+    };
+
+    struct Desc
+    {
+        uint64_t seed = 0x5eed0001;          ///< Base seed. Chain c uses a generator derived from (seed, c).
+        uint32_t chainCount = 0;             ///< Number of annealing chains (0 = one per logical core).
+        uint32_t threadCount = 0;            ///< Number of worker threads (0 = one per logical core, clamped to chain count).
+        size_t iterationsPerChain = 1000000; ///< Candidate evaluations per chain.
+        size_t maxResults = 256;             ///< Size of the returned top-N list.
+        size_t maxUniqueStates = 0;          ///< Capacity of the dedup set (0 = total iteration count).
+        double startTemperature = 100.0;
+        double coolingRate = 0.9999;
+    };
+
+    struct Result
+    {
+        std::vector<std::pair<int, std::array<int, 16>>> permutations; ///< Top-N (score, matrix), best first.
+        uint64_t evaluations = 0;    ///< Total number of scored candidates.
+        size_t uniqueStates = 0;     ///< Number of distinct accepted states with non-zero score.
+        bool overflow = false;       ///< True if the dedup set was full (result is then no longer deterministic).
+        uint32_t chainCount = 0;
+        uint32_t threadCount = 0;
+        double seconds = 0.0;
+        double evaluationsPerSecond = 0.0;
+    };
+
+    /// Run a single annealing chain and record all accepted states with non-zero score in the set.
+    inline void runChain(const Desc& desc, uint32_t chainIndex, PackedMatrixSet& set)
+    {
+        SplitMix64 seeder(desc.seed);
+        for (uint32_t i = 0; i <= chainIndex; ++i) seeder.next();
+        SplitMix64 rng(seeder.next());
+
+        // Start with Bayer matrix as initial guess
+        IncrementalPermutationScore<4> current({
+            0, 8, 2, 10,
+            12, 4, 14, 6,
+            3, 11, 1, 9,
+            15, 7, 13, 5
+        });
+        int currentScore = current.score();
+        if (currentScore > 0) set.insert(pack4x4(current.getIndices()));
+
+        double temperature = desc.startTemperature;
+        for (size_t iter = 0; iter < desc.iterationsPerChain; ++iter)
+        {
+            // Evaluate neighbor (two random positions swapped) incrementally
+            uint32_t i = rng.nextBelow(16);
+            uint32_t j = rng.nextBelow(16);
+            int neighborScore = current.scoreAfterSwap(i, j);
+
+            // Accept if better or with probability based on temperature
+            bool accept = neighborScore > currentScore;
+            if (!accept && neighborScore > 0) accept = rng.nextDouble() < std::exp((neighborScore - currentScore) / temperature);
+
+            if (accept && i != j)
+            {
+                current.applySwap(i, j);
+                currentScore = neighborScore;
+                if (currentScore > 0) set.insert(pack4x4(current.getIndices()));
+            }
+
+            temperature *= desc.coolingRate;
+        }
+    }
+
+    /// Run the multi-chain search.
+    inline Result search4x4(const Desc& desc)
+    {
+        const uint32_t logicalCores = std::max(1u, std::thread::hardware_concurrency());
+
+        Result result;
+        result.chainCount = desc.chainCount > 0 ? desc.chainCount : logicalCores;
+        result.threadCount = std::min(desc.threadCount > 0 ? desc.threadCount : logicalCores, result.chainCount);
+
+        const size_t totalIterations = size_t(result.chainCount) * desc.iterationsPerChain;
+        PackedMatrixSet set(desc.maxUniqueStates > 0 ? desc.maxUniqueStates : totalIterations + result.chainCount);
+
+        Falcor::CpuTimer timer;
+        timer.update();
+
+        // Workers pull chain indices from a shared counter.
+        std::atomic<uint32_t> nextChain{ 0 };
+        auto worker = [&]()
+        {
+            for (uint32_t c = nextChain++; c < result.chainCount; c = nextChain++) runChain(desc, c, set);
+        };
+        std::vector<std::thread> threads;
+        for (uint32_t t = 1; t < result.threadCount; ++t) threads.emplace_back(worker);
+        worker();
+        for (auto& t : threads) t.join();
+
+        // Deterministic ordering: best score first, ties broken by the packed matrix.
+        std::vector<std::pair<int, uint64_t>> scored;
+        for (uint64_t key : set.getKeys()) scored.emplace_back(scorePermutation<4>(unpack4x4(key)), key);
+        size_t count = std::min(desc.maxResults, scored.size());
+        std::partial_sort(scored.begin(), scored.begin() + count, scored.end(),
+            [](const auto& a, const auto& b) { return a.first != b.first ? a.first > b.first : a.second < b.second; });
+
+        for (size_t i = 0; i < count; ++i) result.permutations.push_back({ scored[i].first, unpack4x4(scored[i].second) });
+
+        timer.update();
+        result.seconds = timer.delta();
+        result.evaluations = totalIterations;
+        result.evaluationsPerSecond = result.seconds > 0.0 ? double(result.evaluations) / result.seconds : 0.0;
+        result.uniqueStates = set.size();
+        result.overflow = set.hasOverflown();
+
+        if (result.overflow) Falcor::logWarning("PermutationSearch: dedup set full ({} states), result is not deterministic.", result.uniqueStates);
+        Falcor::logInfo("PermutationSearch: {} chains on {} threads, {} evaluations in {:.3f}s ({:.2f}M evaluations/s), {} unique states.",
+            result.chainCount, result.threadCount, result.evaluations, result.seconds, result.evaluationsPerSecond * 1e-6, result.uniqueStates);
+
+        return result;
+    }
+} // namespace PermutationSearch
+
+// ============================================================================
+// 4x4 Dither Matrix Generation
+// ============================================================================
+
+// Generate 4x4 permutations using random sampling (16! is too large for exhaustive search)
+// Uses parallel simulated annealing chains to find good permutations
+inline std::vector<std::array<int, 16>> generateBestPermutations4x4(size_t maxResults, size_t iterationsPerChain = 62500, uint64_t seed = PermutationSearch::Desc().seed, uint32_t chainCount = 16) {
+    PermutationSearch::Desc desc;
+    desc.seed = seed;
+    desc.chainCount = chainCount;
+    desc.iterationsPerChain = iterationsPerChain;
+    desc.maxResults = maxResults;
+    auto searchResult = PermutationSearch::search4x4(desc);
+
+    std::vector<std::array<int, 16>> result;
+    for (const auto& p : searchResult.permutations) result.push_back(p.second);
+    return result;
+}
+
+inline Falcor::ref<Falcor::Buffer> generatePermutations4x4(Falcor::ref<Falcor::Device> pDevice, size_t maxResults = 256, size_t iterationsPerChain = 62500, uint64_t seed = PermutationSearch::Desc().seed)
+{
+    auto perms = generateBestPermutations4x4(maxResults, iterationsPerChain, seed);
+    Falcor::logDebug("PermutationSearch: {} 4x4 permutations found.", perms.size());
+
+    if (perms.empty()) {
+        // Fallback: use Bayer matrix if no good permutations found
+        perms.push_back({
+            0, 8, 2, 10,
+            12, 4, 14, 6,
+            3, 11, 1, 9,
+            15, 7, 13, 5
+        });
+    }
+
+    std::vector<Packed4x4Matrix> packed(perms.size());
+    std::transform(perms.begin(), perms.end(), packed.begin(), packPermutation4x4);
+
+    return Falcor::Buffer::createStructured(pDevice, sizeof(packed[0]), packed.size(), Falcor::ResourceBindFlags::ShaderResource, Falcor::Buffer::CpuAccess::None, packed.data(), false);
+}
@@ -0,0 +1,364 @@
+#pragma once
+#include "Falcor.h"
+#include "PermutationLookup.h"
+#include "PermutationScoring.h"
+#include "PermutationSearch.h"
+#include "Core/Platform/MemoryMappedFile.h"
+#include "Utils/CryptoUtils.h"
+#include <chrono>
+#include <fstream>
+#include <map>
+
+/** Precomputed dither permutation tables.
+
+    Enumerating all 9! 3x3 permutations and annealing the 4x4 matrices is expensive, so the tables are
+    generated once and written to a versioned binary cache file in the application data directory.
+    The cache file name is the SHA-1 of the table version and the generator parameters, the payload is
+    protected by its own SHA-1. Later runs (and all further pass instances of the same process) memory-map
+    the cache and create the GPU buffers straight from the mapped data.
+
+    The packed layout is identical to the one produced by PermutationLookup.h (uint32_t for 2x2/3x3,
+    Packed4x4Matrix for 4x4), so the GPU buffers stay byte-identical.
+*/
+class PermutationTables
+{
+public:
+    /** Specifies the current table format version.
+        This needs to be incremented every time the file layout or the generator changes!
+    */
+    static constexpr uint32_t kVersion = 2;
+
+    // Generator parameters (part of the cache key).
+    static constexpr uint32_t kBest3x3Count = 288;
+    static constexpr uint32_t kBest4x4Count = 256;
+    static constexpr uint32_t kAnneal4x4Chains = 16;
+    static constexpr uint32_t kAnneal4x4IterationsPerChain = 62500;
+    static constexpr uint64_t kAnneal4x4Seed = 0x5eed0001;
+
+    /// Range of 3x3 permutations sharing the same score.
+    struct ScoreGroup
+    {
+        int32_t score;
+        uint32_t offset; ///< First element in the 3x3-by-score table.
+        uint32_t count;  ///< Number of permutations with this score.
+    };
+
+    /// Non-owning view into a table (either memory-mapped or generated in-process).
+    template<typename T>
+    struct View
+    {
+        const T* data = nullptr;
+        size_t count = 0;
+
+        const T* begin() const { return data; }
+        const T* end() const { return data + count; }
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        const T& operator[](size_t i) const { return data[i]; }
+    };
+
+    /** Get the process-wide tables.
+        The cache is loaded (or generated and written) on first use. Thread-safe.
+    */
+    static const PermutationTables& get()
+    {
+        static PermutationTables sTables;
+        return sTables;
+    }
+
+    View<uint32_t> get2x2() const { return mPerm2x2; }
+    View<uint32_t> get3x3() const { return mPerm3x3; }
+    View<uint32_t> get3x3ByScore() const { return mPerm3x3ByScore; }
+    View<ScoreGroup> get3x3ScoreGroups() const { return mScoreGroups3x3; }
+    View<Packed4x4Matrix> get4x4() const { return mPerm4x4; }
+
+    /// Unique 3x3 scores, sorted from best to worst (same as getPermutationScores<3>()).
+    std::vector<int> get3x3Scores() const
+    {
+        std::vector<int> scores;
+        scores.reserve(mScoreGroups3x3.size());
+        for (const auto& g : mScoreGroups3x3) scores.push_back(g.score);
+        return scores;
+    }
+
+    /// True if the tables were read from an existing cache file.
+    bool isFromCache() const { return mFromCache; }
+
+    Falcor::ref<Falcor::Buffer> create2x2Buffer(Falcor::ref<Falcor::Device> pDevice) const { return createBuffer(pDevice, mPerm2x2); }
+    Falcor::ref<Falcor::Buffer> create3x3Buffer(Falcor::ref<Falcor::Device> pDevice) const { return createBuffer(pDevice, mPerm3x3); }
+    Falcor::ref<Falcor::Buffer> create4x4Buffer(Falcor::ref<Falcor::Device> pDevice) const { return createBuffer(pDevice, mPerm4x4); }
+
+    /** Create a buffer with all 3x3 permutations whose score lies in [minScore, maxScore].
+        The permutations are ordered as in generatePermutations3x3(pDevice, minScore, maxScore).
+    */
+    Falcor::ref<Falcor::Buffer> create3x3Buffer(Falcor::ref<Falcor::Device> pDevice, int minScore, int maxScore) const
+    {
+        // Groups are sorted by descending score, the enumeration order is restored by merging the groups by rank.
+        std::vector<std::pair<uint32_t, uint32_t>> ranked; // (lexicographic rank, packed)
+        for (const auto& g : mScoreGroups3x3)
+        {
+            if (g.score < minScore || g.score > maxScore) continue;
+            for (uint32_t i = g.offset; i < g.offset + g.count; ++i)
+                ranked.emplace_back(mRank3x3ByScore[i], mPerm3x3ByScore[i]);
+        }
+        std::sort(ranked.begin(), ranked.end());
+
+        std::vector<uint32_t> packed(ranked.size());
+        std::transform(ranked.begin(), ranked.end(), packed.begin(), [](const auto& p) { return p.second; });
+        Falcor::logInfo("Permutations with score between {} and {}: {}", minScore, maxScore, packed.size());
+        return createBuffer(pDevice, View<uint32_t>{ packed.data(), packed.size() });
+    }
+
+    static Falcor::SHA1::MD getKey()
+    {
+        Falcor::SHA1 sha1;
+        sha1.update(std::string_view("DitherPermutationTables"));
+        sha1.update(kVersion);
+        sha1.update(kBest3x3Count);
+        sha1.update(kBest4x4Count);
+        sha1.update(kAnneal4x4Chains);
+        sha1.update(kAnneal4x4IterationsPerChain);
+        sha1.update(kAnneal4x4Seed);
+        sha1.update(uint32_t(sizeof(Packed4x4Matrix)));
+        return sha1.finalize();
+    }
+
+    static std::filesystem::path getCachePath()
+    {
+        return Falcor::getAppDataDirectory() / "NVIDIA/Falcor/DitherPermutations" / (Falcor::SHA1::toString(getKey()) + ".bin");
+    }
+
+private:
+    enum class Section : uint32_t
+    {
+        Perm2x2,
+        Perm3x3,
+        Perm3x3ByScore,
+        Rank3x3ByScore,
+        ScoreGroups3x3,
+        Perm4x4,
+        Count
+    };
+
+    static constexpr char kMagic[8] = { 'F', 'a', 'l', 'c', 'o', 'r', 'D', 'P' };
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t sectionCount;
+        Falcor::SHA1::MD key;
+        Falcor::SHA1::MD payloadHash;
+    };
+
+    struct SectionDesc
+    {
+        uint32_t id;
+        uint32_t stride;
+        uint64_t offset; ///< Offset in bytes from the start of the payload.
+        uint64_t count;
+    };
+
+    /// Tables generated in-process (only used when no valid cache is available).
+    struct Storage
+    {
+        std::vector<uint32_t> perm2x2;
+        std::vector<uint32_t> perm3x3;
+        std::vector<uint32_t> perm3x3ByScore;
+        std::vector<uint32_t> rank3x3ByScore;
+        std::vector<ScoreGroup> scoreGroups3x3;
+        std::vector<Packed4x4Matrix> perm4x4;
+    };
+
+    PermutationTables()
+    {
+        auto path = getCachePath();
+        if (loadCache(path))
+        {
+            mFromCache = true;
+            return;
+        }
+
+        Falcor::logInfo("Generating dither permutation tables (cache '{}' missing or outdated).", path);
+        generate();
+        writeCache(path);
+    }
+
+    PermutationTables(const PermutationTables&) = delete;
+    PermutationTables& operator=(const PermutationTables&) = delete;
+
+    template<typename T>
+    static Falcor::ref<Falcor::Buffer> createBuffer(Falcor::ref<Falcor::Device> pDevice, View<T> view)
+    {
+        FALCOR_ASSERT(!view.empty());
+        return Falcor::Buffer::createStructured(pDevice, sizeof(T), (uint32_t)view.size(), Falcor::ResourceBindFlags::ShaderResource, Falcor::Buffer::CpuAccess::None, view.data, false);
+    }
+
+    void generate()
+    {
+        mpStorage = std::make_unique<Storage>();
+        auto& s = *mpStorage;
+
+        // 2x2: all 24 permutations (see generatePermutations2x2).
+        {
+            std::array<int, 4> indices;
+            std::iota(indices.begin(), indices.end(), 0);
+            do s.perm2x2.push_back(packPermutation2x2(indices));
+            while (std::next_permutation(indices.begin(), indices.end()));
+        }
+
+        // 3x3: enumerate and batch-score all permutations once, then derive both tables from the scored list.
+        {
+            std::vector<std::pair<int, std::array<int, 9>>> scoredPermutations;
+            scoredPermutations.reserve(362880);
+            forEachScoredPermutation<3>([&](const std::array<int, 9>& indices, int score) { scoredPermutations.push_back({ score, indices }); });
+
+            // All permutations grouped by score, best score first.
+            // Within a group the lexicographic enumeration order is kept and its rank is stored for range queries.
+            std::map<int, std::vector<uint32_t>, std::greater<int>> groups;
+            for (uint32_t rank = 0; rank < (uint32_t)scoredPermutations.size(); ++rank)
+                groups[scoredPermutations[rank].first].push_back(rank);
+
+            for (const auto& [score, ranks] : groups)
+            {
+                s.scoreGroups3x3.push_back({ score, (uint32_t)s.perm3x3ByScore.size(), (uint32_t)ranks.size() });
+                for (uint32_t rank : ranks)
+                {
+                    s.rank3x3ByScore.push_back(rank);
+                    s.perm3x3ByScore.push_back(packPermutation(scoredPermutations[rank].second));
+                }
+            }
+
+            // Best permutations (see generatePermutations3x3).
+            auto perms = selectBestPermutations<3>(std::move(scoredPermutations), kBest3x3Count);
+            s.perm3x3.resize(perms.size());
+            std::transform(perms.begin(), perms.end(), s.perm3x3.begin(), packPermutation);
+        }
+
+        // 4x4: annealed permutations with Bayer fallback (see generatePermutations4x4).
+        {
+            auto perms = generateBestPermutations4x4(kBest4x4Count, kAnneal4x4IterationsPerChain, kAnneal4x4Seed, kAnneal4x4Chains);
+            if (perms.empty())
+                perms.push_back({ 0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5 });
+            s.perm4x4.resize(perms.size());
+            std::transform(perms.begin(), perms.end(), s.perm4x4.begin(), packPermutation4x4);
+        }
+
+        mPerm2x2 = { s.perm2x2.data(), s.perm2x2.size() };
+        mPerm3x3 = { s.perm3x3.data(), s.perm3x3.size() };
+        mPerm3x3ByScore = { s.perm3x3ByScore.data(), s.perm3x3ByScore.size() };
+        mRank3x3ByScore = { s.rank3x3ByScore.data(), s.rank3x3ByScore.size() };
+        mScoreGroups3x3 = { s.scoreGroups3x3.data(), s.scoreGroups3x3.size() };
+        mPerm4x4 = { s.perm4x4.data(), s.perm4x4.size() };
+    }
+
+    bool loadCache(const std::filesystem::path& path)
+    {
+        if (!std::filesystem::exists(path)) return false;
+
+        if (!mFile.open(path, Falcor::MemoryMappedFile::kWholeFile, Falcor::MemoryMappedFile::AccessHint::SequentialScan)) return false;
+
+        const uint8_t* pData = reinterpret_cast<const uint8_t*>(mFile.getData());
+        const size_t size = mFile.getMappedSize();
+        const size_t tableSize = sizeof(Header) + sizeof(SectionDesc) * size_t(Section::Count);
+
+        auto fail = [&](const char* reason)
+        {
+            Falcor::logWarning("Ignoring dither permutation cache '{}': {}.", path, reason);
+            mFile.close();
+            return false;
+        };
+
+        if (size < tableSize) return fail("file truncated");
+
+        Header header;
+        std::memcpy(&header, pData, sizeof(header));
+        if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion) return fail("invalid header");
+        if (header.key != getKey()) return fail("key mismatch");
+        if (header.sectionCount != uint32_t(Section::Count)) return fail("unexpected section count");
+
+        const uint8_t* pPayload = pData + tableSize;
+        const size_t payloadSize = size - tableSize;
+        if (Falcor::SHA1::compute(pPayload, payloadSize) != header.payloadHash) return fail("payload hash mismatch");
+
+        const SectionDesc* pSections = reinterpret_cast<const SectionDesc*>(pData + sizeof(Header));
+        auto view = [&](Section section, auto& dst) -> bool
+        {
+            using T = std::remove_const_t<std::remove_pointer_t<decltype(dst.data)>>;
+            const SectionDesc& desc = pSections[uint32_t(section)];
+            if (desc.id != uint32_t(section) || desc.stride != sizeof(T)) return false;
+            if (desc.offset % alignof(T) != 0 || desc.offset + desc.count * sizeof(T) > payloadSize) return false;
+            dst.data = reinterpret_cast<const T*>(pPayload + desc.offset);
+            dst.count = desc.count;
+            return true;
+        };
+
+        bool valid = view(Section::Perm2x2, mPerm2x2) && view(Section::Perm3x3, mPerm3x3) && view(Section::Perm3x3ByScore, mPerm3x3ByScore) &&
+                     view(Section::Rank3x3ByScore, mRank3x3ByScore) && view(Section::ScoreGroups3x3, mScoreGroups3x3) &&
+                     view(Section::Perm4x4, mPerm4x4);
+        if (!valid || mPerm3x3ByScore.size() != mRank3x3ByScore.size()) return fail("invalid section table");
+
+        Falcor::logInfo("Loaded dither permutation tables from '{}'.", path);
+        return true;
+    }
+
+    void writeCache(const std::filesystem::path& path) const
+    {
+        // Assemble payload.
+        std::vector<uint8_t> payload;
+        std::vector<SectionDesc> sections;
+        auto append = [&](Section section, auto view)
+        {
+            using T = std::remove_const_t<std::remove_pointer_t<decltype(view.data)>>;
+            payload.resize(Falcor::align_to(sizeof(uint64_t), payload.size()));
+            sections.push_back({ uint32_t(section), uint32_t(sizeof(T)), payload.size(), view.size() });
+            const uint8_t* pBytes = reinterpret_cast<const uint8_t*>(view.data);
+            payload.insert(payload.end(), pBytes, pBytes + view.size() * sizeof(T));
+        };
+        append(Section::Perm2x2, mPerm2x2);
+        append(Section::Perm3x3, mPerm3x3);
+        append(Section::Perm3x3ByScore, mPerm3x3ByScore);
+        append(Section::Rank3x3ByScore, mRank3x3ByScore);
+        append(Section::ScoreGroups3x3, mScoreGroups3x3);
+        append(Section::Perm4x4, mPerm4x4);
+
+        Header header;
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.sectionCount = (uint32_t)sections.size();
+        header.key = getKey();
+        header.payloadHash = Falcor::SHA1::compute(payload.data(), payload.size());
+
+        // Write to a temporary file first and rename, so that concurrent processes never map a partial file.
+        try
+        {
+            std::filesystem::create_directories(path.parent_path());
+            auto tmpPath = path;
+            tmpPath += ".tmp" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+            {
+                std::ofstream fs(tmpPath, std::ios_base::binary);
+                fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                fs.write(reinterpret_cast<const char*>(sections.data()), sections.size() * sizeof(SectionDesc));
+                fs.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+                if (!fs) throw Falcor::RuntimeError("Failed to write '{}'", tmpPath);
+            }
+            std::filesystem::rename(tmpPath, path);
+            Falcor::logInfo("Wrote dither permutation tables to '{}'.", path);
+        }
+        catch (const std::exception& e)
+        {
+            Falcor::logWarning("Failed to write dither permutation cache '{}': {}", path, e.what());
+        }
+    }
+
+    Falcor::MemoryMappedFile mFile;
+    std::unique_ptr<Storage> mpStorage;
+    bool mFromCache = false;
+
+    View<uint32_t> mPerm2x2;
+    View<uint32_t> mPerm3x3;
+    View<uint32_t> mPerm3x3ByScore;
+    View<uint32_t> mRank3x3ByScore;
+    View<ScoreGroup> mScoreGroups3x3;
+    View<Packed4x4Matrix> mPerm4x4;
+};
@@ -1,42 +1,437 @@
 #pragma once
 #include "Falcor.h"
+#include "Utils/NumericRange.h"
+#include <fstd/bit.h> // TODO C++20: Replace with <bit>
+#include <execution>
+#include <regex>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace Falcor
 {
 using whitelist_t = std::set<std::string>;
 
-// returns true if at least one material was whitelisted (or scene was invalid)
-// pTransparencyWhitelistBuffer will always be updated
-inline bool updateWhitelist(const ref<Device>& pDevice, const ref<Scene>& pScene, const whitelist_t& transparencyWhitelist, ref<Buffer>& pTransparencyWhitelistBuffer)
+/** Compiled set of material name patterns.
+
+    Supported entries:
+    - "re:<regex>": ECMAScript regular expression, must match the whole name.
+    - Globs with '*' (any sequence), '?' (any character) and "[abc]", "[a-z]", "[!a]" character classes.
+      A backslash escapes the next character.
+    - Everything else is an exact name.
+
+    Every entry also matches its literal text, so existing exact names containing glob characters keep working.
+    Exact names are kept in a hash set and globs of the form "prefix*" in a prefix trie, so matching a name
+    costs one hash lookup and one trie walk plus the general globs and regexes.
+*/
+class MaterialNameFilter
 {
-    if (!pScene) return true;
-    bool any = false;
+public:
+    MaterialNameFilter() = default;
 
-    // Calculate the number of uint32_t elements needed to store all bits
-    uint32_t materialCount = pScene->getMaterialCount();
-    uint32_t uintCount = (materialCount + 31) / 32; // Round up to the nearest uint32_t
+    explicit MaterialNameFilter(const whitelist_t& patterns)
+    {
+        for (const auto& pattern : patterns) add(pattern);
+    }
 
-    std::vector<uint32_t> whitelist(uintCount, 0); // Initialize all bits to 0
+    /// True if the entry is interpreted as a pattern rather than an exact name.
+    static bool isPattern(std::string_view entry) { return entry.substr(0, 3) == "re:" || entry.find_first_of("*?[\\") != std::string_view::npos; }
 
-    // Pack the boolean values into bits
-    for (uint32_t mat = 0; mat < materialCount; ++mat)
+    bool matches(std::string_view name) const
     {
-        std::string name = pScene->getMaterial(MaterialID(mat))->getName();
-        bool isTransparent = transparencyWhitelist.find(name) != transparencyWhitelist.end();
-        any |= isTransparent;
+        if (mExact.count(std::string(name)) > 0) return true;
+        if (matchesPrefix(name)) return true;
+        for (const auto& glob : mGlobs)
+            if (matchGlob(glob, name)) return true;
+        for (const auto& regex : mRegexes)
+            if (std::regex_match(name.begin(), name.end(), regex)) return true;
+        return false;
+    }
 
-        if (isTransparent)
+    static bool matchGlob(std::string_view glob, std::string_view name)
+    {
+        // Iterative matcher, backtracking to the last '*' on mismatch.
+        size_t g = 0, n = 0;
+        size_t starG = std::string_view::npos, starN = 0;
+        while (n < name.size())
         {
-            // Set the corresponding bit in the whitelist
-            uint32_t uintIndex = mat / 32;
-            uint32_t bitIndex = mat % 32;
-            whitelist[uintIndex] |= (1 << bitIndex);
+            if (g < glob.size() && glob[g] == '*')
+            {
+                starG = g++;
+                starN = n;
+                continue;
+            }
+            size_t next = g;
+            if (g < glob.size() && matchChar(glob, next, name[n]))
+            {
+                g = next;
+                ++n;
+                continue;
+            }
+            if (starG == std::string_view::npos) return false;
+            g = starG + 1;
+            n = ++starN;
         }
+        while (g < glob.size() && glob[g] == '*') ++g;
+        return g == glob.size();
     }
 
-    pTransparencyWhitelistBuffer = Buffer::createStructured(pDevice, sizeof(uint32_t), uintCount, ResourceBindFlags::ShaderResource, Buffer::CpuAccess::None, whitelist.data(), false);
+private:
+    struct TrieNode
+    {
+        std::vector<std::pair<char, uint32_t>> children; ///< Sorted by character.
+        bool terminal = false;
+    };
 
-    return any;
-}
+    void add(const std::string& entry)
+    {
+        mExact.insert(entry);
+        if (entry.size() > 3 && entry.substr(0, 3) == "re:")
+        {
+            try
+            {
+                mRegexes.emplace_back(entry.substr(3), std::regex::ECMAScript | std::regex::optimize);
+            }
+            catch (const std::regex_error& e)
+            {
+                logWarning("Ignoring invalid transparency whitelist regex '{}': {}", entry, e.what());
+            }
+            return;
+        }
+        if (!isPattern(entry)) return;
+
+        // "prefix*" without any other special character goes into the trie.
+        std::string_view prefix = std::string_view(entry).substr(0, entry.size() - 1);
+        if (entry.back() == '*' && prefix.find_first_of("*?[\\") == std::string_view::npos) insertPrefix(prefix);
+        else mGlobs.push_back(entry);
+    }
+
+    void insertPrefix(std::string_view prefix)
+    {
+        if (mTrie.empty()) mTrie.emplace_back();
+        uint32_t node = 0;
+        for (char c : prefix)
+        {
+            auto& children = mTrie[node].children;
+            auto it = std::lower_bound(children.begin(), children.end(), c, [](const auto& child, char value) { return child.first < value; });
+            if (it != children.end() && it->first == c)
+            {
+                node = it->second;
+                continue;
+            }
+            uint32_t child = (uint32_t)mTrie.size();
+            children.insert(it, { c, child });
+            mTrie.emplace_back();
+            node = child;
+        }
+        mTrie[node].terminal = true;
+    }
+
+    bool matchesPrefix(std::string_view name) const
+    {
+        if (mTrie.empty()) return false;
+        uint32_t node = 0;
+        for (size_t i = 0;; ++i)
+        {
+            if (mTrie[node].terminal) return true;
+            if (i == name.size()) return false;
+            const auto& children = mTrie[node].children;
+            auto it = std::lower_bound(children.begin(), children.end(), name[i], [](const auto& child, char value) { return child.first < value; });
+            if (it == children.end() || it->first != name[i]) return false;
+            node = it->second;
+        }
+    }
+
+    /// Match a single glob element (character, '?', escape or class) starting at glob[g] against c. Advances g on success.
+    static bool matchChar(std::string_view glob, size_t& g, char c)
+    {
+        switch (glob[g])
+        {
+        case '?':
+            ++g;
+            return true;
+        case '\\':
+            if (g + 1 < glob.size())
+            {
+                g += 2;
+                return glob[g - 1] == c;
+            }
+            break;
+        case '[':
+        {
+            size_t end = glob.find(']', g + 2); // A ']' right after '[' (or "[!") is part of the class.
+            if (end == std::string_view::npos) break;
+            size_t i = g + 1;
+            bool negate = glob[i] == '!';
+            if (negate) ++i;
+            if (negate && i == end) end = glob.find(']', end + 1);
+            if (end == std::string_view::npos) break;
+            bool found = false;
+            for (; i < end; ++i)
+            {
+                if (i + 2 < end && glob[i + 1] == '-')
+                {
+                    found |= c >= glob[i] && c <= glob[i + 2];
+                    i += 2;
+                }
+                else found |= c == glob[i];
+            }
+            g = end + 1;
+            return found != negate;
+        }
+        default:
+            break;
+        }
+        return glob[g++] == c;
+    }
+
+    std::unordered_set<std::string> mExact;
+    std::vector<TrieNode> mTrie;
+    std::vector<std::string> mGlobs;
+    std::vector<std::regex> mRegexes;
+};
+
+/** Per-material transparency whitelist.
+
+    Keeps the filter patterns, the resulting per-material bitset and the GPU buffer (one bit per material ID,
+    read as gTransparencyWhitelist[materialID / 32] in the shaders). Each material is matched once against the
+    compiled patterns; afterwards only materials affected by a change are re-evaluated:
+    - new materials (the material count grew),
+    - materials whose name was added or removed as an exact entry,
+    - all materials if a glob/regex entry changed or invalidate() was called.
+    Only the 32-bit words that actually changed are uploaded, and only the materials whose bit flipped
+    update the set of matched names.
+*/
+class TransparencyWhitelist
+{
+public:
+    /// Parse a comma-separated list of entries (the "whitelist" property).
+    static whitelist_t parse(const std::string& str)
+    {
+        whitelist_t entries;
+        std::stringstream ss(str);
+        std::string entry;
+        while (std::getline(ss, entry, ','))
+            if (!entry.empty()) entries.insert(entry);
+        return entries;
+    }
+
+    /// Comma-separated list of entries, as read by parse().
+    std::string toString() const
+    {
+        std::string str;
+        for (const auto& entry : mPatterns) str += entry + ",";
+        return str;
+    }
+
+    const whitelist_t& getPatterns() const { return mPatterns; }
+
+    void setPatterns(whitelist_t patterns)
+    {
+        if (patterns == mPatterns) return;
+        mPatterns = std::move(patterns);
+        mFilter = MaterialNameFilter(mPatterns);
+        mFullUpdate = true;
+    }
+
+    bool contains(const std::string& entry) const { return mPatterns.count(entry) > 0; }
+
+    void insert(const std::string& entry)
+    {
+        if (!mPatterns.insert(entry).second) return;
+        onEntryChanged(entry);
+    }
+
+    void erase(const std::string& entry)
+    {
+        if (mPatterns.erase(entry) == 0) return;
+        onEntryChanged(entry);
+    }
+
+    /// Force a full re-evaluation on the next update (e.g. after material names changed).
+    void invalidate() { mFullUpdate = true; }
+
+    /// True if the material was whitelisted by the last update().
+    bool isWhitelisted(uint32_t materialID) const
+    {
+        return materialID / 32 < mBits.size() && (mBits[materialID / 32] & (1u << (materialID % 32))) != 0;
+    }
+
+    /// Names of all whitelisted materials of the scene, for passes that look up materials by name.
+    const whitelist_t& getMatchedNames() const { return mMatchedNames; }
+
+    const ref<Buffer>& getBuffer() const { return mpBuffer; }
+
+    /// Number of 32-bit words uploaded by the last update().
+    uint32_t getUploadedWordCount() const { return mUploadedWordCount; }
+
+    /** Bring the bitset and GPU buffer up to date with the scene materials.
+        Returns true if at least one material is whitelisted (or there is no scene), like the shader define expects.
+    */
+    bool update(const ref<Device>& pDevice, const ref<Scene>& pScene)
+    {
+        mUploadedWordCount = 0;
+        if (!pScene) return true;
+
+        const bool sceneChanged = pScene.get() != mpScene;
+        if (sceneChanged)
+        {
+            mpScene = pScene.get();
+            mMaterialsByName.clear();
+            mNames.clear();
+            mFullUpdate = true;
+        }
+
+        const uint32_t materialCount = pScene->getMaterialCount();
+        if (!mFullUpdate && mPendingNames.empty() && materialCount == mNames.size() && mpBuffer) return !mMatchedNames.empty();
+
+        if (materialCount < mNames.size()) mFullUpdate = true;
+        const bool namesRebuilt = mFullUpdate;
+
+        const uint32_t wordCount = std::max(1u, (materialCount + 31) / 32);
+        const uint32_t knownCount = mFullUpdate ? 0 : (uint32_t)mNames.size();
+
+        // Register names of new materials.
+        if (mFullUpdate)
+        {
+            mMaterialsByName.clear();
+            mNames.clear();
+        }
+        for (uint32_t mat = (uint32_t)mNames.size(); mat < materialCount; ++mat)
+        {
+            mNames.push_back(pScene->getMaterial(MaterialID(mat))->getName());
+            mMaterialsByName[mNames.back()].push_back(mat);
+        }
+
+        std::vector<uint32_t> bits = mBits;
+        bits.resize(wordCount, 0);
+        if (materialCount % 32 != 0) bits[wordCount - 1] &= (1u << (materialCount % 32)) - 1; // Bits of removed materials.
+        std::vector<uint8_t> dirtyWords(wordCount, 0);
+
+        auto evaluate = [&](uint32_t mat)
+        {
+            const uint32_t mask = 1u << (mat % 32);
+            if (mFilter.matches(mNames[mat])) bits[mat / 32] |= mask;
+            else bits[mat / 32] &= ~mask;
+        };
+
+        // Materials that were not matched before: words are evaluated in parallel, each by one thread.
+        if (knownCount < materialCount)
+        {
+            NumericRange<uint32_t> wordRange(knownCount / 32, (materialCount + 31) / 32);
+            std::for_each(
+                std::execution::par,
+                wordRange.begin(),
+                wordRange.end(),
+                [&](uint32_t word)
+                {
+                    for (uint32_t mat = std::max(knownCount, word * 32); mat < std::min(materialCount, word * 32 + 32); ++mat) evaluate(mat);
+                }
+            );
+        }
+
+        // Materials whose name was added or removed as an exact entry.
+        for (const auto& name : mPendingNames)
+        {
+            auto it = mMaterialsByName.find(name);
+            if (it == mMaterialsByName.end()) continue;
+            for (uint32_t mat : it->second)
+                if (mat < knownCount) evaluate(mat);
+        }
+        mPendingNames.clear();
+        mFullUpdate = false;
+
+        // Update the matched names from the flipped bits. If the names were rebuilt, all bits count as flipped.
+        if (namesRebuilt)
+        {
+            mMatchedNames.clear();
+            mMatchedNameCounts.clear();
+        }
+        for (uint32_t word = 0; word < wordCount; ++word)
+        {
+            const uint32_t oldBits = namesRebuilt || word >= mBits.size() ? 0 : mBits[word];
+            for (uint32_t flipped = bits[word] ^ oldBits; flipped != 0; flipped &= flipped - 1)
+            {
+                const uint32_t bit = fstd::countr_zero(flipped);
+                setMatched(word * 32 + bit, (bits[word] >> bit) & 1);
+            }
+        }
+
+        // Upload changed words, coalesced into ranges. The buffer is only recreated if it is too small.
+        bool recreate = !mpBuffer || mpBuffer->getElementCount() < wordCount;
+        for (uint32_t word = 0; word < wordCount; ++word)
+            dirtyWords[word] = recreate || word >= mBits.size() || bits[word] != mBits[word];
+        mBits = std::move(bits);
+
+        if (recreate)
+        {
+            // Grow geometrically when materials are added to a live scene, so appends rarely reallocate.
+            const uint32_t capacity = mpBuffer && !sceneChanged ? std::max(wordCount, 2 * mpBuffer->getElementCount()) : wordCount;
+            std::vector<uint32_t> data(mBits);
+            data.resize(capacity, 0);
+            mpBuffer = Buffer::createStructured(pDevice, sizeof(uint32_t), capacity, ResourceBindFlags::ShaderResource, Buffer::CpuAccess::None, data.data(), false);
+            mUploadedWordCount = capacity;
+        }
+        else
+        {
+            for (uint32_t word = 0; word < wordCount;)
+            {
+                if (!dirtyWords[word])
+                {
+                    ++word;
+                    continue;
+                }
+                uint32_t end = word;
+                while (end < wordCount && dirtyWords[end]) ++end;
+                mpBuffer->setBlob(mBits.data() + word, word * sizeof(uint32_t), (end - word) * sizeof(uint32_t));
+                mUploadedWordCount += end - word;
+                word = end;
+            }
+        }
+
+        return !mMatchedNames.empty();
+    }
+
+private:
+    /// Count a material under its name, so names shared by several materials stay matched while any of them is.
+    void setMatched(uint32_t materialID, bool matched)
+    {
+        const std::string& name = mNames[materialID];
+        if (matched)
+        {
+            if (mMatchedNameCounts[name]++ == 0) mMatchedNames.insert(name);
+            return;
+        }
+        auto it = mMatchedNameCounts.find(name);
+        FALCOR_ASSERT(it != mMatchedNameCounts.end());
+        if (--it->second == 0)
+        {
+            mMatchedNameCounts.erase(it);
+            mMatchedNames.erase(name);
+        }
+    }
+
+    void onEntryChanged(const std::string& entry)
+    {
+        mFilter = MaterialNameFilter(mPatterns);
+        // Exact entries only affect materials of that name, patterns can affect all of them.
+        if (MaterialNameFilter::isPattern(entry)) mFullUpdate = true;
+        else mPendingNames.insert(entry);
+    }
+
+    whitelist_t mPatterns;
+    MaterialNameFilter mFilter;
+
+    const Scene* mpScene = nullptr;
+    std::vector<std::string> mNames;                                        ///< Material names by ID.
+    std::unordered_map<std::string, std::vector<uint32_t>> mMaterialsByName; ///< Material IDs by name.
+    std::set<std::string> mPendingNames;
+    bool mFullUpdate = true;
 
+    std::vector<uint32_t> mBits; ///< CPU copy of the GPU buffer contents.
+    whitelist_t mMatchedNames;
+    std::unordered_map<std::string, uint32_t> mMatchedNameCounts; ///< Whitelisted materials per name in mMatchedNames.
+    ref<Buffer> mpBuffer;
+    uint32_t mUploadedWordCount = 0;
+};
 }
@@ -0,0 +1,594 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Platform/OS.h"
+#include "Utils/Threading.h"
+#if FALCOR_HAS_AVX2_TARGET
+#include <immintrin.h>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/** Void-and-cluster generator for blue-noise dither masks (Ulichney 1993).
+
+    Supported mask types:
+    - Spatial2D: independent 2D masks, one per slice (2D Gaussian energy).
+    - Volume3D: a single toroidal 3D mask (3D Gaussian energy), as in bluenoise3d_16.dds.
+    - SpatioTemporal: 2Dx1D spatiotemporal blue noise (Wolfe et al. 2022). A cell only interacts with
+      cells of the same slice (spatial Gaussian) and with the same pixel in other slices (temporal
+      Gaussian), so every slice is a 2D blue-noise mask and every pixel is a 1D blue-noise sequence.
+
+    The Gaussian energy kernel is truncated at kernelRadius and applied as contiguous row segments,
+    which the compiler vectorizes. The tightest cluster / largest void is found through a 64-ary
+    min/max tree over the energy field, so a rank step costs O(kernel size) instead of a scan over all
+    cells. Building the energy field and the tree runs on the Falcor thread pool (Threading::parallelFor),
+    and independent 2D slices are generated in parallel. Ties are broken by the lowest cell index, so the result only depends on
+    the description, not on the number of threads.
+*/
+namespace VoidAndCluster
+{
+    enum class MaskType
+    {
+        Spatial2D,
+        Volume3D,
+        SpatioTemporal,
+    };
+
+    struct Desc
+    {
+        MaskType type = MaskType::Spatial2D;
+        uint32_t width = 64;
+        uint32_t height = 64;
+        uint32_t depth = 1;             ///< Slices (Spatial2D, SpatioTemporal) or layers (Volume3D).
+        float sigma = 1.9f;             ///< Spatial standard deviation of the energy kernel (in cells).
+        float temporalSigma = 1.9f;     ///< Standard deviation along the slices (Volume3D uses sigma).
+        uint32_t kernelRadius = 0;      ///< Kernel truncation radius (0 = ceil(3 * sigma)).
+        float initialDensity = 0.1f;    ///< Fraction of cells set in the initial binary pattern.
+        uint64_t seed = 0x5eed0001;
+        bool parallel = true;           ///< Run on the thread pool, otherwise everything runs on the calling thread.
+    };
+
+    struct Result
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t depth = 0;
+        uint32_t rankCount = 0;         ///< Ranks per independently ranked field (W*H for Spatial2D, else W*H*D).
+        std::vector<uint32_t> ranks;    ///< Rank of every cell, x fastest, then y, then slice.
+        uint64_t swaps = 0;             ///< Swaps done while relaxing the initial pattern.
+        double seconds = 0.0;
+
+        /// Threshold in [0, 1) of a cell, (rank + 0.5) / rankCount.
+        float getThreshold(size_t index) const { return (float(ranks[index]) + 0.5f) / float(rankCount); }
+    };
+
+    /// SplitMix64 finalizer, used to derive deterministic streams from the seed.
+    inline uint64_t mix64(uint64_t z)
+    {
+        z += 0x9e3779b97f4a7c15ull;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    /// Truncated Gaussian energy kernel as a list of rows along x.
+    struct Kernel
+    {
+        struct Row
+        {
+            int32_t dy = 0;
+            int32_t dz = 0;
+            int32_t radius = 0;         ///< Row covers dx in [-radius, radius].
+            std::vector<float> weights; ///< 2 * radius + 1 weights.
+        };
+        std::vector<Row> rows;
+
+        static std::vector<float> gaussian(int32_t radius, float sigma)
+        {
+            std::vector<float> g(2 * radius + 1);
+            for (int32_t d = -radius; d <= radius; ++d) g[d + radius] = std::exp(-float(d * d) / (2.f * sigma * sigma));
+            return g;
+        }
+
+        static Kernel create(const Desc& desc)
+        {
+            const int32_t r = desc.kernelRadius > 0 ? int32_t(desc.kernelRadius) : int32_t(std::ceil(3.f * desc.sigma));
+            const int32_t rt = desc.kernelRadius > 0 ? int32_t(desc.kernelRadius) : int32_t(std::ceil(3.f * desc.temporalSigma));
+            // Keep the truncated window smaller than the torus so that no cell is covered twice.
+            const int32_t rx = std::min<int32_t>(r, (int32_t(desc.width) - 1) / 2);
+            const int32_t ry = std::min<int32_t>(r, (int32_t(desc.height) - 1) / 2);
+            const int32_t rz = std::min<int32_t>(desc.type == MaskType::SpatioTemporal ? rt : r, (int32_t(desc.depth) - 1) / 2);
+
+            const auto gx = gaussian(rx, desc.sigma);
+            const auto gy = gaussian(ry, desc.sigma);
+            const auto gz = gaussian(rz, desc.type == MaskType::SpatioTemporal ? desc.temporalSigma : desc.sigma);
+
+            Kernel kernel;
+            const int32_t spatialRz = desc.type == MaskType::Volume3D ? rz : 0;
+            for (int32_t dz = -spatialRz; dz <= spatialRz; ++dz)
+            {
+                for (int32_t dy = -ry; dy <= ry; ++dy)
+                {
+                    Row row;
+                    row.dy = dy;
+                    row.dz = dz;
+                    row.radius = rx;
+                    row.weights.resize(gx.size());
+                    for (size_t i = 0; i < gx.size(); ++i) row.weights[i] = gx[i] * gy[dy + ry] * gz[dz + rz];
+                    kernel.rows.push_back(std::move(row));
+                }
+            }
+            if (desc.type == MaskType::SpatioTemporal)
+            {
+                for (int32_t dz = -rz; dz <= rz; ++dz)
+                {
+                    if (dz == 0) continue;
+                    Row row;
+                    row.dz = dz;
+                    row.weights = { gz[dz + rz] };
+                    kernel.rows.push_back(std::move(row));
+                }
+            }
+            return kernel;
+        }
+    };
+
+#if FALCOR_HAS_AVX2_TARGET
+    /// AVX2 part of reduceCells(). Reduces the largest multiple of 8 cells and returns that count.
+    FALCOR_TARGET_AVX2 inline size_t reduceCellsAVX2(const float* pEnergy, const float* pPattern, size_t count, float& maxSet, float& minUnset)
+    {
+        constexpr float kInf = std::numeric_limits<float>::infinity();
+        size_t i = 0;
+        __m256 vMax = _mm256_set1_ps(-kInf);
+        __m256 vMin = _mm256_set1_ps(kInf);
+        const __m256 vHalf = _mm256_set1_ps(0.5f);
+        const __m256 vNegInf = _mm256_set1_ps(-kInf);
+        const __m256 vPosInf = _mm256_set1_ps(kInf);
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 e = _mm256_loadu_ps(pEnergy + i);
+            __m256 set = _mm256_cmp_ps(_mm256_loadu_ps(pPattern + i), vHalf, _CMP_GT_OQ);
+            vMax = _mm256_max_ps(vMax, _mm256_blendv_ps(vNegInf, e, set));
+            vMin = _mm256_min_ps(vMin, _mm256_blendv_ps(e, vPosInf, set));
+        }
+        alignas(32) float lanesMax[8], lanesMin[8];
+        _mm256_store_ps(lanesMax, vMax);
+        _mm256_store_ps(lanesMin, vMin);
+        maxSet = *std::max_element(lanesMax, lanesMax + 8);
+        minUnset = *std::min_element(lanesMin, lanesMin + 8);
+        return i;
+    }
+
+    /// AVX2 part of reduceNodes(). Reduces the largest multiple of 8 children and returns that count.
+    FALCOR_TARGET_AVX2 inline size_t reduceNodesAVX2(const float* pMax, const float* pMin, size_t count, float& maxOut, float& minOut)
+    {
+        constexpr float kInf = std::numeric_limits<float>::infinity();
+        size_t i = 0;
+        __m256 vMax = _mm256_set1_ps(-kInf);
+        __m256 vMin = _mm256_set1_ps(kInf);
+        for (; i + 8 <= count; i += 8)
+        {
+            vMax = _mm256_max_ps(vMax, _mm256_loadu_ps(pMax + i));
+            vMin = _mm256_min_ps(vMin, _mm256_loadu_ps(pMin + i));
+        }
+        alignas(32) float lanesMax[8], lanesMin[8];
+        _mm256_store_ps(lanesMax, vMax);
+        _mm256_store_ps(lanesMin, vMin);
+        maxOut = *std::max_element(lanesMax, lanesMax + 8);
+        minOut = *std::min_element(lanesMin, lanesMin + 8);
+        return i;
+    }
+#endif
+
+    /// Max over set cells and min over unset cells of the energy.
+    inline void reduceCells(const float* pEnergy, const float* pPattern, size_t count, float& maxSet, float& minUnset)
+    {
+        constexpr float kInf = std::numeric_limits<float>::infinity();
+        maxSet = -kInf;
+        minUnset = kInf;
+        size_t i = 0;
+#if FALCOR_HAS_AVX2_TARGET
+        if (Falcor::isAVX2Supported()) i = reduceCellsAVX2(pEnergy, pPattern, count, maxSet, minUnset);
+#endif
+        for (; i < count; ++i)
+        {
+            if (pPattern[i] > 0.5f) maxSet = std::max(maxSet, pEnergy[i]);
+            else minUnset = std::min(minUnset, pEnergy[i]);
+        }
+    }
+
+    /// Max and min of two child arrays.
+    inline void reduceNodes(const float* pMax, const float* pMin, size_t count, float& maxOut, float& minOut)
+    {
+        constexpr float kInf = std::numeric_limits<float>::infinity();
+        maxOut = -kInf;
+        minOut = kInf;
+        size_t i = 0;
+#if FALCOR_HAS_AVX2_TARGET
+        if (Falcor::isAVX2Supported()) i = reduceNodesAVX2(pMax, pMin, count, maxOut, minOut);
+#endif
+        for (; i < count; ++i)
+        {
+            maxOut = std::max(maxOut, pMax[i]);
+            minOut = std::min(minOut, pMin[i]);
+        }
+    }
+
+    /** Energy field of a binary pattern on a W x H x D torus, with a 64-ary tree that tracks the
+        maximum energy over set cells (tightest cluster) and the minimum over unset cells (largest void).
+    */
+    class EnergyField
+    {
+    public:
+        static constexpr size_t kFanout = 64;
+        static constexpr size_t kGrainSize = 256;
+
+        EnergyField(uint32_t width, uint32_t height, uint32_t depth, const Kernel& kernel, bool parallel)
+            : mWidth(width), mHeight(height), mDepth(depth), mCellCount(size_t(width) * height * depth), mKernel(kernel), mParallel(parallel)
+        {
+            mPattern.assign(mCellCount, 0.f);
+            mEnergy.assign(mCellCount, 0.f);
+            size_t count = mCellCount;
+            do
+            {
+                count = (count + kFanout - 1) / kFanout;
+                mLevels.push_back({ std::vector<float>(count), std::vector<float>(count), std::vector<uint32_t>(count, 0) });
+            } while (count > 1);
+        }
+
+        size_t getCellCount() const { return mCellCount; }
+        bool isSet(size_t cell) const { return mPattern[cell] > 0.5f; }
+        const std::vector<float>& getPattern() const { return mPattern; }
+
+        /// Replace the pattern and recompute energy and tree from scratch (parallel).
+        void assign(std::vector<float> pattern)
+        {
+            mPattern = std::move(pattern);
+            computeEnergy();
+            rebuildTree();
+        }
+
+        void set(size_t cell, bool value)
+        {
+            if (isSet(cell) == value) return;
+            mPattern[cell] = value ? 1.f : 0.f;
+            splat(cell, value ? 1.f : -1.f);
+        }
+
+        /// Set cell with the highest energy, lowest index on ties.
+        size_t findTightestCluster() const { return descend(true); }
+
+        /// Unset cell with the lowest energy, lowest index on ties.
+        size_t findLargestVoid() const { return descend(false); }
+
+    private:
+        struct Level
+        {
+            std::vector<float> maxSet;
+            std::vector<float> minUnset;
+            std::vector<uint32_t> stamp; ///< Last update that touched the node.
+        };
+
+        size_t cellIndex(uint32_t x, uint32_t y, uint32_t z) const { return (size_t(z) * mHeight + y) * mWidth + x; }
+
+        /// Chunk size for Threading::parallelFor. A single chunk runs on the calling thread.
+        size_t getGrainSize(size_t count) const { return mParallel ? kGrainSize : std::max<size_t>(1, count); }
+
+        /// Wrap a coordinate that is at most one period outside of [0, n).
+        static uint32_t wrap(int64_t v, uint32_t n) { return uint32_t(v < 0 ? v + n : (v >= n ? v - n : v)); }
+
+        /// Gather formulation: every cell sums the kernel over its neighborhood. Rows are independent.
+        void computeEnergy()
+        {
+            const size_t rowCount = size_t(mHeight) * mDepth;
+            Falcor::Threading::parallelFor(0, rowCount, [&](size_t row)
+            {
+                const uint32_t y = uint32_t(row % mHeight);
+                const uint32_t z = uint32_t(row / mHeight);
+                float* pOut = mEnergy.data() + row * mWidth;
+                std::fill(pOut, pOut + mWidth, 0.f);
+                std::vector<float> source;
+                for (const auto& k : mKernel.rows)
+                {
+                    // Source row padded by the kernel radius on both sides, so the inner loop needs no wrapping.
+                    const float* pSrc = mPattern.data() + cellIndex(0, wrap(int64_t(y) + k.dy, mHeight), wrap(int64_t(z) + k.dz, mDepth));
+                    source.resize(mWidth + 2 * k.radius);
+                    for (int32_t i = 0; i < int32_t(source.size()); ++i) source[i] = pSrc[wrap(int64_t(i) - k.radius, mWidth)];
+                    for (int32_t d = 0; d <= 2 * k.radius; ++d)
+                    {
+                        const float w = k.weights[d];
+                        const float* pS = source.data() + d;
+                        for (uint32_t x = 0; x < mWidth; ++x) pOut[x] += w * pS[x];
+                    }
+                }
+            }, getGrainSize(rowCount));
+        }
+
+        void rebuildTree()
+        {
+            for (size_t level = 0; level < mLevels.size(); ++level)
+            {
+                auto& l = mLevels[level];
+                Falcor::Threading::parallelFor(0, l.maxSet.size(), [&](size_t node) { reduceNode(level, node); }, getGrainSize(l.maxSet.size()));
+            }
+        }
+
+        /// Recompute a tree node from its children. Returns true if its values changed.
+        bool reduceNode(size_t level, size_t node)
+        {
+            auto& l = mLevels[level];
+            const float oldMax = l.maxSet[node];
+            const float oldMin = l.minUnset[node];
+            const size_t begin = node * kFanout;
+            if (level == 0)
+            {
+                const size_t count = std::min(kFanout, mCellCount - begin);
+                reduceCells(mEnergy.data() + begin, mPattern.data() + begin, count, l.maxSet[node], l.minUnset[node]);
+            }
+            else
+            {
+                const auto& child = mLevels[level - 1];
+                const size_t count = std::min(kFanout, child.maxSet.size() - begin);
+                reduceNodes(child.maxSet.data() + begin, child.minUnset.data() + begin, count, l.maxSet[node], l.minUnset[node]);
+            }
+            return l.maxSet[node] != oldMax || l.minUnset[node] != oldMin;
+        }
+
+        void touch(size_t level, size_t node)
+        {
+            auto& l = mLevels[level];
+            if (l.stamp[node] == mUpdate) return;
+            l.stamp[node] = mUpdate;
+            mTouched[level].push_back(uint32_t(node));
+        }
+
+        /// Add sign * kernel around cell, then refresh the touched tree nodes bottom-up.
+        void splat(size_t cell, float sign)
+        {
+            if (mTouched.size() != mLevels.size()) mTouched.resize(mLevels.size());
+            if (++mUpdate == 0)
+            {
+                for (auto& l : mLevels) std::fill(l.stamp.begin(), l.stamp.end(), 0);
+                mUpdate = 1;
+            }
+
+            const uint32_t x = uint32_t(cell % mWidth);
+            const uint32_t y = uint32_t((cell / mWidth) % mHeight);
+            const uint32_t z = uint32_t(cell / (size_t(mWidth) * mHeight));
+            for (const auto& k : mKernel.rows)
+            {
+                const size_t rowBase = cellIndex(0, wrap(int64_t(y) + k.dy, mHeight), wrap(int64_t(z) + k.dz, mDepth));
+                float* pRow = mEnergy.data() + rowBase;
+                const float* pW = k.weights.data();
+                const int64_t x0 = int64_t(x) - k.radius;
+                const int64_t len = 2 * int64_t(k.radius) + 1;
+                // Split the window into at most two contiguous segments at the torus seam.
+                int64_t start = x0 < 0 ? x0 + mWidth : x0;
+                int64_t first = std::min<int64_t>(len, int64_t(mWidth) - start);
+                for (int64_t i = 0; i < first; ++i) pRow[start + i] += sign * pW[i];
+                for (int64_t i = first; i < len; ++i) pRow[i - first] += sign * pW[i];
+
+                for (size_t b = size_t(rowBase + start) / kFanout; b <= size_t(rowBase + start + first - 1) / kFanout; ++b) touch(0, b);
+                if (first < len)
+                    for (size_t b = rowBase / kFanout; b <= size_t(rowBase + len - first - 1) / kFanout; ++b) touch(0, b);
+            }
+
+            for (size_t level = 0; level < mLevels.size(); ++level)
+            {
+                for (uint32_t node : mTouched[level])
+                {
+                    // Parents only need a refresh if the extremes of the node changed.
+                    if (reduceNode(level, node) && level + 1 < mLevels.size()) touch(level + 1, node / kFanout);
+                }
+                mTouched[level].clear();
+            }
+        }
+
+        size_t descend(bool cluster) const
+        {
+            const auto& top = mLevels.back();
+            const float target = cluster ? top.maxSet[0] : top.minUnset[0];
+            if (!std::isfinite(target)) return size_t(-1);
+
+            size_t node = 0;
+            for (size_t level = mLevels.size() - 1; level > 0; --level)
+            {
+                const auto& child = mLevels[level - 1];
+                const auto& values = cluster ? child.maxSet : child.minUnset;
+                const size_t begin = node * kFanout;
+                const size_t end = std::min(begin + kFanout, values.size());
+                size_t i = begin;
+                while (i < end && values[i] != target) ++i;
+                node = i;
+            }
+            const size_t begin = node * kFanout;
+            const size_t end = std::min(begin + kFanout, mCellCount);
+            for (size_t i = begin; i < end; ++i)
+                if (isSet(i) == cluster && mEnergy[i] == target) return i;
+            return size_t(-1);
+        }
+
+        uint32_t mWidth, mHeight, mDepth;
+        size_t mCellCount;
+        const Kernel& mKernel;
+        bool mParallel;
+
+        std::vector<float> mPattern;
+        std::vector<float> mEnergy;
+        std::vector<Level> mLevels;
+        std::vector<std::vector<uint32_t>> mTouched;
+        uint32_t mUpdate = 0;
+    };
+
+    /** Rank all cells of one field. ranks must hold W*H*D entries.
+        @return Number of swaps done while relaxing the initial pattern.
+    */
+    inline uint64_t rankField(uint32_t width, uint32_t height, uint32_t depth, const Kernel& kernel, float initialDensity, uint64_t seed, bool parallel, uint32_t* pRanks)
+    {
+        EnergyField field(width, height, depth, kernel, parallel);
+        const size_t n = field.getCellCount();
+        const size_t initialCount = std::clamp<size_t>(size_t(std::llround(double(n) * initialDensity)), 1, std::max<size_t>(1, n / 2));
+
+        // Initial random pattern: partial Fisher-Yates shuffle.
+        std::vector<uint32_t> order(n);
+        for (size_t i = 0; i < n; ++i) order[i] = uint32_t(i);
+        uint64_t state = mix64(seed);
+        for (size_t i = 0; i < initialCount; ++i)
+        {
+            state = mix64(state);
+            size_t j = i + size_t(((state >> 32) * uint64_t(n - i)) >> 32);
+            std::swap(order[i], order[j]);
+        }
+        std::vector<float> pattern(n, 0.f);
+        for (size_t i = 0; i < initialCount; ++i) pattern[order[i]] = 1.f;
+        field.assign(std::move(pattern));
+
+        // Relax: move the tightest cluster into the largest void until that is a no-op.
+        uint64_t swaps = 0;
+        for (size_t iteration = 0; iteration < n; ++iteration)
+        {
+            size_t cluster = field.findTightestCluster();
+            field.set(cluster, false);
+            size_t gap = field.findLargestVoid();
+            if (gap == cluster)
+            {
+                field.set(cluster, true);
+                break;
+            }
+            field.set(gap, true);
+            ++swaps;
+        }
+        const std::vector<float> prototype = field.getPattern();
+
+        // Phase 1: remove the tightest clusters from the prototype, ranks counting down.
+        for (size_t rank = initialCount; rank-- > 0;)
+        {
+            size_t cluster = field.findTightestCluster();
+            pRanks[cluster] = uint32_t(rank);
+            field.set(cluster, false);
+        }
+
+        // Phase 2: fill the largest voids up to half of the cells.
+        field.assign(prototype);
+        const size_t half = n / 2;
+        for (size_t rank = initialCount; rank < half; ++rank)
+        {
+            size_t gap = field.findLargestVoid();
+            pRanks[gap] = uint32_t(rank);
+            field.set(gap, true);
+        }
+
+        // Phase 3: the unset cells are now the minority. Invert and remove their tightest clusters.
+        std::vector<float> inverted = field.getPattern();
+        for (float& v : inverted) v = 1.f - v;
+        field.assign(std::move(inverted));
+        for (size_t rank = half; rank < n; ++rank)
+        {
+            size_t cluster = field.findTightestCluster();
+            pRanks[cluster] = uint32_t(rank);
+            field.set(cluster, false);
+        }
+        return swaps;
+    }
+
+    inline Result generate(const Desc& desc)
+    {
+        if (desc.width == 0 || desc.height == 0 || desc.depth == 0) throw std::invalid_argument("VoidAndCluster: mask dimensions must be non-zero.");
+        // Ranking needs at least one set and one unset cell per field (Spatial2D ranks every slice on its own).
+        const size_t fieldSize = size_t(desc.width) * desc.height * (desc.type == MaskType::Spatial2D ? 1 : desc.depth);
+        if (fieldSize < 2) throw std::invalid_argument("VoidAndCluster: a mask must have at least 2 cells per ranked field.");
+        if (!(desc.initialDensity > 0.f && desc.initialDensity <= 0.5f)) throw std::invalid_argument("VoidAndCluster: initial density must be in (0, 0.5].");
+        if (!(desc.sigma > 0.f && desc.temporalSigma > 0.f)) throw std::invalid_argument("VoidAndCluster: sigma must be positive.");
+
+        const auto startTime = std::chrono::steady_clock::now();
+
+        Result result;
+        result.width = desc.width;
+        result.height = desc.height;
+        result.depth = desc.depth;
+        result.ranks.resize(size_t(desc.width) * desc.height * desc.depth);
+
+        const Kernel kernel = Kernel::create(desc);
+        if (desc.type == MaskType::Spatial2D)
+        {
+            // Independent slices: one slice per task, the energy updates of a slice run nested on the same pool.
+            const size_t sliceSize = size_t(desc.width) * desc.height;
+            result.rankCount = uint32_t(sliceSize);
+            std::vector<uint64_t> swaps(desc.depth, 0);
+            Falcor::Threading::parallelFor(
+                0,
+                desc.depth,
+                [&](size_t s)
+                {
+                    swaps[s] = rankField(
+                        desc.width, desc.height, 1, kernel, desc.initialDensity, mix64(desc.seed + s), desc.parallel, result.ranks.data() + s * sliceSize
+                    );
+                },
+                desc.parallel ? 1 : desc.depth
+            );
+            for (uint64_t s : swaps) result.swaps += s;
+        }
+        else
+        {
+            result.rankCount = uint32_t(result.ranks.size());
+            result.swaps = rankField(desc.width, desc.height, desc.depth, kernel, desc.initialDensity, desc.seed, desc.parallel, result.ranks.data());
+        }
+
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        return result;
+    }
+
+    /// Quantize ranks to 8-bit unorm, floor(rank * 256 / rankCount), as stored in data/dither.
+    inline std::vector<uint8_t> toUnorm8(const Result& result)
+    {
+        std::vector<uint8_t> data(result.ranks.size());
+        for (size_t i = 0; i < data.size(); ++i) data[i] = uint8_t(uint64_t(result.ranks[i]) * 256 / result.rankCount);
+        return data;
+    }
+
+    /// Quantize ranks to 16-bit unorm, floor(rank * 65536 / rankCount).
+    inline std::vector<uint16_t> toUnorm16(const Result& result)
+    {
+        std::vector<uint16_t> data(result.ranks.size());
+        for (size_t i = 0; i < data.size(); ++i) data[i] = uint16_t(uint64_t(result.ranks[i]) * 65536 / result.rankCount);
+        return data;
+    }
+
+    inline std::vector<float> toFloat(const Result& result)
+    {
+        std::vector<float> data(result.ranks.size());
+        for (size_t i = 0; i < data.size(); ++i) data[i] = result.getThreshold(i);
+        return data;
+    }
+} // namespace VoidAndCluster
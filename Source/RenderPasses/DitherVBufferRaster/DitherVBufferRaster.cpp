@@ -26,7 +26,7 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "DitherVBufferRaster.h"
-#include "../DitherVBuffer/PermutationLookup.h"
+#include "../DitherVBuffer/PermutationTables.h"
 #include "Scene/Lighting/LightSettings.h"
 #include "Scene/Lighting/ShadowSettings.h"
 
@@ -39,6 +39,7 @@ namespace
 
     const std::string kUseWhitelist = "useWhitelist";
     const std::string kWhitelist = "whitelist";
+    const std::string kOcclusionCulling = "occlusionCulling";
 }
 
 extern "C" FALCOR_API_EXPORT void registerPlugin(Falcor::PluginRegistry& registry)
@@ -54,8 +55,6 @@ DitherVBufferRaster::DitherVBufferRaster(ref<Device> pDevice, const Properties&
     mpFbo = Fbo::create(mpDevice);
 
     mpSamplePattern = HaltonSamplePattern::create(16);
-    createNoisePattern();
-    setFractalDitherPattern(mFractalDitherPattern);
     Sampler::Desc sd;
     sd.setFilterMode(Sampler::Filter::Linear, Sampler::Filter::Linear, Sampler::Filter::Linear);
     sd.setAddressingMode(Sampler::AddressMode::Wrap, Sampler::AddressMode::Wrap, Sampler::AddressMode::Clamp);
@@ -65,26 +64,17 @@ DitherVBufferRaster::DitherVBufferRaster(ref<Device> pDevice, const Properties&
     mpNoiseSampler = Sampler::create(mpDevice, sd);
 
     //generatePermutations<3>();
-    mpPermutations3x3Buffer = generatePermutations3x3(mpDevice);
-
-    mpBlueNoise3DTex = Texture::createFromFile(mpDevice, "dither/bluenoise3d_16.dds", false, false);
-    mpBlueNoise64Tex = Texture::createFromFile(mpDevice, "dither/bluenoise64.dds", false, false);
-    mpBayer64Tex = Texture::createFromFile(mpDevice, "dither/bayer64.dds", false, false);
+    mpPermutations3x3Buffer = PermutationTables::get().create3x3Buffer(mpDevice);
 
     // load properties
     for (const auto& [key, value] : props)
     {
         if (key == kUseWhitelist) mUseTransparencyWhitelist = value;
+        else if (key == kOcclusionCulling) mOcclusionCulling = value;
         else if (key == kWhitelist)
         {
-            std::stringstream ss;
             std::string svalue = value;
-            ss << svalue;
-            std::string entry;
-            while (std::getline(ss, entry, ','))
-            {
-                mTransparencyWhitelist.insert(entry);
-            }
+            mTransparencyWhitelist.setPatterns(TransparencyWhitelist::parse(svalue));
         }
     }
 }
@@ -94,9 +84,8 @@ Properties DitherVBufferRaster::getProperties() const
     Properties props;
     props[kUseWhitelist] = mUseTransparencyWhitelist;
     // convert whitelist into a comma separated string
-    std::stringstream ss;
-    for (const auto& entry : mTransparencyWhitelist) ss << entry << ",";
-    props[kWhitelist] = ss.str();
+    props[kWhitelist] = mTransparencyWhitelist.toString();
+    props[kOcclusionCulling] = mOcclusionCulling;
     return props;
 }
 
@@ -126,17 +115,13 @@ void DitherVBufferRaster::execute(RenderContext* pRenderContext, const RenderDat
     mpScene->getCamera()->setPatternGenerator(mpSamplePattern, 1.0f / float2(frameDim));
 
     auto var = mpVars->getRootVar();
-    var["gDitherTex"] = mpFracDitherTex;
-    var["gDitherRampTex"] = mpFracDitherRampTex;
+    updateNoiseTextures();
+    mNoiseTextures.bindShaderData(var);
     var["gDitherSampler"] = mpFracSampler;
-    var["gNoiseTex"] = mpNoiseTex;
     var["gNoiseSampler"] = mpNoiseSampler;
-    assert(mpTransparencyWhitelist);
-    var["gTransparencyWhitelist"] = mpTransparencyWhitelist;
+    assert(mTransparencyWhitelist.getBuffer());
+    var["gTransparencyWhitelist"] = mTransparencyWhitelist.getBuffer();
     var["gPermutations3x3"] = mpPermutations3x3Buffer;
-    var["gBlueNoise3DTex"] = mpBlueNoise3DTex;
-    var["gBlueNoise64x64Tex"] = mpBlueNoise64Tex;
-    var["gBayerNoise64Tex"] = mpBayer64Tex;
 
     var["PerFrame"]["gFrameCount"] = mFrameCount++;
     var["PerFrame"]["gSampleCount"] = mpSamplePattern->getSampleCount();
@@ -146,7 +131,7 @@ void DitherVBufferRaster::execute(RenderContext* pRenderContext, const RenderDat
     var["PerFrame"]["gFrameDim"] = frameDim;
 
     var["DitherConstants"]["gGridScale"] = mGridScale;
-    var["DitherConstants"]["gNoiseScale"] = float2(1.0f / mpNoiseTex->getWidth(), 1.0f / mpNoiseTex->getHeight());
+    var["DitherConstants"]["gNoiseScale"] = mNoiseTextures.getNoiseScale();
     var["DitherConstants"]["gRotatePattern"] = mRotatePattern ? 1 : 0;
     var["DitherConstants"]["gObjectHashType"] = uint(mObjectHashType);
     var["DitherConstants"]["gNoiseTop"] = uint(mNoiseTopPattern);
@@ -169,6 +154,7 @@ void DitherVBufferRaster::execute(RenderContext* pRenderContext, const RenderDat
 
     void (Scene::* rasterize)(RenderContext*, GraphicsState*, GraphicsVars*, RasterizerState::CullMode, RasterizerState::MeshRenderMode, bool) = &Scene::rasterize;
     if(mFrustrumCulling) rasterize = &Scene::rasterizeFrustumCulling;
+    mpScene->setCameraOcclusionCulling(mFrustrumCulling && mOcclusionCulling);
 
     auto cullMode = mCullBackFaces ? RasterizerState::CullMode::Back : RasterizerState::CullMode::None;
     {
@@ -209,10 +195,7 @@ void DitherVBufferRaster::renderUI(Gui::Widgets& widget)
     widget.dropdown("Dither", mDitherMode);
     if (mDitherMode == DitherMode::FractalDithering)
     {
-        if (widget.dropdown("Pattern", mFractalDitherPattern))
-        {
-            setFractalDitherPattern(mFractalDitherPattern);
-        }
+        widget.dropdown("Pattern", mFractalDitherPattern);
     }
 
     const bool is2DDither = mDitherMode == DitherMode::PerPixel2x2 ||
@@ -247,10 +230,7 @@ void DitherVBufferRaster::renderUI(Gui::Widgets& widget)
     }
     if (mDitherMode == DitherMode::HashGrid || useTopNoiseGrid)
     {
-        if (widget.dropdown("Noise Pattern", mNoisePattern))
-        {
-            createNoisePattern();
-        }
+        widget.dropdown("Noise Pattern", mNoisePattern);
     }
 
     if (mDitherMode == DitherMode::DitherTemporalAA)
@@ -266,9 +246,19 @@ void DitherVBufferRaster::renderUI(Gui::Widgets& widget)
     }
 
 
+    if (auto g = widget.group("Noise Textures"))
+    {
+        mNoiseTextures.renderUI(g);
+    }
+
     if (auto g = widget.group("Scene"))
     {
         widget.checkbox("Frustrum Culling", mFrustrumCulling);
+        if (mFrustrumCulling)
+        {
+            widget.checkbox("Occlusion Culling", mOcclusionCulling);
+            widget.tooltip("Skip instances behind large opaque meshes. The occluders are rasterized on the CPU.");
+        }
 
         widget.dropdown("Object Hash", mObjectHashType);
 
@@ -282,12 +272,18 @@ void DitherVBufferRaster::renderUI(Gui::Widgets& widget)
         if (mUseTransparencyWhitelist && mpScene)
         {
             auto g2 = widget.group("Whitelist");
-            std::string removeEntry;
+            std::string patterns = mTransparencyWhitelist.toString();
+            if (g2.textbox("Patterns", patterns))
+            {
+                mTransparencyWhitelist.setPatterns(TransparencyWhitelist::parse(patterns));
+                updateWhitelistBuffer();
+            }
+            g2.tooltip("Comma-separated material names, globs (*, ?, [a-z]) or regular expressions (re:<regex>).");
             // list all material names of the current scene
             for (uint mat = 0; mat < mpScene->getMaterialCount(); ++mat)
             {
                 std::string name = mpScene->getMaterial(MaterialID(mat))->getName();
-                bool isTransparent = mTransparencyWhitelist.find(name) != mTransparencyWhitelist.end();
+                bool isTransparent = mTransparencyWhitelist.isWhitelisted(mat);
                 if (g2.checkbox(name.c_str(), isTransparent))
                 {
                     if (isTransparent) mTransparencyWhitelist.insert(name);
@@ -306,27 +302,6 @@ void DitherVBufferRaster::setScene(RenderContext* pRenderContext, const ref<Scen
     mUseTransparencyWhitelist = updateWhitelistBuffer();
 }
 
-void DitherVBufferRaster::setFractalDitherPattern(DitherPattern pattern)
-{
-    mFractalDitherPattern = pattern;
-    std::string texname;
-    switch (pattern)
-    {
-    case DitherPattern::Dither2x2:
-        texname = "dither/Dither3D_2x2";
-        break;
-    case DitherPattern::Dither4x4:
-        texname = "dither/Dither3D_4x4";
-        break;
-    case DitherPattern::Dither8x8:
-        texname = "dither/Dither3D_8x8";
-        break;
-    }
-    mpFracDitherTex = Texture::createFromFile(mpDevice, texname + ".dds", false, false);
-    mpFracDitherRampTex = Texture::createFromFile(mpDevice, texname + "_ramp.dds", false, false);
-
-}
-
 void DitherVBufferRaster::setupProgram()
 {
     if (!mpScene) return;
@@ -345,65 +320,11 @@ void DitherVBufferRaster::setupProgram()
 
 bool DitherVBufferRaster::updateWhitelistBuffer()
 {
-    if (!mpScene) return true;
-    bool any = false;
-
-    // Calculate the number of uint32_t elements needed to store all bits
-    uint32_t materialCount = mpScene->getMaterialCount();
-    uint32_t uintCount = (materialCount + 31) / 32; // Round up to the nearest uint32_t
-
-    std::vector<uint32_t> whitelist(uintCount, 0); // Initialize all bits to 0
-
-    // Pack the boolean values into bits
-    for (uint32_t mat = 0; mat < materialCount; ++mat)
-    {
-        std::string name = mpScene->getMaterial(MaterialID(mat))->getName();
-        bool isTransparent = mTransparencyWhitelist.find(name) != mTransparencyWhitelist.end();
-        any |= isTransparent;
-
-        if (isTransparent)
-        {
-            // Set the corresponding bit in the whitelist
-            uint32_t uintIndex = mat / 32;
-            uint32_t bitIndex = mat % 32;
-            whitelist[uintIndex] |= (1 << bitIndex);
-        }
-    }
-
-    mpTransparencyWhitelist = Buffer::createStructured(mpDevice, sizeof(uint32_t), uintCount, ResourceBindFlags::ShaderResource, Buffer::CpuAccess::None, whitelist.data(), false);
-
-    return any;
+    return mTransparencyWhitelist.update(mpDevice, mpScene);
 }
 
-void DitherVBufferRaster::createNoisePattern()
+void DitherVBufferRaster::updateNoiseTextures()
 {
-    std::string texname;
-    switch (mNoisePattern)
-    {
-    case NoisePattern::White:
-        texname = "dither/whitenoise1024.dds";
-        break;
-    case NoisePattern::Blue:
-        texname = "dither/bluenoise1024.dds";
-        break;
-    case NoisePattern::Bayer:
-        texname = "dither/bayer_matrix.dds";
-        break;
-    case NoisePattern::BlueBayer:
-        texname = "dither/blue_bayer.dds";
-        break;
-    case NoisePattern::Poisson:
-        texname = "dither/poisson1024.dds";
-        break;
-    case NoisePattern::Perlin:
-        texname = "dither/perlin1024.dds";
-        break;
-    case NoisePattern::Blue64:
-        texname = "dither/bluenoise64.dds";
-        break;
-    default:
-        assert(false);
-    }
-
-    mpNoiseTex = Texture::createFromFile(mpDevice, texname, false, false);
+    // the raster shader has no STBN modes, so the variant does not matter
+    mNoiseTextures.update(mpDevice, DitherVBuffer::getNoiseTexturePaths(mDitherMode, mNoiseTopPattern, mNoisePattern, DitherVBuffer::STBNNoise::Scalar, mFractalDitherPattern));
 }
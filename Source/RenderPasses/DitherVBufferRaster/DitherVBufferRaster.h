@@ -57,14 +57,13 @@ public:
     virtual bool onKeyEvent(const KeyboardEvent& keyEvent) override { return false; }
 
 private:
-    void setFractalDitherPattern(DitherPattern pattern);
     void setupProgram();
     // returns true if at least one material was whitelisted (or scene was invalid)
     bool updateWhitelistBuffer();
-    void createNoisePattern();
+    // loads the noise textures used by the current settings and releases the others
+    void updateNoiseTextures();
 
     ref<Scene> mpScene;
-    ref<Buffer> mpTransparencyWhitelist;
     ref<Buffer> mpPermutations3x3Buffer;
 
     uint mFrameCount = 0;
@@ -73,7 +72,7 @@ private:
     DitherMode mDitherMode = DitherMode::PerPixel3x3;
     bool mUseAlphaTextureLOD = false; // use lod for alpha lookups
     bool mUseTransparencyWhitelist = false;
-    std::set<std::string> mTransparencyWhitelist;
+    TransparencyWhitelist mTransparencyWhitelist;
     CoverageCorrection mCoverageCorrection = CoverageCorrection::DLSS;
     float mDLSSCorrectionStrength = 1.0;
     DitherPattern mFractalDitherPattern = DitherPattern::Dither8x8;
@@ -86,14 +85,9 @@ private:
     ref<GraphicsVars> mpVars;
     ref<Fbo> mpFbo;
 
-    ref<Texture> mpFracDitherTex;
-    ref<Texture> mpFracDitherRampTex;
     ref<Sampler> mpFracSampler;
-    ref<Texture> mpNoiseTex;
     ref<Sampler> mpNoiseSampler;
-    ref<Texture> mpBlueNoise3DTex;
-    ref<Texture> mpBlueNoise64Tex;
-    ref<Texture> mpBayer64Tex;
+    NoiseTextureSet mNoiseTextures;
 
     NoisePattern mNoisePattern = NoisePattern::Blue;
     NoiseTopPattern mNoiseTopPattern = NoiseTopPattern::StaticBlue;
@@ -102,4 +96,5 @@ private:
     bool mRotatePattern = true; // rotate pattern when using pixel grid techniques
     bool mDitherTAAPermutations = true;
     bool mFrustrumCulling = true;
+    bool mOcclusionCulling = false;
 };
@@ -36,6 +36,7 @@ namespace
     const std::string kColor = "color";
 
     const std::string kWhitelist = "whitelist";
+    const std::string kOcclusionCulling = "occlusionCulling";
 
     const std::string kProgramFile = "RenderPasses/RasterOITDynFragment/BuildList.3D.slang";
     const std::string kSortFile = "RenderPasses/RasterOITDynFragment/Sort.slang";
@@ -84,11 +85,19 @@ RasterOITDynFragment::RasterOITDynFragment(ref<Device> pDevice, const Properties
     {
         pass->setVars(mpSortPass->getVars());
     }
+
+    // load properties
+    for (const auto& [key, value] : props)
+    {
+        if (key == kOcclusionCulling) mOcclusionCulling = value;
+    }
 }
 
 Properties RasterOITDynFragment::getProperties() const
 {
-    return {};
+    Properties props;
+    props[kOcclusionCulling] = mOcclusionCulling;
+    return props;
 }
 
 RenderPassReflection RasterOITDynFragment::reflect(const CompileData& compileData)
@@ -151,6 +160,7 @@ void RasterOITDynFragment::execute(RenderContext* pRenderContext, const RenderDa
     {
         mpCulling = make_ref<FrustumCulling>(camera);
     }
+    mpCulling->setOcclusionCullingEnabled(mOcclusionCulling);
 
     mpCulling->setUserCallback([&](const MeshDesc& mesh)
         {
@@ -249,6 +259,9 @@ void RasterOITDynFragment::renderUI(Gui::Widgets& widget)
     widget.text("Size in MB: " + std::to_string(sizeInBytes / (1024u * 1024u)));
 
     widget.checkbox("Optimize Sort", mOptimizeSort);
+
+    widget.checkbox("Occlusion Culling", mOcclusionCulling);
+    widget.tooltip("Skip transparent instances behind large opaque meshes. The occluders are rasterized on the CPU.");
 }
 
 void RasterOITDynFragment::setScene(RenderContext* pRenderContext, const ref<Scene>& pScene)
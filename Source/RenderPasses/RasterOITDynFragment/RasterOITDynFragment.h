@@ -76,6 +76,7 @@ private:
 
     uint mDataBufferSize = 1024 * 1024 * 40;
     ref<FrustumCulling> mpCulling;
+    bool mOcclusionCulling = false;
 
     static const UINT64 s_scanWorkgroup = 1024;
     static const UINT64 s_scanLocal = 8;
@@ -38,6 +38,7 @@ namespace
     const std::string kPixelCount = "pixelCount";
 
     const std::string kWhitelist = "whitelist";
+    const std::string kOcclusionCulling = "occlusionCulling";
 
     const std::string kProgramFile = "RenderPasses/RasterOITLinkedList/BuildList.3D.slang";
     const std::string kSortFile = "RenderPasses/RasterOITLinkedList/SortList.slang";
@@ -79,11 +80,19 @@ RasterOITLinkedList::RasterOITLinkedList(ref<Device> pDevice, const Properties&
         mpOptimizedSortPasses.push_back(ComputePass::create(mpDevice, desc, d));
         mpOptimizedSortPasses.back()->setVars(mpSortPass->getVars());
     }
+
+    // load properties
+    for (const auto& [key, value] : props)
+    {
+        if (key == kOcclusionCulling) mOcclusionCulling = value;
+    }
 }
 
 Properties RasterOITLinkedList::getProperties() const
 {
-    return {};
+    Properties props;
+    props[kOcclusionCulling] = mOcclusionCulling;
+    return props;
 }
 
 RenderPassReflection RasterOITLinkedList::reflect(const CompileData& compileData)
@@ -162,6 +171,7 @@ void RasterOITLinkedList::execute(RenderContext* pRenderContext, const RenderDat
         {
             mpCulling = make_ref<FrustumCulling>(camera);
         }
+        mpCulling->setOcclusionCullingEnabled(mOcclusionCulling);
 
         mpCulling->setUserCallback([&](const MeshDesc& mesh)
         {
@@ -214,6 +224,9 @@ void RasterOITLinkedList::renderUI(Gui::Widgets& widget)
     widget.text("Size in MB: " + std::to_string(sizeInBytes / (1024u * 1024u)));
 
     widget.checkbox("Optimize Sort", mOptimizeSort);
+
+    widget.checkbox("Occlusion Culling", mOcclusionCulling);
+    widget.tooltip("Skip transparent instances behind large opaque meshes. The occluders are rasterized on the CPU.");
 }
 
 void RasterOITLinkedList::setScene(RenderContext* pRenderContext, const ref<Scene>& pScene)
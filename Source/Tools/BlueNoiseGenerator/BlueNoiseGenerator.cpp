@@ -0,0 +1,184 @@
+/***************************************************************************
+ # Copyright (c) 2015-22, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Falcor.h"
+#include "Utils/Image/ImageIO.h"
+#include "../../RenderPasses/DitherVBuffer/VoidAndCluster.h"
+
+#include <args.hxx>
+
+#include <iostream>
+
+using namespace Falcor;
+
+/** Generates blue-noise dither masks with the void-and-cluster method (VoidAndCluster.h).
+
+    The output is an uncompressed single-channel DDS file in the layout of the masks in data/dither:
+    - 2d:   independent 2D masks stored as a 2D texture array (e.g. bluenoise64.dds with 1 slice).
+    - 3d:   a single 3D mask stored as a 2D texture array of its layers (e.g. bluenoise3d_16.dds).
+    - stbn: a spatiotemporal mask, one 2D texture array slice per frame (e.g. spatiotemporal_bluenoise.dds).
+    Pass --volume to store the slices as a 3D texture instead.
+*/
+
+namespace
+{
+VoidAndCluster::MaskType parseType(const std::string& str)
+{
+    if (str == "2d") return VoidAndCluster::MaskType::Spatial2D;
+    if (str == "3d") return VoidAndCluster::MaskType::Volume3D;
+    if (str == "stbn") return VoidAndCluster::MaskType::SpatioTemporal;
+    throw ArgumentError("Unknown mask type '{}'.", str);
+}
+
+ResourceFormat parseFormat(const std::string& str)
+{
+    if (str == "r8") return ResourceFormat::R8Unorm;
+    if (str == "r16") return ResourceFormat::R16Unorm;
+    if (str == "r32f") return ResourceFormat::R32Float;
+    throw ArgumentError("Unknown output format '{}'.", str);
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    args::ArgumentParser parser("Void-and-cluster generator for blue-noise and spatiotemporal blue-noise dither masks.");
+    parser.helpParams.programName = "BlueNoiseGenerator";
+    args::HelpFlag helpFlag(parser, "help", "Display this help menu.", {'h', "help"});
+    args::ValueFlag<std::string> typeFlag(parser, "type", "Mask type: 2d (default), 3d or stbn.", {'t', "type"});
+    args::ValueFlag<uint32_t> widthFlag(parser, "width", "Mask width (default 64).", {'W', "width"});
+    args::ValueFlag<uint32_t> heightFlag(parser, "height", "Mask height (default 64).", {'H', "height"});
+    args::ValueFlag<uint32_t> slicesFlag(parser, "slices", "Number of slices, layers or frames (default 1).", {'s', "slices"});
+    args::ValueFlag<float> sigmaFlag(parser, "sigma", "Spatial energy kernel standard deviation (default 1.9).", {"sigma"});
+    args::ValueFlag<float> temporalSigmaFlag(parser, "sigma", "Temporal energy kernel standard deviation (default 1.9).", {"temporal-sigma"});
+    args::ValueFlag<uint32_t> radiusFlag(parser, "radius", "Kernel truncation radius (default ceil(3 * sigma)).", {"radius"});
+    args::ValueFlag<float> densityFlag(parser, "density", "Density of the initial binary pattern (default 0.1).", {"density"});
+    args::ValueFlag<uint64_t> seedFlag(parser, "seed", "Random seed.", {"seed"});
+    args::ValueFlag<uint32_t> threadsFlag(parser, "threads", "Worker threads (default one per logical core).", {'j', "threads"});
+    args::ValueFlag<std::string> formatFlag(parser, "format", "Output format: r8 (default), r16 or r32f.", {'f', "format"});
+    args::Flag volumeFlag(parser, "volume", "Store the slices as a 3D texture instead of a 2D texture array.", {"volume"});
+    args::Positional<std::string> outputArg(parser, "output", "Output DDS file.", args::Options::Required);
+    args::CompletionFlag completionFlag(parser, {"complete"});
+
+    try
+    {
+        parser.ParseCLI(argc, argv);
+    }
+    catch (const args::Completion& e)
+    {
+        std::cout << e.what();
+        return 0;
+    }
+    catch (const args::Help&)
+    {
+        std::cout << parser;
+        return 0;
+    }
+    catch (const args::ParseError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    catch (const args::RequiredError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+
+    Threading::start(threadsFlag ? args::get(threadsFlag) : Threading::getLogicalThreadCount());
+
+    try
+    {
+        VoidAndCluster::Desc desc;
+        if (typeFlag) desc.type = parseType(args::get(typeFlag));
+        if (widthFlag) desc.width = args::get(widthFlag);
+        if (heightFlag) desc.height = args::get(heightFlag);
+        if (slicesFlag) desc.depth = args::get(slicesFlag);
+        if (sigmaFlag) desc.sigma = args::get(sigmaFlag);
+        if (temporalSigmaFlag) desc.temporalSigma = args::get(temporalSigmaFlag);
+        if (radiusFlag) desc.kernelRadius = args::get(radiusFlag);
+        if (densityFlag) desc.initialDensity = args::get(densityFlag);
+        if (seedFlag) desc.seed = args::get(seedFlag);
+        if (threadsFlag) desc.parallel = args::get(threadsFlag) > 1;
+        const ResourceFormat format = formatFlag ? parseFormat(args::get(formatFlag)) : ResourceFormat::R8Unorm;
+
+        VoidAndCluster::Result result;
+        try
+        {
+            result = VoidAndCluster::generate(desc);
+        }
+        catch (const std::invalid_argument& e)
+        {
+            throw ArgumentError("{}", e.what());
+        }
+
+        std::cout << fmt::format(
+                         "Generated {}x{}x{} mask ({} ranks per field, {} relaxation swaps) in {:.3f}s", result.width, result.height,
+                         result.depth, result.rankCount, result.swaps, result.seconds
+                     )
+                  << std::endl;
+
+        const void* pData = nullptr;
+        std::vector<uint8_t> unorm8;
+        std::vector<uint16_t> unorm16;
+        std::vector<float> float32;
+        switch (format)
+        {
+        case ResourceFormat::R8Unorm:
+            unorm8 = VoidAndCluster::toUnorm8(result);
+            pData = unorm8.data();
+            break;
+        case ResourceFormat::R16Unorm:
+            unorm16 = VoidAndCluster::toUnorm16(result);
+            pData = unorm16.data();
+            break;
+        default:
+            float32 = VoidAndCluster::toFloat(result);
+            pData = float32.data();
+            break;
+        }
+
+        const std::filesystem::path path = args::get(outputArg);
+        const Resource::Type type = volumeFlag ? Resource::Type::Texture3D : Resource::Type::Texture2D;
+        ImageIO::saveToDDS(path, format, type, result.width, result.height, result.depth, pData);
+        std::cout << fmt::format(
+                         "Wrote '{}' ({}, {:.1f} KB)", path.string(), volumeFlag ? "3D texture" : "2D texture array",
+                         result.ranks.size() * getFormatBytesPerBlock(format) / 1024.0
+                     )
+                  << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        Threading::shutdown();
+        return 1;
+    }
+
+    Threading::shutdown();
+    return 0;
+}
@@ -0,0 +1,437 @@
+/***************************************************************************
+ # Copyright (c) 2015-22, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Falcor.h"
+#include "Utils/Timing/CpuTimer.h"
+#include "../../RenderPasses/DitherVBuffer/DitherReference.h"
+
+#include <args.hxx>
+#include <nlohmann/json.hpp>
+
+#include <fstream>
+#include <iostream>
+
+using namespace Falcor;
+
+/** Temporal coverage-convergence benchmark for the DitherVBuffer modes.
+
+    Renders synthetic stacks of full-screen transparent layers in front of an opaque background with the
+    CPU reference of the dither decisions (DitherReference.h) for a number of frames with a static camera.
+    For every pixel and layer the visibility (first kept layer, or the RIS selection) is accumulated over
+    time and compared against the expected coverage alpha_k * prod_{j<k}(1 - alpha_j), which is what a
+    temporal accumulator converges to for an unbiased mode.
+
+    Reported per (mode, configuration):
+    - bias / absBias: signed / absolute difference of the temporal mean and the expected coverage.
+    - rmsError: RMS over all pixels of that difference after the last frame.
+    - temporalVariance: per-pixel variance of the visibility over time.
+    - flickerEnergy: mean squared change of the visibility between consecutive frames.
+    - framesToConverge: first frame count after which the RMS error of the running mean stays below
+      the tolerance (-1 if it never does).
+
+    All (mode, configuration) jobs run in parallel, and each frame is evaluated tile-parallel.
+*/
+
+namespace
+{
+using DitherReference::Mode;
+
+struct ModeDesc
+{
+    Mode mode;
+    const char* name;
+};
+
+const ModeDesc kModes[] = {
+    {Mode::PerPixel2x2, "PerPixel2x2"},
+    {Mode::PerPixel3x3, "PerPixel3x3"},
+    {Mode::PerPixel4x4, "PerPixel4x4"},
+    {Mode::RussianRoulette, "RussianRoulette"},
+    {Mode::Periodic, "Periodic"},
+    {Mode::HashGrid, "HashGrid"},
+    {Mode::FractalDithering, "FractalDithering"},
+    {Mode::BlueNoise3D, "BlueNoise3D"},
+    {Mode::DitherTemporalAA, "DitherTemporalAA"},
+    {Mode::SpatioTemporalBlueNoise, "SpatioTemporalBlueNoise"},
+    {Mode::SurfaceSpatioTemporalBlueNoise, "SurfaceSpatioTemporalBlueNoise"},
+    {Mode::Adaptive, "Adaptive"},
+    {Mode::RIS, "RIS"},
+};
+
+/// Synthetic alpha configuration: a stack of full-screen layers, front to back.
+struct LayerConfig
+{
+    std::string name;
+    std::vector<float> alphas; ///< Alpha of each layer (ignored for the gradient).
+    bool gradient = false;     ///< Single layer with alpha going from 0 to 1 across the screen.
+};
+
+/// Surface samples and expected coverage of a configuration.
+struct LayerStack
+{
+    const LayerConfig* pConfig = nullptr;
+    std::vector<std::vector<DitherReference::PixelInput>> layers; ///< [layer][pixel]
+    std::vector<std::vector<float>> expected;                     ///< [layer][pixel]
+};
+
+struct Metrics
+{
+    double bias = 0.0;
+    double absBias = 0.0;
+    double rmsError = 0.0;
+    double temporalVariance = 0.0;
+    double flickerEnergy = 0.0;
+    int framesToConverge = -1;
+    double seconds = 0.0;
+};
+
+struct BenchmarkDesc
+{
+    uint2 frameDim = uint2(64);
+    uint32_t frameCount = 64;
+    double tolerance = 0.02;
+    DitherReference::Params params;
+};
+
+LayerStack createLayerStack(const LayerConfig& config, uint2 frameDim)
+{
+    const size_t pixelCount = size_t(frameDim.x) * frameDim.y;
+    const size_t layerCount = config.gradient ? 1 : config.alphas.size();
+
+    LayerStack stack;
+    stack.pConfig = &config;
+    stack.layers.resize(layerCount, std::vector<DitherReference::PixelInput>(pixelCount));
+    stack.expected.resize(layerCount, std::vector<float>(pixelCount));
+
+    for (uint32_t y = 0; y < frameDim.y; ++y)
+    {
+        for (uint32_t x = 0; x < frameDim.x; ++x)
+        {
+            const size_t i = size_t(y) * frameDim.x + x;
+            float transmittance = 1.f;
+            for (size_t k = 0; k < layerCount; ++k)
+            {
+                // Layers are parallel quads at increasing depth, each a separate instance.
+                DitherReference::PixelInput& in = stack.layers[k][i];
+                in.alpha = config.gradient ? (x + 0.5f) / frameDim.x : config.alphas[k];
+                in.posW = float3(x * 0.01f, y * 0.01f, float(k));
+                in.texC = (float2(x, y) + 0.5f) / float2(frameDim);
+                in.ddx = float2(1.f / frameDim.x, 0.f);
+                in.ddy = float2(0.f, 1.f / frameDim.y);
+                in.rayT = 2.f + k;
+                in.instanceID = uint32_t(k);
+
+                // Alpha below the shader's 0.01 cutoff is never kept, opaque layers always are.
+                float alpha = in.alpha <= 0.01f ? 0.f : std::min(in.alpha, 1.f);
+                stack.expected[k][i] = transmittance * alpha;
+                transmittance *= 1.f - alpha;
+            }
+        }
+    }
+    return stack;
+}
+
+Metrics runBenchmark(Mode mode, const LayerStack& stack, const DitherReference::Resources& res, const BenchmarkDesc& desc)
+{
+    CpuTimer timer;
+    timer.update();
+
+    const uint2 frameDim = desc.frameDim;
+    const size_t pixelCount = size_t(frameDim.x) * frameDim.y;
+    const size_t layerCount = stack.layers.size();
+
+    std::vector<std::vector<uint8_t>> masks(layerCount, std::vector<uint8_t>(pixelCount));
+    std::vector<uint8_t> visible(layerCount * pixelCount);
+    std::vector<uint8_t> previous(layerCount * pixelCount);
+    std::vector<uint32_t> visibleCount(layerCount * pixelCount, 0);
+    std::vector<double> frameError(desc.frameCount);
+    uint64_t flickerCount = 0;
+
+    std::vector<DitherReference::PixelInput> pixelLayers(layerCount);
+    for (uint32_t frame = 0; frame < desc.frameCount; ++frame)
+    {
+        if (mode == Mode::RIS)
+        {
+            for (size_t i = 0; i < pixelCount; ++i)
+            {
+                for (size_t k = 0; k < layerCount; ++k) pixelLayers[k] = stack.layers[k][i];
+                const uint2 pixel(uint32_t(i % frameDim.x), uint32_t(i / frameDim.x));
+                int selected = DitherReference::selectRisCandidate(desc.params, pixel, frame, pixelLayers.data(), layerCount);
+                for (size_t k = 0; k < layerCount; ++k) visible[k * pixelCount + i] = int(k) == selected ? 1 : 0;
+            }
+        }
+        else
+        {
+            for (size_t k = 0; k < layerCount; ++k)
+                DitherReference::evaluateCoverage(mode, desc.params, res, frameDim, frame, stack.layers[k].data(), masks[k].data());
+
+            // The closest kept layer is visible.
+            for (size_t i = 0; i < pixelCount; ++i)
+            {
+                uint8_t occluded = 0;
+                for (size_t k = 0; k < layerCount; ++k)
+                {
+                    visible[k * pixelCount + i] = masks[k][i] & uint8_t(!occluded);
+                    occluded |= masks[k][i];
+                }
+            }
+        }
+
+        double errorSum = 0.0;
+        for (size_t j = 0; j < visible.size(); ++j)
+        {
+            visibleCount[j] += visible[j];
+            if (frame > 0) flickerCount += visible[j] ^ previous[j];
+            double error = double(visibleCount[j]) / (frame + 1) - stack.expected[j / pixelCount][j % pixelCount];
+            errorSum += error * error;
+        }
+        frameError[frame] = std::sqrt(errorSum / visible.size());
+        std::swap(visible, previous);
+    }
+
+    Metrics metrics;
+    const double sampleCount = double(layerCount * pixelCount);
+    for (size_t j = 0; j < visibleCount.size(); ++j)
+    {
+        // Visibility is binary, so E[v^2] = E[v].
+        double mean = double(visibleCount[j]) / desc.frameCount;
+        double error = mean - stack.expected[j / pixelCount][j % pixelCount];
+        metrics.bias += error;
+        metrics.absBias += std::abs(error);
+        metrics.temporalVariance += mean - mean * mean;
+    }
+    metrics.bias /= sampleCount;
+    metrics.absBias /= sampleCount;
+    metrics.temporalVariance /= sampleCount;
+    metrics.rmsError = frameError.back();
+    metrics.flickerEnergy = desc.frameCount > 1 ? double(flickerCount) / (sampleCount * (desc.frameCount - 1)) : 0.0;
+
+    // Converged after F frames if the error stays below the tolerance for all F' >= F.
+    if (frameError.back() <= desc.tolerance)
+    {
+        uint32_t frame = desc.frameCount;
+        while (frame > 0 && frameError[frame - 1] <= desc.tolerance) --frame;
+        metrics.framesToConverge = int(frame) + 1;
+    }
+
+    timer.update();
+    metrics.seconds = timer.delta();
+    return metrics;
+}
+
+std::vector<LayerConfig> getDefaultConfigs()
+{
+    std::vector<LayerConfig> configs;
+    for (float alpha : {0.1f, 0.25f, 0.5f, 0.75f, 0.9f}) configs.push_back({fmt::format("constant_{}", alpha), {alpha}});
+    configs.push_back({"gradient", {}, true});
+    configs.push_back({"stack_0.5_0.5", {0.5f, 0.5f}});
+    configs.push_back({"stack_0.25_0.5_0.75", {0.25f, 0.5f, 0.75f}});
+    return configs;
+}
+
+/// Parse a layer stack given as comma-separated alphas, e.g. "0.3,0.6".
+LayerConfig parseStack(const std::string& str)
+{
+    LayerConfig config;
+    config.name = "stack";
+    size_t pos = 0;
+    while (pos <= str.size())
+    {
+        size_t end = std::min(str.find(',', pos), str.size());
+        std::string token = str.substr(pos, end - pos);
+        try
+        {
+            config.alphas.push_back(std::stof(token));
+        }
+        catch (const std::exception&)
+        {
+            throw ArgumentError("Invalid alpha '{}' in layer stack '{}'.", token, str);
+        }
+        config.name += "_" + token;
+        pos = end + 1;
+    }
+    return config;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    args::ArgumentParser parser("Temporal coverage-convergence benchmark for the DitherVBuffer modes.");
+    parser.helpParams.programName = "DitherConvergenceBenchmark";
+    args::HelpFlag helpFlag(parser, "help", "Display this help menu.", {'h', "help"});
+    args::ValueFlag<uint32_t> widthFlag(parser, "width", "Frame width (default 64).", {'W', "width"});
+    args::ValueFlag<uint32_t> heightFlag(parser, "height", "Frame height (default 64).", {'H', "height"});
+    args::ValueFlag<uint32_t> framesFlag(parser, "frames", "Number of frames (default 64).", {'f', "frames"});
+    args::ValueFlag<double> toleranceFlag(parser, "tolerance", "RMS error tolerance for convergence (default 0.02).", {'t', "tolerance"});
+    args::ValueFlagList<std::string> stackFlag(
+        parser, "alphas", "Layer stack as comma-separated alphas, front to back. Replaces the default configurations.", {'s', "stack"}
+    );
+    args::ValueFlag<std::string> modeFlag(parser, "mode", "Only run the given mode.", {'m', "mode"});
+    args::ValueFlag<float> gridScaleFlag(parser, "scale", "Hash grid / fractal dither scale (log2, default 0.5).", {"grid-scale"});
+    args::ValueFlag<std::string> correctionFlag(parser, "correction", "Coverage correction: Disabled (default), DLSS or FSR.", {"correction"});
+    args::ValueFlag<std::string> dataFlag(parser, "dir", "Additional data directory to search for the dither textures.", {'d', "data"});
+    args::ValueFlag<std::string> csvFlag(parser, "path", "Write the results as CSV.", {"csv"});
+    args::ValueFlag<std::string> jsonFlag(parser, "path", "Write the results as JSON.", {"json"});
+    args::CompletionFlag completionFlag(parser, {"complete"});
+
+    try
+    {
+        parser.ParseCLI(argc, argv);
+    }
+    catch (const args::Completion& e)
+    {
+        std::cout << e.what();
+        return 0;
+    }
+    catch (const args::Help&)
+    {
+        std::cout << parser;
+        return 0;
+    }
+    catch (const args::ParseError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+
+    try
+    {
+        BenchmarkDesc desc;
+        desc.frameDim = uint2(widthFlag ? args::get(widthFlag) : 64, heightFlag ? args::get(heightFlag) : 64);
+        desc.frameCount = framesFlag ? args::get(framesFlag) : 64;
+        desc.tolerance = toleranceFlag ? args::get(toleranceFlag) : 0.02;
+        if (desc.frameDim.x == 0 || desc.frameDim.y == 0 || desc.frameCount == 0) throw ArgumentError("Frame size and count must be non-zero.");
+
+        // Measure the raw dither decisions by default, the correction curves are tuned for a specific upscaler.
+        desc.params.coverageCorrection = DitherReference::CoverageCorrection::Disabled;
+        if (correctionFlag)
+        {
+            const std::string& correction = args::get(correctionFlag);
+            if (correction == "DLSS") desc.params.coverageCorrection = DitherReference::CoverageCorrection::DLSS;
+            else if (correction == "FSR") desc.params.coverageCorrection = DitherReference::CoverageCorrection::FSR;
+            else if (correction != "Disabled") throw ArgumentError("Unknown coverage correction '{}'.", correction);
+        }
+
+        if (gridScaleFlag) desc.params.gridScale = args::get(gridScaleFlag);
+
+        std::vector<ModeDesc> modes;
+        for (const auto& mode : kModes)
+            if (!modeFlag || args::get(modeFlag) == mode.name) modes.push_back(mode);
+        if (modes.empty()) throw ArgumentError("Unknown mode '{}'.", args::get(modeFlag));
+
+        std::vector<LayerConfig> configs;
+        if (stackFlag)
+            for (const auto& str : args::get(stackFlag)) configs.push_back(parseStack(str));
+        else configs = getDefaultConfigs();
+
+        if (dataFlag) addDataDirectory(args::get(dataFlag), true);
+        const DitherReference::TextureSet textures = DitherReference::TextureSet::load();
+        DitherReference::Resources res = DitherReference::Resources::fromPermutationTables();
+        textures.bind(res);
+
+        CpuTimer timer;
+        timer.update();
+
+        std::vector<LayerStack> stacks;
+        for (const auto& config : configs) stacks.push_back(createLayerStack(config, desc.frameDim));
+
+        // One job per (mode, configuration), results are stored by job index so the output order is fixed.
+        const size_t jobCount = modes.size() * stacks.size();
+        std::vector<Metrics> results(jobCount);
+        NumericRange<size_t> jobRange(0, jobCount);
+        std::for_each(
+            std::execution::par,
+            jobRange.begin(),
+            jobRange.end(),
+            [&](size_t job) { results[job] = runBenchmark(modes[job / stacks.size()].mode, stacks[job % stacks.size()], res, desc); }
+        );
+
+        timer.update();
+
+        std::cout << fmt::format(
+                         "{:<32} {:<24} {:>9} {:>9} {:>9} {:>9} {:>9} {:>7}", "mode", "config", "bias", "absBias", "rmsError", "variance",
+                         "flicker", "frames"
+                     )
+                  << std::endl;
+        nlohmann::json json = nlohmann::json::array();
+        std::string csv = "mode,config,layers,width,height,frames,bias,absBias,rmsError,temporalVariance,flickerEnergy,framesToConverge,seconds\n";
+        for (size_t job = 0; job < jobCount; ++job)
+        {
+            const ModeDesc& mode = modes[job / stacks.size()];
+            const LayerStack& stack = stacks[job % stacks.size()];
+            const Metrics& m = results[job];
+            std::cout << fmt::format(
+                             "{:<32} {:<24} {:>9.5f} {:>9.5f} {:>9.5f} {:>9.5f} {:>9.5f} {:>7}", mode.name, stack.pConfig->name, m.bias,
+                             m.absBias, m.rmsError, m.temporalVariance, m.flickerEnergy, m.framesToConverge
+                         )
+                      << std::endl;
+            csv += fmt::format(
+                "{},{},{},{},{},{},{:.6f},{:.6f},{:.6f},{:.6f},{:.6f},{},{:.6f}\n", mode.name, stack.pConfig->name, stack.layers.size(),
+                desc.frameDim.x, desc.frameDim.y, desc.frameCount, m.bias, m.absBias, m.rmsError, m.temporalVariance, m.flickerEnergy,
+                m.framesToConverge, m.seconds
+            );
+            json.push_back({
+                {"mode", mode.name},
+                {"config", stack.pConfig->name},
+                {"layers", stack.layers.size()},
+                {"width", desc.frameDim.x},
+                {"height", desc.frameDim.y},
+                {"frames", desc.frameCount},
+                {"bias", m.bias},
+                {"absBias", m.absBias},
+                {"rmsError", m.rmsError},
+                {"temporalVariance", m.temporalVariance},
+                {"flickerEnergy", m.flickerEnergy},
+                {"framesToConverge", m.framesToConverge},
+                {"seconds", m.seconds},
+            });
+        }
+        std::cout << fmt::format("{} jobs ({} modes x {} configurations) in {:.3f}s", jobCount, modes.size(), stacks.size(), timer.delta())
+                  << std::endl;
+
+        if (csvFlag)
+        {
+            std::ofstream fs(args::get(csvFlag));
+            fs << csv;
+            if (!fs) throw RuntimeError("Failed to write '{}'.", args::get(csvFlag));
+        }
+        if (jsonFlag)
+        {
+            std::ofstream fs(args::get(jsonFlag));
+            fs << json.dump(4) << std::endl;
+            if (!fs) throw RuntimeError("Failed to write '{}'.", args::get(jsonFlag));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
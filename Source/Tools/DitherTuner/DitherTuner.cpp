@@ -0,0 +1,619 @@
+/***************************************************************************
+ # Copyright (c) 2015-22, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Falcor.h"
+#include "Utils/Timing/CpuTimer.h"
+#include "Utils/Image/Bitmap.h"
+#include "../../RenderPasses/DitherVBuffer/DitherReference.h"
+
+#include <args.hxx>
+#include <nlohmann/json.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <random>
+
+using namespace Falcor;
+
+/** Offline tuner for the ADTF (Adaptive) and RIS weights of DitherVBuffer.
+
+    Candidate parameter sets are scored with the CPU reference of the dither decisions (DitherReference.h)
+    on layer stacks, either recorded or synthetic, and optimized with a separable CMA-ES
+    (Ros & Hansen 2008). All candidates of a generation are evaluated in parallel.
+
+    A recorded layer is an image with R = alpha, G = hit distance and BA = texture coordinate derivative
+    (ddx), e.g. an EXR capture of those values. Layers of one stack are given front to back as a
+    comma-separated list. Without recordings, synthetic stacks are used that cover the alpha, depth and
+    derivative ranges the adaptive matrix selection distinguishes.
+
+    The cost of a candidate is the mean over all stacks of
+      temporalWeight * rmsError + spatialWeight * spatialError + flickerWeight * flickerEnergy
+    where rmsError is the RMS difference of the temporal mean visibility and the expected coverage after
+    the last frame, spatialError the RMS difference of the single-frame visibility filtered with a 3x3 box
+    (what a spatial reconstruction filter sees) and flickerEnergy the rate of visibility changes between
+    consecutive frames.
+
+    The best parameters are written as a DitherVBuffer Properties preset (JSON).
+*/
+
+namespace
+{
+using DitherReference::Mode;
+
+/// Tuned parameter with the range of its UI slider in DitherVBuffer.
+struct TunedParam
+{
+    const char* name; ///< DitherVBuffer property name.
+    float DitherReference::Params::*pMember;
+    float minValue;
+    float maxValue;
+};
+
+const TunedParam kAdaptiveParams[] = {
+    {"adaptiveDepthFar", &DitherReference::Params::adaptiveDepthFar, 10.f, 1000.f},
+    {"adaptiveDepthWeight", &DitherReference::Params::adaptiveDepthWeight, 0.f, 2.f},
+    {"adaptiveFreqWeight", &DitherReference::Params::adaptiveFreqWeight, 0.f, 2.f},
+    {"adaptiveAlphaWeight", &DitherReference::Params::adaptiveAlphaWeight, 0.f, 2.f},
+    {"adaptiveFreqScale", &DitherReference::Params::adaptiveFreqScale, 0.1f, 10.f},
+    {"adaptiveNoiseBlend", &DitherReference::Params::adaptiveNoiseBlend, 0.f, 1.f},
+};
+
+const TunedParam kRisParams[] = {
+    {"risRepeatPenalty", &DitherReference::Params::risRepeatPenalty, 0.01f, 1.f},
+    {"risNoveltyBoost", &DitherReference::Params::risNoveltyBoost, 1.f, 3.f},
+};
+
+struct LayerStack
+{
+    std::string name;
+    uint2 frameDim = uint2(0);
+    std::vector<std::vector<DitherReference::PixelInput>> layers; ///< [layer][pixel]
+    std::vector<std::vector<float>> expected;                     ///< [layer][pixel]
+};
+
+struct CostWeights
+{
+    double temporal = 1.0;
+    double spatial = 0.5;
+    double flicker = 0.1;
+};
+
+struct Metrics
+{
+    double rmsError = 0.0;
+    double spatialError = 0.0;
+    double flickerEnergy = 0.0;
+    double cost = 0.0;
+
+    void accumulate(const Metrics& other, double weight)
+    {
+        rmsError += weight * other.rmsError;
+        spatialError += weight * other.spatialError;
+        flickerEnergy += weight * other.flickerEnergy;
+        cost += weight * other.cost;
+    }
+};
+
+/// Fill in the per-layer synthetic inputs and the expected coverage (as in DitherConvergenceBenchmark).
+void finalizeStack(LayerStack& stack)
+{
+    const size_t pixelCount = size_t(stack.frameDim.x) * stack.frameDim.y;
+    stack.expected.assign(stack.layers.size(), std::vector<float>(pixelCount));
+    for (size_t i = 0; i < pixelCount; ++i)
+    {
+        const uint32_t x = uint32_t(i % stack.frameDim.x), y = uint32_t(i / stack.frameDim.x);
+        float transmittance = 1.f;
+        for (size_t k = 0; k < stack.layers.size(); ++k)
+        {
+            DitherReference::PixelInput& in = stack.layers[k][i];
+            in.posW = float3(x * 0.01f, y * 0.01f, float(k));
+            in.texC = (float2(x, y) + 0.5f) / float2(stack.frameDim);
+            in.ddy = float2(0.f, math::length(in.ddx));
+            in.instanceID = uint32_t(k);
+
+            float alpha = in.alpha <= 0.01f ? 0.f : std::min(in.alpha, 1.f);
+            stack.expected[k][i] = transmittance * alpha;
+            transmittance *= 1.f - alpha;
+        }
+    }
+}
+
+/// Load a recorded stack from comma-separated layer images, front to back.
+LayerStack loadStack(const std::string& files)
+{
+    LayerStack stack;
+    stack.name = files;
+    size_t pos = 0;
+    while (pos <= files.size())
+    {
+        size_t end = std::min(files.find(',', pos), files.size());
+        const std::filesystem::path path = files.substr(pos, end - pos);
+        pos = end + 1;
+
+        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(path, true);
+        if (!pBitmap) throw RuntimeError("Failed to load layer '{}'.", path);
+        const uint2 dim(pBitmap->getWidth(), pBitmap->getHeight());
+        if (stack.layers.empty()) stack.frameDim = dim;
+        else if (any(dim != stack.frameDim)) throw RuntimeError("Layer '{}' does not match the size of the first layer.", path);
+
+        const ResourceFormat format = pBitmap->getFormat();
+        const uint32_t channelCount = getFormatChannelCount(format);
+        if (getFormatType(format) != FormatType::Float || getNumChannelBits(format, 0) != 32 || channelCount < 4)
+            throw RuntimeError("Layer '{}' must be a 4-channel 32-bit float image (alpha, hit distance, ddx).", path);
+
+        const float* pData = reinterpret_cast<const float*>(pBitmap->getData());
+        std::vector<DitherReference::PixelInput> layer(size_t(dim.x) * dim.y);
+        for (size_t i = 0; i < layer.size(); ++i)
+        {
+            const float* pTexel = pData + i * channelCount;
+            layer[i].alpha = pTexel[0];
+            layer[i].rayT = pTexel[1];
+            layer[i].ddx = float2(pTexel[2], pTexel[3]);
+        }
+        stack.layers.push_back(std::move(layer));
+    }
+    finalizeStack(stack);
+    return stack;
+}
+
+/** Synthetic stacks: alpha increases along x, depth along y, and the derivatives grow with depth as
+    under a perspective projection. Stacks with one to three layers are generated.
+*/
+std::vector<LayerStack> createSyntheticStacks(uint2 frameDim)
+{
+    std::vector<LayerStack> stacks;
+    for (uint32_t layerCount = 1; layerCount <= 3; ++layerCount)
+    {
+        LayerStack stack;
+        stack.name = fmt::format("synthetic_{}", layerCount);
+        stack.frameDim = frameDim;
+        stack.layers.resize(layerCount, std::vector<DitherReference::PixelInput>(size_t(frameDim.x) * frameDim.y));
+        for (uint32_t y = 0; y < frameDim.y; ++y)
+        {
+            for (uint32_t x = 0; x < frameDim.x; ++x)
+            {
+                const size_t i = size_t(y) * frameDim.x + x;
+                const float u = (x + 0.5f) / frameDim.x, v = (y + 0.5f) / frameDim.y;
+                for (uint32_t k = 0; k < layerCount; ++k)
+                {
+                    DitherReference::PixelInput& in = stack.layers[k][i];
+                    in.alpha = layerCount == 1 ? u : math::lerp(0.2f, 0.8f, u) * (1.f - 0.15f * k);
+                    in.rayT = std::exp2(v * 8.f) + float(k);
+                    in.ddx = float2(in.rayT * 0.002f, 0.f);
+                }
+            }
+        }
+        finalizeStack(stack);
+        stacks.push_back(std::move(stack));
+    }
+    return stacks;
+}
+
+/// RMS difference of the 3x3 box filtered visibility and the expected coverage of a frame (wrap addressing).
+double getSpatialError(const LayerStack& stack, const std::vector<uint8_t>& visible)
+{
+    const uint2 dim = stack.frameDim;
+    const size_t pixelCount = size_t(dim.x) * dim.y;
+    double errorSum = 0.0;
+    for (size_t k = 0; k < stack.layers.size(); ++k)
+    {
+        const uint8_t* pVisible = visible.data() + k * pixelCount;
+        for (uint32_t y = 0; y < dim.y; ++y)
+        {
+            for (uint32_t x = 0; x < dim.x; ++x)
+            {
+                uint32_t sum = 0;
+                float expected = 0.f;
+                for (int dy = -1; dy <= 1; ++dy)
+                {
+                    for (int dx = -1; dx <= 1; ++dx)
+                    {
+                        const size_t j = size_t((y + dim.y + dy) % dim.y) * dim.x + (x + dim.x + dx) % dim.x;
+                        sum += pVisible[j];
+                        expected += stack.expected[k][j];
+                    }
+                }
+                double error = (double(sum) - expected) / 9.0;
+                errorSum += error * error;
+            }
+        }
+    }
+    return std::sqrt(errorSum / (stack.layers.size() * pixelCount));
+}
+
+Metrics evaluate(
+    Mode mode,
+    const DitherReference::Params& params,
+    const DitherReference::Resources& res,
+    const LayerStack& stack,
+    uint32_t frameCount,
+    const CostWeights& weights
+)
+{
+    const uint2 frameDim = stack.frameDim;
+    const size_t pixelCount = size_t(frameDim.x) * frameDim.y;
+    const size_t layerCount = stack.layers.size();
+
+    std::vector<std::vector<uint8_t>> masks(layerCount, std::vector<uint8_t>(pixelCount));
+    std::vector<uint8_t> visible(layerCount * pixelCount);
+    std::vector<uint8_t> previous(layerCount * pixelCount);
+    std::vector<uint32_t> visibleCount(layerCount * pixelCount, 0);
+    std::vector<uint32_t> history(pixelCount, 0xffffffffu);
+    std::vector<DitherReference::PixelInput> pixelLayers(layerCount);
+    uint64_t flickerCount = 0;
+    double spatialError = 0.0;
+
+    DitherReference::Params frameParams = params;
+    for (uint32_t frame = 0; frame < frameCount; ++frame)
+    {
+        if (mode == Mode::RIS)
+        {
+            // The pass only uses the history once the previous frame's selection is valid.
+            frameParams.risUseHistory = frame > 0;
+            for (size_t i = 0; i < pixelCount; ++i)
+            {
+                for (size_t k = 0; k < layerCount; ++k) pixelLayers[k] = stack.layers[k][i];
+                const uint2 pixel(uint32_t(i % frameDim.x), uint32_t(i / frameDim.x));
+                int selected = DitherReference::selectRisCandidate(frameParams, pixel, frame, pixelLayers.data(), layerCount, history[i]);
+                for (size_t k = 0; k < layerCount; ++k) visible[k * pixelCount + i] = int(k) == selected ? 1 : 0;
+                history[i] = selected >= 0 ? DitherReference::makeRisSignature(pixelLayers[selected].instanceID, pixelLayers[selected].primitiveIndex)
+                                           : 0xffffffffu;
+            }
+        }
+        else
+        {
+            for (size_t k = 0; k < layerCount; ++k)
+                DitherReference::evaluateCoverage(mode, params, res, frameDim, frame, stack.layers[k].data(), masks[k].data());
+            for (size_t i = 0; i < pixelCount; ++i)
+            {
+                uint8_t occluded = 0;
+                for (size_t k = 0; k < layerCount; ++k)
+                {
+                    visible[k * pixelCount + i] = masks[k][i] & uint8_t(!occluded);
+                    occluded |= masks[k][i];
+                }
+            }
+        }
+
+        for (size_t j = 0; j < visible.size(); ++j)
+        {
+            visibleCount[j] += visible[j];
+            if (frame > 0) flickerCount += visible[j] ^ previous[j];
+        }
+        spatialError += getSpatialError(stack, visible);
+        std::swap(visible, previous);
+    }
+
+    Metrics metrics;
+    const double sampleCount = double(layerCount * pixelCount);
+    double errorSum = 0.0;
+    for (size_t j = 0; j < visibleCount.size(); ++j)
+    {
+        double error = double(visibleCount[j]) / frameCount - stack.expected[j / pixelCount][j % pixelCount];
+        errorSum += error * error;
+    }
+    metrics.rmsError = std::sqrt(errorSum / sampleCount);
+    metrics.spatialError = spatialError / frameCount;
+    metrics.flickerEnergy = frameCount > 1 ? double(flickerCount) / (sampleCount * (frameCount - 1)) : 0.0;
+    metrics.cost = weights.temporal * metrics.rmsError + weights.spatial * metrics.spatialError + weights.flicker * metrics.flickerEnergy;
+    return metrics;
+}
+
+/** Separable CMA-ES (diagonal covariance) in the normalized [0, 1]^n parameter space.
+    Candidates outside the box are clamped before evaluation and the clamped values are used for the update.
+*/
+class SepCMAES
+{
+public:
+    SepCMAES(size_t dimension, uint32_t populationSize, double initialSigma, uint64_t seed)
+        : mN(dimension), mLambda(populationSize), mSigma(initialSigma), mRng(seed)
+    {
+        mMu = mLambda / 2;
+        for (size_t i = 0; i < mMu; ++i) mWeights.push_back(std::log(mMu + 0.5) - std::log(i + 1.0));
+        double sum = 0.0, sumSq = 0.0;
+        for (double w : mWeights) sum += w;
+        for (double& w : mWeights) w /= sum, sumSq += w * w;
+        mMuEff = 1.0 / sumSq;
+
+        const double n = double(mN);
+        mCSigma = (mMuEff + 2.0) / (n + mMuEff + 5.0);
+        mDSigma = 1.0 + 2.0 * std::max(0.0, std::sqrt((mMuEff - 1.0) / (n + 1.0)) - 1.0) + mCSigma;
+        mCc = 4.0 / (n + 4.0);
+        // Learning rates of the full CMA-ES, scaled up by (n + 2) / 3 for the diagonal model.
+        mC1 = std::min(1.0, 2.0 / ((n + 1.3) * (n + 1.3) + mMuEff) * (n + 2.0) / 3.0);
+        mCMu = std::min(1.0 - mC1, 2.0 * (mMuEff - 2.0 + 1.0 / mMuEff) / ((n + 2.0) * (n + 2.0) + mMuEff) * (n + 2.0) / 3.0);
+        mChiN = std::sqrt(n) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+
+        mMean.assign(mN, 0.5);
+        mDiagC.assign(mN, 1.0);
+        mPathSigma.assign(mN, 0.0);
+        mPathC.assign(mN, 0.0);
+    }
+
+    void setMean(const std::vector<double>& mean) { mMean = mean; }
+    const std::vector<double>& getMean() const { return mMean; }
+    double getSigma() const { return mSigma; }
+
+    /// Sample a new population.
+    std::vector<std::vector<double>> sample()
+    {
+        std::normal_distribution<double> normal;
+        std::vector<std::vector<double>> population(mLambda, std::vector<double>(mN));
+        for (auto& x : population)
+            for (size_t d = 0; d < mN; ++d) x[d] = std::clamp(mMean[d] + mSigma * std::sqrt(mDiagC[d]) * normal(mRng), 0.0, 1.0);
+        return population;
+    }
+
+    /// Update the distribution from the population and the costs of its candidates.
+    void update(const std::vector<std::vector<double>>& population, const std::vector<double>& costs)
+    {
+        std::vector<size_t> order(population.size());
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return costs[a] < costs[b]; });
+
+        const std::vector<double> oldMean = mMean;
+        for (size_t d = 0; d < mN; ++d)
+        {
+            mMean[d] = 0.0;
+            for (size_t i = 0; i < mMu; ++i) mMean[d] += mWeights[i] * population[order[i]][d];
+        }
+
+        double pathSigmaNormSq = 0.0;
+        for (size_t d = 0; d < mN; ++d)
+        {
+            const double step = (mMean[d] - oldMean[d]) / mSigma;
+            mPathSigma[d] = (1.0 - mCSigma) * mPathSigma[d] + std::sqrt(mCSigma * (2.0 - mCSigma) * mMuEff) * step / std::sqrt(mDiagC[d]);
+            mPathC[d] = (1.0 - mCc) * mPathC[d] + std::sqrt(mCc * (2.0 - mCc) * mMuEff) * step;
+            pathSigmaNormSq += mPathSigma[d] * mPathSigma[d];
+        }
+
+        for (size_t d = 0; d < mN; ++d)
+        {
+            double rankMu = 0.0;
+            for (size_t i = 0; i < mMu; ++i)
+            {
+                const double y = (population[order[i]][d] - oldMean[d]) / mSigma;
+                rankMu += mWeights[i] * y * y;
+            }
+            mDiagC[d] = (1.0 - mC1 - mCMu) * mDiagC[d] + mC1 * mPathC[d] * mPathC[d] + mCMu * rankMu;
+            mDiagC[d] = std::max(mDiagC[d], 1e-12);
+        }
+
+        mSigma *= std::exp(mCSigma / mDSigma * (std::sqrt(pathSigmaNormSq) / mChiN - 1.0));
+        mSigma = std::min(mSigma, 1.0);
+    }
+
+private:
+    size_t mN;
+    size_t mLambda;
+    size_t mMu = 0;
+    double mSigma;
+    std::mt19937_64 mRng;
+    std::vector<double> mWeights;
+    double mMuEff = 1.0;
+    double mCSigma = 0.0;
+    double mDSigma = 0.0;
+    double mCc = 0.0;
+    double mC1 = 0.0;
+    double mCMu = 0.0;
+    double mChiN = 0.0;
+    std::vector<double> mMean;
+    std::vector<double> mDiagC;
+    std::vector<double> mPathSigma;
+    std::vector<double> mPathC;
+};
+
+DitherReference::Params applyCandidate(DitherReference::Params params, const std::vector<TunedParam>& tuned, const std::vector<double>& x)
+{
+    for (size_t d = 0; d < tuned.size(); ++d) params.*tuned[d].pMember = math::lerp(tuned[d].minValue, tuned[d].maxValue, float(x[d]));
+    return params;
+}
+
+std::vector<double> normalizeParams(const DitherReference::Params& params, const std::vector<TunedParam>& tuned)
+{
+    std::vector<double> x(tuned.size());
+    for (size_t d = 0; d < tuned.size(); ++d)
+        x[d] = std::clamp((params.*tuned[d].pMember - tuned[d].minValue) / double(tuned[d].maxValue - tuned[d].minValue), 0.0, 1.0);
+    return x;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    args::ArgumentParser parser("Offline tuner for the DitherVBuffer ADTF and RIS weights.");
+    parser.helpParams.programName = "DitherTuner";
+    args::HelpFlag helpFlag(parser, "help", "Display this help menu.", {'h', "help"});
+    args::ValueFlag<std::string> modeFlag(parser, "mode", "Mode to tune: Adaptive (default) or RIS.", {'m', "mode"});
+    args::ValueFlagList<std::string> stackFlag(
+        parser, "images", "Recorded layer stack as comma-separated images (RGBA32F: alpha, hit distance, ddx), front to back.", {'s', "stack"}
+    );
+    args::ValueFlag<uint32_t> widthFlag(parser, "width", "Synthetic stack width (default 64).", {'W', "width"});
+    args::ValueFlag<uint32_t> heightFlag(parser, "height", "Synthetic stack height (default 64).", {'H', "height"});
+    args::ValueFlag<uint32_t> framesFlag(parser, "frames", "Frames per evaluation (default 16).", {'f', "frames"});
+    args::ValueFlag<uint32_t> generationsFlag(parser, "count", "CMA-ES generations (default 40).", {'g', "generations"});
+    args::ValueFlag<uint32_t> populationFlag(parser, "count", "Candidates per generation (default 16).", {'p', "population"});
+    args::ValueFlag<double> sigmaFlag(parser, "sigma", "Initial step size in the normalized parameter space (default 0.3).", {"sigma"});
+    args::ValueFlag<uint64_t> seedFlag(parser, "seed", "Random seed.", {"seed"});
+    args::ValueFlag<double> temporalWeightFlag(parser, "weight", "Cost weight of the temporal RMS error (default 1).", {"temporal-weight"});
+    args::ValueFlag<double> spatialWeightFlag(parser, "weight", "Cost weight of the filtered single-frame error (default 0.5).", {"spatial-weight"});
+    args::ValueFlag<double> flickerWeightFlag(parser, "weight", "Cost weight of the flicker energy (default 0.1).", {"flicker-weight"});
+    args::ValueFlag<std::string> dataFlag(parser, "dir", "Additional data directory to search for the dither textures.", {'d', "data"});
+    args::ValueFlag<std::string> outputFlag(parser, "path", "Write the tuned DitherVBuffer properties as JSON.", {'o', "output"});
+    args::CompletionFlag completionFlag(parser, {"complete"});
+
+    try
+    {
+        parser.ParseCLI(argc, argv);
+    }
+    catch (const args::Completion& e)
+    {
+        std::cout << e.what();
+        return 0;
+    }
+    catch (const args::Help&)
+    {
+        std::cout << parser;
+        return 0;
+    }
+    catch (const args::ParseError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+
+    try
+    {
+        Mode mode = Mode::Adaptive;
+        std::vector<TunedParam> tuned(std::begin(kAdaptiveParams), std::end(kAdaptiveParams));
+        if (modeFlag && args::get(modeFlag) == "RIS")
+        {
+            mode = Mode::RIS;
+            tuned.assign(std::begin(kRisParams), std::end(kRisParams));
+        }
+        else if (modeFlag && args::get(modeFlag) != "Adaptive") throw ArgumentError("Unknown mode '{}'.", args::get(modeFlag));
+
+        const uint2 frameDim(widthFlag ? args::get(widthFlag) : 64, heightFlag ? args::get(heightFlag) : 64);
+        const uint32_t frameCount = framesFlag ? args::get(framesFlag) : 16;
+        const uint32_t generationCount = generationsFlag ? args::get(generationsFlag) : 40;
+        const uint32_t populationSize = populationFlag ? args::get(populationFlag) : 16;
+        if (frameDim.x == 0 || frameDim.y == 0 || frameCount == 0) throw ArgumentError("Frame size and count must be non-zero.");
+        if (populationSize < 4) throw ArgumentError("Population size must be at least 4.");
+
+        CostWeights weights;
+        if (temporalWeightFlag) weights.temporal = args::get(temporalWeightFlag);
+        if (spatialWeightFlag) weights.spatial = args::get(spatialWeightFlag);
+        if (flickerWeightFlag) weights.flicker = args::get(flickerWeightFlag);
+
+        std::vector<LayerStack> stacks;
+        if (stackFlag)
+            for (const auto& files : args::get(stackFlag)) stacks.push_back(loadStack(files));
+        else stacks = createSyntheticStacks(frameDim);
+        // RIS chooses between layers, a single layer is always kept.
+        if (mode == Mode::RIS)
+            stacks.erase(std::remove_if(stacks.begin(), stacks.end(), [](const LayerStack& s) { return s.layers.size() < 2; }), stacks.end());
+        if (stacks.empty()) throw ArgumentError("No layer stacks to evaluate.");
+
+        if (dataFlag) addDataDirectory(args::get(dataFlag), true);
+        const DitherReference::TextureSet textures = DitherReference::TextureSet::load();
+        DitherReference::Resources res = DitherReference::Resources::fromPermutationTables();
+        textures.bind(res);
+
+        // Same defaults as the shader constants of the pass. Tune the raw dither decisions.
+        DitherReference::Params baseParams;
+        baseParams.coverageCorrection = DitherReference::CoverageCorrection::Disabled;
+
+        // Evaluates a list of candidates, one job per (candidate, stack).
+        auto evaluateCandidates = [&](const std::vector<std::vector<double>>& candidates)
+        {
+            const size_t jobCount = candidates.size() * stacks.size();
+            std::vector<Metrics> results(jobCount);
+            NumericRange<size_t> jobRange(0, jobCount);
+            std::for_each(
+                std::execution::par,
+                jobRange.begin(),
+                jobRange.end(),
+                [&](size_t job)
+                {
+                    const DitherReference::Params params = applyCandidate(baseParams, tuned, candidates[job / stacks.size()]);
+                    results[job] = evaluate(mode, params, res, stacks[job % stacks.size()], frameCount, weights);
+                }
+            );
+            std::vector<Metrics> metrics(candidates.size());
+            for (size_t job = 0; job < jobCount; ++job) metrics[job / stacks.size()].accumulate(results[job], 1.0 / stacks.size());
+            return metrics;
+        };
+
+        CpuTimer timer;
+        timer.update();
+
+        const std::vector<double> baseX = normalizeParams(baseParams, tuned);
+        const Metrics baseMetrics = evaluateCandidates({baseX})[0];
+        std::cout << fmt::format(
+                         "Default: cost {:.5f} (rmsError {:.5f}, spatialError {:.5f}, flicker {:.5f})", baseMetrics.cost, baseMetrics.rmsError,
+                         baseMetrics.spatialError, baseMetrics.flickerEnergy
+                     )
+                  << std::endl;
+
+        SepCMAES cmaes(tuned.size(), populationSize, sigmaFlag ? args::get(sigmaFlag) : 0.3, seedFlag ? args::get(seedFlag) : 1);
+        cmaes.setMean(baseX);
+        std::vector<double> bestX = baseX;
+        Metrics bestMetrics = baseMetrics;
+        uint32_t evaluationCount = 1;
+        for (uint32_t generation = 0; generation < generationCount && cmaes.getSigma() > 1e-4; ++generation)
+        {
+            const std::vector<std::vector<double>> population = cmaes.sample();
+            const std::vector<Metrics> metrics = evaluateCandidates(population);
+            evaluationCount += uint32_t(population.size());
+
+            std::vector<double> costs(population.size());
+            for (size_t i = 0; i < population.size(); ++i)
+            {
+                costs[i] = metrics[i].cost;
+                if (metrics[i].cost < bestMetrics.cost)
+                {
+                    bestMetrics = metrics[i];
+                    bestX = population[i];
+                }
+            }
+            cmaes.update(population, costs);
+            std::cout << fmt::format("Generation {:>3}: best cost {:.5f}, sigma {:.4f}", generation, bestMetrics.cost, cmaes.getSigma())
+                      << std::endl;
+        }
+
+        timer.update();
+        std::cout << fmt::format(
+                         "Tuned: cost {:.5f} (rmsError {:.5f}, spatialError {:.5f}, flicker {:.5f}), {} evaluations on {} stacks in {:.1f}s",
+                         bestMetrics.cost, bestMetrics.rmsError, bestMetrics.spatialError, bestMetrics.flickerEnergy, evaluationCount,
+                         stacks.size(), timer.delta()
+                     )
+                  << std::endl;
+
+        const DitherReference::Params bestParams = applyCandidate(baseParams, tuned, bestX);
+        nlohmann::ordered_json props;
+        for (const auto& param : tuned)
+        {
+            props[param.name] = bestParams.*param.pMember;
+            std::cout << fmt::format("  {} = {:.4f}", param.name, bestParams.*param.pMember) << std::endl;
+        }
+
+        if (outputFlag)
+        {
+            std::ofstream fs(args::get(outputFlag));
+            fs << props.dump(4) << std::endl;
+            if (!fs) throw RuntimeError("Failed to write '{}'.", args::get(outputFlag));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,110 @@
+/***************************************************************************
+ # Copyright (c) 2015-22, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "../../../../RenderPasses/DitherVBuffer/PermutationScoring.h"
+#include "../../../../RenderPasses/DitherVBuffer/PermutationSearch.h"
+
+namespace Falcor
+{
+namespace
+{
+template<int T>
+std::array<int, T * T> randomPermutation(PermutationSearch::SplitMix64& rng)
+{
+    std::array<int, T * T> indices;
+    std::iota(indices.begin(), indices.end(), 0);
+    for (int i = T * T - 1; i > 0; --i) std::swap(indices[i], indices[rng.nextBelow(i + 1)]);
+    return indices;
+}
+
+template<int T>
+void testIncrementalScore(UnitTestContext& ctx, uint64_t seed)
+{
+    PermutationSearch::SplitMix64 rng(seed);
+    IncrementalPermutationScore<T> state(randomPermutation<T>(rng));
+    for (int iter = 0; iter < 10000; ++iter)
+    {
+        int i = rng.nextBelow(T * T);
+        int j = rng.nextBelow(T * T);
+        std::array<int, T * T> swapped = state.getIndices();
+        std::swap(swapped[i], swapped[j]);
+        EXPECT_EQ(state.scoreAfterSwap(i, j), scorePermutation<T>(swapped));
+        state.applySwap(i, j);
+        EXPECT_EQ(state.score(), scorePermutation<T>(swapped));
+    }
+}
+} // namespace
+
+CPU_TEST(DitherPermutationBatchScore)
+{
+    // Exhaustive 3x3 enumeration must match the scalar scorer exactly.
+    size_t count = 0;
+    size_t mismatches = 0;
+    forEachScoredPermutation<3>(
+        [&](const std::array<int, 9>& indices, int score)
+        {
+            if (score != scorePermutation<3>(indices)) ++mismatches;
+            ++count;
+        }
+    );
+    EXPECT_EQ(count, 362880);
+    EXPECT_EQ(mismatches, 0);
+
+    // Random 4x4 batches, including a partial batch at the end.
+    PermutationSearch::SplitMix64 rng(1);
+    std::vector<std::array<int, 16>> perms(1000);
+    for (auto& p : perms) p = randomPermutation<4>(rng);
+    std::vector<int> scores(perms.size());
+    scorePermutations<4>(perms.data(), perms.size(), scores.data());
+    for (size_t i = 0; i < perms.size(); ++i) EXPECT_EQ(scores[i], scorePermutation<4>(perms[i]));
+}
+
+CPU_TEST(DitherPermutationIncrementalScore)
+{
+    testIncrementalScore<2>(ctx, 2);
+    testIncrementalScore<3>(ctx, 3);
+    testIncrementalScore<4>(ctx, 4);
+}
+
+CPU_TEST(DitherPermutationSearchDeterministic)
+{
+    PermutationSearch::Desc desc;
+    desc.chainCount = 4;
+    desc.iterationsPerChain = 20000;
+    desc.maxResults = 32;
+
+    desc.threadCount = 1;
+    auto a = PermutationSearch::search4x4(desc);
+    desc.threadCount = 4;
+    auto b = PermutationSearch::search4x4(desc);
+
+    EXPECT(!a.permutations.empty());
+    EXPECT(a.permutations == b.permutations);
+    for (const auto& p : a.permutations) EXPECT_EQ(p.first, scorePermutation<4>(p.second));
+}
+} // namespace Falcor
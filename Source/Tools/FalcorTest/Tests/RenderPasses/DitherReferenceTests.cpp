@@ -0,0 +1,234 @@
+/***************************************************************************
+ # Copyright (c) 2015-22, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "../../../../RenderPasses/DitherVBuffer/DitherReference.h"
+#include <limits>
+
+namespace Falcor
+{
+namespace
+{
+using namespace DitherReference;
+
+/// Pseudo-random texture contents in [0, 1).
+std::vector<float> createNoise(size_t count, uint32_t seed)
+{
+    std::vector<float> data(count);
+    uint32_t state = seed;
+    for (auto& v : data)
+    {
+        state = state * 1664525u + 1013904223u;
+        v = float(state >> 8) / float(1u << 24);
+    }
+    return data;
+}
+
+struct TestResources
+{
+    std::vector<float> noise = createNoise(64 * 64, 1);
+    std::vector<float> blueNoise3D = createNoise(16 * 16 * 16, 2);
+    std::vector<float> stbn = createNoise(128 * 128 * 64, 3);
+    std::vector<float> ramp = createNoise(64, 4);
+    std::vector<float> fracDither = createNoise(32 * 32 * 16, 5);
+    Resources res = Resources::fromPermutationTables();
+
+    TestResources()
+    {
+        std::sort(ramp.begin(), ramp.end());
+        res.noise = { noise.data(), 64, 64, 1 };
+        res.blueNoise64 = { noise.data(), 64, 64, 1 };
+        res.bayer64 = { noise.data(), 64, 64, 1 };
+        res.blueNoise3D = { blueNoise3D.data(), 16, 16, 16 };
+        res.spatioTemporalBlueNoise = { stbn.data(), 128, 128, 64 };
+        res.fracDitherRamp = { ramp.data(), 64, 1, 1 };
+        res.fracDither = { fracDither.data(), 32, 32, 16 };
+    }
+};
+
+/// Single object covering the frame at constant alpha.
+std::vector<PixelInput> createFrame(uint2 frameDim, float alpha)
+{
+    std::vector<PixelInput> inputs(frameDim.x * frameDim.y);
+    for (uint32_t y = 0; y < frameDim.y; ++y)
+    {
+        for (uint32_t x = 0; x < frameDim.x; ++x)
+        {
+            PixelInput& in = inputs[y * frameDim.x + x];
+            in.alpha = alpha;
+            in.posW = float3(x * 0.01f, y * 0.01f, 1.f);
+            in.texC = float2(x, y) * 0.005f;
+            in.ddx = float2(0.005f, 0.f);
+            in.ddy = float2(0.f, 0.005f);
+            in.rayT = 10.f;
+        }
+    }
+    return inputs;
+}
+
+double getCoverage(Mode mode, const Params& params, const Resources& res, uint2 frameDim, uint32_t frameIndex, float alpha)
+{
+    auto inputs = createFrame(frameDim, alpha);
+    std::vector<uint8_t> mask(inputs.size());
+    evaluateCoverage(mode, params, res, frameDim, frameIndex, inputs.data(), mask.data());
+    return std::accumulate(mask.begin(), mask.end(), 0.0) / mask.size();
+}
+} // namespace
+
+CPU_TEST(DitherReferencePermutation5)
+{
+    // GetPermutation5 lists the permutations of [0, 5) in lexicographic order.
+    std::array<uint32_t, 5> expected = { 0, 1, 2, 3, 4 };
+    for (uint32_t i = 0; i < 120; ++i)
+    {
+        EXPECT(getPermutation5(i) == expected);
+        std::next_permutation(expected.begin(), expected.end());
+    }
+    EXPECT(getPermutation5(120) == getPermutation5(0));
+}
+
+CPU_TEST(DitherReferenceHashedAlphaThreshold)
+{
+    // With a lerp factor of 1 the interpolation divides by zero. At x = 1 this gives NaN,
+    // which the shader's clamp turns into the lower bound.
+    EXPECT_EQ(hashedAlphaThreshold(float2(1.f), 1.0f), 1e-6f);
+    EXPECT_EQ(hashedAlphaThreshold(float2(0.25f), 1.0f), 0.25f);
+    EXPECT_EQ(clampThreshold(std::numeric_limits<float>::quiet_NaN()), 1e-6f);
+}
+
+CPU_TEST(DitherReferenceTileMatchesPixel)
+{
+    TestResources resources;
+    Params params;
+    params.noiseTop = NoiseTop::StaticWhite;
+
+    const uint2 frameDim(37, 21); // not a multiple of the tile size
+    auto inputs = createFrame(frameDim, 0.4f);
+    for (size_t i = 0; i < inputs.size(); ++i) inputs[i].instanceID = uint32_t(i / 100);
+    std::vector<uint8_t> mask(inputs.size());
+
+    for (Mode mode :
+         { Mode::Disabled, Mode::PerPixel2x2, Mode::PerPixel3x3, Mode::PerPixel4x4, Mode::DitherTemporalAA, Mode::RussianRoulette,
+           Mode::Periodic, Mode::HashGrid, Mode::FractalDithering, Mode::BlueNoise3D, Mode::SpatioTemporalBlueNoise,
+           Mode::SurfaceSpatioTemporalBlueNoise, Mode::Adaptive, Mode::RIS })
+    {
+        for (uint32_t frameIndex = 0; frameIndex < 4; ++frameIndex)
+        {
+            evaluateCoverage(mode, params, resources.res, frameDim, frameIndex, inputs.data(), mask.data());
+            size_t mismatches = 0;
+            for (size_t i = 0; i < inputs.size(); ++i)
+            {
+                uint2 pixel(uint32_t(i % frameDim.x), uint32_t(i / frameDim.x));
+                if (isCovered(mode, params, resources.res, pixel, frameIndex, inputs[i]) != bool(mask[i])) ++mismatches;
+            }
+            EXPECT_EQ(mismatches, 0) << "mode " << uint32_t(mode) << " frame " << frameIndex;
+        }
+    }
+}
+
+CPU_TEST(DitherReferenceMatrixCoverage)
+{
+    TestResources resources;
+    Params params;
+    params.noiseTop = NoiseTop::Disabled; // constant 0.5 offset
+    params.coverageCorrection = CoverageCorrection::Disabled;
+
+    // With a constant offset of 0.5, an NxN matrix covers exactly round(alpha * N^2) cells per period.
+    const uint2 frameDim(72, 72);
+    for (uint32_t frameIndex = 0; frameIndex < 3; ++frameIndex)
+    {
+        EXPECT_EQ(getCoverage(Mode::PerPixel2x2, params, resources.res, frameDim, frameIndex, 0.5f), 2.0 / 4.0);
+        EXPECT_EQ(getCoverage(Mode::PerPixel3x3, params, resources.res, frameDim, frameIndex, 0.5f), 5.0 / 9.0);
+        EXPECT_EQ(getCoverage(Mode::PerPixel4x4, params, resources.res, frameDim, frameIndex, 0.5f), 8.0 / 16.0);
+        EXPECT_EQ(getCoverage(Mode::PerPixel3x3, params, resources.res, frameDim, frameIndex, 0.25f), 2.0 / 9.0);
+    }
+
+    // Fully transparent and opaque samples are never dithered.
+    EXPECT_EQ(getCoverage(Mode::PerPixel3x3, params, resources.res, frameDim, 0, 0.005f), 0.0);
+    EXPECT_EQ(getCoverage(Mode::PerPixel3x3, params, resources.res, frameDim, 0, 1.0f), 1.0);
+}
+
+CPU_TEST(DitherReferenceAdaptiveMatrixSize)
+{
+    Params params;
+    AdaptiveFactors factors;
+    // Low alpha, flat and far: fine matrix.
+    EXPECT_EQ(selectAdaptiveMatrixSize(params, params.adaptiveDepthFar, float2(0.f), 0.f, factors), 4);
+    EXPECT_EQ(factors.adaptiveScore, 1.f);
+    // Opaque-ish, high frequency and close: coarse matrix.
+    EXPECT_EQ(selectAdaptiveMatrixSize(params, 0.f, float2(10.f, 0.f), 1.f, factors), 2);
+    EXPECT_EQ(factors.adaptiveScore, 0.f);
+    // Only the alpha term (weight 0.5 of 1.0) active: medium matrix.
+    EXPECT_EQ(selectAdaptiveMatrixSize(params, 0.f, float2(10.f, 0.f), 0.f, factors), 3);
+}
+
+CPU_TEST(DitherReferenceRisReservoir)
+{
+    float weightSum = 0.f;
+    uint32_t candidateCount = 0;
+    uint32_t selectedIndex = 0xffffffffu;
+
+    // Zero weights are counted but never selected.
+    EXPECT(!risUpdateReservoir(0.f, weightSum, candidateCount, selectedIndex, 0, 0.f));
+    EXPECT_EQ(candidateCount, 1);
+    EXPECT_EQ(selectedIndex, 0xffffffffu);
+
+    // The first candidate with positive weight is always selected.
+    EXPECT(risUpdateReservoir(1.f, weightSum, candidateCount, selectedIndex, 1, 0.999f));
+    EXPECT_EQ(selectedIndex, 1);
+
+    // Later candidates replace it with probability w / weightSum.
+    EXPECT(!risUpdateReservoir(1.f, weightSum, candidateCount, selectedIndex, 2, 0.6f));
+    EXPECT(risUpdateReservoir(2.f, weightSum, candidateCount, selectedIndex, 3, 0.5f));
+    EXPECT_EQ(selectedIndex, 3);
+    EXPECT_EQ(candidateCount, 4);
+    EXPECT_EQ(weightSum, 4.f);
+}
+
+CPU_TEST(DitherReferenceLoadTextures)
+{
+    // All slices of arrays and volumes are loaded, in the formats shipped in data/dither.
+    TextureSet textures = TextureSet::load();
+    auto checkSize = [&](const TextureData& tex, uint32_t width, uint32_t height, uint32_t depth)
+    {
+        EXPECT_EQ(tex.width, width);
+        EXPECT_EQ(tex.height, height);
+        EXPECT_EQ(tex.depth, depth);
+        EXPECT_EQ(tex.data.size(), size_t(width) * height * depth);
+    };
+    checkSize(textures.blueNoise64, 64, 64, 1);
+    checkSize(textures.blueNoise3D, 16, 16, 16);
+    checkSize(textures.spatioTemporalBlueNoise, 128, 128, 64);
+    checkSize(textures.fracDither, 128, 128, 64);
+    checkSize(textures.fracDitherRamp, 64, 1, 1);
+
+    // Blue noise thresholds are uniformly distributed.
+    double sum = 0.0;
+    for (float v : textures.spatioTemporalBlueNoise.data) sum += v;
+    EXPECT_LE(std::abs(sum / textures.spatioTemporalBlueNoise.data.size() - 0.5), 0.01);
+}
+} // namespace Falcor
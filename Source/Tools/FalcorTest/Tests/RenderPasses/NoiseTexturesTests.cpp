@@ -0,0 +1,107 @@
+/***************************************************************************
+ # Copyright (c) 2015-22, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "../../../../RenderPasses/DitherVBuffer/DitherVBuffer.h"
+#include <algorithm>
+
+namespace Falcor
+{
+namespace
+{
+using Slot = NoiseTextureSet::Slot;
+using DitherMode = DitherVBuffer::DitherMode;
+using NoiseTopPattern = DitherVBuffer::NoiseTopPattern;
+using NoisePattern = DitherVBuffer::NoisePattern;
+using STBNNoise = DitherVBuffer::STBNNoise;
+using DitherPattern = DitherVBuffer::DitherPattern;
+
+size_t countPaths(const NoiseTextureSet::Paths& paths)
+{
+    return std::count_if(paths.begin(), paths.end(), [](const std::string& path) { return !path.empty(); });
+}
+} // namespace
+
+CPU_TEST(NoiseTexturePaths)
+{
+    // Only the noise on top is sampled by the matrix modes.
+    auto paths = DitherVBuffer::getNoiseTexturePaths(DitherMode::PerPixel3x3, NoiseTopPattern::StaticBlue, NoisePattern::Blue, STBNNoise::Scalar, DitherPattern::Dither8x8);
+    EXPECT_EQ(countPaths(paths), 1);
+    EXPECT_EQ(paths[size_t(Slot::BlueNoise64)], "dither/bluenoise64.dds");
+
+    paths = DitherVBuffer::getNoiseTexturePaths(DitherMode::Adaptive, NoiseTopPattern::SurfaceWhite, NoisePattern::Perlin, STBNNoise::Scalar, DitherPattern::Dither8x8);
+    EXPECT_EQ(countPaths(paths), 1);
+    EXPECT_EQ(paths[size_t(Slot::Noise)], "dither/perlin1024.dds");
+
+    paths = DitherVBuffer::getNoiseTexturePaths(DitherMode::DitherTemporalAA, NoiseTopPattern::Disabled, NoisePattern::Blue, STBNNoise::Scalar, DitherPattern::Dither8x8);
+    EXPECT_EQ(countPaths(paths), 0);
+
+    // The noise on top setting is ignored by modes that do not use it.
+    paths = DitherVBuffer::getNoiseTexturePaths(DitherMode::RussianRoulette, NoiseTopPattern::StaticBlue, NoisePattern::Blue, STBNNoise::Scalar, DitherPattern::Dither8x8);
+    EXPECT_EQ(countPaths(paths), 0);
+    paths = DitherVBuffer::getNoiseTexturePaths(DitherMode::RIS, NoiseTopPattern::DynamicBlue, NoisePattern::Blue, STBNNoise::Scalar, DitherPattern::Dither8x8);
+    EXPECT_EQ(countPaths(paths), 0);
+
+    paths = DitherVBuffer::getNoiseTexturePaths(DitherMode::HashGrid, NoiseTopPattern::StaticBlue, NoisePattern::White, STBNNoise::Scalar, DitherPattern::Dither8x8);
+    EXPECT_EQ(countPaths(paths), 1);
+    EXPECT_EQ(paths[size_t(Slot::Noise)], "dither/whitenoise1024.dds");
+
+    paths = DitherVBuffer::getNoiseTexturePaths(DitherMode::SurfaceSpatioTemporalBlueNoise, NoiseTopPattern::StaticBlue, NoisePattern::Blue, STBNNoise::Vector1D, DitherPattern::Dither8x8);
+    EXPECT_EQ(countPaths(paths), 1);
+    EXPECT_EQ(paths[size_t(Slot::SpatioTemporal)], "dither/spatiotemporal_bluenoise2.dds");
+
+    paths = DitherVBuffer::getNoiseTexturePaths(DitherMode::FractalDithering, NoiseTopPattern::StaticBlue, NoisePattern::Blue, STBNNoise::Scalar, DitherPattern::Dither4x4);
+    EXPECT_EQ(countPaths(paths), 2);
+    EXPECT_EQ(paths[size_t(Slot::FracDither)], "dither/Dither3D_4x4.dds");
+    EXPECT_EQ(paths[size_t(Slot::FracDitherRamp)], "dither/Dither3D_4x4_ramp.dds");
+}
+
+GPU_TEST(NoiseTexturesShared)
+{
+    ref<Device> pDevice = ctx.getDevice();
+    const auto baseline = NoiseTextures::getStats();
+
+    auto paths = DitherVBuffer::getNoiseTexturePaths(DitherMode::PerPixel3x3, NoiseTopPattern::StaticBayer, NoisePattern::Blue, STBNNoise::Scalar, DitherPattern::Dither8x8);
+    NoiseTextureSet a, b;
+    a.update(pDevice, paths);
+    b.update(pDevice, paths);
+    ASSERT(a.get(Slot::Bayer64) != nullptr);
+    EXPECT(a.get(Slot::Bayer64) == b.get(Slot::Bayer64));
+    EXPECT(a.get(Slot::BlueNoise64) == nullptr);
+
+    auto stats = NoiseTextures::getStats();
+    EXPECT_EQ(stats.textureCount, baseline.textureCount + 1);
+    EXPECT_EQ(stats.residentBytes, baseline.residentBytes + a.getSizeInBytes());
+
+    // The texture stays resident until the last holder releases it.
+    a.update(pDevice, NoiseTextureSet::Paths{});
+    EXPECT_EQ(NoiseTextures::getStats().textureCount, baseline.textureCount + 1);
+    b.update(pDevice, NoiseTextureSet::Paths{});
+    EXPECT_EQ(NoiseTextures::getStats().textureCount, baseline.textureCount);
+    EXPECT_EQ(NoiseTextures::getStats().residentBytes, baseline.residentBytes);
+}
+} // namespace Falcor
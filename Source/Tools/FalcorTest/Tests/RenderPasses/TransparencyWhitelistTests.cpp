@@ -0,0 +1,156 @@
+/***************************************************************************
+ # Copyright (c) 2015-22, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/Scene.h"
+#include "Scene/Material/StandardMaterial.h"
+#include "../../../../RenderPasses/DitherVBuffer/TransparencyWhitelist.h"
+
+namespace Falcor
+{
+namespace
+{
+/// True if the GPU buffer holds exactly the whitelist bits of the first materialCount materials.
+bool isBufferInSync(const TransparencyWhitelist& whitelist, uint32_t materialCount)
+{
+    const ref<Buffer>& pBuffer = whitelist.getBuffer();
+    const uint32_t* pWords = reinterpret_cast<const uint32_t*>(pBuffer->map(Buffer::MapType::Read));
+    bool inSync = true;
+    for (uint32_t mat = 0; mat < materialCount; ++mat)
+        inSync &= (((pWords[mat / 32] >> (mat % 32)) & 1) != 0) == whitelist.isWhitelisted(mat);
+    pBuffer->unmap();
+    return inSync;
+}
+} // namespace
+
+CPU_TEST(TransparencyWhitelistGlob)
+{
+    EXPECT(MaterialNameFilter::matchGlob("*", ""));
+    EXPECT(MaterialNameFilter::matchGlob("a*c", "abbbc"));
+    EXPECT(!MaterialNameFilter::matchGlob("a*c", "abbb"));
+    EXPECT(MaterialNameFilter::matchGlob("*a*b*c", "xaybzc"));
+    EXPECT(!MaterialNameFilter::matchGlob("*a*b*c", "xaybz"));
+    EXPECT(MaterialNameFilter::matchGlob("a?c", "abc"));
+    EXPECT(MaterialNameFilter::matchGlob("m[0-9][!x]", "m5y"));
+    EXPECT(!MaterialNameFilter::matchGlob("m[0-9][!x]", "m5x"));
+    EXPECT(MaterialNameFilter::matchGlob("[]]", "]"));
+    EXPECT(MaterialNameFilter::matchGlob("a\\*b", "a*b"));
+    EXPECT(!MaterialNameFilter::matchGlob("a\\*b", "axb"));
+}
+
+CPU_TEST(TransparencyWhitelistFilter)
+{
+    MaterialNameFilter filter(TransparencyWhitelist::parse("Smoke,/root/_materials/effect_*,*Leaf??,re:Glass_[0-9]+,Mat[0],"));
+
+    // Exact names.
+    EXPECT(filter.matches("Smoke"));
+    EXPECT(!filter.matches("Smoke2"));
+    // Prefix.
+    EXPECT(filter.matches("/root/_materials/effect_Fire"));
+    EXPECT(!filter.matches("/root/_materials/eff_clouds"));
+    // Glob.
+    EXPECT(filter.matches("OakLeaf01"));
+    EXPECT(!filter.matches("OakLeaf1"));
+    // Regex (full match).
+    EXPECT(filter.matches("Glass_12"));
+    EXPECT(!filter.matches("Glass_"));
+    EXPECT(!filter.matches("Glass_12b"));
+    // Entries also match their literal text.
+    EXPECT(filter.matches("Mat[0]"));
+    EXPECT(filter.matches("Mat0"));
+
+    EXPECT(MaterialNameFilter(whitelist_t{"*"}).matches("anything"));
+    EXPECT(!MaterialNameFilter().matches("anything"));
+}
+
+CPU_TEST(TransparencyWhitelistParse)
+{
+    TransparencyWhitelist whitelist;
+    whitelist.setPatterns(TransparencyWhitelist::parse("b,a*,,c"));
+    EXPECT_EQ(whitelist.getPatterns().size(), 3);
+    EXPECT_EQ(whitelist.toString(), "a*,b,c,");
+    EXPECT(TransparencyWhitelist::parse(whitelist.toString()) == whitelist.getPatterns());
+}
+
+GPU_TEST(TransparencyWhitelistUpload)
+{
+    // 100 materials Mat00..Mat99, 4 bitset words. Mat07 is added twice.
+    Scene::SceneData sceneData;
+    sceneData.pMaterials = std::make_unique<MaterialSystem>(ctx.getDevice());
+    for (uint32_t i = 0; i < 100; ++i)
+        sceneData.pMaterials->addMaterial(StandardMaterial::create(ctx.getDevice(), fmt::format("Mat{:02}", i == 99 ? 7 : i)));
+    ref<Scene> pScene = Scene::create(ctx.getDevice(), std::move(sceneData));
+    const uint32_t materialCount = pScene->getMaterialCount();
+    EXPECT_EQ(materialCount, 100);
+
+    // The first update creates the buffer.
+    TransparencyWhitelist whitelist;
+    EXPECT(!whitelist.update(ctx.getDevice(), pScene));
+    EXPECT_EQ(whitelist.getUploadedWordCount(), 4);
+    EXPECT(isBufferInSync(whitelist, materialCount));
+
+    // Nothing changed.
+    EXPECT(!whitelist.update(ctx.getDevice(), pScene));
+    EXPECT_EQ(whitelist.getUploadedWordCount(), 0);
+
+    // An exact entry only touches the words of the materials with that name.
+    whitelist.insert("Mat40");
+    EXPECT(whitelist.update(ctx.getDevice(), pScene));
+    EXPECT_EQ(whitelist.getUploadedWordCount(), 1);
+    EXPECT(whitelist.isWhitelisted(40));
+    EXPECT(whitelist.getMatchedNames() == whitelist_t({"Mat40"}));
+
+    whitelist.insert("Mat07");
+    EXPECT(whitelist.update(ctx.getDevice(), pScene));
+    EXPECT_EQ(whitelist.getUploadedWordCount(), 2); // Words 0 and 3.
+    EXPECT(whitelist.isWhitelisted(7) && whitelist.isWhitelisted(99));
+    EXPECT(isBufferInSync(whitelist, materialCount));
+
+    // A glob re-evaluates all materials, but only the words whose bits changed are uploaded.
+    whitelist.insert("Mat9?");
+    EXPECT(whitelist.update(ctx.getDevice(), pScene));
+    EXPECT_EQ(whitelist.getUploadedWordCount(), 2); // Words 2 (Mat90..Mat95) and 3 (Mat96..Mat98).
+    EXPECT_EQ(whitelist.getMatchedNames().size(), 2 + 9);
+    EXPECT(isBufferInSync(whitelist, materialCount));
+
+    // Removing entries updates the matched names.
+    whitelist.erase("Mat40");
+    whitelist.erase("Mat07");
+    EXPECT(whitelist.update(ctx.getDevice(), pScene));
+    EXPECT_EQ(whitelist.getUploadedWordCount(), 3);
+    EXPECT(!whitelist.isWhitelisted(40) && !whitelist.isWhitelisted(7) && !whitelist.isWhitelisted(99));
+    EXPECT_EQ(whitelist.getMatchedNames().size(), 9);
+    EXPECT(whitelist.getMatchedNames().count("Mat07") == 0);
+    EXPECT(isBufferInSync(whitelist, materialCount));
+
+    // A full re-evaluation with the same result uploads nothing.
+    whitelist.invalidate();
+    EXPECT(whitelist.update(ctx.getDevice(), pScene));
+    EXPECT_EQ(whitelist.getUploadedWordCount(), 0);
+    EXPECT_EQ(whitelist.getMatchedNames().size(), 9);
+}
+} // namespace Falcor
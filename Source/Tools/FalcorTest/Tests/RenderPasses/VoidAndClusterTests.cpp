@@ -0,0 +1,205 @@
+/***************************************************************************
+ # Copyright (c) 2015-22, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "../../../../RenderPasses/DitherVBuffer/VoidAndCluster.h"
+#include <cmath>
+
+namespace Falcor
+{
+namespace
+{
+bool isPermutation(const VoidAndCluster::Result& result)
+{
+    const size_t fieldCount = result.ranks.size() / result.rankCount;
+    for (size_t f = 0; f < fieldCount; ++f)
+    {
+        std::vector<bool> seen(result.rankCount, false);
+        for (size_t i = 0; i < result.rankCount; ++i)
+        {
+            uint32_t rank = result.ranks[f * result.rankCount + i];
+            if (rank >= result.rankCount || seen[rank]) return false;
+            seen[rank] = true;
+        }
+    }
+    return true;
+}
+
+/// Mean power of the low frequencies (0 < max(|kx|, |ky|) <= 2) of one slice, normalized so white noise is ~1/12.
+double getLowFrequencyPower(const VoidAndCluster::Result& result, uint32_t slice)
+{
+    const uint32_t w = result.width, h = result.height;
+    const size_t offset = size_t(slice) * w * h;
+    const double pi = 3.14159265358979323846;
+    double power = 0.0;
+    uint32_t count = 0;
+    for (int ky = -2; ky <= 2; ++ky)
+    {
+        for (int kx = -2; kx <= 2; ++kx)
+        {
+            if (kx == 0 && ky == 0) continue;
+            double re = 0.0, im = 0.0;
+            for (uint32_t y = 0; y < h; ++y)
+            {
+                for (uint32_t x = 0; x < w; ++x)
+                {
+                    double v = result.getThreshold(offset + size_t(y) * w + x) - 0.5;
+                    double phase = 2.0 * pi * (double(kx) * x / w + double(ky) * y / h);
+                    re += v * std::cos(phase);
+                    im -= v * std::sin(phase);
+                }
+            }
+            power += (re * re + im * im) / (double(w) * h);
+            count++;
+        }
+    }
+    return power / count;
+}
+} // namespace
+
+CPU_TEST(VoidAndClusterSpatial)
+{
+    VoidAndCluster::Desc desc;
+    desc.width = 32;
+    desc.height = 32;
+    desc.depth = 2;
+    desc.parallel = false;
+    VoidAndCluster::Result result = VoidAndCluster::generate(desc);
+    EXPECT_EQ(result.rankCount, 32 * 32);
+    EXPECT(isPermutation(result));
+    // The slices use different seeds.
+    EXPECT(!std::equal(result.ranks.begin(), result.ranks.begin() + 1024, result.ranks.begin() + 1024));
+
+    // Blue noise has almost no low-frequency energy, white noise has ~1/12.
+    EXPECT_LT(getLowFrequencyPower(result, 0), 0.1 / 12.0);
+    EXPECT_LT(getLowFrequencyPower(result, 1), 0.1 / 12.0);
+
+    // The result does not depend on the number of threads.
+    desc.parallel = true;
+    EXPECT(VoidAndCluster::generate(desc).ranks == result.ranks);
+}
+
+CPU_TEST(VoidAndClusterVolume)
+{
+    VoidAndCluster::Desc desc;
+    desc.type = VoidAndCluster::MaskType::Volume3D;
+    desc.width = 8;
+    desc.height = 8;
+    desc.depth = 8;
+    desc.sigma = 1.5f;
+    desc.parallel = false;
+    VoidAndCluster::Result result = VoidAndCluster::generate(desc);
+    EXPECT_EQ(result.rankCount, 512);
+    EXPECT(isPermutation(result));
+    desc.parallel = true;
+    EXPECT(VoidAndCluster::generate(desc).ranks == result.ranks);
+}
+
+CPU_TEST(VoidAndClusterSpatioTemporal)
+{
+    VoidAndCluster::Desc desc;
+    desc.type = VoidAndCluster::MaskType::SpatioTemporal;
+    desc.width = 16;
+    desc.height = 16;
+    desc.depth = 16;
+    VoidAndCluster::Result result = VoidAndCluster::generate(desc);
+    EXPECT_EQ(result.rankCount, 16 * 16 * 16);
+    EXPECT(isPermutation(result));
+
+    // Every pixel is a 1D blue-noise sequence, so its running mean over the first half of the frames stays
+    // close to 0.5 (white noise deviates by ~0.1 with 8 samples).
+    const size_t sliceSize = 16 * 16;
+    double deviation = 0.0;
+    for (size_t i = 0; i < sliceSize; ++i)
+    {
+        double sum = 0.0;
+        for (size_t s = 0; s < 8; ++s) sum += result.getThreshold(s * sliceSize + i);
+        deviation += std::abs(sum / 8 - 0.5);
+    }
+    EXPECT_LT(deviation / sliceSize, 0.05);
+
+    // Every slice is a 2D blue-noise mask.
+    EXPECT_LT(getLowFrequencyPower(result, 0), 0.2 / 12.0);
+}
+
+CPU_TEST(VoidAndClusterTinyMask)
+{
+    // A single cell cannot be ranked (there is no void to fill), a 2x1 mask is the smallest valid one.
+    VoidAndCluster::Desc desc;
+    desc.width = 1;
+    desc.height = 1;
+    desc.depth = 1;
+    bool caught = false;
+    try
+    {
+        VoidAndCluster::generate(desc);
+    }
+    catch (const std::invalid_argument&)
+    {
+        caught = true;
+    }
+    EXPECT(caught);
+
+    // Spatial2D ranks every slice on its own, so more slices do not help.
+    desc.depth = 4;
+    caught = false;
+    try
+    {
+        VoidAndCluster::generate(desc);
+    }
+    catch (const std::invalid_argument&)
+    {
+        caught = true;
+    }
+    EXPECT(caught);
+
+    desc.width = 2;
+    VoidAndCluster::Result result = VoidAndCluster::generate(desc);
+    EXPECT_EQ(result.rankCount, 2);
+    EXPECT(isPermutation(result));
+
+    desc.type = VoidAndCluster::MaskType::Volume3D;
+    desc.width = 1;
+    desc.depth = 2;
+    result = VoidAndCluster::generate(desc);
+    EXPECT_EQ(result.rankCount, 2);
+    EXPECT(isPermutation(result));
+}
+
+CPU_TEST(VoidAndClusterQuantize)
+{
+    VoidAndCluster::Result result;
+    result.width = 4;
+    result.height = 1;
+    result.depth = 1;
+    result.rankCount = 4;
+    result.ranks = {3, 0, 2, 1};
+    EXPECT(VoidAndCluster::toUnorm8(result) == std::vector<uint8_t>({192, 0, 128, 64}));
+    EXPECT(VoidAndCluster::toUnorm16(result) == std::vector<uint16_t>({49152, 0, 32768, 16384}));
+    EXPECT_EQ(VoidAndCluster::toFloat(result)[1], 0.125f);
+}
+} // namespace Falcor
@@ -0,0 +1,138 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/Scene.h"
+#include "Scene/Animation/AnimationController.h"
+#include <cstring>
+#include <numeric>
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+const size_t kNodeCount = 3000;
+
+float4x4 createTransform(std::mt19937& rng)
+{
+    // Affine and close to identity, so long parent chains stay well conditioned.
+    std::uniform_real_distribution<float> dist(-0.1f, 0.1f);
+    float4x4 m = float4x4::identity();
+    for (int r = 0; r < 3; r++)
+        for (int c = 0; c < 4; c++)
+            m[r][c] += dist(rng);
+    return m;
+}
+
+/// Reference update in node ID order. A node whose parent has a larger ID reads the parent's state from before the update.
+void updateSerial(
+    const std::vector<Scene::Node>& nodes,
+    const std::vector<float4x4>& locals,
+    std::vector<float4x4>& globals,
+    std::vector<uint8_t>& changed,
+    bool updateAll
+)
+{
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        const NodeID parent = nodes[i].parent;
+        if (parent != NodeID::Invalid())
+            changed[i] = changed[i] || changed[parent.get()];
+        if (!changed[i] && !updateAll)
+            continue;
+        globals[i] = parent != NodeID::Invalid() ? mul(globals[parent.get()], locals[i]) : locals[i];
+    }
+}
+} // namespace
+
+GPU_TEST(AnimationController_WorldMatrices)
+{
+    std::mt19937 rng(0);
+
+    // Build a random forest in creation order and shuffle the node IDs, so that many nodes have a parent with a larger ID.
+    // The levels are wider than the grain size of the parallel update.
+    std::vector<uint32_t> ids(kNodeCount);
+    std::iota(ids.begin(), ids.end(), 0);
+    std::shuffle(ids.begin(), ids.end(), rng);
+
+    std::vector<Scene::Node> nodes(kNodeCount);
+    std::vector<float4x4> locals(kNodeCount);
+    for (size_t k = 0; k < kNodeCount; k++)
+    {
+        const uint32_t id = ids[k];
+        NodeID parent = NodeID::Invalid();
+        if (k >= 8 && rng() % 16 != 0)
+            parent = NodeID{ids[rng() % k]};
+        locals[id] = createTransform(rng);
+        nodes[id] = Scene::Node("Node" + std::to_string(id), parent, locals[id], float4x4::identity(), float4x4::identity());
+    }
+
+    size_t deferredCount = 0;
+    for (size_t i = 0; i < kNodeCount; i++)
+        if (nodes[i].parent != NodeID::Invalid() && nodes[i].parent.get() > i)
+            deferredCount++;
+    EXPECT_GT(deferredCount, kNodeCount / 4);
+
+    Scene::SceneData sceneData;
+    sceneData.pMaterials = std::make_unique<MaterialSystem>(ctx.getDevice());
+    sceneData.sceneGraph = nodes;
+    ref<Scene> pScene = Scene::create(ctx.getDevice(), std::move(sceneData));
+    pScene->update(ctx.getRenderContext(), 0.0);
+
+    const AnimationController* pController = pScene->getAnimationController();
+    auto bitEqual = [](const float4x4& a, const float4x4& b) { return std::memcmp(&a, &b, sizeof(float4x4)) == 0; };
+
+    // The first update computes all matrices. The globals start out as identity.
+    std::vector<float4x4> globals(kNodeCount, float4x4::identity());
+    std::vector<uint8_t> changed(kNodeCount, 0);
+    updateSerial(nodes, locals, globals, changed, true);
+    for (size_t i = 0; i < kNodeCount; i++)
+        EXPECT(bitEqual(pController->getGlobalMatrices()[i], globals[i])) << "i=" << i;
+
+    // Incremental updates of edited nodes, including parents of nodes with smaller IDs.
+    for (uint32_t frame = 0; frame < 3; frame++)
+    {
+        std::fill(changed.begin(), changed.end(), 0);
+        for (uint32_t e = 0; e < 50; e++)
+        {
+            const uint32_t id = rng() % kNodeCount;
+            locals[id] = createTransform(rng);
+            changed[id] = 1;
+            pScene->updateNodeTransform(id, locals[id]);
+        }
+        pScene->update(ctx.getRenderContext(), 0.0);
+        updateSerial(nodes, locals, globals, changed, false);
+
+        for (size_t i = 0; i < kNodeCount; i++)
+        {
+            EXPECT(bitEqual(pController->getGlobalMatrices()[i], globals[i])) << "frame=" << frame << " i=" << i;
+            EXPECT_EQ(pController->isMatrixChanged(NodeID{i}), changed[i] != 0) << "frame=" << frame << " i=" << i;
+        }
+    }
+}
+} // namespace Falcor
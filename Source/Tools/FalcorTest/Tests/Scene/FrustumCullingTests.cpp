@@ -0,0 +1,124 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/FrustumCulling.h"
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+// Creates random boxes around the frustum, so that a good part of them straddles a plane.
+FrustumCulling::AABBArray createRandomBoxes(size_t count)
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> position(-40.f, 40.f);
+    std::uniform_real_distribution<float> extent(0.f, 4.f);
+
+    FrustumCulling::AABBArray boxes;
+    boxes.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const float3 p = float3(position(rng), position(rng), position(rng));
+        const float3 e = float3(extent(rng), extent(rng), extent(rng));
+        boxes.set(i, AABB(p - e, p + e));
+    }
+    return boxes;
+}
+
+void testBatch(CPUUnitTestContext& ctx, const FrustumCulling& culling)
+{
+    const size_t count = 1000;
+    const auto boxes = createRandomBoxes(count);
+
+    std::vector<uint8_t> expected(count);
+    size_t visibleCount = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        expected[i] = culling.isInFrustum(boxes.get(i)) ? 1 : 0;
+        visibleCount += expected[i];
+    }
+    EXPECT_GT(visibleCount, 0);
+    EXPECT_LT(visibleCount, count);
+
+    // Test ranges that do not start or end on a batch boundary.
+    const std::pair<size_t, size_t> ranges[] = {{0, count}, {3, 997}, {5, 12}, {16, 16}};
+    for (const auto& [begin, end] : ranges)
+    {
+        std::vector<uint8_t> visible(end - begin, 2);
+        culling.isInFrustum(boxes, begin, end, visible.data());
+        for (size_t i = begin; i < end; i++)
+            EXPECT_EQ(visible[i - begin], expected[i]) << "box " << i;
+    }
+
+    // The plane order only affects the early-out, not the result.
+    for (uint8_t firstPlane = 0; firstPlane < FrustumCulling::kPlaneCount; firstPlane++)
+    {
+        std::vector<uint8_t> visible(count, 2);
+        uint8_t lastPlane = firstPlane;
+        culling.isInFrustum(boxes, 0, count, FrustumCulling::kAllPlanes, lastPlane, visible.data());
+        EXPECT(visible == expected) << "first plane " << (int)firstPlane;
+        EXPECT_LT(lastPlane, FrustumCulling::kPlaneCount);
+    }
+}
+
+void testClassify(CPUUnitTestContext& ctx, const FrustumCulling& culling)
+{
+    const auto boxes = createRandomBoxes(1000);
+    for (size_t i = 0; i < boxes.size(); i++)
+    {
+        const AABB box = boxes.get(i);
+        const auto intersection = culling.classify(box);
+        EXPECT_EQ(intersection != FrustumCulling::Intersection::Outside, culling.isInFrustum(box)) << "box " << i;
+
+        // Planes the box is fully in front of are removed from the mask.
+        uint32_t planeMask = FrustumCulling::kAllPlanes;
+        uint8_t lastPlane = uint8_t(i % FrustumCulling::kPlaneCount);
+        EXPECT(culling.classify(box, planeMask, lastPlane) == intersection) << "box " << i;
+        if (intersection == FrustumCulling::Intersection::Inside)
+            EXPECT_EQ(planeMask, 0);
+        if (intersection == FrustumCulling::Intersection::Intersecting)
+            EXPECT_NE(planeMask, 0);
+    }
+}
+} // namespace
+
+CPU_TEST(FrustumCulling_BatchPerspective)
+{
+    FrustumCulling culling(float3(0.f, 0.f, -30.f), float3(0.f), float3(0.f, 1.f, 0.f), 16.f / 9.f, 0.8f, 0.1f, 50.f);
+    testBatch(ctx, culling);
+    testClassify(ctx, culling);
+}
+
+CPU_TEST(FrustumCulling_BatchOrtho)
+{
+    FrustumCulling culling(float3(5.f, 10.f, -30.f), float3(0.f), float3(0.f, 1.f, 0.f), -20.f, 20.f, -10.f, 10.f, 0.1f, 60.f);
+    testBatch(ctx, culling);
+    testClassify(ctx, culling);
+}
+} // namespace Falcor
@@ -0,0 +1,141 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/InstanceBVH.h"
+#include <algorithm>
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+std::vector<InstanceBVH::Item> createRandomItems(size_t count, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> position(-40.f, 40.f);
+    std::uniform_real_distribution<float> extent(0.f, 2.f);
+
+    std::vector<InstanceBVH::Item> items(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const float3 p = float3(position(rng), position(rng), position(rng));
+        const float3 e = float3(extent(rng), extent(rng), extent(rng));
+        // Use sparse IDs to test the ID lookup.
+        items[i] = {uint32_t(3 * i + 1), AABB(p - e, p + e)};
+    }
+    return items;
+}
+
+std::vector<uint32_t> queryFrustumBruteForce(const std::vector<InstanceBVH::Item>& items, const FrustumCulling& frustum)
+{
+    std::vector<uint32_t> ids;
+    for (const auto& item : items)
+    {
+        if (frustum.isInFrustum(item.bounds))
+            ids.push_back(item.id);
+    }
+    return ids;
+}
+
+std::vector<uint32_t> sorted(std::vector<uint32_t> ids)
+{
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+} // namespace
+
+CPU_TEST(InstanceBVH_QueryFrustum)
+{
+    std::mt19937 rng(3);
+    auto items = createRandomItems(5000, rng);
+
+    InstanceBVH bvh;
+    bvh.build(items);
+    EXPECT_EQ(bvh.getItemCount(), items.size());
+
+    FrustumCulling frustum(float3(0.f, 0.f, -30.f), float3(0.f), float3(0.f, 1.f, 0.f), 16.f / 9.f, 0.8f, 0.1f, 50.f);
+    std::vector<uint32_t> ids;
+    bvh.queryFrustum(frustum, ids);
+
+    const auto expected = queryFrustumBruteForce(items, frustum);
+    EXPECT_GT(expected.size(), 0);
+    EXPECT_LT(expected.size(), items.size());
+    EXPECT(sorted(ids) == expected);
+
+    // Move some items and refit.
+    std::uniform_real_distribution<float> offset(-20.f, 20.f);
+    for (size_t i = 0; i < items.size(); i += 7)
+    {
+        const float3 d = float3(offset(rng), offset(rng), offset(rng));
+        items[i].bounds = AABB(items[i].bounds.minPoint + d, items[i].bounds.maxPoint + d);
+        bvh.setItemBounds(items[i].id, items[i].bounds);
+    }
+    bvh.refit();
+
+    ids.clear();
+    bvh.queryFrustum(frustum, ids);
+    EXPECT(sorted(ids) == queryFrustumBruteForce(items, frustum));
+}
+
+CPU_TEST(InstanceBVH_QueryAABB)
+{
+    std::mt19937 rng(5);
+    const auto items = createRandomItems(5000, rng);
+
+    InstanceBVH bvh;
+    bvh.build(items);
+
+    const AABB box(float3(-10.f, -5.f, 0.f), float3(15.f, 5.f, 20.f));
+    std::vector<uint32_t> ids;
+    bvh.queryAABB(box, ids);
+
+    std::vector<uint32_t> expected;
+    for (const auto& item : items)
+    {
+        if (all(item.bounds.minPoint <= box.maxPoint) && all(box.minPoint <= item.bounds.maxPoint))
+            expected.push_back(item.id);
+    }
+    EXPECT_GT(expected.size(), 0);
+    EXPECT(sorted(ids) == expected);
+}
+
+CPU_TEST(InstanceBVH_CoincidentItems)
+{
+    // Items with the same centroid cannot be split and end up in a single leaf.
+    std::vector<InstanceBVH::Item> items;
+    for (uint32_t i = 0; i < 100; i++)
+        items.push_back({i, AABB(float3(-1.f - 0.01f * i), float3(1.f + 0.01f * i))});
+
+    InstanceBVH bvh;
+    bvh.build(items);
+    EXPECT_EQ(bvh.getNodeCount(), 1);
+
+    std::vector<uint32_t> ids;
+    bvh.queryAABB(AABB(float3(0.f), float3(0.5f)), ids);
+    EXPECT_EQ(ids.size(), items.size());
+}
+} // namespace Falcor
@@ -0,0 +1,66 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/Material/MaterialSystem.h"
+#include "Scene/Material/StandardMaterial.h"
+
+namespace Falcor
+{
+GPU_TEST(MaterialSystem_RemoveDuplicateMaterials)
+{
+    ref<Device> pDevice = ctx.getDevice();
+    MaterialSystem materialSystem(pDevice);
+
+    // Materials 0, 2 and 4 and materials 1 and 3 are identical except for the name.
+    const float3 colors[] = {float3(0.5f), float3(0.25f), float3(0.5f), float3(0.25f), float3(0.5f), float3(1.f)};
+    for (size_t i = 0; i < std::size(colors); i++)
+    {
+        auto pMaterial = StandardMaterial::create(pDevice, fmt::format("material{}", i));
+        pMaterial->setBaseColor(float4(colors[i], 1.f));
+        materialSystem.addMaterial(pMaterial);
+    }
+
+    auto getHash = [&](uint32_t id) { return materialSystem.getMaterial(MaterialID(id))->getHash(); };
+    EXPECT_EQ(getHash(0), getHash(2));
+    EXPECT_EQ(getHash(0), getHash(4));
+    EXPECT_EQ(getHash(1), getHash(3));
+    EXPECT_NE(getHash(0), getHash(1));
+
+    std::vector<MaterialID> idMap;
+    size_t removed = materialSystem.removeDuplicateMaterials(idMap);
+    EXPECT_EQ(removed, 3u);
+    EXPECT_EQ(materialSystem.getMaterialCount(), 3u);
+
+    const uint32_t expected[] = {0, 1, 0, 1, 0, 2};
+    ASSERT_EQ(idMap.size(), std::size(expected));
+    for (size_t i = 0; i < idMap.size(); i++)
+        EXPECT_EQ(idMap[i].get(), expected[i]);
+    EXPECT_EQ(materialSystem.getMaterial(MaterialID(0))->getName(), "material0");
+    EXPECT_EQ(materialSystem.getMaterial(MaterialID(1))->getName(), "material1");
+}
+} // namespace Falcor
@@ -0,0 +1,107 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/MeshGroupPartitioner.h"
+#include <algorithm>
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+const uint64_t kTrianglesPerItem = 1000;
+
+// Creates a lattice of disjoint boxes in random order.
+std::vector<MeshGroupPartitioner::Item> createShuffledLattice(uint32_t size)
+{
+    std::vector<MeshGroupPartitioner::Item> items;
+    for (uint32_t z = 0; z < size; z++)
+    {
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                const float3 p = float3((float)x, (float)y, (float)z);
+                items.push_back({AABB(p, p + float3(0.8f)), kTrianglesPerItem});
+            }
+        }
+    }
+    std::shuffle(items.begin(), items.end(), std::mt19937(1));
+    return items;
+}
+} // namespace
+
+CPU_TEST(MeshGroupPartitioner_SAH)
+{
+    const auto items = createShuffledLattice(16);
+    const uint64_t maxTriangles = items.size() * kTrianglesPerItem / 8;
+
+    auto groups = MeshGroupPartitioner::partitionSAH(items, maxTriangles);
+
+    // All items must be assigned to exactly one group.
+    std::vector<uint32_t> indices;
+    for (const auto& group : groups)
+        indices.insert(indices.end(), group.begin(), group.end());
+    std::sort(indices.begin(), indices.end());
+    ASSERT_EQ(indices.size(), items.size());
+    for (uint32_t i = 0; i < indices.size(); i++)
+        EXPECT_EQ(indices[i], i);
+
+    // The lattice can be partitioned into the minimum number of groups without overlap.
+    const auto report = MeshGroupPartitioner::evaluate(items, groups);
+    EXPECT_EQ(report.groupCount, 8);
+    EXPECT_LE(report.maxTriangleCount, maxTriangles);
+    EXPECT_EQ(report.overlapVolume, 0.f);
+
+    // Splitting the items in their original order gives large overlaps and a higher cost.
+    std::vector<MeshGroupPartitioner::Group> simpleGroups(8);
+    for (uint32_t i = 0; i < items.size(); i++)
+        simpleGroups[i * simpleGroups.size() / items.size()].push_back(i);
+    const auto simpleReport = MeshGroupPartitioner::evaluate(items, simpleGroups);
+    EXPECT_GT(simpleReport.overlapRatio, 1.f);
+    EXPECT_LT(report.traversalCost, simpleReport.traversalCost);
+}
+
+CPU_TEST(MeshGroupPartitioner_Degenerate)
+{
+    EXPECT(MeshGroupPartitioner::partitionSAH({}, 10).empty());
+
+    // A single item is never split, even if it exceeds the limit.
+    std::vector<MeshGroupPartitioner::Item> items = {{AABB(float3(0.f), float3(1.f)), 100}};
+    EXPECT_EQ(MeshGroupPartitioner::partitionSAH(items, 10).size(), 1);
+
+    // Items with identical or invalid bounds can still be split.
+    items = {{AABB(), 100}, {AABB(), 100}, {AABB(float3(0.f), float3(1.f)), 100}, {AABB(float3(0.f), float3(1.f)), 100}};
+    EXPECT_EQ(MeshGroupPartitioner::partitionSAH(items, 100).size(), 4);
+
+    // Two identical groups overlap completely.
+    const auto report = MeshGroupPartitioner::evaluate(items, {{2}, {3}});
+    EXPECT_EQ(report.overlapVolume, 1.f);
+    EXPECT_EQ(report.overlapRatio, 1.f);
+}
+} // namespace Falcor
@@ -0,0 +1,111 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/OcclusionCulling.h"
+
+namespace Falcor
+{
+namespace
+{
+// Square wall in the z = 0 plane, facing the camera.
+const float3 kWallPositions[] = {{-5.f, -5.f, 0.f}, {5.f, -5.f, 0.f}, {5.f, 5.f, 0.f}, {-5.f, 5.f, 0.f}};
+const uint32_t kWallIndices[] = {0, 1, 2, 0, 2, 3};
+
+AABB box(float3 center, float3 extent)
+{
+    return AABB(center - extent, center + extent);
+}
+
+void testWall(CPUUnitTestContext& ctx, OcclusionCulling& occlusion, const float4x4& viewProj)
+{
+    // Nothing is occluded before the occluders are rasterized.
+    occlusion.begin(viewProj);
+    EXPECT(!occlusion.isOccluded(box(float3(0.f, 0.f, -5.f), float3(1.f))));
+
+    occlusion.addOccluder(kWallPositions, 4, kWallIndices, 2, float4x4::identity());
+    occlusion.rasterize();
+    EXPECT(occlusion.isValid());
+    EXPECT_EQ(occlusion.getStats().occluderCount, 1);
+    EXPECT_EQ(occlusion.getStats().rasterizedTriangleCount, 2);
+
+    // Behind the wall.
+    EXPECT(occlusion.isOccluded(box(float3(0.f, 0.f, -5.f), float3(1.f))));
+    EXPECT(occlusion.isOccluded(box(float3(1.f, -1.f, -1.f), float3(0.5f))));
+
+    // In front of the wall, crossing the wall, and the wall itself.
+    EXPECT(!occlusion.isOccluded(box(float3(0.f, 0.f, 5.f), float3(1.f))));
+    EXPECT(!occlusion.isOccluded(box(float3(0.f, 0.f, 0.f), float3(1.f))));
+    EXPECT(!occlusion.isOccluded(box(float3(0.f), float3(5.f, 5.f, 0.f))));
+
+    // Behind the wall, but next to it or overlapping its edge.
+    EXPECT(!occlusion.isOccluded(box(float3(8.f, 0.f, -5.f), float3(1.f))));
+    EXPECT(!occlusion.isOccluded(box(float3(5.f, 0.f, -1.f), float3(0.5f))));
+
+    // Containing the camera.
+    EXPECT(!occlusion.isOccluded(box(float3(0.f, 0.f, 10.f), float3(1.f))));
+
+    // Occluders are only valid until the next begin().
+    occlusion.begin(viewProj);
+    occlusion.rasterize();
+    EXPECT_EQ(occlusion.getStats().triangleCount, 0);
+    EXPECT(!occlusion.isOccluded(box(float3(0.f, 0.f, -5.f), float3(1.f))));
+}
+} // namespace
+
+CPU_TEST(OcclusionCulling_Perspective)
+{
+    const float4x4 view = math::matrixFromLookAt(float3(0.f, 0.f, 10.f), float3(0.f), float3(0.f, 1.f, 0.f));
+    const float4x4 proj = math::perspective(1.f, 2.f, 0.1f, 100.f);
+    OcclusionCulling occlusion;
+    testWall(ctx, occlusion, mul(proj, view));
+}
+
+CPU_TEST(OcclusionCulling_Ortho)
+{
+    const float4x4 view = math::matrixFromLookAt(float3(0.f, 0.f, 10.f), float3(0.f), float3(0.f, 1.f, 0.f));
+    const float4x4 proj = math::ortho(-20.f, 20.f, -10.f, 10.f, 0.1f, 100.f);
+    OcclusionCulling occlusion(160, 80);
+    testWall(ctx, occlusion, mul(proj, view));
+}
+
+CPU_TEST(OcclusionCulling_Transform)
+{
+    // Same wall rotated to face +x, seen from the side.
+    const float4x4 view = math::matrixFromLookAt(float3(10.f, 0.f, 0.f), float3(0.f), float3(0.f, 1.f, 0.f));
+    const float4x4 proj = math::perspective(1.f, 1.f, 0.1f, 100.f);
+    const float4x4 transform = math::matrixFromRotationY(math::radians(90.f));
+
+    OcclusionCulling occlusion(64, 64);
+    occlusion.begin(mul(proj, view));
+    occlusion.addOccluder(kWallPositions, 4, kWallIndices, 2, transform);
+    occlusion.rasterize();
+
+    EXPECT(occlusion.isOccluded(box(float3(-5.f, 0.f, 0.f), float3(1.f))));
+    EXPECT(!occlusion.isOccluded(box(float3(5.f, 0.f, 0.f), float3(1.f))));
+}
+} // namespace Falcor
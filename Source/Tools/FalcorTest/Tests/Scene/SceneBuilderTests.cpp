@@ -0,0 +1,227 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/SceneBuilder.h"
+#include "Scene/Material/StandardMaterial.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+namespace Falcor
+{
+namespace
+{
+struct MeshData
+{
+    std::vector<uint32_t> indices;
+    std::vector<float3> positions;
+    std::vector<float3> normals;
+    std::vector<float2> texCoords;
+};
+
+std::vector<ref<TriangleMesh>> createTriangleMeshes()
+{
+    return {
+        TriangleMesh::createSphere(0.5f, 24, 12),
+        TriangleMesh::createCube(float3(1.f, 2.f, 3.f)),
+        TriangleMesh::createQuad(float2(2.f)),
+        TriangleMesh::createDisk(1.f, 40),
+        TriangleMesh::createSphere(2.f, 8, 4),
+    };
+}
+
+/// Add a triangle mesh with addMesh() or addMeshAsync(), and instance it on a new node.
+void addMesh(SceneBuilder& builder, const ref<TriangleMesh>& pTriangleMesh, const ref<Material>& pMaterial, bool async)
+{
+    auto pData = std::make_shared<MeshData>();
+    pData->indices = pTriangleMesh->getIndices();
+    for (const auto& v : pTriangleMesh->getVertices())
+    {
+        pData->positions.push_back(v.position);
+        pData->normals.push_back(v.normal);
+        pData->texCoords.push_back(v.texCoord);
+    }
+
+    SceneBuilder::Mesh mesh;
+    mesh.name = pTriangleMesh->getName();
+    mesh.faceCount = (uint32_t)(pData->indices.size() / 3);
+    mesh.vertexCount = (uint32_t)pData->positions.size();
+    mesh.indexCount = (uint32_t)pData->indices.size();
+    mesh.topology = Vao::Topology::TriangleList;
+    mesh.pMaterial = pMaterial;
+    mesh.pIndices = pData->indices.data();
+    mesh.positions = {pData->positions.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex};
+    mesh.normals = {pData->normals.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex};
+    mesh.texCrds = {pData->texCoords.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex};
+
+    MeshID meshID = async ? builder.addMeshAsync(mesh, pData) : builder.addMesh(mesh);
+    NodeID nodeID = builder.addNode({mesh.name, float4x4::identity(), float4x4::identity()});
+    builder.addMeshInstance(nodeID, meshID);
+}
+
+ref<Scene> createScene(ref<Device> pDevice, bool async)
+{
+    SceneBuilder builder(pDevice, Settings(), SceneBuilder::Flags::DontMergeMeshes);
+
+    auto triangleMeshes = createTriangleMeshes();
+    for (size_t i = 0; i < triangleMeshes.size(); i++)
+    {
+        triangleMeshes[i]->setName("Mesh" + std::to_string(i));
+        auto pMaterial = StandardMaterial::create(pDevice, "Material" + std::to_string(i));
+        pMaterial->setBaseColor(float4(float(i) / triangleMeshes.size(), 0.5f, 0.5f, 1.f));
+        addMesh(builder, triangleMeshes[i], pMaterial, async);
+    }
+
+    return builder.getScene();
+}
+
+std::vector<uint8_t> readBuffer(const ref<Buffer>& pBuffer)
+{
+    if (!pBuffer)
+        return {};
+    std::vector<uint8_t> data(pBuffer->getSize());
+    std::memcpy(data.data(), pBuffer->map(Buffer::MapType::Read), data.size());
+    pBuffer->unmap();
+    return data;
+}
+} // namespace
+
+GPU_TEST(SceneBuilder_AsyncMeshProcessing)
+{
+    ref<Device> pDevice = ctx.getDevice();
+
+    ref<Scene> pSyncScene = createScene(pDevice, false);
+    ref<Scene> pAsyncScene = createScene(pDevice, true);
+
+    // The meshes are in the order they were added, with the same layout in the global buffers.
+    EXPECT_EQ(pAsyncScene->getMeshCount(), pSyncScene->getMeshCount());
+    if (pAsyncScene->getMeshCount() != pSyncScene->getMeshCount())
+        return;
+
+    for (MeshID meshID{0}; meshID.get() < pSyncScene->getMeshCount(); ++meshID)
+    {
+        const MeshDesc& syncMesh = pSyncScene->getMesh(meshID);
+        const MeshDesc& asyncMesh = pAsyncScene->getMesh(meshID);
+        EXPECT_EQ(pAsyncScene->getMeshName(meshID.get()), pSyncScene->getMeshName(meshID.get())) << "meshID=" << meshID.get();
+        EXPECT_EQ(asyncMesh.vbOffset, syncMesh.vbOffset) << "meshID=" << meshID.get();
+        EXPECT_EQ(asyncMesh.ibOffset, syncMesh.ibOffset) << "meshID=" << meshID.get();
+        EXPECT_EQ(asyncMesh.vertexCount, syncMesh.vertexCount) << "meshID=" << meshID.get();
+        EXPECT_EQ(asyncMesh.indexCount, syncMesh.indexCount) << "meshID=" << meshID.get();
+        EXPECT_EQ(asyncMesh.materialID, syncMesh.materialID) << "meshID=" << meshID.get();
+        EXPECT_EQ(asyncMesh.flags, syncMesh.flags) << "meshID=" << meshID.get();
+    }
+
+    // The vertex and index data is identical.
+    const ref<Vao>& pSyncVao = pSyncScene->getMeshVao();
+    const ref<Vao>& pAsyncVao = pAsyncScene->getMeshVao();
+    EXPECT_EQ(pAsyncVao->getVertexBuffersCount(), pSyncVao->getVertexBuffersCount());
+    for (uint32_t i = 0; i < std::min(pSyncVao->getVertexBuffersCount(), pAsyncVao->getVertexBuffersCount()); i++)
+    {
+        EXPECT(readBuffer(pAsyncVao->getVertexBuffer(i)) == readBuffer(pSyncVao->getVertexBuffer(i))) << "vertex buffer " << i;
+    }
+    EXPECT(readBuffer(pAsyncVao->getIndexBuffer()) == readBuffer(pSyncVao->getIndexBuffer()));
+}
+
+GPU_TEST(SceneBuilder_InstanceIdenticalMeshes)
+{
+    ref<Device> pDevice = ctx.getDevice();
+
+    SceneBuilder builder(
+        pDevice, Settings(), SceneBuilder::Flags::InstanceIdenticalMeshes | SceneBuilder::Flags::FlattenStaticMeshInstances
+    );
+    auto pMaterial = StandardMaterial::create(pDevice, "Material");
+
+    auto addNode = [&](const std::string& name, float3 translation)
+    { return builder.addNode({name, math::matrixFromTranslation(translation), float4x4::identity()}); };
+
+    // Identical copies of a cube on separate nodes, as emitted by importers. These are replaced by instances of a single mesh.
+    std::map<std::string, std::vector<float3>> expectedCenters;
+    auto pCube = TriangleMesh::createCube();
+    pCube->setName("Cube");
+    for (int i = 0; i < 4; i++)
+    {
+        float3 translation(3.f * i, 0.f, 0.f);
+        builder.addMeshInstance(addNode("Cube", translation), builder.addTriangleMesh(pCube, pMaterial));
+        expectedCenters["Cube"].push_back(translation);
+    }
+
+    // A mesh instanced on two nodes. This is flattened into two meshes.
+    auto pBox = TriangleMesh::createCube(float3(1.f, 2.f, 1.f));
+    pBox->setName("Box");
+    MeshID boxID = builder.addTriangleMesh(pBox, pMaterial);
+    for (int i = 0; i < 2; i++)
+    {
+        float3 translation(0.f, 5.f, 3.f * i);
+        builder.addMeshInstance(addNode("Box", translation), boxID);
+        expectedCenters["Box"].push_back(translation);
+    }
+
+    // A mesh that is neither instanced nor flattened.
+    auto pSphere = TriangleMesh::createSphere();
+    pSphere->setName("Sphere");
+    builder.addMeshInstance(addNode("Sphere", float3(0.f, -5.f, 0.f)), builder.addTriangleMesh(pSphere, pMaterial));
+    expectedCenters["Sphere"].push_back(float3(0.f, -5.f, 0.f));
+
+    ref<Scene> pScene = builder.getScene();
+    pScene->update(ctx.getRenderContext(), 0.0);
+
+    // The cubes share one mesh, the box is split into one mesh per instance.
+    std::map<std::string, uint32_t> meshCounts;
+    for (uint32_t meshID = 0; meshID < pScene->getMeshCount(); meshID++)
+        meshCounts[pScene->getMeshName(meshID).substr(0, pScene->getMeshName(meshID).find('['))]++;
+    EXPECT_EQ(pScene->getMeshCount(), 4);
+    EXPECT_EQ(meshCounts["Cube"], 1);
+    EXPECT_EQ(meshCounts["Box"], 2);
+    EXPECT_EQ(meshCounts["Sphere"], 1);
+    EXPECT_EQ(pScene->getGeometryInstanceCount(), 7);
+
+    // Every instance is placed where its node was.
+    const auto& globalMatrices = pScene->getAnimationController()->getGlobalMatrices();
+    std::map<std::string, std::vector<float3>> centers;
+    for (uint32_t instanceID = 0; instanceID < pScene->getGeometryInstanceCount(); instanceID++)
+    {
+        const auto& instance = pScene->getGeometryInstance(instanceID);
+        const std::string name = pScene->getMeshName(instance.geometryID);
+        const float3 center = transformPoint(globalMatrices[instance.globalMatrixID], pScene->getMeshBounds(instance.geometryID).center());
+        centers[name.substr(0, name.find('['))].push_back(center);
+    }
+
+    for (const auto& [name, expected] : expectedCenters)
+    {
+        auto& actual = centers[name];
+        EXPECT_EQ(actual.size(), expected.size()) << name;
+        for (const float3& e : expected)
+        {
+            auto it = std::find_if(actual.begin(), actual.end(), [&](const float3& c) { return length(c - e) < 1e-4f; });
+            EXPECT(it != actual.end()) << name << " instance at " << e.x << ", " << e.y << ", " << e.z << " not found";
+            if (it != actual.end())
+                actual.erase(it);
+        }
+    }
+}
+} // namespace Falcor
@@ -0,0 +1,169 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Core/Plugin.h"
+#include "Scene/SceneBuilder.h"
+#include "Scene/Lights/EnvMap.h"
+#include "Utils/Image/Bitmap.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+namespace Falcor
+{
+namespace
+{
+const char kObj[] = R"(mtllib scene.mtl
+v 0 0 0
+v 1 0 0
+v 1 1 0
+v 0 1 0
+vt 0 0
+vt 1 0
+vt 1 1
+vt 0 1
+vn 0 0 1
+usemtl Textured
+f 1/1/1 2/2/1 3/3/1
+f 1/1/1 3/3/1 4/4/1
+)";
+
+const char kMtl[] = R"(newmtl Textured
+Kd 1 1 1
+Ks 1 1 1
+map_Kd base_color.png
+map_Ks specular.png
+)";
+
+/// Write an RGBA8 image with gradients in all channels, so that it is not optimized away.
+void writeImage(const std::filesystem::path& path, uint32_t width, uint32_t height)
+{
+    std::vector<uint8_t> data(width * height * 4);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            uint8_t* pTexel = &data[(y * width + x) * 4];
+            pTexel[0] = uint8_t(x * 255 / (width - 1));
+            pTexel[1] = uint8_t(y * 255 / (height - 1));
+            pTexel[2] = uint8_t((x + y) * 255 / (width + height - 2));
+            pTexel[3] = uint8_t(255 - x * 255 / (width - 1));
+        }
+    }
+    Bitmap::saveImage(
+        path, width, height, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::ExportAlpha, ResourceFormat::RGBA8Unorm, true, data.data()
+    );
+}
+
+void expectSameTexture(GPUUnitTestContext& ctx, const ref<Texture>& pTexture, const ref<Texture>& pRefTexture, const std::string& what)
+{
+    EXPECT_EQ(pTexture != nullptr, pRefTexture != nullptr) << what;
+    if (!pTexture || !pRefTexture)
+        return;
+    EXPECT_EQ(pTexture->getSourcePath(), pRefTexture->getSourcePath()) << what;
+    EXPECT_EQ(pTexture->getWidth(), pRefTexture->getWidth()) << what;
+    EXPECT_EQ(pTexture->getHeight(), pRefTexture->getHeight()) << what;
+    EXPECT_EQ(pTexture->getMipCount(), pRefTexture->getMipCount()) << what;
+    EXPECT_EQ((uint32_t)pTexture->getFormat(), (uint32_t)pRefTexture->getFormat()) << what;
+}
+} // namespace
+
+GPU_TEST(SceneCache_DeferredLoading)
+{
+    PluginManager::instance().loadPluginByName("AssimpImporter");
+
+    ref<Device> pDevice = ctx.getDevice();
+
+    const auto dir = getRuntimeDirectory() / "test_scene_cache";
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir / "scene.obj") << kObj;
+    std::ofstream(dir / "scene.mtl") << kMtl;
+    writeImage(dir / "base_color.png", 16, 16);
+    writeImage(dir / "specular.png", 8, 8);
+    writeImage(dir / "env_map.png", 32, 16);
+
+    const auto scenePath = dir / "scene.obj";
+    const auto flags = SceneBuilder::Flags::UseCache;
+
+    // Build the scene and write the cache.
+    {
+        SceneBuilder builder(pDevice, scenePath, Settings(), flags | SceneBuilder::Flags::RebuildCache);
+        auto pEnvMap = EnvMap::createFromFile(pDevice, dir / "env_map.png");
+        pEnvMap->setRotation(float3(0.f, 90.f, 0.f));
+        pEnvMap->setIntensity(2.f);
+        builder.setEnvMap(pEnvMap);
+        builder.getScene();
+    }
+
+    ref<Scene> pScene = SceneBuilder(pDevice, scenePath, Settings(), flags).getScene();
+    ref<Scene> pDeferredScene = SceneBuilder(pDevice, scenePath, Settings(), flags | SceneBuilder::Flags::DeferCacheLoading).getScene();
+
+    // The deferred data is applied in update().
+    EXPECT(pScene->isFullyLoaded());
+    EXPECT(!pDeferredScene->isFullyLoaded());
+    for (int i = 0; i < 1000 && !pDeferredScene->isFullyLoaded(); i++)
+    {
+        pDeferredScene->update(ctx.getRenderContext(), 0.0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT(pDeferredScene->isFullyLoaded());
+    pScene->update(ctx.getRenderContext(), 0.0);
+
+    // Once loaded, the materials and the environment map are the same as with a synchronous load.
+    EXPECT_EQ(pDeferredScene->getMaterialCount(), pScene->getMaterialCount());
+    for (MaterialID materialID{0}; materialID.get() < std::min(pScene->getMaterialCount(), pDeferredScene->getMaterialCount()); ++materialID)
+    {
+        const auto& pMaterial = pDeferredScene->getMaterial(materialID);
+        const auto& pRefMaterial = pScene->getMaterial(materialID);
+        EXPECT_EQ(pMaterial->getName(), pRefMaterial->getName());
+        EXPECT(std::memcmp(&pMaterial->getHeader(), &pRefMaterial->getHeader(), sizeof(MaterialHeader)) == 0) << pMaterial->getName();
+        for (uint32_t slot = 0; slot < (uint32_t)Material::TextureSlot::Count; slot++)
+        {
+            expectSameTexture(
+                ctx, pMaterial->getTexture(Material::TextureSlot(slot)), pRefMaterial->getTexture(Material::TextureSlot(slot)),
+                pMaterial->getName() + " " + to_string(Material::TextureSlot(slot))
+            );
+        }
+    }
+
+    const auto& pEnvMap = pDeferredScene->getEnvMap();
+    const auto& pRefEnvMap = pScene->getEnvMap();
+    EXPECT(pEnvMap != nullptr);
+    EXPECT(pRefEnvMap != nullptr);
+    if (pEnvMap && pRefEnvMap)
+    {
+        expectSameTexture(ctx, pEnvMap->getEnvMap(), pRefEnvMap->getEnvMap(), "env map");
+        EXPECT(all(pEnvMap->getRotation() == pRefEnvMap->getRotation()));
+        EXPECT_EQ(pEnvMap->getIntensity(), pRefEnvMap->getIntensity());
+        EXPECT(all(pEnvMap->getTint() == pRefEnvMap->getTint()));
+    }
+
+    std::filesystem::remove_all(dir);
+}
+} // namespace Falcor
@@ -0,0 +1,139 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/VertexCacheOptimizer.h"
+#include <algorithm>
+#include <array>
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+using Triangle = std::array<uint32_t, 3>;
+
+// Creates a sphere grid with the triangles in random order.
+void createShuffledSphere(uint32_t size, std::vector<uint32_t>& indices, std::vector<float3>& positions)
+{
+    positions.clear();
+    for (uint32_t y = 0; y < size; y++)
+    {
+        for (uint32_t x = 0; x < size; x++)
+        {
+            float phi = x * 2.f * (float)M_PI / size;
+            float theta = y * (float)M_PI / (size - 1);
+            positions.push_back(float3(std::cos(phi) * std::sin(theta), std::sin(phi) * std::sin(theta), std::cos(theta)));
+        }
+    }
+
+    std::vector<Triangle> triangles;
+    for (uint32_t y = 0; y + 1 < size; y++)
+    {
+        for (uint32_t x = 0; x + 1 < size; x++)
+        {
+            uint32_t i = y * size + x;
+            triangles.push_back({i, i + 1, i + size});
+            triangles.push_back({i + 1, i + size + 1, i + size});
+        }
+    }
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(1));
+
+    indices.clear();
+    for (const auto& t : triangles)
+        indices.insert(indices.end(), t.begin(), t.end());
+}
+
+// Returns the triangles rotated to start with the smallest index, in sorted order.
+std::vector<Triangle> getCanonicalTriangles(const std::vector<uint32_t>& indices)
+{
+    std::vector<Triangle> triangles;
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        Triangle t = {indices[i], indices[i + 1], indices[i + 2]};
+        std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+        triangles.push_back(t);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+} // namespace
+
+CPU_TEST(VertexCacheOptimizer_TriangleOrder)
+{
+    const uint32_t kSize = 64;
+    std::vector<uint32_t> indices;
+    std::vector<float3> positions;
+    createShuffledSphere(kSize, indices, positions);
+    const uint32_t vertexCount = (uint32_t)positions.size();
+
+    const double acmrBefore = VertexCacheOptimizer::computeACMR(indices, vertexCount);
+    EXPECT_GT(acmrBefore, 2.5);
+
+    // The same triangles with the same winding must be emitted, with a much better ACMR.
+    auto optimized = indices;
+    VertexCacheOptimizer::optimizeTriangleOrder(optimized, vertexCount);
+    EXPECT(getCanonicalTriangles(optimized) == getCanonicalTriangles(indices));
+    const double acmrCache = VertexCacheOptimizer::computeACMR(optimized, vertexCount);
+    EXPECT_LT(acmrCache, 0.8);
+
+    // Sorting clusters for overdraw may only increase the ACMR slightly.
+    optimized = indices;
+    VertexCacheOptimizer::optimizeTriangleOrder(optimized, vertexCount, positions.data());
+    EXPECT(getCanonicalTriangles(optimized) == getCanonicalTriangles(indices));
+    EXPECT_LT(VertexCacheOptimizer::computeACMR(optimized, vertexCount), acmrCache * 1.1);
+}
+
+CPU_TEST(VertexCacheOptimizer_VertexOrder)
+{
+    // Vertices 1 and 4 are unreferenced.
+    std::vector<uint32_t> indices = {5, 3, 0, 0, 3, 2, 2, 6, 5};
+    const std::vector<uint32_t> original = indices;
+    auto remap = VertexCacheOptimizer::optimizeVertexOrder(indices, 7);
+
+    const std::vector<uint32_t> expectedIndices = {0, 1, 2, 2, 1, 3, 3, 4, 0};
+    const std::vector<uint32_t> expectedRemap = {2, 5, 3, 1, 6, 0, 4};
+    EXPECT(indices == expectedIndices);
+    EXPECT(remap == expectedRemap);
+    for (size_t i = 0; i < indices.size(); i++)
+        EXPECT_EQ(indices[i], remap[original[i]]);
+}
+
+CPU_TEST(VertexCacheOptimizer_Degenerate)
+{
+    std::vector<uint32_t> indices;
+    VertexCacheOptimizer::optimizeTriangleOrder(indices, 0);
+    EXPECT(indices.empty());
+
+    // Degenerate triangles must be kept.
+    indices = {0, 0, 0, 0, 1, 1, 2, 2, 2};
+    const std::vector<float3> positions = {float3(0.f), float3(1.f, 0.f, 0.f), float3(0.f, 1.f, 0.f)};
+    auto optimized = indices;
+    VertexCacheOptimizer::optimizeTriangleOrder(optimized, 3, positions.data());
+    EXPECT(getCanonicalTriangles(optimized) == getCanonicalTriangles(indices));
+}
+} // namespace Falcor
@@ -0,0 +1,166 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/VertexWelder.h"
+#include <limits>
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+using Vertex = VertexWelder::Vertex;
+
+// Reference implementation of the vertex comparison.
+bool compareReference(const Vertex& lhs, const Vertex& rhs, float threshold)
+{
+    if (any(lhs.position != rhs.position))
+        return false;
+    if (lhs.tangent.w != rhs.tangent.w)
+        return false;
+    if (lhs.curveRadius != rhs.curveRadius)
+        return false;
+    if (any(lhs.boneIDs != rhs.boneIDs))
+        return false;
+    if (any(abs(lhs.normal - rhs.normal) > float3(threshold)))
+        return false;
+    if (any(abs(lhs.tangent.xyz() - rhs.tangent.xyz()) > float3(threshold)))
+        return false;
+    if (any(abs(lhs.texCrd - rhs.texCrd) > float2(threshold)))
+        return false;
+    if (any(abs(lhs.boneWeights - rhs.boneWeights) > float4(threshold)))
+        return false;
+    return true;
+}
+
+// Generates vertices that are split at a few original indices, with near-duplicates and non-finite values.
+std::vector<std::pair<Vertex, uint32_t>> generateVertices(uint32_t originalVertexCount, uint32_t count, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> u(-1.f, 1.f);
+    const float kSpecial[] = {
+        0.f,
+        -0.f,
+        std::numeric_limits<float>::quiet_NaN(),
+        std::numeric_limits<float>::infinity(),
+        -std::numeric_limits<float>::infinity(),
+        1e30f,
+    };
+
+    std::vector<Vertex> prototypes(32);
+    for (auto& v : prototypes)
+    {
+        v = {};
+        v.position = float3((float)(rng() % 3), 0.f, 1.f);
+        v.normal = float3(u(rng), u(rng), u(rng));
+        v.tangent = float4(u(rng), u(rng), u(rng), rng() % 2 ? 1.f : -1.f);
+        v.texCrd = float2(u(rng), u(rng));
+        v.boneIDs = uint4(rng() % 2, 0, 0, 0);
+        v.boneWeights = float4(u(rng), 0.f, 0.f, 0.f);
+    }
+
+    std::vector<std::pair<Vertex, uint32_t>> vertices(count);
+    for (auto& [v, originalIndex] : vertices)
+    {
+        v = prototypes[rng() % prototypes.size()];
+        originalIndex = rng() % originalVertexCount;
+
+        uint32_t r = rng() % 10;
+        float* pApprox[] = {&v.normal.x, &v.normal.y, &v.normal.z, &v.tangent.x, &v.tangent.y, &v.tangent.z, &v.texCrd.x, &v.texCrd.y};
+        float& approx = *pApprox[rng() % 8];
+        if (r < 4)
+            approx += u(rng) * 1.5e-6f;
+        else if (r == 4)
+            approx = kSpecial[rng() % std::size(kSpecial)];
+        else if (r == 5)
+            v.position.x = kSpecial[rng() % std::size(kSpecial)];
+    }
+    return vertices;
+}
+
+void testWelder(CPUUnitTestContext& ctx, float threshold)
+{
+    const uint32_t kOriginalVertexCount = 50;
+    auto vertices = generateVertices(kOriginalVertexCount, 5000, 1);
+
+    VertexWelder linear(VertexWelder::Mode::Linear, kOriginalVertexCount, threshold);
+    VertexWelder hashed(VertexWelder::Mode::Hashed, kOriginalVertexCount, threshold);
+
+    // The reference merges with the most recent identical vertex using the same original index.
+    std::vector<std::pair<Vertex, uint32_t>> reference;
+    for (const auto& [v, originalIndex] : vertices)
+    {
+        uint32_t expected = (uint32_t)reference.size();
+        for (size_t i = reference.size(); i-- > 0;)
+        {
+            if (reference[i].second == originalIndex && compareReference(v, reference[i].first, threshold))
+            {
+                expected = (uint32_t)i;
+                break;
+            }
+        }
+        if (expected == reference.size())
+            reference.push_back({v, originalIndex});
+
+        auto [linearIndex, linearInserted] = linear.insert(v, originalIndex);
+        auto [hashedIndex, hashedInserted] = hashed.insert(v, originalIndex);
+        EXPECT_EQ(linearIndex, expected);
+        EXPECT_EQ(hashedIndex, expected);
+        EXPECT_EQ(linearInserted, hashedInserted);
+    }
+
+    EXPECT_EQ(linear.getVertexCount(), reference.size());
+    EXPECT_EQ(hashed.getVertexCount(), reference.size());
+}
+} // namespace
+
+CPU_TEST(VertexWelder_Compare)
+{
+    auto vertices = generateVertices(1, 1000, 2);
+    for (size_t i = 1; i < vertices.size(); i++)
+    {
+        const Vertex& a = vertices[i - 1].first;
+        const Vertex& b = vertices[i].first;
+        EXPECT_EQ(VertexWelder::compare(a, b), compareReference(a, b, 1e-6f));
+    }
+}
+
+CPU_TEST(VertexWelder_Merge)
+{
+    testWelder(ctx, 1e-6f);
+    testWelder(ctx, 0.f);
+    testWelder(ctx, 1e-2f);
+}
+
+CPU_TEST(VertexWelder_MergeNonFiniteThreshold)
+{
+    testWelder(ctx, -1.f);
+    testWelder(ctx, std::numeric_limits<float>::infinity());
+    testWelder(ctx, std::numeric_limits<float>::quiet_NaN());
+}
+} // namespace Falcor
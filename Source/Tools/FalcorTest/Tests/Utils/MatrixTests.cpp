@@ -27,9 +27,13 @@
  **************************************************************************/
 #include "Testing/UnitTest.h"
 #include "Utils/Math/Matrix.h"
+#include "Utils/Math/MatrixBatch.h"
 
 #include <fmt/format.h>
+#include <cstring>
 #include <iostream>
+#include <random>
+#include <vector>
 
 namespace Falcor
 {
@@ -803,4 +807,45 @@ CPU_TEST(Matrix_FloatFormatter)
     EXPECT_EQ(fmt::format("{:.2f}", test0), "{{1.10, 1.20, 1.30}, {2.10, 2.20, 2.30}, {3.10, 3.20, 3.30}}");
 }
 
+CPU_TEST(Matrix_Batch)
+{
+    // 8 matrices per SIMD iteration. The last 3 are zero-padded to a full iteration.
+    const size_t count = 8 * 5 + 3;
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> dist(-2.f, 2.f);
+
+    std::vector<float4x4> lhs(count), rhs(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        for (int r = 0; r < 4; r++)
+        {
+            for (int c = 0; c < 4; c++)
+            {
+                lhs[i][r][c] = dist(rng);
+                rhs[i][r][c] = dist(rng);
+            }
+        }
+    }
+    rhs[3] = math::matrixFromTranslation(float3(1.f, -2.f, 0.f));
+    rhs[9] = float4x4::identity();
+
+    // The batched kernels must be bit-identical to the scalar functions.
+    auto bitEqual = [](const float4x4& a, const float4x4& b) { return std::memcmp(&a, &b, sizeof(float4x4)) == 0; };
+
+    std::vector<float4x4> result(count);
+    mulBatch(lhs.data(), rhs.data(), result.data(), count);
+    for (size_t i = 0; i < count; i++)
+        EXPECT(bitEqual(result[i], mul(lhs[i], rhs[i]))) << "i=" << i;
+
+    inverseTransposeBatch(rhs.data(), result.data(), count);
+    for (size_t i = 0; i < count; i++)
+        EXPECT(bitEqual(result[i], transpose(inverse(rhs[i])))) << "i=" << i;
+
+    // In-place.
+    result = lhs;
+    inverseTransposeBatch(result.data(), result.data(), count);
+    for (size_t i = 0; i < count; i++)
+        EXPECT(bitEqual(result[i], transpose(inverse(lhs[i])))) << "i=" << i;
+}
+
 } // namespace Falcor
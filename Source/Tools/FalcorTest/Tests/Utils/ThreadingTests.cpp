@@ -0,0 +1,147 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Threading.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Falcor
+{
+// The test runner starts the global thread pool.
+
+CPU_TEST(ThreadingTask)
+{
+    std::atomic<int> value = 0;
+    Threading::Task task = Threading::dispatchTask([&]() { value = 1; });
+    task.finish();
+    EXPECT(!task.isRunning());
+    EXPECT_EQ(value.load(), 1);
+
+    EXPECT(!Threading::Task().isValid());
+    EXPECT(!Threading::Task().isRunning());
+
+    // Continuations run in order after their parent.
+    std::atomic<int> order = 0;
+    int first = -1, second = -1;
+    Threading::Task last = Threading::dispatchTask([&]() { first = order++; }).then([&]() { second = order++; });
+    last.finish();
+    EXPECT_EQ(first, 0);
+    EXPECT_EQ(second, 1);
+
+    // Continuation of a finished task.
+    int late = 0;
+    task.then([&]() { late = 1; }).finish();
+    EXPECT_EQ(late, 1);
+
+    // Exceptions are rethrown when waiting.
+    bool caught = false;
+    try
+    {
+        Threading::dispatchTask([]() { throw std::runtime_error("task"); }).finish();
+    }
+    catch (const std::runtime_error&)
+    {
+        caught = true;
+    }
+    EXPECT(caught);
+}
+
+CPU_TEST(ThreadingFinish)
+{
+    std::atomic<int> count = 0;
+    for (int i = 0; i < 100; ++i)
+        Threading::dispatchTask([&]() { count++; }).then([&]() { count++; });
+    Threading::finish();
+    EXPECT_EQ(count.load(), 200);
+}
+
+CPU_TEST(ThreadingParallelFor)
+{
+    std::vector<uint32_t> values(100000, 0);
+    Threading::parallelFor(0, values.size(), [&](size_t i) { values[i] += uint32_t(i); });
+    bool correct = true;
+    for (size_t i = 0; i < values.size(); ++i)
+        correct &= values[i] == uint32_t(i);
+    EXPECT(correct);
+
+    // Nested loops on the worker threads.
+    std::atomic<uint32_t> count = 0;
+    Threading::parallelFor(0, 64, [&](size_t) { Threading::parallelFor(0, 64, [&](size_t) { count++; }, 4); }, 1);
+    EXPECT_EQ(count.load(), 64 * 64);
+
+    // Empty range.
+    Threading::parallelFor(10, 10, [&](size_t) { count++; });
+    EXPECT_EQ(count.load(), 64 * 64);
+
+    bool caught = false;
+    try
+    {
+        Threading::parallelFor(
+            0,
+            1000,
+            [](size_t i)
+            {
+                if (i == 500)
+                    throw std::runtime_error("iteration");
+            }
+        );
+    }
+    catch (const std::runtime_error&)
+    {
+        caught = true;
+    }
+    EXPECT(caught);
+}
+
+CPU_TEST(ThreadingParallelReduce)
+{
+    auto sumSquares = [](size_t begin, size_t end, uint64_t sum)
+    {
+        for (size_t i = begin; i < end; ++i)
+            sum += uint64_t(i) * i;
+        return sum;
+    };
+    auto add = [](uint64_t a, uint64_t b) { return a + b; };
+    EXPECT_EQ(Threading::parallelReduce(size_t(0), size_t(100000), uint64_t(0), sumSquares, add), 333328333350000ull);
+    EXPECT_EQ(Threading::parallelReduce(size_t(0), size_t(100000), uint64_t(0), sumSquares, add, 7), 333328333350000ull);
+    EXPECT_EQ(Threading::parallelReduce(size_t(5), size_t(5), uint64_t(42), sumSquares, add), 42ull);
+
+    // Chunks are combined in order.
+    auto concat = [](std::string a, std::string b) { return a + b; };
+    auto digits = [](size_t begin, size_t end, std::string s)
+    {
+        for (size_t i = begin; i < end; ++i)
+            s += char('0' + i);
+        return s;
+    };
+    EXPECT_EQ(Threading::parallelReduce(size_t(0), size_t(10), std::string(), digits, concat, 1), "0123456789");
+}
+} // namespace Falcor
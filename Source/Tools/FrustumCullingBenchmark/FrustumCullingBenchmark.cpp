@@ -0,0 +1,279 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Falcor.h"
+#include "Scene/FrustumCulling.h"
+#include "Scene/InstanceBVH.h"
+#include "Utils/Timing/CpuTimer.h"
+
+#include <args.hxx>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+using namespace Falcor;
+
+/** Benchmark for CPU instance frustum culling along camera paths.
+    Camera paths are read from the .campath files written by the VideoRecorder render pass. Each frame culls a
+    synthetic city of instance boxes with the linear batched test, with the instance BVH without temporal state,
+    and with the instance BVH reusing the rejecting planes of the previous frame. Fails if the results differ.
+*/
+
+namespace
+{
+// Path point layout of the VideoRecorder .campath files.
+const std::string kPathHeader = "VideoRecorderVersion1_0";
+
+struct PathPoint
+{
+    float3 pos;
+    float3 dir;
+    float3 up;
+    float time;
+};
+
+struct PathPointPre1_0
+{
+    float3 pos;
+    float3 dir;
+    float time;
+};
+
+struct CullingDesc
+{
+    float aspect = 16.f / 9.f;
+    float fovY = math::radians(45.f);
+    float nearZ = 0.1f;
+    float farZ = 1000.f;
+};
+
+std::vector<PathPoint> loadCameraPath(const std::string& path)
+{
+    std::vector<PathPoint> points;
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return points;
+
+    std::string header(kPathHeader.size(), '\0');
+    bool isPre1_0 = !file.read(header.data(), header.size()) || header != kPathHeader;
+    if (isPre1_0)
+    {
+        file.clear();
+        file.seekg(0);
+        PathPointPre1_0 point;
+        while (file.read(reinterpret_cast<char*>(&point), sizeof(point)))
+            points.push_back({point.pos, point.dir, float3(0.f, 1.f, 0.f), point.time});
+    }
+    else
+    {
+        PathPoint point;
+        while (file.read(reinterpret_cast<char*>(&point), sizeof(point)))
+            points.push_back(point);
+    }
+    return points;
+}
+
+// Slow walk through the city with a turning camera.
+std::vector<PathPoint> createCameraPath(uint32_t frameCount)
+{
+    std::vector<PathPoint> points;
+    for (uint32_t i = 0; i < frameCount; i++)
+    {
+        const float t = float(i) / frameCount;
+        const float angle = t * 2.f * float(M_PI);
+        PathPoint p;
+        p.pos = float3(300.f * std::cos(angle), 10.f, 300.f * std::sin(angle));
+        p.dir = normalize(float3(-std::sin(angle * 3.f), -0.1f, std::cos(angle * 3.f)));
+        p.up = float3(0.f, 1.f, 0.f);
+        p.time = t * 20.f;
+        points.push_back(p);
+    }
+    return points;
+}
+
+// Buildings and props on a 1 km^2 ground plane.
+std::vector<InstanceBVH::Item> createCity(uint32_t instanceCount)
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> position(-500.f, 500.f);
+    std::uniform_real_distribution<float> size(0.5f, 8.f);
+    std::exponential_distribution<float> height(0.1f);
+
+    std::vector<InstanceBVH::Item> items(instanceCount);
+    for (uint32_t i = 0; i < instanceCount; i++)
+    {
+        const float3 minPoint = float3(position(rng), 0.f, position(rng));
+        const float3 extent = float3(size(rng), 1.f + height(rng), size(rng));
+        items[i] = {i, AABB(minPoint, minPoint + extent)};
+    }
+    return items;
+}
+
+void updateFrustum(FrustumCulling& culling, const PathPoint& p, const CullingDesc& desc)
+{
+    culling.updateFrustum(p.pos, p.pos + p.dir, p.up, desc.aspect, desc.fovY, desc.nearZ, desc.farZ);
+}
+
+void printTime(const char* name, double seconds, uint32_t frameCount, double baseline)
+{
+    std::cout << fmt::format(
+                     "  {:<24} {:>10.3f} ms/frame {:>8.2f}x", name, seconds * 1e3 / frameCount, seconds > 0.0 ? baseline / seconds : 0.0
+                 )
+              << std::endl;
+}
+
+bool benchmarkPath(const std::string& name, const std::vector<PathPoint>& path, const std::vector<InstanceBVH::Item>& items, const CullingDesc& desc)
+{
+    if (path.empty())
+    {
+        std::cerr << fmt::format("Failed to load camera path '{}'.", name) << std::endl;
+        return false;
+    }
+
+    FrustumCulling::AABBArray boxes;
+    boxes.resize(items.size());
+    for (size_t i = 0; i < items.size(); i++)
+        boxes.set(i, items[i].bounds);
+
+    InstanceBVH bvh;
+    bvh.build(items);
+
+    FrustumCulling linearCulling, bvhCulling, coherentCulling;
+    std::vector<uint8_t> visible(items.size());
+    std::vector<uint32_t> linearIDs, bvhIDs, coherentIDs;
+    double linearSeconds = 0.0, bvhSeconds = 0.0, coherentSeconds = 0.0;
+    uint64_t visibleCount = 0;
+    bool identical = true;
+
+    CpuTimer timer;
+    for (const auto& point : path)
+    {
+        updateFrustum(linearCulling, point, desc);
+        updateFrustum(bvhCulling, point, desc);
+        updateFrustum(coherentCulling, point, desc);
+
+        timer.update();
+        linearCulling.isInFrustum(boxes, 0, items.size(), visible.data());
+        linearIDs.clear();
+        for (size_t i = 0; i < items.size(); i++)
+        {
+            if (visible[i])
+                linearIDs.push_back(items[i].id);
+        }
+        timer.update();
+        linearSeconds += timer.delta();
+
+        // Forget the rejecting planes of the previous frame.
+        bvhCulling.getRejectingPlanes().clear();
+        bvhIDs.clear();
+        timer.update();
+        bvh.queryFrustum(bvhCulling, bvhIDs);
+        timer.update();
+        bvhSeconds += timer.delta();
+
+        coherentIDs.clear();
+        timer.update();
+        bvh.queryFrustum(coherentCulling, coherentIDs);
+        timer.update();
+        coherentSeconds += timer.delta();
+
+        std::sort(bvhIDs.begin(), bvhIDs.end());
+        std::sort(coherentIDs.begin(), coherentIDs.end());
+        identical &= bvhIDs == linearIDs && coherentIDs == linearIDs;
+        visibleCount += linearIDs.size();
+    }
+
+    const uint32_t frameCount = (uint32_t)path.size();
+    std::cout << fmt::format(
+                     "{} ({} frames, {} instances, {:.1f}% visible)", name, frameCount, items.size(),
+                     100.0 * visibleCount / (double(frameCount) * items.size())
+                 )
+              << std::endl;
+    printTime("linear", linearSeconds, frameCount, linearSeconds);
+    printTime("bvh", bvhSeconds, frameCount, linearSeconds);
+    printTime("bvh + temporal planes", coherentSeconds, frameCount, linearSeconds);
+    std::cout << fmt::format("  {}", identical ? "identical" : "MISMATCH") << std::endl;
+    return identical;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    args::ArgumentParser parser("Benchmark for CPU instance frustum culling along camera paths.");
+    parser.helpParams.programName = "FrustumCullingBenchmark";
+    args::HelpFlag helpFlag(parser, "help", "Display this help menu.", {'h', "help"});
+    args::ValueFlag<uint32_t> instancesFlag(parser, "instances", "Number of synthetic instances (default 500000).", {'n', "instances"});
+    args::ValueFlag<uint32_t> framesFlag(parser, "frames", "Frames of the synthetic camera path (default 600).", {'f', "frames"});
+    args::ValueFlag<float> fovFlag(parser, "fov", "Vertical field of view in degrees (default 45).", {"fov"});
+    args::PositionalList<std::string> pathsArg(parser, "paths", "VideoRecorder .campath files. Uses a synthetic path if none are given.");
+    args::CompletionFlag completionFlag(parser, {"complete"});
+
+    try
+    {
+        parser.ParseCLI(argc, argv);
+    }
+    catch (const args::Completion& e)
+    {
+        std::cout << e.what();
+        return 0;
+    }
+    catch (const args::Help&)
+    {
+        std::cout << parser;
+        return 0;
+    }
+    catch (const args::ParseError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+
+    std::cout << "Box test: " << (isAVX2Supported() ? "AVX2" : "scalar fallback") << std::endl;
+
+    CullingDesc desc;
+    if (fovFlag)
+        desc.fovY = math::radians(args::get(fovFlag));
+
+    const auto items = createCity(instancesFlag ? args::get(instancesFlag) : 500000);
+
+    bool success = true;
+    if (pathsArg)
+    {
+        for (const auto& path : args::get(pathsArg))
+            success &= benchmarkPath(path, loadCameraPath(path), items, desc);
+    }
+    else
+    {
+        uint32_t frameCount = framesFlag ? args::get(framesFlag) : 600;
+        success &= benchmarkPath("synthetic path", createCameraPath(frameCount), items, desc);
+    }
+
+    return success ? 0 : 1;
+}
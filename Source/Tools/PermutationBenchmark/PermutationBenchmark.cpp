@@ -0,0 +1,236 @@
+/***************************************************************************
+ # Copyright (c) 2015-22, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Falcor.h"
+#include "Utils/Timing/CpuTimer.h"
+#include "../../RenderPasses/DitherVBuffer/PermutationScoring.h"
+#include "../../RenderPasses/DitherVBuffer/PermutationSearch.h"
+
+#include <args.hxx>
+
+#include <iostream>
+
+using namespace Falcor;
+
+/** Microbenchmark for the dither permutation scorers.
+    Compares the scalar reference against the batched scorer (exhaustive 3x3 enumeration) and the
+    full rescore against the incremental swap score (4x4 annealing). Fails if any result differs.
+*/
+
+namespace
+{
+template<typename Func>
+double measure(Func func)
+{
+    CpuTimer timer;
+    timer.update();
+    func();
+    timer.update();
+    return timer.delta();
+}
+
+void printRate(const char* name, uint64_t count, double seconds)
+{
+    std::cout << fmt::format("  {:<24} {:>10.3f} ms {:>10.2f} M/s", name, seconds * 1e3, seconds > 0.0 ? count / seconds * 1e-6 : 0.0)
+              << std::endl;
+}
+
+bool benchmark3x3()
+{
+    std::vector<std::array<int, 9>> perms;
+    std::array<int, 9> indices;
+    std::iota(indices.begin(), indices.end(), 0);
+    do
+        perms.push_back(indices);
+    while (std::next_permutation(indices.begin(), indices.end()));
+
+    std::cout << fmt::format("3x3 scoring ({} permutations)", perms.size()) << std::endl;
+
+    std::vector<int> scalarScores(perms.size());
+    double scalarSeconds = measure(
+        [&]()
+        {
+            for (size_t i = 0; i < perms.size(); ++i) scalarScores[i] = scorePermutation<3>(perms[i]);
+        }
+    );
+
+    std::vector<int> batchScores(perms.size());
+    double batchSeconds = measure([&]() { scorePermutations<3>(perms.data(), perms.size(), batchScores.data()); });
+
+    uint64_t enumerated = 0;
+    double enumerateSeconds = measure([&]() { forEachScoredPermutation<3>([&](const std::array<int, 9>&, int) { ++enumerated; }); });
+
+    printRate("scalar", perms.size(), scalarSeconds);
+    printRate("batched", perms.size(), batchSeconds);
+    printRate("enumerate + batched", enumerated, enumerateSeconds);
+    bool identical = scalarScores == batchScores;
+    std::cout << fmt::format("  speedup {:.2f}x, {}", scalarSeconds / batchSeconds, identical ? "identical" : "MISMATCH") << std::endl;
+    return identical;
+}
+
+/// Same chain as PermutationSearch::runChain, but rescoring the full matrix for every candidate.
+uint64_t runFullRescoreChain(const PermutationSearch::Desc& desc, uint32_t chainIndex)
+{
+    PermutationSearch::SplitMix64 seeder(desc.seed);
+    for (uint32_t i = 0; i <= chainIndex; ++i) seeder.next();
+    PermutationSearch::SplitMix64 rng(seeder.next());
+
+    std::array<int, 16> current = {0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5};
+    int currentScore = scorePermutation<4>(current);
+    uint64_t checksum = 0;
+
+    double temperature = desc.startTemperature;
+    for (size_t iter = 0; iter < desc.iterationsPerChain; ++iter)
+    {
+        uint32_t i = rng.nextBelow(16);
+        uint32_t j = rng.nextBelow(16);
+        std::array<int, 16> neighbor = current;
+        std::swap(neighbor[i], neighbor[j]);
+        int neighborScore = scorePermutation<4>(neighbor);
+
+        bool accept = neighborScore > currentScore;
+        if (!accept && neighborScore > 0) accept = rng.nextDouble() < std::exp((neighborScore - currentScore) / temperature);
+        if (accept && i != j)
+        {
+            current = neighbor;
+            currentScore = neighborScore;
+        }
+        checksum = checksum * 31 + uint64_t(currentScore);
+        temperature *= desc.coolingRate;
+    }
+    return checksum;
+}
+
+/// Incremental counterpart of runFullRescoreChain.
+uint64_t runIncrementalChain(const PermutationSearch::Desc& desc, uint32_t chainIndex)
+{
+    PermutationSearch::SplitMix64 seeder(desc.seed);
+    for (uint32_t i = 0; i <= chainIndex; ++i) seeder.next();
+    PermutationSearch::SplitMix64 rng(seeder.next());
+
+    IncrementalPermutationScore<4> current({0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5});
+    int currentScore = current.score();
+    uint64_t checksum = 0;
+
+    double temperature = desc.startTemperature;
+    for (size_t iter = 0; iter < desc.iterationsPerChain; ++iter)
+    {
+        uint32_t i = rng.nextBelow(16);
+        uint32_t j = rng.nextBelow(16);
+        int neighborScore = current.scoreAfterSwap(i, j);
+
+        bool accept = neighborScore > currentScore;
+        if (!accept && neighborScore > 0) accept = rng.nextDouble() < std::exp((neighborScore - currentScore) / temperature);
+        if (accept && i != j)
+        {
+            current.applySwap(i, j);
+            currentScore = neighborScore;
+        }
+        checksum = checksum * 31 + uint64_t(currentScore);
+        temperature *= desc.coolingRate;
+    }
+    return checksum;
+}
+
+bool benchmark4x4(const PermutationSearch::Desc& desc)
+{
+    const uint64_t count = uint64_t(desc.chainCount) * desc.iterationsPerChain;
+    std::cout << fmt::format("4x4 annealing chains ({} chains x {} iterations)", desc.chainCount, desc.iterationsPerChain) << std::endl;
+
+    uint64_t fullChecksum = 0;
+    double fullSeconds = measure(
+        [&]()
+        {
+            for (uint32_t c = 0; c < desc.chainCount; ++c) fullChecksum = fullChecksum * 31 + runFullRescoreChain(desc, c);
+        }
+    );
+
+    uint64_t incrementalChecksum = 0;
+    double incrementalSeconds = measure(
+        [&]()
+        {
+            for (uint32_t c = 0; c < desc.chainCount; ++c) incrementalChecksum = incrementalChecksum * 31 + runIncrementalChain(desc, c);
+        }
+    );
+
+    printRate("full rescore", count, fullSeconds);
+    printRate("incremental", count, incrementalSeconds);
+    std::cout << fmt::format(
+                     "  speedup {:.2f}x, {}", fullSeconds / incrementalSeconds, fullChecksum == incrementalChecksum ? "identical" : "MISMATCH"
+                 )
+              << std::endl;
+
+    // Full search including dedup, on the requested number of threads.
+    auto result = PermutationSearch::search4x4(desc);
+    printRate("search4x4", result.evaluations, result.seconds);
+
+    return fullChecksum == incrementalChecksum;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    args::ArgumentParser parser("Microbenchmark for the dither permutation scorers.");
+    parser.helpParams.programName = "PermutationBenchmark";
+    args::HelpFlag helpFlag(parser, "help", "Display this help menu.", {'h', "help"});
+    args::ValueFlag<uint32_t> chainsFlag(parser, "chains", "Number of 4x4 annealing chains (default 16).", {'c', "chains"});
+    args::ValueFlag<size_t> iterationsFlag(parser, "iterations", "Iterations per 4x4 chain (default 62500).", {'i', "iterations"});
+    args::ValueFlag<uint32_t> threadsFlag(parser, "threads", "Worker threads for search4x4 (default all cores).", {'t', "threads"});
+    args::CompletionFlag completionFlag(parser, {"complete"});
+
+    try
+    {
+        parser.ParseCLI(argc, argv);
+    }
+    catch (const args::Completion& e)
+    {
+        std::cout << e.what();
+        return 0;
+    }
+    catch (const args::Help&)
+    {
+        std::cout << parser;
+        return 0;
+    }
+    catch (const args::ParseError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+
+    PermutationSearch::Desc desc;
+    desc.chainCount = chainsFlag ? args::get(chainsFlag) : 16;
+    desc.iterationsPerChain = iterationsFlag ? args::get(iterationsFlag) : 62500;
+    desc.threadCount = threadsFlag ? args::get(threadsFlag) : 0;
+
+    std::cout << "Batched scorer: " << (isAVX2Supported() ? "AVX2" : "scalar fallback") << std::endl;
+
+    bool success = benchmark3x3();
+    success &= benchmark4x4(desc);
+    return success ? 0 : 1;
+}
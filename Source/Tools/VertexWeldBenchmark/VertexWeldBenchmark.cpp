@@ -0,0 +1,208 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Falcor.h"
+#include "Scene/TriangleMesh.h"
+#include "Scene/VertexWelder.h"
+#include "Utils/Timing/CpuTimer.h"
+
+#include <args.hxx>
+
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+using namespace Falcor;
+
+/** Benchmark for merging duplicate vertices in SceneBuilder::processMesh().
+    Each mesh is expanded into a face-varying vertex stream with flat normals, indexed by unique position,
+    which is how importers pass hard-edged meshes to the scene builder. The stream is then welded with the
+    linear and the hashed vertex welder. Fails if the two produce different vertices or indices.
+*/
+
+namespace
+{
+struct VertexStream
+{
+    std::vector<VertexWelder::Vertex> vertices;
+    std::vector<uint32_t> originalIndices;
+    uint32_t originalVertexCount = 0;
+};
+
+struct WeldResult
+{
+    std::vector<VertexWelder::Vertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+template<typename Func>
+double measure(Func func)
+{
+    CpuTimer timer;
+    timer.update();
+    func();
+    timer.update();
+    return timer.delta();
+}
+
+void printRate(const char* name, uint64_t count, double seconds)
+{
+    std::cout << fmt::format("  {:<24} {:>10.3f} ms {:>10.2f} M/s", name, seconds * 1e3, seconds > 0.0 ? count / seconds * 1e-6 : 0.0)
+              << std::endl;
+}
+
+VertexStream createVertexStream(const TriangleMesh& mesh)
+{
+    const auto& meshVertices = mesh.getVertices();
+    const auto& meshIndices = mesh.getIndices();
+
+    // Index vertices by position, ignoring the splits of the source mesh.
+    std::unordered_map<std::string, uint32_t> positionIndices;
+    VertexStream stream;
+    stream.vertices.reserve(meshIndices.size());
+    stream.originalIndices.reserve(meshIndices.size());
+
+    for (size_t i = 0; i + 2 < meshIndices.size(); i += 3)
+    {
+        const float3 p[3] = {
+            meshVertices[meshIndices[i]].position,
+            meshVertices[meshIndices[i + 1]].position,
+            meshVertices[meshIndices[i + 2]].position,
+        };
+        const float3 faceNormal = normalize(cross(p[1] - p[0], p[2] - p[0]));
+
+        for (uint32_t j = 0; j < 3; j++)
+        {
+            std::string key(sizeof(float3), '\0');
+            std::memcpy(key.data(), &p[j], sizeof(float3));
+            auto [it, inserted] = positionIndices.try_emplace(key, (uint32_t)positionIndices.size());
+
+            VertexWelder::Vertex v = {};
+            v.position = p[j];
+            v.normal = faceNormal;
+            v.texCrd = meshVertices[meshIndices[i + j]].texCoord;
+            stream.vertices.push_back(v);
+            stream.originalIndices.push_back(it->second);
+        }
+    }
+
+    stream.originalVertexCount = (uint32_t)positionIndices.size();
+    return stream;
+}
+
+WeldResult weld(const VertexStream& stream, VertexWelder::Mode mode)
+{
+    VertexWelder welder(mode, stream.originalVertexCount);
+    WeldResult result;
+    result.indices.resize(stream.vertices.size());
+    for (size_t i = 0; i < stream.vertices.size(); i++)
+        result.indices[i] = welder.insert(stream.vertices[i], stream.originalIndices[i]).first;
+    result.vertices = welder.takeVertices();
+    return result;
+}
+
+bool isIdentical(const WeldResult& a, const WeldResult& b)
+{
+    // Welded vertices are copies of the first vertex of each merged set, so equal indices imply equal vertices.
+    return a.indices == b.indices && a.vertices.size() == b.vertices.size();
+}
+
+bool benchmarkMesh(const std::string& name, const ref<TriangleMesh>& pMesh)
+{
+    if (!pMesh)
+    {
+        std::cerr << fmt::format("Failed to load mesh '{}'.", name) << std::endl;
+        return false;
+    }
+
+    VertexStream stream = createVertexStream(*pMesh);
+    std::cout << fmt::format("{} ({} triangles, {} positions)", name, stream.vertices.size() / 3, stream.originalVertexCount) << std::endl;
+
+    WeldResult linear, hashed;
+    double linearSeconds = measure([&]() { linear = weld(stream, VertexWelder::Mode::Linear); });
+    double hashedSeconds = measure([&]() { hashed = weld(stream, VertexWelder::Mode::Hashed); });
+
+    bool identical = isIdentical(linear, hashed);
+    printRate("linear", stream.vertices.size(), linearSeconds);
+    printRate("hashed", stream.vertices.size(), hashedSeconds);
+    std::cout << fmt::format(
+                     "  {} welded vertices, speedup {:.2f}x, {}", hashed.vertices.size(), linearSeconds / hashedSeconds,
+                     identical ? "identical" : "MISMATCH"
+                 )
+              << std::endl;
+    return identical;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    args::ArgumentParser parser("Benchmark for the linear and hashed vertex welders.");
+    parser.helpParams.programName = "VertexWeldBenchmark";
+    args::HelpFlag helpFlag(parser, "help", "Display this help menu.", {'h', "help"});
+    args::ValueFlag<uint32_t> segmentsFlag(
+        parser, "segments", "Segments of the synthetic sphere, sets the valence at the poles (default 1024).", {'s', "segments"}
+    );
+    args::PositionalList<std::string> meshesArg(parser, "meshes", "Mesh files to weld. Uses a synthetic sphere if none are given.");
+    args::CompletionFlag completionFlag(parser, {"complete"});
+
+    try
+    {
+        parser.ParseCLI(argc, argv);
+    }
+    catch (const args::Completion& e)
+    {
+        std::cout << e.what();
+        return 0;
+    }
+    catch (const args::Help&)
+    {
+        std::cout << parser;
+        return 0;
+    }
+    catch (const args::ParseError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+
+    std::cout << "Vertex compare: " << (isAVX2Supported() ? "AVX2" : "scalar fallback") << std::endl;
+
+    bool success = true;
+    if (meshesArg)
+    {
+        for (const auto& path : args::get(meshesArg))
+            success &= benchmarkMesh(path, TriangleMesh::createFromFile(path));
+    }
+    else
+    {
+        uint32_t segments = segmentsFlag ? args::get(segmentsFlag) : 1024;
+        success &= benchmarkMesh(fmt::format("sphere {}x{}", segments, segments / 2), TriangleMesh::createSphere(0.5f, segments, segments / 2));
+    }
+
+    return success ? 0 : 1;
+}
@@ -455,6 +455,11 @@ void BasicSceneBuilder::onObjectInstance(const std::string& name, FileLoc loc)
     mInstances.push_back(std::move(instance));
 }
 
+void BasicSceneBuilder::onInclude(const std::filesystem::path& path, FileLoc loc)
+{
+    mScene.addIncludedFile(path);
+}
+
 void BasicSceneBuilder::onEndOfFiles()
 {
     if (mCurrentBlock != BlockState::WorldBlock)
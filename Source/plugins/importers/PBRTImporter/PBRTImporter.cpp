@@ -256,7 +256,13 @@ struct BuilderContext
         return pMaterial;
     }
 
-    Resolver resolver = [this](const std::filesystem::path& path) { return scene.resolvePath(path); };
+    /// Resolves a file referenced by the scene and records it as a scene dependency.
+    Resolver resolver = [this](const std::filesystem::path& path)
+    {
+        auto resolvedPath = scene.resolvePath(path);
+        if (!path.empty()) builder.addDependency(resolvedPath);
+        return resolvedPath;
+    };
 };
 
 inline void warnUnsupportedType(const FileLoc& loc, const std::string_view category, const std::string_view name)
@@ -1680,7 +1686,9 @@ std::variant<Falcor::MeshID, Falcor::CurveID> createCurveGeometry(BuilderContext
     }
     else
     {
-        Falcor::CurveTessellation::MeshResult result;
+        // The tessellation is owned by the mesh processing task.
+        auto pResult = std::make_shared<Falcor::CurveTessellation::MeshResult>();
+        auto& result = *pResult;
         if (mode == CurveTessellationMode::PolyTube)
         {
             result = CurveTessellation::convertToPolytube(
@@ -1711,7 +1719,7 @@ std::variant<Falcor::MeshID, Falcor::CurveID> createCurveGeometry(BuilderContext
         mesh.curveRadii.pData = result.radii.data();
         mesh.curveRadii.frequency = Falcor::SceneBuilder::Mesh::AttributeFrequency::Vertex;
 
-        return ctx.builder.addMesh(mesh);
+        return ctx.builder.addMeshAsync(mesh, pResult);
     }
 }
 
@@ -1883,6 +1891,7 @@ void PBRTImporter::importScene(const std::filesystem::path& path, SceneBuilder&
         pbrt::BasicScene pbrtScene(path.parent_path());
         pbrt::BasicSceneBuilder pbrtBuilder(pbrtScene);
         pbrt::parseFile(pbrtBuilder, path);
+        for (const auto& includedPath : pbrtScene.getIncludedFiles()) builder.addDependency(includedPath);
         timeReport.measure("Parsing pbrt scene");
 
         pbrt::BuilderContext ctx{pbrtScene, builder};
@@ -1427,6 +1427,7 @@ namespace Falcor
         float intensity = getAuthoredAttribute(domeLight.GetIntensityAttr(), lightPrim.GetAttribute(TfToken("intensity")), 1.f);
         GfVec3f color = getAuthoredAttribute(domeLight.GetColorAttr(), lightPrim.GetAttribute(TfToken("color")), GfVec3f(1.f, 1.f, 1.f));
 
+        builder.addDependency(envMapPath);
         ref<EnvMap> pEnvMap = EnvMap::createFromFile(builder.getDevice(), envMapPath);
 
         if (pEnvMap == nullptr)
@@ -1799,7 +1800,8 @@ namespace Falcor
         , builder(builder)
         , useInstanceProxies(useInstanceProxies)
     {
-        mpPreviewSurfaceConverter = std::make_unique<PreviewSurfaceConverter>(builder.getDevice());
+        mpPreviewSurfaceConverter = std::make_unique<PreviewSurfaceConverter>(
+            builder.getDevice(), [&builder](const std::filesystem::path& path) { builder.addDependency(path); });
     }
 
 
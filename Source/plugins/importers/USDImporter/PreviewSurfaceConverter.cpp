@@ -533,8 +533,8 @@ StandardMaterialSpec::ConvertedInput PreviewSurfaceConverter::convertColor(
     return ret;
 }
 
-PreviewSurfaceConverter::PreviewSurfaceConverter(ref<Device> pDevice)
-    : mpDevice(pDevice)
+PreviewSurfaceConverter::PreviewSurfaceConverter(ref<Device> pDevice, FileCallback onFileLoaded)
+    : mpDevice(pDevice), mOnFileLoaded(std::move(onFileLoaded))
 {
     mpSpecTransPass = ComputePass::create(mpDevice, kSpecTransShaderFile, kSpecTransShaderEntry);
 
@@ -714,6 +714,10 @@ ref<Texture> PreviewSurfaceConverter::loadTexture(const StandardMaterialSpec::Co
     {
         return nullptr;
     }
+    if (mOnFileLoaded)
+    {
+        mOnFileLoaded(ci.texturePath);
+    }
     if (hasExtension(ci.texturePath, ".dds"))
     {
         // It would be better if we could separate texture file reading, which is relatlvely
@@ -53,10 +53,13 @@ namespace Falcor
 class PreviewSurfaceConverter
 {
 public:
+    using FileCallback = std::function<void(const std::filesystem::path&)>;
+
     /**
      * Create a new converter, compiling required compute shaders
+     * \param onFileLoaded Optional callback invoked with the path of every texture file that is loaded (may be called concurrently).
      */
-    PreviewSurfaceConverter(ref<Device> pDevice);
+    PreviewSurfaceConverter(ref<Device> pDevice, FileCallback onFileLoaded = {});
 
     /**
      * Create a Falcor material from a USD material containing a UsdPreviewSurface shader.
@@ -122,6 +125,8 @@ private:
 
     ref<Sampler> mpSampler; ///< Bilinear clamp sampler
 
+    FileCallback mOnFileLoaded; ///< Called for every loaded texture file.
+
     ///< Map from UsdPreviewSurface-defining UsdShadeShader to Falcor material instance. An entry with a null instance
     ///< indicates in-progress conversion.
     std::unordered_map<pxr::UsdPrim, ref<StandardMaterial>, UsdObjHash> mPrimMaterialCache;
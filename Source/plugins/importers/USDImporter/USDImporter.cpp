@@ -332,6 +332,13 @@ namespace Falcor
 
         timeReport.measure("Open stage");
 
+        // Record all layers (sublayers, references, payloads) for scene cache validation.
+        for (const auto& pLayer : pStage->GetUsedLayers())
+        {
+            const std::string& realPath = pLayer->GetRealPath();
+            if (!realPath.empty()) builder.addDependency(realPath);
+        }
+
         Falcor::addDataDirectory(path.parent_path());
         ImporterContext ctx(path, pStage, builder, dict, timeReport);
 